@@ -7,7 +7,9 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include "../server/admin_actions.h"
+#include "../server/enroll_stats.h"
 #include "../server/utils.h"
+#include "../server/probes.h"
 
 #define DB_STUDENTS "../database/students.csv"
 #define DB_FACULTY  "../database/faculty.csv"
@@ -15,6 +17,32 @@
 #define USER_NOT_FOUND -2
 #define DUPLICATE_ID -3
 
+/**
+ * @brief Lists users a page at a time until the admin enters a user ID.
+ *
+ * @param db   Path to the user table.
+ * @param buf  Receives the entered line.
+ * @param size Size of buf.
+ * @return 1 once a line other than "n" was entered, 0 on end of input or error.
+ */
+static inline int prompt_user_id(const char *db, char *buf, size_t size) {
+    ListCursor cursor;
+    cursor_reset(&cursor);
+
+    while (1) {
+        if (print_users(db, &cursor) < 0) return 0;
+
+        const char *prompt = cursor.done ? "Enter user ID: " : "Enter user ID (n for more users): ";
+        write(STDOUT_FILENO, prompt, strlen(prompt));
+        ssize_t n = read(STDIN_FILENO, buf, size - 1);
+        if (n <= 0) return 0;
+        buf[n] = '\0';
+        buf[strcspn(buf, "\n")] = '\0';
+
+        if (cursor.done || strcmp(buf, "n") != 0) return 1;
+    }
+}
+
 /**
  * @brief Displays the admin menu, gathers inputs, and invokes server functions.
  *
@@ -37,7 +65,9 @@ static inline void handle_admin_menu(void) {
             "\n 2) Add Faculty          "
             "\n 3) Update User Details  "
             "\n 4) View User Details    "
-            "\n 5) Exit                 "
+            "\n 5) Bulk Import Users    "
+            "\n 6) Enrollment Stats     "
+            "\n 7) Exit                 "
             "\n---------------------------"
             "\nEnter choice: ";
         
@@ -49,8 +79,9 @@ static inline void handle_admin_menu(void) {
         buf[strcspn(buf, "\n")] = '\0'; // Remove newline
         
         choice = atoi(buf);
+        PROBE_ACTION_DISPATCH(ADMIN, choice, 0);
 
-        if (choice == 5) {
+        if (choice == 7) {
             const char *logout_msg = "\n╔═════════════════════════╗"
                                      "\n║      Logging out...     ║"
                                      "\n╚═════════════════════════╝\n";
@@ -195,15 +226,8 @@ static inline void handle_admin_menu(void) {
                 strcpy(db, DB_FACULTY);
             }
         
-            // Show available users
-            print_users(db);
-        
-            // Ask for user ID
-            write(STDOUT_FILENO, "Enter user ID: ", 15);
-            n = read(STDIN_FILENO, buf, sizeof(buf) - 1);
-            if (n <= 0) continue;
-            buf[n] = '\0';
-            buf[strcspn(buf, "\n")] = '\0';
+            // Show available users a page at a time and ask for user ID
+            if (!prompt_user_id(db, buf, sizeof(buf))) continue;
             user_id = atoi(buf);
         
             const char *field_msg = "1) Update Name\n2) Update Email\n3) Update Password\n4) Toggle Active (only for students)\nEnter field: ";
@@ -275,15 +299,8 @@ static inline void handle_admin_menu(void) {
                 strcpy(db, DB_FACULTY);
             }
         
-            // Show available users
-            print_users(db);
-        
-            // Ask for user ID
-            write(STDOUT_FILENO, "Enter user ID: ", 15);
-            n = read(STDIN_FILENO, buf, sizeof(buf) - 1);
-            if (n <= 0) continue;
-            buf[n] = '\0';
-            buf[strcspn(buf, "\n")] = '\0';
+            // Show available users a page at a time and ask for user ID
+            if (!prompt_user_id(db, buf, sizeof(buf))) continue;
             user_id = atoi(buf);
         
             // View user details with proper file locking
@@ -304,6 +321,59 @@ static inline void handle_admin_menu(void) {
         
             write(STDOUT_FILENO, msg, strlen(msg));
         }
+        else if (choice == 5) {
+            // Import many users from a CSV file
+            char usertype, path[256];
+            const char *import_msg = "\n---------------------------"
+                                     "\n     BULK IMPORT USERS     "
+                                     "\n---------------------------\n";
+            write(STDOUT_FILENO, import_msg, strlen(import_msg));
+
+            write(STDOUT_FILENO, "Import Students or Faculty? (s/f): ", 35);
+            n = read(STDIN_FILENO, buf, sizeof(buf) - 1);
+            if (n <= 0) continue;
+            buf[n] = '\0';
+            buf[strcspn(buf, "\n")] = '\0';
+            usertype = buf[0];
+
+            int is_student = (usertype == 's' || usertype == 'S');
+            const char *format = is_student ? "Rows: id,name,email,password[,active]\n"
+                                            : "Rows: id,name,email,password\n";
+            write(STDOUT_FILENO, format, strlen(format));
+
+            write(STDOUT_FILENO, "Enter CSV file path: ", 21);
+            n = read(STDIN_FILENO, path, sizeof(path) - 1);
+            if (n <= 0) continue;
+            path[n] = '\0';
+            path[strcspn(path, "\n")] = '\0';
+
+            ImportReport report;
+            int res = bulk_import_users(is_student ? DB_STUDENTS : DB_FACULTY, path, is_student, &report);
+            if (res == SUCCESS) {
+                printf("\n╔══════════════════════════════════╗"
+                       "\n║ Imported: %-22d ║"
+                       "\n║ Duplicate ids: %-17d ║"
+                       "\n║ Duplicate emails: %-14d ║"
+                       "\n║ Malformed rows: %-16d ║"
+                       "\n╚══════════════════════════════════╝\n",
+                       report.added, report.duplicate_ids, report.duplicate_emails, report.malformed);
+                fflush(stdout);
+            } else {
+                const char *msg = "\n╔═════════════════════════╗"
+                                  "\n║ Import failed           ║"
+                                  "\n╚═════════════════════════╝\n";
+                write(STDOUT_FILENO, msg, strlen(msg));
+            }
+        }
+        else if (choice == 6) {
+            // Live fill rates, served from the shared statistics
+            if (print_enrollment_stats() != SUCCESS) {
+                const char *msg = "\n╔═════════════════════════╗"
+                                  "\n║ Stats unavailable       ║"
+                                  "\n╚═════════════════════════╝\n";
+                write(STDOUT_FILENO, msg, strlen(msg));
+            }
+        }
     }
 }
 
@@ -0,0 +1,348 @@
+#ifndef BATCH_CLIENT_H
+#define BATCH_CLIENT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "../server/types.h"
+#include "../server/utils.h"
+#include "../server/protocol.h"
+#include "../server/session_actions.h"
+
+#define BATCH_WINDOW     32     ///< Default number of requests in flight
+#define BATCH_LINE_LEN   1024
+
+/**
+ * @brief Non-interactive client: runs a list of actions over one connection.
+ *
+ * Usage: client -r ROLE -u EMAIL [-p PASSWORD] [-f FILE]... [-e ACTION]... [-w WINDOW]
+ *               [-l LISTING]... [-R] [-Z]
+ *
+ * ROLE is admin, student or faculty (or 1-3). The password may also come from
+ * the ACADEMIA_PASSWORD environment variable. Actions are lines as accepted
+ * by the server (see session_actions.h), e.g. "enroll 12", taken from -f
+ * files ("-" for stdin) and -e options in command-line order. Blank lines and
+ * lines starting with '#' are skipped.
+ *
+ * Up to WINDOW requests are sent before the first reply is read, so a batch
+ * costs about one round trip per window instead of one per action. Each
+ * result is printed as one tab-separated line:
+ *
+ *     <seq> <TAB> <status code | error> <TAB> <status name | reason> <TAB> <action>
+ *
+ * After the actions, each -l listing (e.g. "roster CS101", see session_actions.h)
+ * is fetched as rows, page by page for the long ones, and rendered here as a
+ * table, or printed as the tab-separated rows themselves with -R. Replies are compressed when large,
+ * unless -Z is given.
+ *
+ * The exit status is 0 if every action got a reply, 1 if the connection or
+ * login failed, 2 if the server refused at least one action line or listing,
+ * and 3 if the server was too busy to log in; stderr then says after how
+ * many ms to try again.
+ */
+
+/**
+ * @brief Returns the name of an action status code.
+ *
+ * Some codes are shared (-3 is also DUPLICATE_ID); the action tells which is meant.
+ */
+static inline const char *batch_status_name(const char *action, int status) {
+    int adds = strncmp(action, "add_", 4) == 0;
+    switch (status) {
+        case SUCCESS:           return "SUCCESS";
+        case FILE_ERROR:        return "FILE_ERROR";
+        case NOT_FOUND:         return "NOT_FOUND";
+        case COURSE_NOT_FOUND:  return adds ? "DUPLICATE_ID" : "COURSE_NOT_FOUND";
+        case ALREADY_ENROLLED:  return "ALREADY_ENROLLED";
+        case NOT_ENROLLED:      return "NOT_ENROLLED";
+        case WAITLISTED:        return "WAITLISTED";
+        case SCHEDULE_CONFLICT: return "SCHEDULE_CONFLICT";
+        case PREREQ_MISSING:    return "PREREQ_MISSING";
+        case PREREQ_CYCLE:      return "PREREQ_CYCLE";
+        default:                return "UNKNOWN";
+    }
+}
+
+/**
+ * @brief Logs in without prompting, following the same exchange as the interactive client.
+ *
+ * @param fd       Connected socket.
+ * @param role     ADMIN, STUDENT or FACULTY.
+ * @param email    Email.
+ * @param password Password.
+ * @param user_id  Receives the user's ID on success, or the ms to wait on LOGIN_BUSY.
+ * @return LOGIN_SUCCESS (1), or the server's failure status (WRONG_PASS, ...),
+ *         LOGIN_BUSY if the server is overloaded, or FAILURE.
+ */
+static inline int client_login(int fd, int role, const char *email, const char *password, int *user_id) {
+    char buf[BATCH_LINE_LEN];
+
+    // Each answer is sent only after its prompt, so the server reads them separately
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    if (n <= 0) return FAILURE;
+    buf[n] = '\0';
+    if ((*user_id = proto_busy_delay(buf)) >= 0) return LOGIN_BUSY;
+    if (write(fd, &role, sizeof(role)) != sizeof(role)) return FAILURE;
+    if (read(fd, buf, sizeof(buf)) <= 0 || write(fd, email, strlen(email)) <= 0) return FAILURE;
+    if (read(fd, buf, sizeof(buf)) <= 0 || write(fd, password, strlen(password)) <= 0) return FAILURE;
+
+    int status;
+    if (frame_read_all(fd, &status, sizeof(status)) != SUCCESS) return FAILURE;
+    if (status == LOGIN_BUSY && frame_read_all(fd, user_id, sizeof(*user_id)) != SUCCESS) return FAILURE;
+    if (status != 1) return status;
+    if (frame_read_all(fd, user_id, sizeof(*user_id)) != SUCCESS) return FAILURE;
+
+    // The welcome line ends with a newline; nothing may be left unread
+    // before the first frame
+    char c;
+    do {
+        if (read(fd, &c, 1) != 1) return FAILURE;
+    } while (c != '\n');
+    return status;
+}
+
+/**
+ * @brief Connects to the server.
+ * @return Socket, or -1 on error.
+ */
+static inline int client_connect(const char *ip, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port) };
+    addr.sin_addr.s_addr = inet_addr(ip);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Actions of a batch, in order.
+ */
+typedef struct {
+    char **lines;
+    int count;
+    int cap;
+} BatchScript;
+
+static inline int batch_script_add(BatchScript *b, const char *line) {
+    while (*line == ' ' || *line == '\t') line++;
+    size_t len = strcspn(line, "\r\n");
+    if (len == 0 || line[0] == '#') return SUCCESS;
+
+    if (b->count == b->cap) {
+        int bigger = b->cap ? b->cap * 2 : 64;
+        char **grown = realloc(b->lines, bigger * sizeof(char *));
+        if (!grown) return FAILURE;
+        b->lines = grown;
+        b->cap = bigger;
+    }
+    b->lines[b->count] = strndup(line, len);
+    return b->lines[b->count++] ? SUCCESS : FAILURE;
+}
+
+static inline int batch_script_load(BatchScript *b, const char *path) {
+    FILE *in = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!in) return FILE_ERROR;
+    char line[BATCH_LINE_LEN];
+    int status = SUCCESS;
+    while (status == SUCCESS && fgets(line, sizeof(line), in)) status = batch_script_add(b, line);
+    if (in != stdin) fclose(in);
+    return status;
+}
+
+static inline void batch_script_free(BatchScript *b) {
+    for (int i = 0; i < b->count; i++) free(b->lines[i]);
+    free(b->lines);
+    memset(b, 0, sizeof(*b));
+}
+
+/**
+ * @brief Sends every action, keeping up to window requests in flight, and
+ *        prints the results in order.
+ *
+ * @return 0, 1 if the connection failed, 2 if an action line was refused.
+ */
+static inline int batch_run(int fd, const BatchScript *b, int window, FILE *out) {
+    int sent = 0, done = 0, refused = 0;
+    while (done < b->count) {
+        while (sent < b->count && sent - done < window) {
+            if (frame_send(fd, FRAME_ACTION, b->lines[sent], strlen(b->lines[sent])) != SUCCESS) return 1;
+            sent++;
+        }
+
+        uint32_t type, len;
+        char *reply;
+        if (frame_recv(fd, &type, &reply, &len) != SUCCESS) return 1;
+        const char *action = b->lines[done];
+        if (type == FRAME_RESULT) {
+            int status = atoi(reply);
+            fprintf(out, "%d\t%d\t%s\t%s\n", done + 1, status, batch_status_name(action, status), action);
+        } else {
+            fprintf(out, "%d\terror\t%s\t%s\n", done + 1, reply, action);
+            refused = 1;
+        }
+        free(reply);
+        done++;
+    }
+    fflush(out);
+    return refused ? 2 : 0;
+}
+
+/**
+ * @brief Fetches a listing as rows and prints it, rendered unless raw.
+ *
+ * A paged listing is fetched one page per request, following the reply's
+ * next token, and each page is printed as it arrives.
+ *
+ * @return 0, 1 if the connection failed, 2 if the server refused the listing.
+ */
+static inline int batch_list(int fd, const char *listing, int raw, FILE *out) {
+    char name[64];
+    snprintf(name, sizeof(name), "%.*s", (int)strcspn(listing, " \t"), listing);
+    const ListingOp *op = listing_find(name);
+
+    char token[CURSOR_TOKEN_LEN] = "";
+    RenderBuf table = {0};
+    int result = 0, pages = 0;
+    do {
+        FrameBuf request = {0};
+        uint32_t type, len;
+        char *reply = NULL;
+        int status = token[0] ? framebuf_printf(&request, "0 rows %s page=%s", listing, token)
+                              : framebuf_printf(&request, "0 rows %s", listing);
+        if (status == SUCCESS) status = frame_send(fd, FRAME_LIST, request.data, request.len);
+        if (status == SUCCESS) status = frame_recv(fd, &type, &reply, &len);
+        framebuf_free(&request);
+        if (status != SUCCESS) {
+            result = 1;
+            break;
+        }
+
+        char *rows = strchr(reply, '\n');
+        if (type != FRAME_LISTING || !rows || !op) {
+            fprintf(stderr, "%s: %s\n", listing, type == FRAME_ERROR ? reply : "unexpected reply");
+            result = 2;
+        } else if (atoi(reply) != SUCCESS) {
+            fprintf(stderr, "%s: %s\n", listing, batch_status_name(listing, atoi(reply)));
+            result = 2;
+        } else {
+            *rows++ = '\0';
+            char *next = strstr(reply, " next=");
+            snprintf(token, sizeof(token), "%s", next ? next + 6 : "");
+            if (raw) {
+                fputs(rows, out);
+            } else {
+                if (!pages) render_listing_begin(&table, op->box, op->title);
+                render_rows(&table, op->box, rows);
+                fwrite(table.data, 1, table.len, out);
+                table.len = 0;
+            }
+            pages++;
+        }
+        free(reply);
+    } while (!result && token[0]);
+
+    if (pages && !raw) {
+        render_rule(&table, op->box, RULE_BOTTOM_COLUMNS);
+        fwrite(table.data, 1, table.len, out);
+    }
+    render_free(&table);
+    fflush(out);
+    return result;
+}
+
+static inline int batch_parse_role(const char *s) {
+    if (strcmp(s, "admin") == 0) return ADMIN;
+    if (strcmp(s, "student") == 0) return STUDENT;
+    if (strcmp(s, "faculty") == 0) return FACULTY;
+    int role = atoi(s);
+    return role >= ADMIN && role <= FACULTY ? role : 0;
+}
+
+/**
+ * @brief Entry point of the batch mode; see the usage above.
+ * @return Process exit status.
+ */
+static inline int batch_main(int argc, char **argv, const char *ip, int port) {
+    int role = 0, window = BATCH_WINDOW, raw = 0, compress = 1, opt;
+    const char *email = NULL, *password = getenv("ACADEMIA_PASSWORD");
+    BatchScript script = {0}, listings = {0};
+
+    while ((opt = getopt(argc, argv, "r:u:p:f:e:w:l:RZ")) != -1) {
+        switch (opt) {
+            case 'R': raw = 1; break;
+            case 'Z': compress = 0; break;
+            case 'l':
+                if (batch_script_add(&listings, optarg) != SUCCESS) {
+                    batch_script_free(&script);
+                    batch_script_free(&listings);
+                    return 1;
+                }
+                break;
+            case 'r': role = batch_parse_role(optarg); break;
+            case 'u': email = optarg; break;
+            case 'p': password = optarg; break;
+            case 'w': window = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+            case 'e':
+            case 'f':
+                if ((opt == 'e' ? batch_script_add(&script, optarg) : batch_script_load(&script, optarg)) != SUCCESS) {
+                    fprintf(stderr, "Cannot read %s\n", optarg);
+                    batch_script_free(&script);
+                    batch_script_free(&listings);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr, "Usage: %s -r ROLE -u EMAIL [-p PASSWORD] [-f FILE]... [-e ACTION]... [-w WINDOW]"
+                                " [-l LISTING]... [-R] [-Z]\n", argv[0]);
+                batch_script_free(&script);
+                batch_script_free(&listings);
+                return 1;
+        }
+    }
+    if (!role || !email || !password) {
+        fprintf(stderr, "A role (-r), email (-u) and password (-p or ACADEMIA_PASSWORD) are required\n");
+        batch_script_free(&script);
+        batch_script_free(&listings);
+        return 1;
+    }
+
+    int fd = client_connect(ip, port);
+    if (fd < 0) {
+        fprintf(stderr, "Connection failed\n");
+        batch_script_free(&script);
+        batch_script_free(&listings);
+        return 1;
+    }
+
+    int user_id = 0;
+    int status = client_login(fd, role, email, password, &user_id);
+    if (status == 1 && compress && frame_negotiate(fd, FRAME_COMPRESS_MIN) != SUCCESS) status = FAILURE;
+    if (status == LOGIN_BUSY) fprintf(stderr, "Server busy, retry after %d ms\n", user_id);
+    else if (status != 1) fprintf(stderr, "Login failed (%d)\n", status);
+    if (status != 1) {
+        close(fd);
+        batch_script_free(&script);
+        batch_script_free(&listings);
+        return status == LOGIN_BUSY ? 3 : 1;
+    }
+
+    int result = batch_run(fd, &script, window, stdout);
+    for (int i = 0; i < listings.count && result != 1; i++) {
+        int listed = batch_list(fd, listings.lines[i], raw, stdout);
+        if (listed > result) result = listed;
+    }
+    if (result == 1) fprintf(stderr, "Connection lost\n");
+    close(fd);
+    batch_script_free(&script);
+    batch_script_free(&listings);
+    return result;
+}
+
+#endif // BATCH_CLIENT_H
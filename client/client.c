@@ -7,6 +7,7 @@
 #include "admin_client.h"
 #include "student_client.h"
 #include "faculty_client.h"
+#include "batch_client.h"
 #include "../server/utils.h" // Add this include
 
 #define LOGIN_SUCCESS 1
@@ -14,6 +15,7 @@
 #define WRONG_USER -2
 #define DEACTIVATED -3
 #define INCORRECT_ROLE -4
+#define LOGIN_BUSY -5
 
 #define SERVER_IP "127.0.0.1"
 #define SERVER_PORT 8080
@@ -21,15 +23,23 @@
 #define CLIENT_BUF_SIZE 1024
 
 // Update the main function to use system calls
-int main() {
+int main(int argc, char **argv) {
     int sockfd;
     struct sockaddr_in serv_addr;
     char buffer[CLIENT_BUF_SIZE];
     int role;
-    
+
+    // Any option selects the non-interactive batch mode
+    if (argc > 1) return batch_main(argc, argv, SERVER_IP, SERVER_PORT);
+
     // Clear the screen
     system("clear");
 
+    // Finish any multi-table write a crash interrupted before touching the tables,
+    // and recount the statistics if it also cut off their update
+    txn_recover();
+    stats_recover();
+
     // Print welcome banner
     const char *banner = "\n╔═══════════════════════════════════════════════════════════════════╗"
                          "\n║                                                                   ║"
@@ -66,6 +76,20 @@ int main() {
         return -1;
     }
     buffer[bytes_read] = '\0';
+
+    // Turned away while the server is overloaded
+    int busy = proto_busy_delay(buffer);
+    if (busy >= 0) {
+        char busy_msg[512];
+        snprintf(busy_msg, sizeof(busy_msg),
+                 "\n╔═════════════════════════════════════════════════════════╗"
+                 "\n║ Server is busy! Please try again in %-3d seconds.        ║"
+                 "\n╚═════════════════════════════════════════════════════════╝\n",
+                 (busy + 999) / 1000);
+        write(STDOUT_FILENO, busy_msg, strlen(busy_msg));
+        close(sockfd);
+        return -1;
+    }
     write(STDOUT_FILENO, "\n", 1);
     write(STDOUT_FILENO, buffer, bytes_read);
 
@@ -162,6 +186,10 @@ int main() {
             const char *welcome_footer = "╚═════════════════════════════════════════════════════════╝\n";
             write(STDOUT_FILENO, welcome_footer, strlen(welcome_footer));
         }
+
+        // Keep the catalogue in sync through the server from now on, with
+        // large deltas compressed
+        if (frame_negotiate(sockfd, FRAME_COMPRESS_MIN) == SUCCESS) catalogue_attach(sockfd);
     } else if (status == INCORRECT_ROLE) {
         const char *invalid_role = "\n╔═════════════════════════╗"
                                   "\n║ Invalid role selected!  ║"
@@ -185,6 +213,18 @@ int main() {
                 write(STDOUT_FILENO, wrong_user, strlen(wrong_user));
                 break;
             }
+            case LOGIN_BUSY: {
+                int wait = 0;
+                read(sockfd, &wait, sizeof(wait));
+                char busy_msg[512];
+                snprintf(busy_msg, sizeof(busy_msg),
+                         "\n╔═════════════════════════════════════════════════════════╗"
+                         "\n║ Too many logins right now. Try again in %-3d seconds.    ║"
+                         "\n╚═════════════════════════════════════════════════════════╝\n",
+                         (wait + 999) / 1000);
+                write(STDOUT_FILENO, busy_msg, strlen(busy_msg));
+                break;
+            }
             case DEACTIVATED: {
                 const char *deactivated = "\n╔═════════════════════════╗"
                                          "\n║ Account is deactivated! ║"
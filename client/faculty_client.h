@@ -6,12 +6,105 @@
 #include <string.h>
 #include <unistd.h>
 #include "../server/faculty_actions.h"
+#include "../server/cursor.h"
+#include "../server/render.h"
 #include "../server/utils.h"
+#include "../server/probes.h"
+#include "search_client.h"
 
 #define DB_COURSES "../database/courses.csv"
 #define DB_STUDENTS "../database/students.csv"
 #define DB_FACULTY "../database/faculty.csv"
 
+/**
+ * @brief Lists the faculty's own courses a page at a time and lets them pick one.
+ *
+ * @param faculty_id ID of the faculty.
+ * @param title      Heading of the list.
+ * @param prompt     Question to ask, without the trailing colon.
+ * @param id         Receives the chosen course ID.
+ * @param code       Receives the chosen course code (32 bytes).
+ * @return 1 if a course was chosen, 0 otherwise (the reason is printed).
+ */
+static inline int select_own_course(int faculty_id, const char *title, const char *prompt, int *id, char *code) {
+    ListCursor cursor;
+    cursor_reset(&cursor);
+    char buf[64];
+
+    for (int first = 1; ; first = 0) {
+        // The faculty's courses come straight from the courses-by-faculty index
+        const FacultyIndex *ix = faculty_index_get();
+        if (!ix) {
+            const char *err_msg = "\n╔═════════════════════════════════╗"
+                                  "\n║ Could not open course database  ║"
+                                  "\n╚═════════════════════════════════╝\n";
+            write(STDOUT_FILENO, err_msg, strlen(err_msg));
+            return 0;
+        }
+        const FacultyCourse *own = NULL;
+        int own_count = faculty_courses(ix, faculty_id, &own);
+
+        // Resume after the last course shown if the table changed since
+        int start = cursor.started ? (int)cursor.position : 0;
+        if (cursor.started && cursor.version != ix->generation) {
+            for (int i = 0; i < own_count; i++) {
+                if (own[i].id == cursor.last_id) start = i + 1;
+            }
+        }
+        const FacultyCourse *page = own + start;
+        int page_count = own_count - start < LIST_PAGE_SIZE ? own_count - start : LIST_PAGE_SIZE;
+        if (page_count < 0) page_count = 0;
+        cursor.version = ix->generation;
+        cursor.position = start + page_count;
+        cursor.started = 1;
+        cursor.done = start + page_count >= own_count;
+        if (page_count > 0) cursor.last_id = page[page_count - 1].id;
+
+        if (page_count == 0) {
+            const char *no_courses_msg = first ? "\n╔═════════════════════════════════╗"
+                                                 "\n║ You are not assigned to any     ║"
+                                                 "\n║ courses.                        ║"
+                                                 "\n╚═════════════════════════════════╝\n"
+                                               : "\n╔═════════════════════════════════╗"
+                                                 "\n║ No more courses.                ║"
+                                                 "\n╚═════════════════════════════════╝\n";
+            write(STDOUT_FILENO, no_courses_msg, strlen(no_courses_msg));
+            return 0;
+        }
+
+        RenderBuf out = {0};
+        render_printf(&out, "\n-------------------------------------"
+                           "\n     %-27s "
+                           "\n-------------------------------------\n", title);
+        for (int i = 0; i < page_count; i++) {
+            render_printf(&out, "%-2d. %-25s (%s)\n", i + 1, faculty_index_str(ix, page[i].name),
+                          faculty_index_str(ix, page[i].code));
+        }
+        render_printf(&out, "-------------------------------------\n%s%s", prompt,
+                      cursor.done ? ": " : " (n for more courses): ");
+        render_flush(&out, STDOUT_FILENO);
+        render_free(&out);
+
+        ssize_t n = read(STDIN_FILENO, buf, sizeof(buf) - 1);
+        if (n <= 0) return 0;
+        buf[n] = '\0';
+        buf[strcspn(buf, "\n")] = '\0'; // Remove newline
+        if (!cursor.done && strcmp(buf, "n") == 0) continue;
+
+        int sel = atoi(buf);
+        if (sel < 1 || sel > page_count) {
+            const char *invalid_sel_msg = "\n╔═════════════════════════╗"
+                                          "\n║ Invalid selection!      ║"
+                                          "\n╚═════════════════════════╝\n";
+            write(STDOUT_FILENO, invalid_sel_msg, strlen(invalid_sel_msg));
+            return 0;
+        }
+        *id = page[sel - 1].id;
+        snprintf(code, 32, "%s", faculty_index_str(ix, page[sel - 1].code));
+        return 1;
+    }
+}
+
 /**
  * @brief Displays the faculty menu, gathers inputs, and invokes server functions.
  *
@@ -36,7 +129,8 @@ static inline void handle_faculty_menu(int faculty_id) {
             "\n 2) Remove Course        "
             "\n 3) View Enrollments     "
             "\n 4) Change Password      "
-            "\n 5) Exit                 "
+            "\n 5) Search Courses       "
+            "\n 6) Exit                 "
             "\n---------------------------"
             "\nEnter choice: ";
         write(STDOUT_FILENO, menu, strlen(menu));
@@ -47,7 +141,8 @@ static inline void handle_faculty_menu(int faculty_id) {
         buf[strcspn(buf, "\n")] = '\0'; // Remove newline
 
         choice = atoi(buf);
-        if (choice == 5) {
+        PROBE_ACTION_DISPATCH(FACULTY, choice, faculty_id);
+        if (choice == 6) {
             const char *logout_msg = "\n╔═════════════════════════╗"
                                      "\n║      Logging out...     ║"
                                      "\n╚═════════════════════════╝\n";
@@ -97,8 +192,33 @@ static inline void handle_faculty_menu(int faculty_id) {
             buf[strcspn(buf, "\n")] = '\0'; // Remove newline
             credits = atoi(buf);
 
-            // Add course to the database
-            int result = add_course(id, code, name, capacity, credits, faculty_id);
+            const char *times_prompt = "Enter meeting times (e.g. Mon 09:00-10:30, Wed 09:00-10:30), blank for none: ";
+            write(STDOUT_FILENO, times_prompt, strlen(times_prompt));
+            n = read(STDIN_FILENO, buf, sizeof(buf) - 1);
+            if (n <= 0) continue;
+            buf[n] = '\0';
+            buf[strcspn(buf, "\n")] = '\0'; // Remove newline
+
+            TimeSlot slots[MAX_SLOTS_PER_COURSE];
+            int slot_count = schedule_parse(buf, slots, MAX_SLOTS_PER_COURSE);
+            if (slot_count < 0) {
+                const char *err_msg = "\n╔═════════════════════════╗"
+                                      "\n║ Invalid meeting times   ║"
+                                      "\n╚═════════════════════════╝\n";
+                write(STDOUT_FILENO, err_msg, strlen(err_msg));
+                continue;
+            }
+
+            char requires[512];
+            const char *prereq_prompt = "Enter prerequisite course codes (comma-separated), blank for none: ";
+            write(STDOUT_FILENO, prereq_prompt, strlen(prereq_prompt));
+            n = read(STDIN_FILENO, requires, sizeof(requires) - 1);
+            if (n <= 0) continue;
+            requires[n] = '\0';
+            requires[strcspn(requires, "\n")] = '\0'; // Remove newline
+
+            // Add the course together with its meeting times and prerequisites
+            int result = add_course(id, code, name, capacity, credits, faculty_id, slots, slot_count, requires);
             const char *msg;
             if (result == SUCCESS)
                 msg = "\n╔═════════════════════════╗"
@@ -108,107 +228,24 @@ static inline void handle_faculty_menu(int faculty_id) {
                 msg = "\n╔═════════════════════════╗"
                       "\n║ Error: ID already exists ║"
                       "\n╚═════════════════════════╝\n";
+            else if (result == PREREQ_CYCLE)
+                msg = "\n╔═════════════════════════╗"
+                      "\n║ Prerequisites form a     ║"
+                      "\n║ cycle; course not added  ║"
+                      "\n╚═════════════════════════╝\n";
             else
                 msg = "\n╔═════════════════════════╗"
                       "\n║ Error adding course      ║"
                       "\n╚═════════════════════════╝\n";
             write(STDOUT_FILENO, msg, strlen(msg));
         } else if (choice == 2) {
-            int courses_fd = open(DB_COURSES, O_RDONLY);
-            if (courses_fd < 0) {
-                const char *err_msg = "\n╔═════════════════════════════════╗"
-                                      "\n║ Could not open course database  ║"
-                                      "\n╚═════════════════════════════════╝\n";
-                write(STDOUT_FILENO, err_msg, strlen(err_msg));
+            int course_id;
+            char course_code[32];
+            if (!select_own_course(faculty_id, "YOUR OFFERED COURSES", "Enter number of the course to remove",
+                                   &course_id, course_code)) {
                 continue;
             }
 
-            // Acquire shared lock for reading
-            struct flock lock;
-            memset(&lock, 0, sizeof(lock));
-            lock.l_type = F_RDLCK;
-            lock.l_whence = SEEK_SET;
-            lock.l_start = 0;
-            lock.l_len = 0; // Lock the entire file
-            
-            if (fcntl(courses_fd, F_SETLKW, &lock) == -1) {
-                perror("fcntl lock");
-                close(courses_fd);
-                continue;
-            }
-
-            char line[512];
-            int course_ids[50];
-            char course_codes[50][32];
-            char course_names[50][64];
-            int course_count = 0;
-            ssize_t bytes_read;
-
-            // Skip header if present
-            bytes_read = read_line(courses_fd, line, sizeof(line));
-            if (bytes_read > 0 && strncmp(line, "id,", 3) != 0) {
-                lseek(courses_fd, 0, SEEK_SET);
-            }
-
-            while ((bytes_read = read_line(courses_fd, line, sizeof(line))) > 0) {
-                int id, cap, enr, cred, fid;
-                char code[32], name[64];
-
-                if (sscanf(line, "%d,%31[^,],%63[^,],%d,%d,%d,%d",
-                           &id, code, name, &cap, &enr, &cred, &fid) == 7) {
-                    if (fid == faculty_id) {
-                        course_ids[course_count] = id;
-                        strncpy(course_codes[course_count], code, sizeof(course_codes[0]));
-                        strncpy(course_names[course_count], name, sizeof(course_names[0]));
-                        course_count++;
-                    }
-                }
-            }
-
-            // Release lock
-            lock.l_type = F_UNLCK;
-            fcntl(courses_fd, F_SETLK, &lock);
-            close(courses_fd);
-
-            if (course_count == 0) {
-                const char *no_courses_msg = "\n╔═════════════════════════════════╗"
-                                             "\n║ You are not assigned to any     ║"
-                                             "\n║ courses.                        ║"
-                                             "\n╚═════════════════════════════════╝\n";
-                write(STDOUT_FILENO, no_courses_msg, strlen(no_courses_msg));
-                continue;
-            }
-
-            const char *list_msg = "\n-------------------------------------"
-                                   "\n     YOUR OFFERED COURSES        "
-                                   "\n-------------------------------------\n";
-            write(STDOUT_FILENO, list_msg, strlen(list_msg));
-
-            for (int i = 0; i < course_count; ++i) {
-                char course_line[256];
-                int len = snprintf(course_line, sizeof(course_line), 
-                                  "%d. %-25s (%s)\n", i + 1, course_names[i], course_codes[i]);
-                write(STDOUT_FILENO, course_line, len);
-            }
-            const char *end_list_msg = "-------------------------------------\n";
-            write(STDOUT_FILENO, end_list_msg, strlen(end_list_msg));
-
-            write(STDOUT_FILENO, "Enter number of the course to remove: ", 39);
-            n = read(STDIN_FILENO, buf, sizeof(buf) - 1);
-            if (n <= 0) continue;
-            buf[n] = '\0';
-            buf[strcspn(buf, "\n")] = '\0'; // Remove newline
-            int sel = atoi(buf);
-
-            if (sel < 1 || sel > course_count) {
-                const char *invalid_sel_msg = "\n╔═════════════════════════╗"
-                                              "\n║ Invalid selection!      ║"
-                                              "\n╚═════════════════════════╝\n";
-                write(STDOUT_FILENO, invalid_sel_msg, strlen(invalid_sel_msg));
-                continue;
-            }
-
-            int course_id = course_ids[sel - 1];
             int result = remove_course(course_id, faculty_id);
             const char *msg;
             if (result == SUCCESS)
@@ -222,102 +259,14 @@ static inline void handle_faculty_menu(int faculty_id) {
                       "\n╚═════════════════════════════════╝\n";
             write(STDOUT_FILENO, msg, strlen(msg));
         } else if (choice == 3) {
-            int courses_fd = open(DB_COURSES, O_RDONLY);
-            if (courses_fd < 0) {
-                const char *err_msg = "\n╔═════════════════════════════════╗"
-                                      "\n║ Could not open course database  ║"
-                                      "\n╚═════════════════════════════════╝\n";
-                write(STDOUT_FILENO, err_msg, strlen(err_msg));
-                continue;
-            }
-
-            // Acquire shared lock for reading
-            struct flock lock;
-            memset(&lock, 0, sizeof(lock));
-            lock.l_type = F_RDLCK;
-            lock.l_whence = SEEK_SET;
-            lock.l_start = 0;
-            lock.l_len = 0; // Lock the entire file
-            
-            if (fcntl(courses_fd, F_SETLKW, &lock) == -1) {
-                perror("fcntl lock");
-                close(courses_fd);
-                continue;
-            }
-
-            char line[512];
-            char course_codes[10][32];
-            char course_names[10][64];
-            int course_count = 0;
-            ssize_t bytes_read;
-
-            // Skip header if present
-            bytes_read = read_line(courses_fd, line, sizeof(line));
-            if (bytes_read > 0 && strncmp(line, "id,", 3) != 0) {
-                lseek(courses_fd, 0, SEEK_SET);
-            }
-
-            while ((bytes_read = read_line(courses_fd, line, sizeof(line))) > 0) {
-                int id, cap, enr, cred, fid;
-                char code[32], name[64];
-
-                if (sscanf(line, "%d,%31[^,],%63[^,],%d,%d,%d,%d",
-                           &id, code, name, &cap, &enr, &cred, &fid) == 7) {
-                    if (fid == faculty_id) {
-                        strncpy(course_codes[course_count], code, sizeof(course_codes[0]));
-                        strncpy(course_names[course_count], name, sizeof(course_names[0]));
-                        course_count++;
-                    }
-                }
-            }
-
-            // Release lock
-            lock.l_type = F_UNLCK;
-            fcntl(courses_fd, F_SETLK, &lock);
-            close(courses_fd);
-
-            if (course_count == 0) {
-                const char *no_courses_msg = "\n╔═════════════════════════════════╗"
-                                             "\n║ You are not assigned to any     ║"
-                                             "\n║ courses.                        ║"
-                                             "\n╚═════════════════════════════════╝\n";
-                write(STDOUT_FILENO, no_courses_msg, strlen(no_courses_msg));
-                continue;
-            }
-
-            const char *list_msg = "\n-------------------------------------"
-                                   "\n     YOUR TEACHING COURSES       "
-                                   "\n-------------------------------------\n";
-            write(STDOUT_FILENO, list_msg, strlen(list_msg));
-
-            for (int i = 0; i < course_count; i++) {
-                char course_line[256];
-                int len = snprintf(course_line, sizeof(course_line), 
-                                  "%-2d. %-25s (%s)\n", i + 1, course_names[i], course_codes[i]);
-                write(STDOUT_FILENO, course_line, len);
-            }
-            const char *end_list_msg = "\n-------------------------------------"
-                                       "\n     END OF COURSE LIST       "
-                                       "\n-------------------------------------\n";
-            
-            write(STDOUT_FILENO, end_list_msg, strlen(end_list_msg));
-
-            write(STDOUT_FILENO, "Enter number of the course to view enrollments: ", 49);
-            n = read(STDIN_FILENO, buf, sizeof(buf) - 1);
-            if (n <= 0) continue;
-            buf[n] = '\0';
-            buf[strcspn(buf, "\n")] = '\0'; // Remove newline
-            int sel = atoi(buf);
-
-            if (sel < 1 || sel > course_count) {
-                const char *invalid_sel_msg = "\n╔═════════════════════════╗"
-                                              "\n║ Invalid selection!      ║"
-                                              "\n╚═════════════════════════╝\n";
-                write(STDOUT_FILENO, invalid_sel_msg, strlen(invalid_sel_msg));
+            int course_id;
+            char course_code[32];
+            if (!select_own_course(faculty_id, "YOUR TEACHING COURSES", "Enter number of the course to view enrollments",
+                                   &course_id, course_code)) {
                 continue;
             }
 
-            view_enrollments(faculty_id, course_codes[sel - 1]);
+            view_enrollments(faculty_id, course_code);
         } else if (choice == 4) {
             char newpass[100];
             const char *change_pass_msg = "\n---------------------------"
@@ -342,6 +291,8 @@ static inline void handle_faculty_menu(int faculty_id) {
                       "\n║ Failed to change password║"
                       "\n╚═════════════════════════╝\n";
             write(STDOUT_FILENO, msg, strlen(msg));
+        } else if (choice == 5) {
+            handle_course_search();
         } else {
             const char *invalid_choice_msg = "\n╔═════════════════════════╗"
                                              "\n║ Invalid choice!         ║"
@@ -0,0 +1,700 @@
+#ifndef PORTAL_H
+#define PORTAL_H
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "../server/types.h"
+#include "../server/utils.h"
+#include "../server/protocol.h"
+
+/**
+ * @brief Asynchronous client library for programs that talk to the server on
+ *        behalf of many users (e.g. a web portal gateway). Usable from C and C++.
+ *
+ * A Portal keeps a small pool of connections open in framed mode (see
+ * protocol.h). Users are logged in as sessions with portal_login(); every
+ * session is pinned to one connection, and any number of sessions share it.
+ * Requests are queued with portal_submit() and sent by portal_poll(), which
+ * also reads the replies and calls each request's callback with the action's
+ * status code. Nothing blocks except portal_poll() and portal_wait(), and
+ * only for as long as they are told to.
+ *
+ *     Portal *p = portal_open("127.0.0.1", 8080, 4);
+ *     int s = portal_login(p, STUDENT, "a@x", "p", NULL, NULL);
+ *     PortalFuture f = PORTAL_FUTURE_INIT;
+ *     portal_submit(p, s, "enroll 12", portal_future_cb, &f);
+ *     portal_wait(p, &f, 1000);   // f.status is SUCCESS, WAITLISTED, ...
+ *
+ * Connections are opened with a non-blocking connect and reopened after a
+ * failure, with backoff. On a new connection every session of it is logged in
+ * again before its queued requests are sent, so sessions survive server
+ * restarts. Requests that were already sent when a connection dropped may or
+ * may not have run; they complete with PORTAL_DISCONNECTED rather than being
+ * repeated.
+ *
+ * An overloaded server may turn a connection away, which then is reopened no
+ * sooner than the server asked, or refuse a login with PORTAL_BUSY. The
+ * session is then not logged in; portal_retry_after() says when to try again.
+ *
+ * Callbacks run inside portal_poll(); they may submit further requests or
+ * log sessions in or out, but must not call portal_close(). Whatever a
+ * callback's arg points to must stay valid until the callback has run;
+ * portal_close() completes every outstanding request with PORTAL_DISCONNECTED.
+ */
+
+#define PORTAL_DISCONNECTED  -100   ///< The connection dropped before the reply arrived
+#define PORTAL_REFUSED       -101   ///< The server refused the request line (FRAME_ERROR)
+#define PORTAL_BUSY          -102   ///< The server is overloaded; log in again after portal_retry_after()
+#define PORTAL_BACKOFF_MIN   100    ///< First reconnect delay, in ms
+#define PORTAL_BACKOFF_MAX   5000
+#define PORTAL_READ_CHUNK    65536
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Receives a request's result: the action's status code, the user id
+ *        for a login, or PORTAL_DISCONNECTED / PORTAL_REFUSED.
+ */
+typedef void (*PortalCallback)(int status, void *arg);
+
+enum { PORTAL_CONN_DOWN, PORTAL_CONN_CONNECTING, PORTAL_CONN_UP };
+enum { PORTAL_SESSION_FREE, PORTAL_SESSION_LOGGING_IN, PORTAL_SESSION_UP, PORTAL_SESSION_FAILED };
+
+typedef struct PortalRequest {
+    struct PortalRequest *next;
+    uint32_t type;              ///< FRAME_LOGIN, FRAME_LOGOUT or FRAME_SESSION_ACTION
+    int session;                ///< Handle of the session
+    unsigned generation;        ///< Of the session when the request was made
+    char *payload;
+    uint32_t len;
+    PortalCallback cb;
+    void *arg;
+} PortalRequest;
+
+typedef struct {
+    PortalRequest *head;
+    PortalRequest *tail;
+} PortalQueue;
+
+/**
+ * @brief One connection of the pool.
+ */
+typedef struct {
+    int fd;
+    int state;
+    int backoff_ms;
+    long long retry_at;         ///< When a DOWN connection is tried again (ms, monotonic)
+    size_t skip;                ///< Bytes of the role prompt still to discard
+    FrameBuf out;               ///< Encoded frames not yet written
+    size_t out_sent;
+    FrameBuf in;                ///< Bytes read but not yet parsed
+    size_t in_pos;
+    PortalQueue queued;         ///< Requests not yet encoded into out
+    PortalQueue sent;           ///< Requests awaiting a reply, in order
+} PortalConn;
+
+/**
+ * @brief A user logged in through the portal.
+ */
+typedef struct {
+    int state;
+    int role;
+    int user_id;
+    unsigned generation;        ///< Bumped each time the slot is reused
+    int retry_ms;               ///< Delay the server asked for with the last PORTAL_BUSY
+    char *email;
+    char *password;
+    PortalCallback login_cb;    ///< Called once, when the first login attempt is answered
+    void *login_arg;
+} PortalSession;
+
+typedef struct {
+    struct sockaddr_in addr;
+    PortalConn *conns;
+    int conn_count;
+    PortalSession *sessions;    ///< Indexed by handle; handle % conn_count is the connection
+    int session_count;
+    int *free_handles;
+    int free_count;
+} Portal;
+
+/**
+ * @brief Result slot for callers that wait instead of using callbacks.
+ */
+typedef struct {
+    int done;
+    int status;
+} PortalFuture;
+
+#define PORTAL_FUTURE_INIT { 0, 0 }
+
+static inline void portal_future_cb(int status, void *arg) {
+    PortalFuture *f = (PortalFuture *)arg;
+    f->status = status;
+    f->done = 1;
+}
+
+static inline long long portal_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static inline void portal_queue_push(PortalQueue *q, PortalRequest *r) {
+    r->next = NULL;
+    if (q->tail) q->tail->next = r;
+    else q->head = r;
+    q->tail = r;
+}
+
+static inline PortalRequest *portal_queue_pop(PortalQueue *q) {
+    PortalRequest *r = q->head;
+    if (r) {
+        q->head = r->next;
+        if (!q->head) q->tail = NULL;
+    }
+    return r;
+}
+
+static inline void portal_request_free(PortalRequest *r) {
+    free(r->payload);
+    free(r);
+}
+
+/**
+ * @brief Builds a request; the payload is formatted like printf.
+ * @return The request, or NULL if out of memory.
+ */
+static inline PortalRequest *portal_request_new(const Portal *p, uint32_t type, int session,
+                                                PortalCallback cb, void *arg, const char *fmt, ...) {
+    PortalRequest *r = (PortalRequest *)calloc(1, sizeof(PortalRequest));
+    if (!r) return NULL;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    r->payload = n >= 0 ? (char *)malloc(n + 1) : NULL;
+    if (!r->payload) {
+        free(r);
+        return NULL;
+    }
+    va_start(ap, fmt);
+    vsnprintf(r->payload, n + 1, fmt, ap);
+    va_end(ap);
+    r->len = n;
+    r->type = type;
+    r->session = session;
+    r->generation = p->sessions[session].generation;
+    r->cb = cb;
+    r->arg = arg;
+    return r;
+}
+
+/**
+ * @brief Session number of a handle on its connection.
+ */
+static inline int portal_wire_session(const Portal *p, int handle) {
+    return handle / p->conn_count;
+}
+
+static inline PortalRequest *portal_login_request(const Portal *p, int handle) {
+    const PortalSession *s = &p->sessions[handle];
+    return portal_request_new(p, FRAME_LOGIN, handle, NULL, NULL, "%d %d \"%s\" \"%s\"",
+                              portal_wire_session(p, handle), s->role, s->email, s->password);
+}
+
+/**
+ * @brief Closes a connection after an error and schedules a reconnect.
+ *
+ * Requests already sent complete with PORTAL_DISCONNECTED; queued requests
+ * wait for the next connection. Logins are not kept: every session is logged
+ * in again when the connection comes back.
+ */
+static inline void portal_conn_down(PortalConn *c) {
+    if (c->fd >= 0) close(c->fd);
+    c->fd = -1;
+    c->state = PORTAL_CONN_DOWN;
+    c->retry_at = portal_now_ms() + c->backoff_ms;
+    c->backoff_ms = c->backoff_ms * 2 > PORTAL_BACKOFF_MAX ? PORTAL_BACKOFF_MAX : c->backoff_ms * 2;
+    c->out.len = c->out_sent = 0;
+    c->in.len = c->in_pos = 0;
+
+    PortalRequest *r;
+    while ((r = portal_queue_pop(&c->sent))) {
+        if (r->type == FRAME_SESSION_ACTION && r->cb) r->cb(PORTAL_DISCONNECTED, r->arg);
+        portal_request_free(r);
+    }
+}
+
+/**
+ * @brief Starts a new connection: sends the framed-mode role answer, then
+ *        logs in every session of the connection.
+ */
+static inline void portal_conn_start(Portal *p, int index) {
+    PortalConn *c = &p->conns[index];
+    c->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (c->fd < 0) {
+        portal_conn_down(c);
+        return;
+    }
+    if (connect(c->fd, (struct sockaddr *)&p->addr, sizeof(p->addr)) == 0) {
+        c->state = PORTAL_CONN_UP;
+        c->backoff_ms = PORTAL_BACKOFF_MIN;
+    } else if (errno == EINPROGRESS) {
+        c->state = PORTAL_CONN_CONNECTING;
+    } else {
+        portal_conn_down(c);
+        return;
+    }
+
+    int role = ROLE_FRAMED;
+    c->skip = sizeof(PROTO_ROLE_PROMPT);
+    if (framebuf_reserve(&c->out, sizeof(role)) != SUCCESS) {
+        portal_conn_down(c);
+        return;
+    }
+    memcpy(c->out.data, &role, sizeof(role));
+    c->out.len = sizeof(role);
+
+    // Logins and logouts still queued are superseded by the replay below
+    PortalQueue keep = { NULL, NULL };
+    PortalRequest *r;
+    while ((r = portal_queue_pop(&c->queued))) {
+        if (r->type == FRAME_SESSION_ACTION) portal_queue_push(&keep, r);
+        else portal_request_free(r);
+    }
+
+    for (int h = index; h < p->session_count; h += p->conn_count) {
+        int state = p->sessions[h].state;
+        if (state != PORTAL_SESSION_LOGGING_IN && state != PORTAL_SESSION_UP) continue;
+        PortalRequest *login = portal_login_request(p, h);
+        if (login) portal_queue_push(&c->queued, login);
+    }
+    while ((r = portal_queue_pop(&keep))) portal_queue_push(&c->queued, r);
+}
+
+/**
+ * @brief Encodes queued requests into the output buffer.
+ */
+static inline int portal_conn_encode(PortalConn *c) {
+    PortalRequest *r;
+    while ((r = portal_queue_pop(&c->queued))) {
+        if (framebuf_reserve(&c->out, sizeof(FrameHeader) + r->len) != SUCCESS) {
+            r->next = c->queued.head;
+            c->queued.head = r;
+            if (!c->queued.tail) c->queued.tail = r;
+            return FAILURE;
+        }
+        FrameHeader h = { htonl(r->type), htonl(r->len) };
+        memcpy(c->out.data + c->out.len, &h, sizeof(h));
+        memcpy(c->out.data + c->out.len + sizeof(h), r->payload, r->len);
+        c->out.len += sizeof(h) + r->len;
+        portal_queue_push(&c->sent, r);
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes as much of the output buffer as the socket takes.
+ */
+static inline int portal_conn_flush(PortalConn *c) {
+    while (c->out_sent < c->out.len) {
+        ssize_t n = send(c->fd, c->out.data + c->out_sent, c->out.len - c->out_sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return SUCCESS;
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return FAILURE;
+        c->out_sent += n;
+    }
+    c->out.len = c->out_sent = 0;
+    return SUCCESS;
+}
+
+/**
+ * @brief Delivers one reply to the oldest request of the connection.
+ * @return SUCCESS, or FAILURE if the reply does not match any request.
+ */
+static inline int portal_deliver(Portal *p, PortalConn *c, uint32_t type, char *payload) {
+    PortalRequest *r = portal_queue_pop(&c->sent);
+    if (!r) return FAILURE;
+
+    int status = type == FRAME_RESULT ? atoi(payload) : type == FRAME_RETRY ? PORTAL_BUSY : PORTAL_REFUSED;
+    PortalSession *s = &p->sessions[r->session];
+    int current = s->generation == r->generation;
+    if (status == PORTAL_BUSY && current) s->retry_ms = atoi(payload);
+
+    if (r->type == FRAME_LOGIN && current) {
+        s->state = status > 0 ? PORTAL_SESSION_UP : PORTAL_SESSION_FAILED;
+        if (status > 0) s->user_id = status;
+        PortalCallback cb = s->login_cb;
+        s->login_cb = NULL;
+        if (cb) cb(status, s->login_arg);
+    } else if (r->type == FRAME_SESSION_ACTION && r->cb) {
+        r->cb(status, r->arg);
+    }
+    portal_request_free(r);
+    return SUCCESS;
+}
+
+/**
+ * @brief Reads what the socket has and delivers every complete reply.
+ * @return Number of replies delivered, or -1 if the connection failed.
+ */
+static inline int portal_conn_read(Portal *p, PortalConn *c) {
+    if (framebuf_reserve(&c->in, PORTAL_READ_CHUNK) != SUCCESS) return -1;
+    ssize_t n = recv(c->fd, c->in.data + c->in.len, PORTAL_READ_CHUNK, MSG_DONTWAIT);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return 0;
+    if (n <= 0) return -1;
+    c->in.len += n;
+
+    // Turned away instead of prompted: come back when the server said
+    size_t busy_len = strlen(PROTO_BUSY);
+    if (c->skip == sizeof(PROTO_ROLE_PROMPT) &&
+        strncmp(c->in.data, PROTO_BUSY, c->in.len < busy_len ? c->in.len : busy_len) == 0) {
+        if (!memchr(c->in.data, '\n', c->in.len)) return 0;
+        c->in.data[c->in.len] = '\0';
+        int busy = proto_busy_delay(c->in.data);
+        c->backoff_ms = busy > PORTAL_BACKOFF_MIN ? busy : PORTAL_BACKOFF_MIN;
+        return -1;
+    }
+
+    if (c->skip) {
+        size_t drop = c->skip < c->in.len ? c->skip : c->in.len;
+        c->skip -= drop;
+        c->in_pos += drop;
+    }
+
+    int delivered = 0;
+    while (c->in.len - c->in_pos >= sizeof(FrameHeader)) {
+        FrameHeader h;
+        memcpy(&h, c->in.data + c->in_pos, sizeof(h));
+        uint32_t type = ntohl(h.type), len = ntohl(h.length);
+        if (len > FRAME_MAX) return -1;
+        if (c->in.len - c->in_pos - sizeof(h) < len) {
+            if (framebuf_reserve(&c->in, sizeof(h) + len) != SUCCESS) return -1;
+            break;
+        }
+
+        char *payload = c->in.data + c->in_pos + sizeof(h);
+        char saved = payload[len];
+        payload[len] = '\0';
+        int status = portal_deliver(p, c, type, payload);
+        payload[len] = saved;
+        if (status != SUCCESS) return -1;
+        c->in_pos += sizeof(h) + len;
+        delivered++;
+    }
+
+    // Keep only the unparsed tail
+    memmove(c->in.data, c->in.data + c->in_pos, c->in.len - c->in_pos);
+    c->in.len -= c->in_pos;
+    c->in_pos = 0;
+    return delivered;
+}
+
+/**
+ * @brief Creates a portal and starts connecting its pool.
+ *
+ * @param ip          Server address.
+ * @param port        Server port.
+ * @param connections Size of the connection pool.
+ * @return The portal, or NULL on error.
+ */
+static inline Portal *portal_open(const char *ip, int port, int connections) {
+    if (connections < 1) connections = 1;
+    Portal *p = (Portal *)calloc(1, sizeof(Portal));
+    if (!p) return NULL;
+    p->addr.sin_family = AF_INET;
+    p->addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip, &p->addr.sin_addr) != 1) {
+        free(p);
+        return NULL;
+    }
+    p->conns = (PortalConn *)calloc(connections, sizeof(PortalConn));
+    if (!p->conns) {
+        free(p);
+        return NULL;
+    }
+    p->conn_count = connections;
+    for (int i = 0; i < connections; i++) {
+        p->conns[i].fd = -1;
+        p->conns[i].backoff_ms = PORTAL_BACKOFF_MIN;
+        portal_conn_start(p, i);
+    }
+    return p;
+}
+
+/**
+ * @brief Logs a user in as a new session.
+ *
+ * The login is sent by portal_poll(); requests for the session may be
+ * submitted right away and are sent behind it.
+ *
+ * @param p        Portal.
+ * @param role     ADMIN, STUDENT or FACULTY.
+ * @param email    Email.
+ * @param password Password; kept to log the session in again after a reconnect.
+ * @param cb       Called with the user id, or a login status (WRONG_PASS, ...); may be NULL.
+ * @param arg      Passed to cb.
+ * @return Session handle, or FAILURE.
+ */
+static inline int portal_login(Portal *p, int role, const char *email, const char *password,
+                               PortalCallback cb, void *arg) {
+    // The credentials are sent as quoted words
+    if (strpbrk(email, "\" \t\r\n") || strpbrk(password, "\"\r\n")) return FAILURE;
+
+    int handle;
+    if (p->free_count > 0) {
+        handle = p->free_handles[--p->free_count];
+    } else {
+        if (p->session_count / p->conn_count >= SESSION_MAX) return FAILURE;
+        PortalSession *grown = (PortalSession *)realloc(p->sessions, (p->session_count + 1) * sizeof(PortalSession));
+        int *handles = (int *)realloc(p->free_handles, (p->session_count + 1) * sizeof(int));
+        if (grown) p->sessions = grown;
+        if (handles) p->free_handles = handles;
+        if (!grown || !handles) return FAILURE;
+        memset(&p->sessions[p->session_count], 0, sizeof(PortalSession));
+        handle = p->session_count++;
+    }
+
+    PortalSession *s = &p->sessions[handle];
+    s->generation++;
+    s->role = role;
+    s->user_id = 0;
+    s->email = strdup(email);
+    s->password = strdup(password);
+    s->login_cb = cb;
+    s->login_arg = arg;
+    s->state = PORTAL_SESSION_LOGGING_IN;
+
+    PortalRequest *r = s->email && s->password ? portal_login_request(p, handle) : NULL;
+    if (!r) {
+        free(s->email);
+        free(s->password);
+        s->state = PORTAL_SESSION_FREE;
+        p->free_handles[p->free_count++] = handle;
+        return FAILURE;
+    }
+    portal_queue_push(&p->conns[handle % p->conn_count].queued, r);
+    return handle;
+}
+
+/**
+ * @brief Queues an action for a session.
+ *
+ * @param p       Portal.
+ * @param session Handle from portal_login().
+ * @param action  Action line, e.g. "enroll 12" (see session_actions.h).
+ * @param cb      Called with the result; may be NULL.
+ * @param arg     Passed to cb.
+ * @return SUCCESS, or FAILURE if the session is not logged in or out of memory.
+ */
+static inline int portal_submit(Portal *p, int session, const char *action, PortalCallback cb, void *arg) {
+    if (session < 0 || session >= p->session_count) return FAILURE;
+    int state = p->sessions[session].state;
+    if (state != PORTAL_SESSION_LOGGING_IN && state != PORTAL_SESSION_UP) return FAILURE;
+
+    PortalRequest *r = portal_request_new(p, FRAME_SESSION_ACTION, session, cb, arg, "%d %s",
+                                          portal_wire_session(p, session), action);
+    if (!r) return FAILURE;
+    portal_queue_push(&p->conns[session % p->conn_count].queued, r);
+    return SUCCESS;
+}
+
+/**
+ * @brief Returns a session's user id, 0 while its login is pending, or FAILURE
+ *        if the login was refused or the handle is not in use.
+ */
+static inline int portal_session_user(const Portal *p, int session) {
+    if (session < 0 || session >= p->session_count) return FAILURE;
+    const PortalSession *s = &p->sessions[session];
+    return s->state == PORTAL_SESSION_UP ? s->user_id : s->state == PORTAL_SESSION_LOGGING_IN ? 0 : FAILURE;
+}
+
+/**
+ * @brief Returns the ms after which the server asked a session refused with
+ *        PORTAL_BUSY to log in again, or 0.
+ */
+static inline int portal_retry_after(const Portal *p, int session) {
+    if (session < 0 || session >= p->session_count) return 0;
+    const PortalSession *s = &p->sessions[session];
+    return s->state == PORTAL_SESSION_FAILED ? s->retry_ms : 0;
+}
+
+/**
+ * @brief Ends a session. Requests already submitted for it are still sent;
+ *        the handle may be returned by a later portal_login().
+ */
+static inline void portal_logout(Portal *p, int session) {
+    if (session < 0 || session >= p->session_count) return;
+    PortalSession *s = &p->sessions[session];
+    if (s->state == PORTAL_SESSION_FREE) return;
+
+    PortalRequest *r = portal_request_new(p, FRAME_LOGOUT, session, NULL, NULL, "%d", portal_wire_session(p, session));
+    if (r) portal_queue_push(&p->conns[session % p->conn_count].queued, r);
+
+    if (s->login_cb) s->login_cb(PORTAL_DISCONNECTED, s->login_arg);
+    free(s->email);
+    free(s->password);
+    s->email = s->password = NULL;
+    s->login_cb = NULL;
+    s->state = PORTAL_SESSION_FREE;
+    s->generation++;
+    p->free_handles[p->free_count++] = session;
+}
+
+/**
+ * @brief Sends queued requests, reads replies and runs their callbacks, and
+ *        reconnects dropped connections.
+ *
+ * @param p          Portal.
+ * @param timeout_ms Longest time to wait for the socket; 0 returns at once, -1 waits.
+ * @return Number of replies delivered, or FAILURE on error.
+ */
+static inline int portal_poll(Portal *p, int timeout_ms) {
+    struct pollfd *fds = (struct pollfd *)calloc(p->conn_count, sizeof(struct pollfd));
+    if (!fds) return FAILURE;
+
+    long long now = portal_now_ms();
+    for (int i = 0; i < p->conn_count; i++) {
+        PortalConn *c = &p->conns[i];
+        if (c->state == PORTAL_CONN_DOWN && now >= c->retry_at) portal_conn_start(p, i);
+        if (c->state == PORTAL_CONN_UP && !c->sent.head && c->queued.head) {
+            // An idle connection may have been closed by a server restart;
+            // find out before handing it requests that would then be lost
+            char byte;
+            ssize_t n = recv(c->fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                portal_conn_down(c);
+                c->retry_at = now;
+                portal_conn_start(p, i);
+            }
+        }
+        if (c->state == PORTAL_CONN_UP) {
+            if (portal_conn_encode(c) != SUCCESS || portal_conn_flush(c) != SUCCESS) portal_conn_down(c);
+        }
+
+        fds[i].fd = c->state == PORTAL_CONN_DOWN ? -1 : c->fd;
+        fds[i].events = c->state == PORTAL_CONN_CONNECTING ? POLLOUT
+                      : POLLIN | (c->out_sent < c->out.len ? POLLOUT : 0);
+        if (c->state == PORTAL_CONN_DOWN) {
+            long long wait = c->retry_at > now ? c->retry_at - now : 0;
+            if (timeout_ms < 0 || wait < timeout_ms) timeout_ms = (int)wait;
+        }
+    }
+
+    int ready = poll(fds, p->conn_count, timeout_ms);
+    if (ready < 0) {
+        free(fds);
+        return errno == EINTR ? 0 : FAILURE;
+    }
+
+    int delivered = 0;
+    for (int i = 0; ready > 0 && i < p->conn_count; i++) {
+        PortalConn *c = &p->conns[i];
+        if (fds[i].fd < 0 || !fds[i].revents) continue;
+
+        if (c->state == PORTAL_CONN_CONNECTING) {
+            int error = 0;
+            socklen_t len = sizeof(error);
+            if (getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &error, &len) != 0 || error) {
+                portal_conn_down(c);
+                continue;
+            }
+            c->state = PORTAL_CONN_UP;
+            c->backoff_ms = PORTAL_BACKOFF_MIN;
+            if (portal_conn_encode(c) != SUCCESS || portal_conn_flush(c) != SUCCESS) portal_conn_down(c);
+            continue;
+        }
+
+        if (fds[i].revents & POLLOUT && portal_conn_flush(c) != SUCCESS) {
+            portal_conn_down(c);
+            continue;
+        }
+        if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+            int n = portal_conn_read(p, c);
+            if (n < 0) portal_conn_down(c);
+            else delivered += n;
+        }
+    }
+    free(fds);
+    return delivered;
+}
+
+/**
+ * @brief Polls until a future completes.
+ * @return SUCCESS, or FAILURE if timeout_ms (-1 for none) passed first.
+ */
+static inline int portal_wait(Portal *p, PortalFuture *f, int timeout_ms) {
+    long long deadline = portal_now_ms() + timeout_ms;
+    while (!f->done) {
+        long long left = deadline - portal_now_ms();
+        if (timeout_ms >= 0 && left <= 0) return FAILURE;
+        if (portal_poll(p, timeout_ms < 0 ? -1 : (int)left) == FAILURE) return FAILURE;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Closes every connection and frees the portal. Outstanding requests
+ *        and pending logins complete with PORTAL_DISCONNECTED.
+ */
+static inline void portal_close(Portal *p) {
+    if (!p) return;
+    for (int i = 0; i < p->conn_count; i++) {
+        PortalConn *c = &p->conns[i];
+        PortalRequest *r;
+        while ((r = portal_queue_pop(&c->sent)) || (r = portal_queue_pop(&c->queued))) {
+            if (r->type == FRAME_SESSION_ACTION && r->cb) r->cb(PORTAL_DISCONNECTED, r->arg);
+            portal_request_free(r);
+        }
+        if (c->fd >= 0) close(c->fd);
+        framebuf_free(&c->out);
+        framebuf_free(&c->in);
+    }
+    for (int h = 0; h < p->session_count; h++) {
+        PortalSession *s = &p->sessions[h];
+        if (s->login_cb) s->login_cb(PORTAL_DISCONNECTED, s->login_arg);
+        free(s->email);
+        free(s->password);
+    }
+    free(p->conns);
+    free(p->sessions);
+    free(p->free_handles);
+    free(p);
+}
+
+#ifdef __cplusplus
+} // extern "C"
+
+#include <utility>
+
+/**
+ * @brief C++: queues an action whose result goes to any callable taking the
+ *        status, e.g. a lambda that captures, or one that fulfils a std::promise.
+ */
+template <typename F>
+static inline int portal_submit(Portal *p, int session, const char *action, F fn) {
+    F *heap = new F(std::move(fn));
+    PortalCallback trampoline = [](int status, void *arg) {
+        F *f = static_cast<F *>(arg);
+        (*f)(status);
+        delete f;
+    };
+    if (portal_submit(p, session, action, trampoline, heap) != SUCCESS) {
+        delete heap;
+        return FAILURE;
+    }
+    return SUCCESS;
+}
+#endif
+
+#endif // PORTAL_H
@@ -0,0 +1,55 @@
+#ifndef SEARCH_CLIENT_H
+#define SEARCH_CLIENT_H
+
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include "../server/course_search.h"
+#include "../server/utils.h"
+
+/**
+ * @brief Reads one line from standard input after printing a prompt.
+ * @return 1 on success, 0 on end of input.
+ */
+static inline int search_read_line(const char *prompt, char *buf, size_t size) {
+    write(STDOUT_FILENO, prompt, strlen(prompt));
+    ssize_t n = read(STDIN_FILENO, buf, size - 1);
+    if (n <= 0) return 0;
+    buf[n] = '\0';
+    buf[strcspn(buf, "\n")] = '\0'; // Remove newline
+    return 1;
+}
+
+/**
+ * @brief Prompts for a course search and pages through the results.
+ *
+ * Shared by the student and faculty menus. Blank filters match everything.
+ */
+static inline void handle_course_search(void) {
+    char text[SEARCH_MAX_QUERY], buf[64];
+    CourseQuery query = { .text = text, .limit = SEARCH_PAGE_SIZE };
+
+    const char *search_msg = "\n---------------------------"
+                             "\n      SEARCH COURSES     "
+                             "\n---------------------------\n";
+    write(STDOUT_FILENO, search_msg, strlen(search_msg));
+
+    if (!search_read_line("Code or name contains (blank for any): ", text, sizeof(text))) return;
+    if (!search_read_line("Credits (blank for any): ", buf, sizeof(buf))) return;
+    query.credits = atoi(buf);
+    if (!search_read_line("Minimum seats left (blank for any): ", buf, sizeof(buf))) return;
+    query.min_seats = atoi(buf);
+    if (!search_read_line("Faculty ID (blank for any): ", buf, sizeof(buf))) return;
+    query.faculty_id = atoi(buf);
+
+    while (1) {
+        int total = print_course_search(&query);
+        if (total < 0 || query.offset + query.limit >= total) return;
+
+        if (!search_read_line("Enter n for the next page, anything else to stop: ", buf, sizeof(buf))) return;
+        if (strcmp(buf, "n") != 0 && strcmp(buf, "N") != 0) return;
+        query.offset += query.limit;
+    }
+}
+
+#endif // SEARCH_CLIENT_H
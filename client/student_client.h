@@ -8,8 +8,39 @@
 #include <fcntl.h>
 #include "../server/student_actions.h"
 #include "../server/utils.h"
+#include "../server/probes.h"
+#include "search_client.h"
 
 #define MAX_BUF 1024
+#define MAX_BATCH_COURSES 16
+
+/**
+ * @brief Lists available courses a page at a time until the student answers a prompt.
+ *
+ * @param student_id ID of the student.
+ * @param prompt     Question to ask, without the trailing colon.
+ * @param buf        Receives the answer.
+ * @param size       Size of buf.
+ * @return 1 once a line other than "n" was entered, 0 on end of input or error.
+ */
+static inline int prompt_available_courses(int student_id, const char *prompt, char *buf, size_t size) {
+    ListCursor cursor;
+    cursor_reset(&cursor);
+
+    while (1) {
+        if (list_available_courses(student_id, &cursor) != SUCCESS) return 0;
+
+        write(STDOUT_FILENO, prompt, strlen(prompt));
+        const char *suffix = cursor.done ? ": " : " (n for more courses): ";
+        write(STDOUT_FILENO, suffix, strlen(suffix));
+        ssize_t n = read(STDIN_FILENO, buf, size - 1);
+        if (n <= 0) return 0;
+        buf[n] = '\0';
+        buf[strcspn(buf, "\n")] = '\0'; // Remove newline
+
+        if (cursor.done || strcmp(buf, "n") != 0) return 1;
+    }
+}
 
 /**
  * @brief Displays the student menu, gathers inputs, and invokes server functions.
@@ -26,6 +57,9 @@ static inline void handle_student_menu(int student_id) {
     ssize_t n;
 
     while (1) {
+        // The previous request's scratch memory is freed in one go
+        arena_reset(request_arena());
+
         // 1) Print menu
         const char *menu =
             "\n---------------------------"
@@ -35,7 +69,9 @@ static inline void handle_student_menu(int student_id) {
             "\n 2) Unenroll from Course "
             "\n 3) View Enrolled Courses"
             "\n 4) Change Password      "
-            "\n 5) Exit                 "
+            "\n 5) Enroll in Several    "
+            "\n 6) Search Courses       "
+            "\n 7) Exit                 "
             "\n---------------------------"
             "\nEnter choice: ";
         write(STDOUT_FILENO, menu, strlen(menu));
@@ -47,7 +83,8 @@ static inline void handle_student_menu(int student_id) {
         buf[strcspn(buf, "\n")] = '\0'; // Remove newline
 
         choice = atoi(buf);
-        if (choice == 5) {
+        PROBE_ACTION_DISPATCH(STUDENT, choice, student_id);
+        if (choice == 7) {
             const char *logout_msg = "\n╔═════════════════════════╗"
                             "\n║      Logging out...     ║"
                             "\n╚═════════════════════════╝\n";
@@ -57,16 +94,9 @@ static inline void handle_student_menu(int student_id) {
 
         if (choice == 1) {
             // Enroll
-            int s = list_available_courses(student_id);
-            if (s == USER_NOT_FOUND) {
+            if (!prompt_available_courses(student_id, "\nEnter course ID to enroll", buf, MAX_BUF)) {
                 continue;
             }
-            
-            write(STDOUT_FILENO, "\nEnter course ID to enroll: ", 28);
-            n = read(STDIN_FILENO, buf, MAX_BUF - 1);
-            if (n <= 0) continue;
-            buf[n] = '\0';
-            buf[strcspn(buf, "\n")] = '\0'; // Remove newline
             int cid = atoi(buf);
             
             int res = enroll_course(student_id, cid);
@@ -82,6 +112,24 @@ static inline void handle_student_menu(int student_id) {
                           "\n║ Already enrolled!       ║"
                           "\n╚═════════════════════════╝\n"; 
                     break;
+                case WAITLISTED:
+                    printf("\n╔═════════════════════════╗"
+                           "\n║ Course full: waitlisted ║"
+                           "\n║ Position: %-13d ║"
+                           "\n╚═════════════════════════╝\n", waitlist_position(student_id, cid));
+                    fflush(stdout);
+                    msg = "";
+                    break;
+                case SCHEDULE_CONFLICT:
+                    msg = "\n╔═════════════════════════╗"
+                          "\n║ Timetable clash!        ║"
+                          "\n╚═════════════════════════╝\n"; 
+                    break;
+                case PREREQ_MISSING:
+                    msg = "\n╔═════════════════════════╗"
+                          "\n║ Prerequisites not met!  ║"
+                          "\n╚═════════════════════════╝\n"; 
+                    break;
                 case COURSE_NOT_FOUND:
                     msg = "\n╔═════════════════════════╗"
                           "\n║ Course not found!       ║"
@@ -101,8 +149,10 @@ static inline void handle_student_menu(int student_id) {
             write(STDOUT_FILENO, msg, strlen(msg));
         }
         else if (choice == 2) {
-            // Unenroll
+            // Unenroll (or leave a waitlist)
             view_enrollments_st(student_id);
+            view_waitlists_st(student_id);
+            fflush(stdout);
             write(STDOUT_FILENO, "\nEnter course ID to unenroll: ", 31);
             n = read(STDIN_FILENO, buf, MAX_BUF - 1);
             if (n <= 0) continue;
@@ -143,6 +193,8 @@ static inline void handle_student_menu(int student_id) {
         else if (choice == 3) {
             // View enrolled
             view_enrollments_st(student_id);
+            view_waitlists_st(student_id);
+            fflush(stdout);
         }
         else if (choice == 4) {
             // Change password
@@ -167,6 +219,49 @@ static inline void handle_student_menu(int student_id) {
                   "\n╚═════════════════════════╝\n";
             write(STDOUT_FILENO, msg, strlen(msg));
         }
+        else if (choice == 5) {
+            // Enroll in several courses at once
+            if (!prompt_available_courses(student_id, "\nEnter course IDs separated by commas", buf, MAX_BUF)) {
+                continue;
+            }
+
+            BatchItem items[MAX_BATCH_COURSES];
+            int count = 0;
+            for (char *tok = strtok(buf, ", "); tok && count < MAX_BATCH_COURSES; tok = strtok(NULL, ", ")) {
+                items[count].student_id = student_id;
+                items[count].course_id = atoi(tok);
+                items[count].enroll = 1;
+                items[count].status = SUCCESS;
+                count++;
+            }
+
+            if (batch_enroll(items, count, 0) != SUCCESS) {
+                const char *msg = "\n╔═════════════════════════╗"
+                                  "\n║ Enrollment failed!      ║"
+                                  "\n╚═════════════════════════╝\n";
+                write(STDOUT_FILENO, msg, strlen(msg));
+                continue;
+            }
+
+            for (int i = 0; i < count; i++) {
+                const char *result;
+                switch (items[i].status) {
+                    case SUCCESS:          result = "enrolled"; break;
+                    case ALREADY_ENROLLED: result = "already enrolled"; break;
+                    case WAITLISTED:       result = "course full, waitlisted"; break;
+                    case SCHEDULE_CONFLICT: result = "timetable clash"; break;
+                    case PREREQ_MISSING:   result = "prerequisites not met"; break;
+                    case COURSE_NOT_FOUND: result = "course not found"; break;
+                    case USER_NOT_FOUND:   result = "user not found"; break;
+                    default:               result = "failed"; break;
+                }
+                printf("Course %d: %s\n", items[i].course_id, result);
+            }
+            fflush(stdout);
+        }
+        else if (choice == 6) {
+            handle_course_search();
+        }
         else {
             const char *invalid_msg = "\n╔═════════════════════════╗"
                                      "\n║ Invalid option!         ║"
@@ -5,12 +5,20 @@
 #include <sys/file.h>
 #include "types.h"
 #include "utils.h"
+#include "db_version.h"
+#include "auth_version.h"
+#include "snapshot.h"
+#include "txn.h"
+#include "hashset.h"
+#include "cursor.h"
+#include "render.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <ctype.h>
 
 #define MAX_LINE 256
 #define SUCCESS         0
@@ -19,123 +27,151 @@
 #define DUPLICATE_ID   -3
 
 /**
- * Prints formatted list of users from CSV file
- * @param filename Path to CSV file containing user data
- *
- * @brief THe function uses fcntl locking to ensure that only one process can read the file at a time.
- * The file is locked for the duration of the function call, and the lock is released when the
- * function returns.
- *
- * If the file does not contain the "active" field, the function will print a table without the
- * "Status" column.
+ * @brief Layouts of the user tables, with and without the status column.
  */
-static inline void print_users(const char *filename) {
-    int fd = open(filename, O_RDONLY);
-    if (fd < 0) {
-        perror("Failed to open file");
-        return;
-    }
+static RenderBox users_box = RENDER_TABLE(
+    "║   User ID  ║           Name               ║             Email                  ║   Status   ║\n",
+    "dsss", 10, 28, 34, 10);
+static RenderBox users_box_plain = RENDER_TABLE(
+    "║   User ID  ║           Name               ║             Email                  ║\n",
+    "dss", 10, 28, 34);
 
-    struct flock lock = {.l_type = F_RDLCK, .l_whence = SEEK_SET, .l_start = 0, .l_len = 0};
-    if (fcntl(fd, F_SETLKW, &lock) == -1) {
-        perror("Failed to acquire read lock");
-        close(fd);
-        return;
+/**
+ * @brief State shared by the rows of one page of render_users().
+ */
+typedef struct {
+    RenderBuf *out;
+    RenderBox *box;
+    int has_active_field;
+} UserPage;
+
+static int print_user_row(const char *line, void *ctx) {
+    UserPage *page = ctx;
+    int id, active = -1;
+    char name[MAX_LINE] = {0}, email[MAX_LINE] = {0};
+
+    if (page->has_active_field) {
+        // Parse the line and get the user ID, name, email and status
+        if (sscanf(line, "%d,%255[^,],%255[^,],%*[^,],%d", &id, name, email, &active) != 4) return 0;
+        name[strcspn(name, "\r\n")] = 0;
+        email[strcspn(email, "\r\n")] = 0;
+        render_row(page->out, page->box, id, name, email, (active == 1) ? "Active" : "Inactive");
+    } else {
+        if (sscanf(line, "%d,%255[^,],%255[^,]", &id, name, email) < 3) return 0;
+        name[strcspn(name, "\r\n")] = 0;
+        email[strcspn(email, "\r\n")] = 0;
+        render_row(page->out, page->box, id, name, email);
     }
+    return 1;
+}
 
-    FILE *file = fdopen(fd, "r");
+/**
+ * Renders a formatted list of users from CSV file
+ * @param out Output
+ * @param filename Path to CSV file containing user data
+ * @param cursor Where the list starts; advanced past the last user rendered
+ * @param limit Most users to render
+ * @return Number of users rendered, or FILE_ERROR
+ *
+ * @brief The rows are read from the current snapshot of the file, so it never waits for writers;
+ * see cursor.h.
+ *
+ * If the file does not contain the "active" field, the table has no "Status" column.
+ */
+static inline int render_users(RenderBuf *out, const char *filename, ListCursor *cursor, int limit) {
+    FILE *file = snapshot_fopen(filename);
     if (!file) {
-        perror("fdopen failed");
-        close(fd);
-        return;
+        perror("Failed to open file");
+        return FILE_ERROR;
     }
 
+    UserPage page = { .out = out };
     char line[MAX_LINE];
     // Check if the file contains the "active" field
-    int has_active_field = (fgets(line, sizeof(line), file) && strstr(line, "active")) ? 1 : 0;
-    if (!has_active_field) rewind(file);
+    page.has_active_field = (fgets(line, sizeof(line), file) && strstr(line, "active")) ? 1 : 0;
+    fclose(file);
 
-    if (has_active_field) {
-        printf("╔════════════╦══════════════════════════════╦════════════════════════════════════╦════════════╗\n");
-        printf("║   User ID  ║           Name               ║             Email                  ║   Status   ║\n");
-        printf("╠════════════╬══════════════════════════════╬════════════════════════════════════╬════════════╣\n");
-    } else {
-        printf("╔════════════╦══════════════════════════════╦════════════════════════════════════╗\n");
-        printf("║   User ID  ║           Name               ║             Email                  ║\n");
-        printf("╠════════════╬══════════════════════════════╬════════════════════════════════════╣\n");
-    }
+    page.box = page.has_active_field ? &users_box : &users_box_plain;
+    render_rule(out, page.box, RULE_TOP_COLUMNS);
+    render_header(out, page.box);
+    render_rule(out, page.box, RULE_MID);
 
-    while (fgets(line, sizeof(line), file)) {
-        int id, active = -1;
-        char name[MAX_LINE] = {0}, email[MAX_LINE] = {0};
-
-        if (has_active_field) {
-            // Parse the line and get the user ID, name, email and status
-            if (sscanf(line, "%d,%255[^,],%255[^,],%*[^,],%d", &id, name, email, &active) == 4) {
-                name[strcspn(name, "\r\n")] = 0;
-                email[strcspn(email, "\r\n")] = 0;
-                printf("║ %-10d ║ %-28s ║ %-34s ║ %-10s ║\n", id, name, email, (active == 1) ? "Active" : "Inactive");
-            }
-        } else if (sscanf(line, "%d,%255[^,],%255[^,]", &id, name, email) >= 3) {
-            name[strcspn(name, "\r\n")] = 0;
-            email[strcspn(email, "\r\n")] = 0;
-            printf("║ %-10d ║ %-28s ║ %-34s ║\n", id, name, email);
-        }
-    }
+    int shown = cursor_fetch(filename, cursor, limit, print_user_row, &page);
 
-    printf(has_active_field ? "╚════════════╩══════════════════════════════╩════════════════════════════════════╩════════════╝\n" 
-                           : "╚════════════╩══════════════════════════════╩════════════════════════════════════╝\n");
+    render_rule(out, page.box, RULE_BOTTOM_COLUMNS);
+    return shown;
+}
 
-    // Release the lock
-    lock.l_type = F_UNLCK;
-    fcntl(fd, F_SETLK, &lock);
-    fclose(file);
+/**
+ * Prints one page of a formatted list of users from CSV file
+ * @param filename Path to CSV file containing user data
+ * @param cursor Where the page starts; advanced to the next page
+ * @return Number of users printed, or FILE_ERROR
+ *
+ * @brief The page is rendered into one buffer that is written at once; see render_users().
+ */
+static inline int print_users(const char *filename, ListCursor *cursor) {
+    RenderBuf out = {0};
+    int shown = render_users(&out, filename, cursor, LIST_PAGE_SIZE);
+    render_flush(&out, STDOUT_FILENO);
+    render_free(&out);
+    return shown;
 }
 
 /**
- * @brief Checks if a student ID exists in the database
+ * @brief Publishes a new version of a user table with one row added.
  *
- * Opens the file in read-only mode, acquires a shared (read) lock, and checks each line of the file
- * to see if the student ID exists. If it does, the function releases the lock and returns 1. If it
- * doesn't, the function releases the lock and returns 0. If the file can't be opened, the function
- * returns FILE_ERROR.
+ * The current rows are copied to a new version of the table under the writer
+ * lock, checking for the id in the same pass, and the row is written at the
+ * end. Readers see the table either without or with the complete row.
  *
- * @param filename Path to student database file
- * @param id Student ID to check
- * @return 1 if exists, 0 if not, FILE_ERROR on failure
+ * @param filename Path to the student or faculty table.
+ * @param id       Id of the new row.
+ * @param header   Header written if the table is empty or missing.
+ * @param row      The new row, including its trailing newline.
+ * @return SUCCESS on success, DUPLICATE_ID if the id exists, FILE_ERROR on failure
  */
-static inline int check_student_id_exists(const char *filename, int id) {
-    // Open the file in read-only mode
-    int fd = open(filename, O_RDONLY);
-    if (fd < 0) return FILE_ERROR; // Return error if file can't be opened
-
-    // Initialize file lock structure for a shared (read) lock
-    struct flock lock = {.l_type = F_RDLCK, .l_whence = SEEK_SET, .l_start = 0, .l_len = 0};
-    if (fcntl(fd, F_SETLKW, &lock) == -1) {
-        perror("fcntl lock"); // Print error if lock acquisition fails
-        close(fd);
+static inline int add_user_row(const char *filename, int id, const char *header, const char *row) {
+    int lock_fd = txn_lock(filename);
+    if (lock_fd < 0) return FILE_ERROR;
+
+    SnapshotWriter writer;
+    if (!snapshot_rewrite_begin(&writer, filename)) {
+        snapshot_unlock(lock_fd, filename);
         return FILE_ERROR;
     }
 
-    char line[MAX_LINE];
-    // Read each line of the file
-    while (read_line(fd, line, sizeof(line)) > 0) {
+    // One pass over the current table: copy it and look for the id
+    FILE *file = snapshot_fopen(filename);
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    int rows = 0, status = SUCCESS;
+    while (file && (len = getline(&line, &cap, file)) > 0) {
         int existing_id;
-        // Parse the line for student ID and compare
         if (sscanf(line, "%d,", &existing_id) == 1 && existing_id == id) {
-            // Release lock and close if ID is found
-            lock.l_type = F_UNLCK;
-            fcntl(fd, F_SETLK, &lock);
-            close(fd);
-            return 1;
+            status = DUPLICATE_ID;
+            break;
         }
+        rows++;
+        fputs(line, writer.out);
+        if (line[len - 1] != '\n') fputc('\n', writer.out);
+    }
+    if (file && ferror(file)) status = FILE_ERROR;
+    if (file) fclose(file);
+    free(line);
+
+    if (status == SUCCESS) {
+        if (rows == 0) fputs(header, writer.out);
+        fputs(row, writer.out);
+        status = snapshot_rewrite_commit(&writer);
+    } else {
+        snapshot_rewrite_abort(&writer);
     }
+    snapshot_unlock(lock_fd, filename);
 
-    // Release lock and close if ID is not found
-    lock.l_type = F_UNLCK;
-    fcntl(fd, F_SETLK, &lock);
-    close(fd);
-    return 0;
+    if (status == SUCCESS) auth_version_bump();
+    return status;
 }
 
 /**
@@ -150,73 +186,10 @@ static inline int check_student_id_exists(const char *filename, int id) {
  */
 static inline int add_student(const char *filename, int id, const char *name, 
                              const char *email, const char *password, int active) {
-    // Check if student ID already exists
-    if (check_student_id_exists(filename, id)) return DUPLICATE_ID;
-
-    // Open file in write-only mode, create if doesn't exist, append to end
-    int fd = open(filename, O_WRONLY | O_CREAT | O_APPEND, 0644);
-    if (fd < 0) return FILE_ERROR; // Return error if file can't be opened
-
-    // Acquire exclusive lock for writing
-    struct flock lock = {.l_type = F_WRLCK, .l_whence = SEEK_SET, .l_start = 0, .l_len = 0};
-    if (fcntl(fd, F_SETLKW, &lock) == -1) {
-        perror("fcntl lock"); // Print error if lock acquisition fails
-        close(fd);
-        return FILE_ERROR;
-    }
-
-    // If file is empty, write header
-    struct stat st;
-    if (fstat(fd, &st) == 0 && st.st_size == 0) {
-        dprintf(fd, "id,name,email,password,active,enrolled_courses\n");
-    }
-
-    // Write student data
-    dprintf(fd, "%d,%s,%s,%s,%d,\n", id, name, email, password, active);
-
-    // Release lock and close
-    lock.l_type = F_UNLCK;
-    fcntl(fd, F_SETLK, &lock);
-    close(fd);
-    return SUCCESS;
-}
-
-/**
- * @brief Checks if a faculty ID exists in the database
- * @param filename Path to faculty database file
- * @param id Faculty ID to check
- * @return 1 if exists, 0 if not, FILE_ERROR on failure
- */
-static inline int check_faculty_id_exists(const char *filename, int id) {
-    int fd = open(filename, O_RDONLY); // Open file in read-only mode
-    if (fd < 0) return FILE_ERROR; // Return error if file can't be opened
-
-    // Acquire shared lock for reading
-    struct flock lock = {.l_type = F_RDLCK, .l_whence = SEEK_SET, .l_start = 0, .l_len = 0};
-    if (fcntl(fd, F_SETLKW, &lock) == -1) {
-        perror("fcntl lock"); // Print error if lock acquisition fails
-        close(fd);
-        return FILE_ERROR;
-    }
-
-    char line[MAX_LINE];
-    while (read_line(fd, line, sizeof(line)) > 0) {
-        int existing_id;
-        // Parse the line for faculty ID and compare
-        if (sscanf(line, "%d,", &existing_id) == 1 && existing_id == id) {
-            // Release lock and close if ID is found
-            lock.l_type = F_UNLCK;
-            fcntl(fd, F_SETLK, &lock);
-            close(fd);
-            return 1;
-        }
-    }
-
-    // Release lock and close if ID is not found
-    lock.l_type = F_UNLCK;
-    fcntl(fd, F_SETLK, &lock);
-    close(fd);
-    return 0;
+    char row[4 * MAX_LINE];
+    int len = snprintf(row, sizeof(row), "%d,%s,%s,%s,%d,\n", id, name, email, password, active);
+    if (len < 0 || len >= (int)sizeof(row)) return FILE_ERROR;
+    return add_user_row(filename, id, "id,name,email,password,active,enrolled_courses\n", row);
 }
 
 /**
@@ -229,34 +202,177 @@ static inline int check_faculty_id_exists(const char *filename, int id) {
  * @return SUCCESS on success, DUPLICATE_ID if ID exists, FILE_ERROR on failure
  */
 static inline int add_faculty(const char *filename, int id, const char *name, const char *email, const char *password) {
-    // Check if ID already exists
-    if (check_faculty_id_exists(filename, id)) return DUPLICATE_ID;
+    char row[4 * MAX_LINE];
+    int len = snprintf(row, sizeof(row), "%d,%s,%s,%s,\n", id, name, email, password);
+    if (len < 0 || len >= (int)sizeof(row)) return FILE_ERROR;
+    return add_user_row(filename, id, "id,name,email,password,offered_courses\n", row);
+}
+
+/**
+ * @brief Outcome of a bulk import.
+ */
+typedef struct {
+    int added;              ///< Rows appended to the table
+    int duplicate_ids;      ///< Rows skipped: id already in the table or earlier in the input
+    int duplicate_emails;   ///< Rows skipped: email already in use (case-insensitive)
+    int malformed;          ///< Rows skipped: wrong number of fields or bad values
+} ImportReport;
+
+/**
+ * @brief Builds the email key used for duplicate detection (lower case).
+ */
+static inline void import_email_key(const char *email, char *key, size_t len) {
+    size_t i = 0;
+    for (; email[i] && i < len - 1; i++) key[i] = tolower((unsigned char)email[i]);
+    key[i] = '\0';
+}
 
-    int fd = open(filename, O_WRONLY | O_CREAT | O_APPEND, 0644);
-    if (fd < 0) return FILE_ERROR;
+/**
+ * @brief Splits a CSV line in place.
+ * @return Number of fields found (at most max).
+ */
+static inline int import_split(char *line, char **fields, int max) {
+    int n = 0;
+    for (char *p = line; n < max; p++) {
+        fields[n++] = p;
+        p = strchr(p, ',');
+        if (!p) return n;
+        *p = '\0';
+    }
+    return n + 1; // Too many fields
+}
 
-    // Acquire exclusive lock for writing
-    struct flock lock = {.l_type = F_WRLCK, .l_whence = SEEK_SET, .l_start = 0, .l_len = 0};
-    if (fcntl(fd, F_SETLKW, &lock) == -1) {
-        perror("fcntl lock"); // Print error if lock acquisition fails
-        close(fd);
+/**
+ * @brief Adds many students or faculty in one pass.
+ *
+ * The input file has one user per line in the table's own column order,
+ * without the course list: "id,name,email,password[,active]" for students
+ * (active defaults to 1) and "id,name,email,password" for faculty. A leading
+ * header line is skipped.
+ *
+ * The ids and emails already in the table are loaded into hash sets in a
+ * single scan, so each input row is checked in O(1) instead of rescanning the
+ * table. Duplicates inside the input are caught by the same sets. Accepted
+ * rows are appended to a new version of the table that is published with one
+ * fsync under a single writer lock: readers see either none or all of the
+ * import. Skipped rows are listed on stdout with their line number.
+ *
+ * @param filename   Path to the student or faculty table.
+ * @param input_path Path to the file to import.
+ * @param is_student 1 to import students, 0 to import faculty.
+ * @param report     Filled with the number of added and skipped rows.
+ * @return SUCCESS (even if rows were skipped) or FILE_ERROR.
+ */
+static inline int bulk_import_users(const char *filename, const char *input_path, int is_student,
+                                    ImportReport *report) {
+    memset(report, 0, sizeof(*report));
+
+    FILE *input = fopen(input_path, "r");
+    if (!input) return FILE_ERROR;
+
+    int lock_fd = txn_lock(filename);
+    if (lock_fd < 0) {
+        fclose(input);
         return FILE_ERROR;
     }
 
-    // If file is empty, write header
-    struct stat st;
-    if (fstat(fd, &st) == 0 && st.st_size == 0) {
-        dprintf(fd, "id,name,email,password,offered_courses\n");
+    SnapshotWriter writer;
+    if (!snapshot_rewrite_begin(&writer, filename)) {
+        snapshot_unlock(lock_fd, filename);
+        fclose(input);
+        return FILE_ERROR;
     }
 
-    // Write faculty data
-    dprintf(fd, "%d,%s,%s,%s,\n", id, name, email, password);
+    HashSet ids = {0}, emails = {0};
+    char *line = NULL, key[MAX_LINE];
+    size_t cap = 0;
+    ssize_t len;
+    int status = SUCCESS;
+
+    // One pass over the current table: copy it and collect its ids and emails
+    FILE *file = snapshot_fopen(filename);
+    int rows = 0;
+    while (file && (len = getline(&line, &cap, file)) > 0) {
+        rows++;
+        fputs(line, writer.out);
+        if (line[len - 1] != '\n') fputc('\n', writer.out);
+
+        char *fields[4];
+        if (import_split(line, fields, 4) < 3 || !isdigit((unsigned char)fields[0][0])) continue; // Header
+        char id_key[16];
+        snprintf(id_key, sizeof(id_key), "%ld", strtol(fields[0], NULL, 10));
+        import_email_key(fields[2], key, sizeof(key));
+        if (hashset_add(&ids, id_key) < 0 || hashset_add(&emails, key) < 0) status = FILE_ERROR;
+    }
+    if (file) fclose(file);
+    if (rows == 0) {
+        fputs(is_student ? "id,name,email,password,active,enrolled_courses\n"
+                         : "id,name,email,password,offered_courses\n", writer.out);
+    }
+
+    // Append every new, unique row
+    int line_no = 0;
+    while (status == SUCCESS && (len = getline(&line, &cap, input)) > 0) {
+        line_no++;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0') continue;
+
+        char *fields[6], *end;
+        int n = import_split(line, fields, 6);
+        long id = strtol(fields[0], &end, 10);
+        if (line_no == 1 && end == fields[0]) continue; // Header
+
+        int active = 1;
+        if (n == 5 && is_student) active = atoi(fields[4]);
+
+        if (end == fields[0] || *end || id <= 0 || id > 2147483647L || n < 4 || n > (is_student ? 5 : 4) ||
+            !*fields[1] || !*fields[2] || !*fields[3] || (n == 5 && strcmp(fields[4], "0") && strcmp(fields[4], "1"))) {
+            printf("Line %d: malformed row, skipped\n", line_no);
+            report->malformed++;
+            continue;
+        }
+
+        // Normalise the id so "007" and "7" collide
+        char id_key[16];
+        snprintf(id_key, sizeof(id_key), "%ld", id);
+        import_email_key(fields[2], key, sizeof(key));
 
-    // Release lock and close
-    lock.l_type = F_UNLCK;
-    fcntl(fd, F_SETLK, &lock);
-    close(fd);
-    return SUCCESS;
+        if (hashset_contains(&ids, id_key)) {
+            printf("Line %d: id %ld already exists, skipped\n", line_no, id);
+            report->duplicate_ids++;
+            continue;
+        }
+        if (hashset_contains(&emails, key)) {
+            printf("Line %d: email %s already in use, skipped\n", line_no, fields[2]);
+            report->duplicate_emails++;
+            continue;
+        }
+        if (hashset_add(&ids, id_key) < 0 || hashset_add(&emails, key) < 0) {
+            status = FILE_ERROR;
+            break;
+        }
+
+        if (is_student) fprintf(writer.out, "%ld,%s,%s,%s,%d,\n", id, fields[1], fields[2], fields[3], active);
+        else fprintf(writer.out, "%ld,%s,%s,%s,\n", id, fields[1], fields[2], fields[3]);
+        report->added++;
+    }
+    if (ferror(input)) status = FILE_ERROR;
+
+    free(line);
+    fclose(input);
+    hashset_free(&ids);
+    hashset_free(&emails);
+
+    if (status == SUCCESS && report->added > 0) {
+        status = snapshot_rewrite_commit(&writer);
+    } else {
+        snapshot_rewrite_abort(&writer);
+    }
+    snapshot_unlock(lock_fd, filename);
+
+    if (status == SUCCESS && report->added > 0) auth_version_bump();
+    if (status != SUCCESS) report->added = 0;
+    return status;
 }
 
 /**
@@ -268,72 +384,70 @@ static inline int add_faculty(const char *filename, int id, const char *name, co
  * @return SUCCESS on success, USER_NOT_FOUND if user not found, FILE_ERROR on failure
  */
 static inline int update_user_details(const char *filename, int user_id, int field_choice, const char *new_value) {
-    int fd = open(filename, O_RDWR);
-    if (fd < 0) return FILE_ERROR;
-
-    // Skip the header line if present
-    char line[MAX_LINE];
-    off_t offset = lseek(fd, 0, SEEK_SET);
-    if (read(fd, line, 4) == 4 && strncmp(line, "id,", 3) == 0) {
-        // Move to the end of the header line
-        char c;
-        while (read(fd, &c, 1) == 1 && c != '\n');
-        offset = lseek(fd, 0, SEEK_CUR);
+    int lock_fd = txn_lock(filename);
+    if (lock_fd < 0) return FILE_ERROR;
+
+    FILE *file = snapshot_fopen(filename);
+    SnapshotWriter writer;
+    if (!file || !snapshot_rewrite_begin(&writer, filename)) {
+        if (file) fclose(file);
+        snapshot_unlock(lock_fd, filename);
+        return FILE_ERROR;
     }
 
-    // Iterate over the lines in the file
-    while (1) {
-        ssize_t n = pread(fd, line, sizeof(line)-1, offset);
-        if (n <= 0) break;
-        line[n] = '\0';
+    char line[MAX_LINE];
+    int found = 0;
 
-        // Get the length of the line
-        char *nl = strchr(line, '\n');
-        int linelen = nl ? (nl - line + 1) : n;
+    // Copy the header and note whether rows carry an "active" field
+    int has_active_field = 0;
+    if (fgets(line, sizeof(line), file)) {
+        has_active_field = strstr(line, "active") ? 1 : 0;
+        fputs(line, writer.out);
+    }
 
-        // Parse the line
-        int id, active = -1;
+    // Copy every row, replacing the matching one
+    while (fgets(line, sizeof(line), file)) {
+        int id, consumed = 0;
         char name[MAX_LINE], email[MAX_LINE], pass[MAX_LINE];
-        int fields = sscanf(line, "%d,%255[^,],%255[^,],%255[^,],%d", &id, name, email, pass, &active);
-
-        // Check if the ID matches and if the line has the correct number of fields
-        if ((fields == 4 || fields == 5) && id == user_id) {
-            struct flock lock = {.l_type = F_WRLCK, .l_whence = SEEK_SET, .l_start = offset, .l_len = linelen};
-            if (fcntl(fd, F_SETLKW, &lock) < 0) {
-                perror("Lock failed");
-                close(fd);
-                return FILE_ERROR;
-            }
-
-            // Update the correct field
-            if (field_choice == 1) strncpy(name, new_value, sizeof(name) - 1);
-            else if (field_choice == 2) strncpy(email, new_value, sizeof(email) - 1);
-            else if (field_choice == 3) strncpy(pass, new_value, sizeof(pass) - 1);
-            else if (field_choice == 4 && fields == 5) active = !active;
 
-            // Construct the updated line
-            char updated[MAX_LINE];
-            int w = (fields == 5) ? snprintf(updated, sizeof(updated), "%d,%s,%s,%s,%d,\n", id, name, email, pass, active)
-                                  : snprintf(updated, sizeof(updated), "%d,%s,%s,%s\n", id, name, email, pass);
+        if (found || sscanf(line, "%d,%255[^,],%255[^,],%255[^,\n]%n", &id, name, email, pass, &consumed) != 4 ||
+            id != user_id) {
+            fputs(line, writer.out);
+            continue;
+        }
+        found = 1;
 
-            // Write the updated line
-            pwrite(fd, updated, w, offset);
+        // Everything after the password (status, course lists) is kept as is
+        const char *rest = line + consumed;
 
-            // Release the lock
-            lock.l_type = F_UNLCK;
-            fcntl(fd, F_SETLK, &lock);
+        // Update the correct field
+        if (field_choice == 1) snprintf(name, sizeof(name), "%s", new_value);
+        else if (field_choice == 2) snprintf(email, sizeof(email), "%s", new_value);
+        else if (field_choice == 3) snprintf(pass, sizeof(pass), "%s", new_value);
 
-            // Close and return success
-            close(fd);
-            return SUCCESS;
+        int active, skip = 0;
+        if (field_choice == 4 && has_active_field && sscanf(rest, ",%d%n", &active, &skip) == 1) {
+            fprintf(writer.out, "%d,%s,%s,%s,%d%s", id, name, email, pass, !active, rest + skip);
+        } else {
+            fprintf(writer.out, "%d,%s,%s,%s%s", id, name, email, pass, rest);
         }
+    }
+    fclose(file);
 
-        // Move to the next line
-        offset += linelen;
+    int status = USER_NOT_FOUND;
+    if (found) {
+        status = snapshot_rewrite_commit(&writer);
+    } else {
+        snapshot_rewrite_abort(&writer);
     }
+    snapshot_unlock(lock_fd, filename);
 
-    close(fd);
-    return USER_NOT_FOUND;
+    // Faculty names are part of the cached catalogue; every field is part of a login
+    if (status == SUCCESS) {
+        db_version_bump();
+        auth_version_bump();
+    }
+    return status;
 }
 
 /**
@@ -343,19 +457,12 @@ static inline int update_user_details(const char *filename, int user_id, int fie
  * @return SUCCESS on success, USER_NOT_FOUND if user not found, FILE_ERROR on failure
  */
 static inline int view_user_details(const char *filename, int user_id) {
-    int fd = open(filename, O_RDONLY); // Open the file in read-only mode
+    int fd = snapshot_open(filename); // Open a snapshot of the file
     if (fd < 0) {
         perror("open failed"); // Print error message if open fails
         return FILE_ERROR; // Return error code
     }
 
-    struct flock lock = {.l_type = F_RDLCK, .l_whence = SEEK_SET, .l_start = 0, .l_len = 0}; // Create a read lock
-    if (fcntl(fd, F_SETLKW, &lock) == -1) {
-        perror("read lock failed"); // Print error message if lock fails
-        close(fd); // Close the file
-        return FILE_ERROR; // Return error code
-    }
-
     FILE *file = fdopen(fd, "r"); // Open the file as a FILE stream
     if (!file) {
         perror("fdopen failed"); // Print error message if fdopen fails
@@ -0,0 +1,250 @@
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include "utils.h"
+#include "protocol.h"
+#include "probes.h"
+
+#define ADMIT_BACKLOG        1024   ///< listen() backlog
+#define ADMIT_MAX_HANDLERS   256    ///< Connections served at once
+#define ADMIT_QUEUE_MAX      128    ///< Accepted connections waiting for a handler
+#define ADMIT_QUEUE_WAIT_MS  2000   ///< Longest a connection waits in the queue
+#define ADMIT_RETRY_MS       1000   ///< Base retry delay when the server is full
+#define ADMIT_IP_RATE        20     ///< New connections per second per client address
+#define ADMIT_IP_BURST       40
+#define ADMIT_USER_RATE      1      ///< Logins per second per user
+#define ADMIT_USER_BURST     5
+#define ADMIT_LOGIN_RATE     200    ///< Logins per second over all users
+#define ADMIT_LOGIN_BURST    400
+#define ADMIT_BUCKET_BITS    12
+#define ADMIT_BUCKETS        (1u << ADMIT_BUCKET_BITS)
+
+/**
+ * @brief Admission control for registration-window load.
+ *
+ * The accept loop keeps at most ADMIT_MAX_HANDLERS connections served at
+ * once. Further connections wait in a bounded FIFO for a handler to finish;
+ * when the queue is full, or a connection has waited ADMIT_QUEUE_WAIT_MS, it
+ * is shed: instead of the role prompt it gets PROTO_BUSY with a retry delay,
+ * and is closed. A token bucket per client address limits how fast one
+ * address may open connections, so one client cannot fill the queue.
+ *
+ * Logins take a token from the user's bucket and from a bucket shared by all
+ * logins. A login refused for lack of tokens is answered with LOGIN_BUSY, or
+ * FRAME_RETRY on a framed connection, and the delay after which a token will
+ * be there. Requests of sessions already logged in take no tokens, so under
+ * overload new logins wait while work in progress goes on.
+ *
+ * The buckets live in a shared anonymous mapping the server creates before
+ * it forks, so every connection handler counts against the same buckets.
+ * A bucket is one 64-bit word (tokens and the time they were counted)
+ * updated by compare-and-swap. Tables are indexed by a hash of the key; a
+ * key whose slots are both owned by busy keys shares a bucket with one of
+ * them, which only makes the limit stricter for both.
+ */
+
+/**
+ * @brief One token bucket.
+ */
+typedef struct {
+    volatile uint32_t key;      ///< Owner, 0 if free
+    uint32_t pad;
+    volatile uint64_t state;    ///< Thousandths of tokens (low 32 bits) and when they were counted (ms, high 32 bits)
+} AdmitBucket;
+
+/**
+ * @brief Buckets shared by the server and its connection handlers.
+ */
+typedef struct {
+    AdmitBucket logins;
+    AdmitBucket users[ADMIT_BUCKETS];
+    AdmitBucket ips[ADMIT_BUCKETS];
+} AdmitShared;
+
+/**
+ * @brief Connections accepted but not yet handed to a handler, oldest first.
+ */
+typedef struct {
+    int fd[ADMIT_QUEUE_MAX];
+    uint32_t since[ADMIT_QUEUE_MAX];
+    int head;
+    int count;
+} AdmitQueue;
+
+/**
+ * @brief Monotonic clock in ms; wraps every 49 days, which the buckets allow for.
+ */
+static inline uint32_t admit_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static inline uint64_t admit_full(uint32_t burst, uint32_t now) {
+    return (uint64_t)now << 32 | (uint64_t)burst * 1000;
+}
+
+/**
+ * @brief Tokens of a bucket, in thousandths, refilled up to now.
+ */
+static inline uint64_t admit_tokens(uint64_t state, uint32_t rate, uint32_t burst, uint32_t now) {
+    int32_t elapsed = (int32_t)(now - (uint32_t)(state >> 32));
+    // Slightly negative: another process counted a moment later. Very
+    // negative: the bucket was idle for weeks and the clock wrapped
+    if (elapsed < 0) elapsed = elapsed > -1000 ? 0 : INT32_MAX;
+    uint64_t tokens = (uint32_t)state + (uint64_t)elapsed * rate;
+    return tokens < (uint64_t)burst * 1000 ? tokens : (uint64_t)burst * 1000;
+}
+
+/**
+ * @brief Takes one token from a bucket.
+ * @return 0 if taken, otherwise the ms until one is available.
+ */
+static inline int admit_take(AdmitBucket *b, uint32_t rate, uint32_t burst, uint32_t now) {
+    while (1) {
+        uint64_t old = b->state;
+        uint64_t tokens = admit_tokens(old, rate, burst, now);
+        if (tokens < 1000) return (int)((1000 - tokens + rate - 1) / rate);
+        uint64_t next = (uint64_t)now << 32 | (tokens - 1000);
+        if (__sync_bool_compare_and_swap(&b->state, old, next)) return 0;
+    }
+}
+
+/**
+ * @brief Finds the bucket of a key, taking over an idle slot if it has none.
+ */
+static inline AdmitBucket *admit_bucket(AdmitBucket *table, uint32_t key, uint32_t rate, uint32_t burst, uint32_t now) {
+    if (!key) key = 1;
+    uint32_t h = (key * 2654435761u) >> (32 - ADMIT_BUCKET_BITS);
+    AdmitBucket *slots[2] = { &table[h], &table[(h + 1) & (ADMIT_BUCKETS - 1)] };
+    for (int i = 0; i < 2; i++) {
+        if (slots[i]->key == key) return slots[i];
+    }
+
+    // A bucket that has filled up again has forgotten its owner
+    for (int i = 0; i < 2; i++) {
+        if (slots[i]->key && admit_tokens(slots[i]->state, rate, burst, now) < (uint64_t)burst * 1000) continue;
+        slots[i]->state = admit_full(burst, now);
+        slots[i]->key = key;
+        return slots[i];
+    }
+    return slots[0];
+}
+
+/**
+ * @brief The shared buckets, mapped on first use.
+ *
+ * The server calls this before it forks its first handler; a process that
+ * gets NULL (the mapping failed) admits everything.
+ */
+static inline AdmitShared *admit_shared(void) {
+    static AdmitShared *shared = NULL;
+    if (shared) return shared;
+    void *m = mmap(NULL, sizeof(AdmitShared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (m == MAP_FAILED) return NULL;
+    shared = (AdmitShared *)m;
+    shared->logins.key = 1;
+    shared->logins.state = admit_full(ADMIT_LOGIN_BURST, admit_now_ms());
+    return shared;
+}
+
+/**
+ * @brief Admission of a new connection from a client address.
+ * @return 0 to admit, otherwise the ms the client should wait.
+ */
+static inline int admit_connection(uint32_t addr) {
+    AdmitShared *a = admit_shared();
+    if (!a) return 0;
+    uint32_t now = admit_now_ms();
+    return admit_take(admit_bucket(a->ips, addr, ADMIT_IP_RATE, ADMIT_IP_BURST, now), ADMIT_IP_RATE, ADMIT_IP_BURST, now);
+}
+
+/**
+ * @brief Admission of a login: a token from the user's bucket, then one from
+ *        the bucket of all logins.
+ *
+ * @param role  Role the user logs in as.
+ * @param email Email the user logs in with.
+ * @return 0 to go on with the login, otherwise the ms the client should wait.
+ */
+static inline int admit_login(int role, const char *email) {
+    AdmitShared *a = admit_shared();
+    if (!a) return 0;
+
+    // FNV-1a of the role and the email
+    uint32_t key = 2166136261u ^ (uint32_t)role;
+    for (const char *c = email; *c; c++) key = (key ^ (uint8_t)*c) * 16777619u;
+
+    uint32_t now = admit_now_ms();
+    AdmitBucket *user = admit_bucket(a->users, key, ADMIT_USER_RATE, ADMIT_USER_BURST, now);
+    int wait = admit_take(user, ADMIT_USER_RATE, ADMIT_USER_BURST, now);
+    return wait ? wait : admit_take(&a->logins, ADMIT_LOGIN_RATE, ADMIT_LOGIN_BURST, now);
+}
+
+/**
+ * @brief Retry delay for a connection shed because the server is full,
+ *        spread out so that shed clients do not all come back at once.
+ */
+static inline int admit_backoff(void) {
+    return ADMIT_RETRY_MS + rand() % ADMIT_RETRY_MS;
+}
+
+/**
+ * @brief Turns a connection away: sends PROTO_BUSY with the retry delay, then closes it.
+ */
+static inline void admit_shed(int fd, int retry_ms) {
+    char busy[64];
+    int len = snprintf(busy, sizeof(busy), PROTO_BUSY "%d ms\n", retry_ms);
+    PROBE_CONN_SHED(fd, retry_ms);
+    // Never block the accept loop on a slow client
+    send(fd, busy, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+    close(fd);
+}
+
+/**
+ * @brief Queues a connection for the next free handler.
+ * @return SUCCESS, or FAILURE if the queue is full.
+ */
+static inline int admit_queue_push(AdmitQueue *q, int fd, uint32_t now) {
+    if (q->count == ADMIT_QUEUE_MAX) return FAILURE;
+    int tail = (q->head + q->count) % ADMIT_QUEUE_MAX;
+    q->fd[tail] = fd;
+    q->since[tail] = now;
+    q->count++;
+    return SUCCESS;
+}
+
+/**
+ * @brief Takes the oldest queued connection.
+ * @return Its socket, or -1 if the queue is empty.
+ */
+static inline int admit_queue_pop(AdmitQueue *q) {
+    if (!q->count) return -1;
+    int fd = q->fd[q->head];
+    q->head = (q->head + 1) % ADMIT_QUEUE_MAX;
+    q->count--;
+    return fd;
+}
+
+/**
+ * @brief Sheds the connections that have waited too long.
+ * @return How long until the next one has, in ms, or -1 if the queue is empty.
+ */
+static inline int admit_queue_expire(AdmitQueue *q, uint32_t now) {
+    while (q->count) {
+        uint32_t waited = now - q->since[q->head];
+        if (waited < ADMIT_QUEUE_WAIT_MS) return (int)(ADMIT_QUEUE_WAIT_MS - waited);
+        admit_shed(admit_queue_pop(q), admit_backoff());
+    }
+    return -1;
+}
+
+#endif // ADMISSION_H
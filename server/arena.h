@@ -0,0 +1,192 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_BLOCK_SIZE 65536
+#define ARENA_ALIGN      16
+
+/**
+ * @brief Bump allocator for memory that lives until the end of a request.
+ *
+ * Allocations are carved from large blocks by advancing a pointer and are
+ * never freed one by one. Rewinding to a mark (or resetting) gives back
+ * everything allocated after it at once, so parse and format helpers need no
+ * cleanup on their error paths. Blocks are kept for the next request instead
+ * of being returned to malloc, except blocks made for a single oversized
+ * allocation.
+ *
+ * Each thread has its own request arena (request_arena()). A request handler
+ * resets it when the request ends; the public actions also rewind it to where
+ * they started, so callers that issue many actions in a row stay bounded.
+ */
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;            ///< Usable bytes
+    size_t used;
+} ArenaBlock;
+
+#define ARENA_HEADER ((sizeof(ArenaBlock) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+typedef struct {
+    ArenaBlock *head;
+    ArenaBlock *current;    ///< Blocks after it are empty spares
+} Arena;
+
+/**
+ * @brief Position in an arena to rewind to.
+ */
+typedef struct {
+    ArenaBlock *block;
+    size_t used;
+} ArenaMark;
+
+static inline char *arena_block_data(ArenaBlock *b) {
+    return (char *)b + ARENA_HEADER;
+}
+
+/**
+ * @brief Allocates uninitialised memory, aligned to ARENA_ALIGN.
+ * @return Pointer valid until the arena is rewound past it, or NULL if out of memory.
+ */
+static inline void *arena_alloc(Arena *a, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (size == 0) size = ARENA_ALIGN;
+
+    ArenaBlock *b = a->current;
+    if (!b || b->size - b->used < size) {
+        if (b && b->next && b->next->size >= size) {
+            b = b->next;
+        } else {
+            size_t block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+            ArenaBlock *fresh = malloc(ARENA_HEADER + block_size);
+            if (!fresh) return NULL;
+            fresh->size = block_size;
+            fresh->used = 0;
+            if (b) {
+                fresh->next = b->next;
+                b->next = fresh;
+            } else {
+                fresh->next = a->head;
+                a->head = fresh;
+            }
+            b = fresh;
+        }
+        a->current = b;
+    }
+
+    void *p = arena_block_data(b) + b->used;
+    b->used += size;
+    return p;
+}
+
+/**
+ * @brief Allocates zeroed memory for an array.
+ * @return Pointer, or NULL if out of memory.
+ */
+static inline void *arena_calloc(Arena *a, size_t count, size_t size) {
+    if (size && count > (size_t)-1 / size) return NULL;
+    void *p = arena_alloc(a, count * size);
+    if (p) memset(p, 0, count * size);
+    return p;
+}
+
+/**
+ * @brief Copies a string into the arena.
+ * @return The copy, or NULL if out of memory.
+ */
+static inline char *arena_strdup(Arena *a, const char *s) {
+    size_t len = strlen(s) + 1;
+    char *copy = arena_alloc(a, len);
+    if (copy) memcpy(copy, s, len);
+    return copy;
+}
+
+/**
+ * @brief Copies at most n bytes of a string into the arena, NUL-terminated.
+ * @return The copy, or NULL if out of memory.
+ */
+static inline char *arena_strndup(Arena *a, const char *s, size_t n) {
+    size_t len = strnlen(s, n);
+    char *copy = arena_alloc(a, len + 1);
+    if (copy) {
+        memcpy(copy, s, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
+static inline ArenaMark arena_mark(const Arena *a) {
+    ArenaMark m = { a->current, a->current ? a->current->used : 0 };
+    return m;
+}
+
+/**
+ * @brief Frees everything allocated after a mark.
+ *
+ * Later blocks become empty spares; oversized ones are released.
+ */
+static inline void arena_rewind(Arena *a, ArenaMark m) {
+    ArenaBlock *keep = m.block;
+    if (keep) {
+        keep->used = m.used;
+    } else if (a->head) {
+        // Nothing was allocated at the mark: keep the first block if it is a
+        // regular one
+        keep = a->head;
+        if (keep->size > ARENA_BLOCK_SIZE) {
+            a->head = keep->next;
+            free(keep);
+            a->current = NULL;
+            if (a->head) arena_rewind(a, m);
+            return;
+        }
+        keep->used = 0;
+    }
+    a->current = keep;
+    if (!keep) return;
+
+    ArenaBlock **link = &keep->next;
+    while (*link) {
+        ArenaBlock *b = *link;
+        if (b->size > ARENA_BLOCK_SIZE) {
+            *link = b->next;
+            free(b);
+        } else {
+            b->used = 0;
+            link = &b->next;
+        }
+    }
+}
+
+/**
+ * @brief Frees everything allocated from the arena, keeping its blocks.
+ */
+static inline void arena_reset(Arena *a) {
+    ArenaMark start = { NULL, 0 };
+    arena_rewind(a, start);
+}
+
+/**
+ * @brief Returns every block to malloc.
+ */
+static inline void arena_release(Arena *a) {
+    while (a->head) {
+        ArenaBlock *next = a->head->next;
+        free(a->head);
+        a->head = next;
+    }
+    a->current = NULL;
+}
+
+/**
+ * @brief The calling thread's request arena.
+ */
+static inline Arena *request_arena(void) {
+    static _Thread_local Arena arena;
+    return &arena;
+}
+
+#endif // ARENA_H
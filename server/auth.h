@@ -1,5 +1,9 @@
 #include "server.h"
 #include "types.h"
+#include "probes.h"
+#include "snapshot.h"
+#include "login_snapshot.h"
+#include "admission.h"
 #include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
@@ -13,84 +17,75 @@
 #define WRONG_USER -2
 #define DEACTIVATED -3
 #define INCORRECT_ROLE -4
+#define LOGIN_BUSY -5
 
 /**
- * @brief Authenticates a user (student, faculty, or admin) by reading from the corresponding CSV file.
- * 
- * @param client_fd File descriptor for the connected client.
- * @param role User role: STUDENT, FACULTY, or ADMIN.
- * 
- * @return int 
- *         LOGIN_SUCCESS (1)     on successful login,
+ * @brief Sends the login result, followed by the user's id and a welcome line on success.
+ */
+static inline void auth_reply(int client_fd, int role, int status, int id, const char *name) {
+    write(client_fd, &status, sizeof(int));
+    if (status != LOGIN_SUCCESS) return;
+
+    write(client_fd, &id, sizeof(int));
+    const char *role_str = (role == ADMIN) ? "Administrator" : (role == FACULTY) ? "Faculty" : "Student";
+    char welcome_msg[256];
+    snprintf(welcome_msg, sizeof(welcome_msg),
+             " Welcome %s! You are logged in as %s.                ║\n",
+             name, role_str);
+    write(client_fd, welcome_msg, strlen(welcome_msg));
+}
+
+/**
+ * @brief Checks a user's credentials against the corresponding CSV file.
+ *
+ * The login snapshot answers instead when it is current for the role's table.
+ *
+ * @param role     User role: STUDENT, FACULTY, or ADMIN.
+ * @param email    Email.
+ * @param password Password.
+ * @param name     Receives the user's name on success (MAX_NAME_LEN bytes).
+ *
+ * @return int
+ *         the user's ID (> 0)   on successful login,
  *         WRONG_PASS (-1)       if password mismatch,
  *         WRONG_USER (-2)       if email not found,
  *         DEACTIVATED (-3)      if student account is inactive,
  *         INCORRECT_ROLE (-4)   if role is unrecognized.
  */
-int authenticate_user(int client_fd, int role) {
-    char email[MAX_EMAIL_LEN] = {0};
-    char password[MAX_PASS_LEN] = {0};
-
-    // Prompt client for email and read input
-    write(client_fd, "Enter email: ", 14);
-    ssize_t bytes_read = read(client_fd, email, MAX_EMAIL_LEN - 1);
-    if (bytes_read <= 0) return WRONG_USER; // Handle read error
-    email[bytes_read] = '\0';
-    email[strcspn(email, "\r\n")] = '\0'; // Remove newline characters
-
-    // Prompt client for password and read input
-    write(client_fd, "Enter password: ", 17);
-    bytes_read = read(client_fd, password, MAX_PASS_LEN - 1);
-    if (bytes_read <= 0) return WRONG_USER; // Handle read error
-    password[bytes_read] = '\0';
-    password[strcspn(password, "\r\n")] = '\0'; // Remove newline characters
+static inline int auth_lookup(int role, const char *email, const char *password, char *name) {
+    PROBE_AUTH_START(role);
 
     // Determine the correct database file based on role
-    const char *filename = NULL;
-    switch (role) {
-        case STUDENT:  filename = "../database/students.csv"; break;
-        case ADMIN:    filename = "../database/admins.csv";   break;
-        case FACULTY:  filename = "../database/faculty.csv";  break;
-        default:       return INCORRECT_ROLE; // Invalid role
+    const char *filename = login_table_path(role);
+    if (!filename) {
+        PROBE_AUTH_FINISH(role, INCORRECT_ROLE, 0);
+        return INCORRECT_ROLE; // Invalid role
     }
 
-    // Open the user database file
-    int fd = open(filename, O_RDONLY);
-    if (fd == -1) {
-        perror("Failed to open user database");
-        int status = WRONG_USER;
-        write(client_fd, &status, sizeof(int));
-        return WRONG_USER;
-    }
-
-    // Set up file lock for reading
-    struct flock lock = {
-        .l_type = F_RDLCK,
-        .l_whence = SEEK_SET,
-        .l_start = 0,
-        .l_len = 0
-    };
-
-    // Acquire file lock
-    if (fcntl(fd, F_SETLKW, &lock) == -1) {
-        perror("Failed to acquire read lock");
-        close(fd);
-        int status = WRONG_USER;
-        write(client_fd, &status, sizeof(int));
-        return WRONG_USER;
+    // Answer from the login snapshot unless the table changed since it was built
+    LoginEntry entry;
+    int found = login_snapshot_find(role, email, &entry);
+    if (found >= 0) {
+        int status = !found ? WRONG_USER
+                   : strcmp(entry.password, password) != 0 ? WRONG_PASS
+                   : !entry.active ? DEACTIVATED
+                   : LOGIN_SUCCESS;
+        if (status == LOGIN_SUCCESS) snprintf(name, MAX_NAME_LEN, "%s", entry.name);
+        PROBE_AUTH_FINISH(role, status, status == LOGIN_SUCCESS ? entry.id : 0);
+        return status == LOGIN_SUCCESS ? entry.id : status;
     }
 
-    // Convert file descriptor to FILE pointer for easier reading
-    FILE *file = fdopen(fd, "r");
+    // Open a snapshot of the user database; logins never wait for writers
+    FILE *file = snapshot_fopen(filename);
     if (!file) {
-        perror("fdopen failed");
-        close(fd);
-        int status = WRONG_USER;
-        write(client_fd, &status, sizeof(int));
+        perror("Failed to open user database");
+        PROBE_AUTH_FINISH(role, WRONG_USER, 0);
         return WRONG_USER;
     }
 
     char line[256];
+    int auth_status = WRONG_USER; // Reported by the auth_finish probe
+    int auth_id = 0;
     // Check for header and skip if present
     if (fgets(line, sizeof(line), file) && strncmp(line, "id,", 3) == 0) {
         // Skip header
@@ -100,82 +95,79 @@ int authenticate_user(int client_fd, int role) {
 
     // Read and process each line from the file
     while (fgets(line, sizeof(line), file)) {
-        int id = 0;
-        char name[MAX_NAME_LEN] = {0};
+        int id = 0, active = 1;
+        char user_name[MAX_NAME_LEN] = {0};
         char mail[MAX_EMAIL_LEN] = {0};
         char pass[MAX_PASS_LEN] = {0};
 
         // Parse the line based on role
         if (role == STUDENT) {
-            int active = 0;
-            if (sscanf(line, "%d,%[^,],%[^,],%[^,],%d", &id, name, mail, pass, &active) < 5)
+            if (sscanf(line, "%d,%99[^,],%99[^,],%63[^,],%d", &id, user_name, mail, pass, &active) < 5)
                 continue; // Skip malformed lines
-
-            mail[strcspn(mail, "\r\n")] = '\0';
-            pass[strcspn(pass, "\r\n")] = '\0';
-
-            if (strcmp(mail, email) == 0) {
-                if (strcmp(pass, password) == 0) {
-                    if (!active) {
-                        int status = DEACTIVATED;
-                        write(client_fd, &status, sizeof(int));
-                        goto cleanup; // Account is inactive
-                    }
-
-                    int status = LOGIN_SUCCESS;
-                    write(client_fd, &status, sizeof(int));
-                    write(client_fd, &id, sizeof(int));
-
-                    char welcome_msg[256];
-                    snprintf(welcome_msg, sizeof(welcome_msg),
-                             " Welcome %s! You are logged in as Student.                ║\n",
-                             name);
-                    write(client_fd, welcome_msg, strlen(welcome_msg));
-                    goto cleanup;
-                } else {
-                    int status = WRONG_PASS;
-                    write(client_fd, &status, sizeof(int));
-                    goto cleanup; // Password mismatch
-                }
-            }
-        } else {
-            if (sscanf(line, "%d,%[^,],%[^,],%[^,\n]", &id, name, mail, pass) < 4)
-                continue; // Skip malformed lines
-
-            mail[strcspn(mail, "\r\n")] = '\0';
-            pass[strcspn(pass, "\r\n")] = '\0';
-
-            if (strcmp(mail, email) == 0) {
-                if (strcmp(pass, password) == 0) {
-                    int status = LOGIN_SUCCESS;
-                    write(client_fd, &status, sizeof(int));
-                    write(client_fd, &id, sizeof(int));
-
-                    const char *role_str = (role == ADMIN) ? "Administrator" : "Faculty";
-                    char welcome_msg[256];
-                    snprintf(welcome_msg, sizeof(welcome_msg),
-                             " Welcome %s! You are logged in as %s.                ║\n",
-                             name, role_str);
-                    write(client_fd, welcome_msg, strlen(welcome_msg));
-                    goto cleanup;
-                } else {
-                    int status = WRONG_PASS;
-                    write(client_fd, &status, sizeof(int));
-                    goto cleanup; // Password mismatch
-                }
+        } else if (sscanf(line, "%d,%99[^,],%99[^,],%63[^,\n]", &id, user_name, mail, pass) < 4) {
+            continue; // Skip malformed lines
+        }
+        mail[strcspn(mail, "\r\n")] = '\0';
+        pass[strcspn(pass, "\r\n")] = '\0';
+
+        if (strcmp(mail, email) == 0) {
+            // Password mismatch, inactive account or success
+            auth_status = strcmp(pass, password) != 0 ? WRONG_PASS : !active ? DEACTIVATED : LOGIN_SUCCESS;
+            if (auth_status == LOGIN_SUCCESS) {
+                auth_id = id;
+                snprintf(name, MAX_NAME_LEN, "%s", user_name);
             }
+            break;
         }
     }
 
-    // If no matching user is found, send WRONG_USER status
-    {
-        int status = WRONG_USER;
+    fclose(file); // Close the file
+    PROBE_AUTH_FINISH(role, auth_status, auth_id);
+    return auth_status == LOGIN_SUCCESS ? auth_id : auth_status;
+}
+
+/**
+ * @brief Authenticates a user (student, faculty, or admin) by prompting for
+ *        email and password and checking them with auth_lookup().
+ * 
+ * @param client_fd File descriptor for the connected client.
+ * @param role User role: STUDENT, FACULTY, or ADMIN.
+ * 
+ * @return int 
+ *         the user's ID (> 0) on successful login, otherwise the failure
+ *         status sent to the client (see auth_lookup()), or LOGIN_BUSY,
+ *         sent with the ms after which to try again.
+ */
+int authenticate_user(int client_fd, int role) {
+    char email[MAX_EMAIL_LEN] = {0};
+    char password[MAX_PASS_LEN] = {0};
+
+    // Prompt client for email and read input
+    write(client_fd, "Enter email: ", 14);
+    ssize_t bytes_read = read(client_fd, email, MAX_EMAIL_LEN - 1);
+    if (bytes_read <= 0) return WRONG_USER; // Handle read error
+    email[bytes_read] = '\0';
+    email[strcspn(email, "\r\n")] = '\0'; // Remove newline characters
+
+    // Prompt client for password and read input
+    write(client_fd, "Enter password: ", 17);
+    bytes_read = read(client_fd, password, MAX_PASS_LEN - 1);
+    if (bytes_read <= 0) return WRONG_USER; // Handle read error
+    password[bytes_read] = '\0';
+    password[strcspn(password, "\r\n")] = '\0'; // Remove newline characters
+
+    // Under load new logins wait; the client is told for how long
+    int wait = admit_login(role, email);
+    if (wait) {
+        int status = LOGIN_BUSY;
         write(client_fd, &status, sizeof(int));
+        write(client_fd, &wait, sizeof(int));
+        return LOGIN_BUSY;
     }
 
-cleanup:
-    lock.l_type = F_UNLCK;
-    fcntl(fd, F_SETLK, &lock); // Release the file lock
-    fclose(file); // Close the file
-    return 0;
+    char name[MAX_NAME_LEN] = {0};
+    int result = auth_lookup(role, email, password, name);
+    if (result == INCORRECT_ROLE) return result; // Nothing is sent for an invalid role
+    auth_reply(client_fd, role, result > 0 ? LOGIN_SUCCESS : result, result, name);
+    return result;
 }
@@ -0,0 +1,72 @@
+#ifndef AUTH_VERSION_H
+#define AUTH_VERSION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#define AUTH_VERSION_FILE "../database/auth_version"
+
+/**
+ * @brief Reads the current login data version.
+ *
+ * The version is a counter stored as text in AUTH_VERSION_FILE. Only writes
+ * that change a login (a new user, a password, an email, a name or an active
+ * flag) bump it; enrollments and course changes rewrite the user tables but
+ * leave it alone, so the login snapshot stays usable across them.
+ *
+ * @return unsigned long Current version, or 0 if the file does not exist yet.
+ */
+static inline unsigned long auth_version_read(void) {
+    int fd = open(AUTH_VERSION_FILE, O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct flock lock = { .l_type = F_RDLCK, .l_whence = SEEK_SET };
+    if (fcntl(fd, F_SETLKW, &lock) == -1) {
+        close(fd);
+        return 0;
+    }
+
+    char buf[32] = {0};
+    pread(fd, buf, sizeof(buf) - 1, 0);
+
+    lock.l_type = F_UNLCK;
+    fcntl(fd, F_SETLK, &lock);
+    close(fd);
+    return strtoul(buf, NULL, 10);
+}
+
+/**
+ * @brief Increments the login data version.
+ *
+ * Must be called after the changed table is published, so that a login
+ * snapshot built under the new version always contains the change.
+ *
+ * @return unsigned long The new version, or 0 on failure.
+ */
+static inline unsigned long auth_version_bump(void) {
+    int fd = open(AUTH_VERSION_FILE, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return 0;
+
+    struct flock lock = { .l_type = F_WRLCK, .l_whence = SEEK_SET };
+    if (fcntl(fd, F_SETLKW, &lock) == -1) {
+        close(fd);
+        return 0;
+    }
+
+    char buf[32] = {0};
+    pread(fd, buf, sizeof(buf) - 1, 0);
+    unsigned long version = strtoul(buf, NULL, 10) + 1;
+
+    int len = snprintf(buf, sizeof(buf), "%lu\n", version);
+    pwrite(fd, buf, len, 0);
+    ftruncate(fd, len);
+
+    lock.l_type = F_UNLCK;
+    fcntl(fd, F_SETLK, &lock);
+    close(fd);
+    return version;
+}
+
+#endif // AUTH_VERSION_H
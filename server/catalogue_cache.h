@@ -0,0 +1,567 @@
+#ifndef CATALOGUE_CACHE_H
+#define CATALOGUE_CACHE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "types.h"
+#include "utils.h"
+#include "db_version.h"
+#include "snapshot.h"
+#include "strpool.h"
+#include "protocol.h"
+
+#define CATALOGUE_CACHE_FILE  "../database/catalogue.cache"
+#define CATALOGUE_COURSES_DB  "../database/courses.csv"
+#define CATALOGUE_FACULTY_DB  "../database/faculty.csv"
+#define CATALOGUE_LINE_LEN    1024
+#define CATALOGUE_ROW_FMT     "%d,%s,%s,%d,%d,%d,%d,%s\n"
+
+/**
+ * @brief One course row of the catalogue, already joined with its faculty name.
+ *
+ * Only used to pass a row in; the catalogue stores each field as a column.
+ * Strings are ids in the catalogue's string pool; see catalogue_str().
+ */
+typedef struct {
+    int id;
+    StrId code;
+    StrId name;
+    int capacity;
+    int enrolled;
+    int credits;
+    int faculty_id;
+    StrId faculty_name;
+} CatalogueEntry;
+
+#define CATALOGUE_COLUMNS 8
+
+/**
+ * @brief The whole catalogue as of one data version, stored by column.
+ *
+ * Listings and search filters look at a few numeric fields of every course
+ * but at the names of only the courses they show. Each field is therefore a
+ * separate array of 4-byte values, with the hot columns first: a scan of
+ * capacity and enrolled over 50k courses reads 400 KB of contiguous ints
+ * instead of striding through whole rows, and the names stay out of the
+ * cache until a row is printed. All columns share one allocation.
+ */
+typedef struct {
+    unsigned long version;
+    int loaded;                            ///< 1 once the columns match version
+    int count;
+    int cap;
+    // Hot columns, read for every course
+    int *ids;
+    StrId *codes;
+    int *capacity;
+    int *enrolled;
+    int *credits;
+    int *faculty_ids;
+    // Cold columns, read for the courses shown
+    StrId *names;
+    StrId *faculty_names;
+    char *block;                           ///< Storage of every column
+    StrPool strings;                       ///< Codes, course names and faculty names
+} CatalogueCache;
+
+/**
+ * @brief Returns one of a catalogue's strings.
+ */
+static inline const char *catalogue_str(const CatalogueCache *c, StrId id) {
+    return strpool_get(&c->strings, id);
+}
+
+/**
+ * @brief Copies column k of the catalogue into a new block of cap rows.
+ * @return The column's new address.
+ */
+static inline void *catalogue_move_column(char *block, int k, int cap, const void *old, int count) {
+    char *column = block + (size_t)k * cap * sizeof(int);
+    if (count) memcpy(column, old, (size_t)count * sizeof(int));
+    return column;
+}
+
+/**
+ * @brief Appends a row to the catalogue, growing the columns as needed.
+ * @return SUCCESS or FAILURE on allocation failure.
+ */
+static inline int catalogue_append(CatalogueCache *c, const CatalogueEntry *e) {
+    if (c->count == c->cap) {
+        int new_cap = c->cap ? c->cap * 2 : 64;
+        char *block = malloc((size_t)new_cap * CATALOGUE_COLUMNS * sizeof(int));
+        if (!block) return FAILURE;
+        c->ids = catalogue_move_column(block, 0, new_cap, c->ids, c->count);
+        c->codes = catalogue_move_column(block, 1, new_cap, c->codes, c->count);
+        c->capacity = catalogue_move_column(block, 2, new_cap, c->capacity, c->count);
+        c->enrolled = catalogue_move_column(block, 3, new_cap, c->enrolled, c->count);
+        c->credits = catalogue_move_column(block, 4, new_cap, c->credits, c->count);
+        c->faculty_ids = catalogue_move_column(block, 5, new_cap, c->faculty_ids, c->count);
+        c->names = catalogue_move_column(block, 6, new_cap, c->names, c->count);
+        c->faculty_names = catalogue_move_column(block, 7, new_cap, c->faculty_names, c->count);
+        free(c->block);
+        c->block = block;
+        c->cap = new_cap;
+    }
+
+    int i = c->count++;
+    c->ids[i] = e->id;
+    c->codes[i] = e->code;
+    c->capacity[i] = e->capacity;
+    c->enrolled[i] = e->enrolled;
+    c->credits[i] = e->credits;
+    c->faculty_ids[i] = e->faculty_id;
+    c->names[i] = e->name;
+    c->faculty_names[i] = e->faculty_name;
+    return SUCCESS;
+}
+
+/**
+ * @brief Parses a row as written with CATALOGUE_ROW_FMT, interning its strings.
+ * @return SUCCESS, or FAILURE if the row is malformed or out of memory.
+ */
+static inline int catalogue_parse_row(CatalogueCache *c, const char *line, CatalogueEntry *e) {
+    char code[32], name[MAX_COURSE_NAME_LEN], faculty_name[MAX_NAME_LEN];
+    memset(e, 0, sizeof(*e));
+    if (sscanf(line, "%d,%31[^,],%99[^,],%d,%d,%d,%d,%99[^\n]",
+               &e->id, code, name, &e->capacity, &e->enrolled,
+               &e->credits, &e->faculty_id, faculty_name) != 8) {
+        return FAILURE;
+    }
+    e->code = strpool_intern(&c->strings, code);
+    e->name = strpool_intern(&c->strings, name);
+    e->faculty_name = strpool_intern(&c->strings, faculty_name);
+    return e->code == STR_NONE || e->name == STR_NONE || e->faculty_name == STR_NONE ? FAILURE : SUCCESS;
+}
+
+/**
+ * @brief Reads the cache file if it was written for the given version.
+ *
+ * A row that does not parse makes the whole file a miss, so a damaged cache
+ * is rebuilt instead of serving a catalogue with courses missing.
+ *
+ * @return 1 if the cache was loaded, 0 if it is missing, stale or damaged.
+ */
+static inline int catalogue_read_file(CatalogueCache *c, unsigned long version) {
+    FILE *fp = fopen(CATALOGUE_CACHE_FILE, "r");
+    if (!fp) return 0;
+
+    char line[CATALOGUE_LINE_LEN];
+    unsigned long file_version = 0;
+    if (!fgets(line, sizeof(line), fp) || sscanf(line, "version=%lu", &file_version) != 1 ||
+        file_version != version) {
+        fclose(fp);
+        return 0;
+    }
+
+    c->count = 0;
+    strpool_clear(&c->strings);
+    int loaded = 1;
+    while (loaded && fgets(line, sizeof(line), fp)) {
+        CatalogueEntry e;
+        loaded = strchr(line, '\n') && catalogue_parse_row(c, line, &e) == SUCCESS &&
+                 catalogue_append(c, &e) == SUCCESS;
+    }
+    fclose(fp);
+    return loaded;
+}
+
+/**
+ * @brief A faculty's name, for joining it onto their courses.
+ */
+typedef struct {
+    int id;
+    StrId name;
+} CatalogueFaculty;
+
+static int catalogue_faculty_cmp(const void *a, const void *b) {
+    const CatalogueFaculty *x = a, *y = b;
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+/**
+ * @brief Rebuilds the catalogue from faculty.csv and courses.csv.
+ *
+ * Faculty names are read in one pass up front and sorted by id, so building
+ * the catalogue costs one scan of each table and a binary search per course
+ * instead of one faculty scan per course. Both tables
+ * are read as snapshots, so a rebuild never waits for writers.
+ *
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int catalogue_rebuild(CatalogueCache *c) {
+    CatalogueFaculty *faculty = NULL;
+    int faculty_count = 0, faculty_cap = 0;
+    char line[CATALOGUE_LINE_LEN];
+
+    c->count = 0;
+    strpool_clear(&c->strings);
+    StrId unknown = strpool_intern(&c->strings, "Unknown");
+
+    int fd = snapshot_open(CATALOGUE_FACULTY_DB);
+    if (fd >= 0) {
+        while (read_line(fd, line, sizeof(line)) > 0) {
+            int fid;
+            char name[MAX_NAME_LEN];
+            if (sscanf(line, "%d,%99[^,]", &fid, name) != 2) continue;
+            if (faculty_count == faculty_cap) {
+                faculty_cap = faculty_cap ? faculty_cap * 2 : 32;
+                void *grown = realloc(faculty, faculty_cap * sizeof(*faculty));
+                if (!grown) break;
+                faculty = grown;
+            }
+            faculty[faculty_count].id = fid;
+            faculty[faculty_count].name = strpool_intern(&c->strings, name);
+            faculty_count++;
+        }
+        close(fd);
+    }
+    if (faculty_count) qsort(faculty, faculty_count, sizeof(*faculty), catalogue_faculty_cmp);
+
+    fd = snapshot_open(CATALOGUE_COURSES_DB);
+    if (fd < 0) {
+        free(faculty);
+        return FILE_ERROR;
+    }
+
+    read_line(fd, line, sizeof(line)); // Skip header
+    while (read_line(fd, line, sizeof(line)) > 0) {
+        CatalogueEntry e = {0};
+        char code[32], name[MAX_COURSE_NAME_LEN];
+        if (sscanf(line, "%d,%31[^,],%99[^,],%d,%d,%d,%d",
+                   &e.id, code, name, &e.capacity, &e.enrolled, &e.credits, &e.faculty_id) != 7)
+            continue;
+        e.code = strpool_intern(&c->strings, code);
+        e.name = strpool_intern(&c->strings, name);
+
+        CatalogueFaculty key = { .id = e.faculty_id };
+        const CatalogueFaculty *f = faculty_count ? bsearch(&key, faculty, faculty_count, sizeof(*faculty),
+                                                            catalogue_faculty_cmp) : NULL;
+        e.faculty_name = f ? f->name : unknown;
+
+        if (e.code == STR_NONE || e.name == STR_NONE || catalogue_append(c, &e) != SUCCESS) break;
+    }
+
+    close(fd);
+    free(faculty);
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes the catalogue to the shared cache file for other clients.
+ *
+ * The file is written to a temp path of this process's own and renamed into
+ * place, so readers see either the old or the new cache, never a partial one,
+ * and clients that miss the cache at the same time never share a temp file.
+ */
+static inline void catalogue_write_file(const CatalogueCache *c) {
+    char temp_path[SNAPSHOT_PATH_LEN];
+    snprintf(temp_path, sizeof(temp_path), "%s.%d.tmp", CATALOGUE_CACHE_FILE, (int)getpid());
+    FILE *fp = fopen(temp_path, "w");
+    if (!fp) return;
+
+    fprintf(fp, "version=%lu\n", c->version);
+    for (int i = 0; i < c->count; i++) {
+        fprintf(fp, CATALOGUE_ROW_FMT, c->ids[i], catalogue_str(c, c->codes[i]),
+                catalogue_str(c, c->names[i]), c->capacity[i], c->enrolled[i], c->credits[i],
+                c->faculty_ids[i], catalogue_str(c, c->faculty_names[i]));
+    }
+
+    int ok = !ferror(fp);
+    if (fclose(fp) != 0 || !ok || rename(temp_path, CATALOGUE_CACHE_FILE) < 0)
+        unlink(temp_path);
+}
+
+static int catalogue_id_cmp(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Encodes the changes a client needs to bring its copy up to date.
+ *
+ * The payload starts with "version=V full" or "version=V delta". A full
+ * payload lists every row; a delta lists the rows of the courses added or
+ * changed since the client's version and "-id" for each course removed.
+ * Rows use CATALOGUE_ROW_FMT. A delta is sent whenever the change log
+ * reaches back to the client's version, which keeps the common case (a few
+ * enrollments since the last sync) to a few hundred bytes.
+ *
+ * @param c     Current catalogue.
+ * @param have  1 if the client holds a copy.
+ * @param since Version of the client's copy.
+ * @param out   Receives the payload.
+ * @return SUCCESS or FAILURE if out of memory.
+ */
+static inline int catalogue_encode_delta(const CatalogueCache *c, int have, unsigned long since, FrameBuf *out) {
+    int changed_count = -1;
+    int *changed = NULL;
+    if (have && since == c->version) {
+        changed_count = 0;
+    } else if (have && since < c->version) {
+        // More changes than rows cost more than the full catalogue
+        changed = malloc((c->count + 1) * sizeof(int));
+        if (changed) changed_count = db_version_changes(since, c->version, changed, c->count + 1);
+    }
+
+    int status = framebuf_printf(out, "version=%lu %s\n", c->version, changed_count < 0 ? "full" : "delta");
+    char *sent = NULL;
+    if (changed_count > 0) {
+        qsort(changed, changed_count, sizeof(int), catalogue_id_cmp);
+        int unique = 1;
+        for (int k = 1; k < changed_count; k++) {
+            if (changed[k] != changed[unique - 1]) changed[unique++] = changed[k];
+        }
+        changed_count = unique;
+        sent = calloc(changed_count, 1);
+        if (!sent) status = FAILURE;
+    }
+
+    for (int i = 0; i < c->count && status == SUCCESS && changed_count != 0; i++) {
+        if (changed_count > 0) {
+            int *hit = bsearch(&c->ids[i], changed, changed_count, sizeof(int), catalogue_id_cmp);
+            if (!hit) continue;
+            sent[hit - changed] = 1;
+        }
+        status = framebuf_printf(out, CATALOGUE_ROW_FMT, c->ids[i], catalogue_str(c, c->codes[i]),
+                                 catalogue_str(c, c->names[i]), c->capacity[i], c->enrolled[i], c->credits[i],
+                                 c->faculty_ids[i], catalogue_str(c, c->faculty_names[i]));
+    }
+    for (int k = 0; k < changed_count && status == SUCCESS; k++) {
+        if (!sent[k]) status = framebuf_printf(out, "-%d\n", changed[k]);
+    }
+    free(sent);
+    free(changed);
+    return status;
+}
+
+/**
+ * @brief One changed course of a delta, while it is applied.
+ */
+typedef struct {
+    int id;
+    int removed;
+    int applied;
+    CatalogueEntry row;
+} CatalogueChange;
+
+static int catalogue_change_cmp(const void *a, const void *b) {
+    return catalogue_id_cmp(&((const CatalogueChange *)a)->id, &((const CatalogueChange *)b)->id);
+}
+
+/**
+ * @brief Brings a catalogue up to date with a payload from catalogue_encode_delta().
+ *
+ * A delta is merged in one pass over the id column: changed rows are
+ * overwritten in place, removed ones are dropped, and new ones appended.
+ *
+ * @param c       Catalogue to update.
+ * @param payload NUL-terminated payload; modified while parsing.
+ * @return SUCCESS, or FAILURE if the payload is malformed or out of memory.
+ */
+static inline int catalogue_apply_delta(CatalogueCache *c, char *payload) {
+    unsigned long version;
+    char kind[8];
+    if (sscanf(payload, "version=%lu %7s", &version, kind) != 2) return FAILURE;
+    char *line = strchr(payload, '\n');
+    line = line ? line + 1 : payload + strlen(payload);
+
+    int full = strcmp(kind, "full") == 0;
+    if (full) {
+        c->count = 0;
+        strpool_clear(&c->strings);
+    }
+
+    int lines = 0;
+    for (const char *p = line; *p; p++) lines += *p == '\n';
+    CatalogueChange *changes = full ? NULL : malloc((lines + 1) * sizeof(CatalogueChange));
+    if (!full && !changes) return FAILURE;
+
+    int count = 0, status = SUCCESS;
+    while (*line && status == SUCCESS) {
+        char *end = strchr(line, '\n');
+        if (end) *end = '\0';
+        if (full) {
+            CatalogueEntry e;
+            if (catalogue_parse_row(c, line, &e) == SUCCESS) status = catalogue_append(c, &e);
+        } else {
+            CatalogueChange *ch = &changes[count];
+            memset(ch, 0, sizeof(*ch));
+            if (line[0] == '-') {
+                ch->id = atoi(line + 1);
+                ch->removed = 1;
+                count++;
+            } else if (catalogue_parse_row(c, line, &ch->row) == SUCCESS) {
+                ch->id = ch->row.id;
+                count++;
+            }
+        }
+        line = end ? end + 1 : line + strlen(line);
+    }
+
+    if (!full && status == SUCCESS) {
+        qsort(changes, count, sizeof(CatalogueChange), catalogue_change_cmp);
+        int kept = 0;
+        for (int i = 0; i < c->count; i++) {
+            CatalogueChange key = { .id = c->ids[i] };
+            CatalogueChange *ch = count ? bsearch(&key, changes, count, sizeof(CatalogueChange), catalogue_change_cmp) : NULL;
+            if (ch) {
+                ch->applied = 1;
+                if (ch->removed) continue;
+                c->codes[i] = ch->row.code;
+                c->names[i] = ch->row.name;
+                c->capacity[i] = ch->row.capacity;
+                c->enrolled[i] = ch->row.enrolled;
+                c->credits[i] = ch->row.credits;
+                c->faculty_ids[i] = ch->row.faculty_id;
+                c->faculty_names[i] = ch->row.faculty_name;
+            }
+            if (kept != i) {
+                c->ids[kept] = c->ids[i];
+                c->codes[kept] = c->codes[i];
+                c->names[kept] = c->names[i];
+                c->capacity[kept] = c->capacity[i];
+                c->enrolled[kept] = c->enrolled[i];
+                c->credits[kept] = c->credits[i];
+                c->faculty_ids[kept] = c->faculty_ids[i];
+                c->faculty_names[kept] = c->faculty_names[i];
+            }
+            kept++;
+        }
+        c->count = kept;
+        for (int k = 0; k < count && status == SUCCESS; k++) {
+            if (!changes[k].applied && !changes[k].removed) status = catalogue_append(c, &changes[k].row);
+        }
+    }
+    free(changes);
+
+    c->version = version;
+    c->loaded = status == SUCCESS;
+    return status;
+}
+
+/**
+ * @brief Connection the catalogue is synced over, or -1 to read the tables.
+ */
+static inline int *catalogue_remote(void) {
+    static int fd = -1;
+    return &fd;
+}
+
+/**
+ * @brief Makes catalogue_get() sync from the server over an authenticated
+ *        connection instead of reading the tables.
+ */
+static inline void catalogue_attach(int fd) {
+    *catalogue_remote() = fd;
+}
+
+/**
+ * @brief Sends the server the version of a cached catalogue and applies the reply.
+ *
+ * On any error the connection is detached, so later calls read the tables.
+ *
+ * @return SUCCESS or FAILURE.
+ */
+static inline int catalogue_sync(CatalogueCache *c) {
+    int fd = *catalogue_remote();
+    char request[32];
+    int len = c->loaded ? snprintf(request, sizeof(request), "%lu", c->version) : 0;
+
+    uint32_t type, reply_len;
+    char *reply = NULL;
+    int status = frame_send(fd, FRAME_CATALOGUE_SYNC, request, len);
+    if (status == SUCCESS) status = frame_recv(fd, &type, &reply, &reply_len);
+    if (status == SUCCESS && type == FRAME_CATALOGUE_DELTA) {
+        status = catalogue_apply_delta(c, reply);
+    } else {
+        status = FAILURE;
+    }
+    free(reply);
+
+    if (status != SUCCESS) {
+        c->loaded = 0;
+        catalogue_attach(-1);
+    }
+    return status;
+}
+
+/**
+ * @brief Returns the catalogue for the current data version.
+ *
+ * On a client attached to the server (catalogue_attach()), the copy is
+ * brought up to date with a delta from the server. Otherwise the lookup
+ * order is: the in-process copy, then the shared cache file, then a
+ * rebuild from the CSV tables (which also refreshes the cache file). Writers
+ * invalidate all three by bumping the data version.
+ *
+ * @return Pointer to the process-wide cache, or NULL if the catalogue could not be read.
+ */
+static inline const CatalogueCache *catalogue_get(void) {
+    static CatalogueCache cache;
+    if (*catalogue_remote() >= 0 && catalogue_sync(&cache) == SUCCESS) return &cache;
+
+    unsigned long version = db_version_read();
+
+    if (cache.loaded && cache.version == version) return &cache;
+
+    cache.loaded = 0;
+    if (!catalogue_read_file(&cache, version)) {
+        if (catalogue_rebuild(&cache) != SUCCESS) return NULL;
+        cache.version = version;
+        catalogue_write_file(&cache);
+    }
+    cache.version = version;
+    cache.loaded = 1;
+    return &cache;
+}
+
+/**
+ * @brief Looks up the ids of a comma-separated list of course codes.
+ *
+ * Codes the catalogue does not hold are left out, so a course is in the
+ * list exactly when its code id is among the returned ones.
+ *
+ * @param c    Catalogue.
+ * @param list Comma-separated course codes.
+ * @param ids  Receives the ids.
+ * @param max  Capacity of ids.
+ * @return Number of ids written.
+ */
+static inline int catalogue_code_ids(const CatalogueCache *c, const char *list, StrId *ids, int max) {
+    int count = 0;
+    const char *p = list;
+    while (*p && count < max) {
+        while (*p == ' ') p++;
+        size_t len = strcspn(p, ", \r\n");
+        StrId id = len ? strpool_find_n(&c->strings, p, len) : STR_NONE;
+        if (id != STR_NONE) ids[count++] = id;
+        p += len;
+        p += strcspn(p, ",");
+        if (*p) p++;
+    }
+    return count;
+}
+
+/**
+ * @brief Answers a FRAME_CATALOGUE_SYNC request on the server.
+ *
+ * @param fd      Client connection.
+ * @param payload Request payload: the client's catalogue version, or "" if it has none.
+ * @return SUCCESS, or FAILURE if the reply could not be sent.
+ */
+static inline int catalogue_serve_sync(int fd, const char *payload) {
+    const CatalogueCache *c = catalogue_get();
+    if (!c) return frame_send(fd, FRAME_ERROR, NULL, 0);
+
+    FrameBuf out = {0};
+    int status = catalogue_encode_delta(c, payload[0] != '\0', strtoul(payload, NULL, 10), &out);
+    status = status == SUCCESS ? frame_send(fd, FRAME_CATALOGUE_DELTA, out.data, out.len)
+                               : frame_send(fd, FRAME_ERROR, NULL, 0);
+    framebuf_free(&out);
+    return status;
+}
+
+#endif // CATALOGUE_CACHE_H
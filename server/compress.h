@@ -0,0 +1,203 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+#define LZ_MIN_MATCH   4
+#define LZ_HASH_BITS   14
+#define LZ_MAX_OFFSET  65535
+#define LZ_LAST_LITERALS 5      ///< A block ends with at least this many literals
+
+/**
+ * @brief Fast LZ77 block codec for large responses.
+ *
+ * The block format is LZ4's: a sequence is a token byte (literal count in the
+ * high nibble, match length - 4 in the low one, 15 meaning "more bytes
+ * follow", each adding up to 255), the literals, and a 2-byte little-endian
+ * match offset followed by the match length's extra bytes. The last sequence
+ * has literals only. Matches are found through a hash of the next 4 bytes,
+ * one probe per position, so compression is a single linear pass.
+ *
+ * Both ends may preset the window with a dictionary: matches can then refer
+ * back into it, so even the first row of a table compresses. lz_dictionary
+ * holds the strings every rendered table and catalogue row is made of: the
+ * rules and column titles of the available-courses table (available_box) and
+ * the column titles of the search results (search_box) and the user tables
+ * (users_box). Keep it in step with those layouts when a column changes.
+ */
+
+/**
+ * @brief Built-in dictionary: box drawing and the common words of listings.
+ */
+static const char lz_dictionary[] =
+    "version=0 full\nversion=0 delta\n,\"\"\n"
+    "╔═══════════╦═══════════╦═══════════╦════════════════════════════════╦═════════════════════╦═══════════╗\n"
+    "╠═══════════╬═══════════╬═══════════╬════════════════════════════════╬═════════════════════╬═══════════╣\n"
+    "╚═══════════╩═══════════╩═══════════╩════════════════════════════════╩═════════════════════╩═══════════╝\n"
+    "║ Course ID ║   Code    ║  Credits  ║          Course Name           ║       Faculty       ║   Seats   ║\n"
+    "║ Course ID ║   Code    ║  Credits  ║ Seats ║          Course Name           ║       Faculty       ║\n"
+    "║   User ID  ║           Name               ║             Email                  ║   Status   ║\n"
+    "║ Active     ║ Inactive   ║                                  ║\n";
+
+#define LZ_DICT_LEN (sizeof(lz_dictionary) - 1)
+
+static inline uint32_t lz_read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t lz_hash(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/**
+ * @brief Worst-case compressed size of len bytes.
+ */
+static inline size_t lz_bound(size_t len) {
+    return len + len / 255 + 16;
+}
+
+static inline uint8_t *lz_put_length(uint8_t *out, size_t len) {
+    while (len >= 255) {
+        *out++ = 255;
+        len -= 255;
+    }
+    *out++ = (uint8_t)len;
+    return out;
+}
+
+/**
+ * @brief Compresses one block.
+ *
+ * @param src      Data.
+ * @param len      Its length.
+ * @param out      Receives the block; must hold lz_bound(len) bytes.
+ * @param use_dict 1 to preset the window with lz_dictionary.
+ * @return Size of the block, or 0 if out of memory.
+ */
+static inline size_t lz_compress(const char *src, size_t len, uint8_t *out, int use_dict) {
+    // Work in one buffer holding the dictionary, if any, followed by the data
+    size_t dict = use_dict ? LZ_DICT_LEN : 0;
+    uint8_t *buf = (uint8_t *)malloc(dict + len + 1);
+    uint32_t *table = (uint32_t *)calloc(1u << LZ_HASH_BITS, sizeof(uint32_t));
+    if (!buf || !table) {
+        free(buf);
+        free(table);
+        return 0;
+    }
+    memcpy(buf, lz_dictionary, dict);
+    memcpy(buf + dict, src, len);
+
+    // Positions are stored + 1 so that 0 means "empty"
+    for (size_t i = 0; i + LZ_MIN_MATCH <= dict; i++) table[lz_hash(lz_read32(buf + i))] = i + 1;
+
+    size_t end = dict + len, anchor = dict, i = dict;
+    size_t limit = len > LZ_LAST_LITERALS + LZ_MIN_MATCH ? end - LZ_LAST_LITERALS - LZ_MIN_MATCH : dict;
+    uint8_t *o = out;
+    while (i < limit) {
+        uint32_t v = lz_read32(buf + i);
+        uint32_t h = lz_hash(v);
+        size_t ref = table[h];
+        table[h] = i + 1;
+        if (!ref || i - (ref - 1) > LZ_MAX_OFFSET || lz_read32(buf + ref - 1) != v) {
+            i++;
+            continue;
+        }
+        ref--;
+
+        size_t match = LZ_MIN_MATCH;
+        while (i + match < end - LZ_LAST_LITERALS && buf[ref + match] == buf[i + match]) match++;
+
+        size_t literals = i - anchor;
+        size_t extra = match - LZ_MIN_MATCH;
+        uint8_t *token = o++;
+        *token = (uint8_t)(((literals < 15 ? literals : 15) << 4) | (extra < 15 ? extra : 15));
+        if (literals >= 15) o = lz_put_length(o, literals - 15);
+        memcpy(o, buf + anchor, literals);
+        o += literals;
+        size_t offset = i - ref;
+        *o++ = (uint8_t)offset;
+        *o++ = (uint8_t)(offset >> 8);
+        if (extra >= 15) o = lz_put_length(o, extra - 15);
+
+        i += match;
+        anchor = i;
+    }
+
+    size_t literals = end - anchor;
+    *o++ = (uint8_t)((literals < 15 ? literals : 15) << 4);
+    if (literals >= 15) o = lz_put_length(o, literals - 15);
+    memcpy(o, buf + anchor, literals);
+    o += literals;
+
+    free(table);
+    free(buf);
+    return o - out;
+}
+
+/**
+ * @brief Decompresses a block from lz_compress().
+ *
+ * @param src      Block.
+ * @param len      Its length.
+ * @param out      Receives the data.
+ * @param out_len  Exact size of the data.
+ * @param use_dict 1 if the block was compressed with the dictionary.
+ * @return SUCCESS, or FAILURE if the block is malformed or does not decode to out_len bytes.
+ */
+static inline int lz_decompress(const uint8_t *src, size_t len, char *out, size_t out_len, int use_dict) {
+    size_t dict = use_dict ? LZ_DICT_LEN : 0;
+    uint8_t *buf = (uint8_t *)malloc(dict + out_len + 1);
+    if (!buf) return FAILURE;
+    memcpy(buf, lz_dictionary, dict);
+
+    const uint8_t *s = src, *s_end = src + len;
+    size_t o = dict, o_end = dict + out_len;
+    int status = FAILURE;
+    while (s < s_end) {
+        uint8_t token = *s++;
+        size_t literals = token >> 4;
+        if (literals == 15) {
+            uint8_t b;
+            do {
+                if (s >= s_end) goto done;
+                b = *s++;
+                literals += b;
+            } while (b == 255);
+        }
+        if (literals > (size_t)(s_end - s) || literals > o_end - o) goto done;
+        memcpy(buf + o, s, literals);
+        s += literals;
+        o += literals;
+        if (s == s_end) break; // Last sequence
+
+        if (s_end - s < 2) goto done;
+        size_t offset = s[0] | (s[1] << 8);
+        s += 2;
+        size_t match = (token & 15) + LZ_MIN_MATCH;
+        if ((token & 15) == 15) {
+            uint8_t b;
+            do {
+                if (s >= s_end) goto done;
+                b = *s++;
+                match += b;
+            } while (b == 255);
+        }
+        if (offset == 0 || offset > o || match > o_end - o) goto done;
+        // Byte by byte: a match may overlap the bytes it produces
+        for (size_t k = 0; k < match; k++, o++) buf[o] = buf[o - offset];
+    }
+    if (o == o_end) {
+        memcpy(out, buf + dict, out_len);
+        status = SUCCESS;
+    }
+done:
+    free(buf);
+    return status;
+}
+
+#endif // COMPRESS_H
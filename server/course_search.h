@@ -0,0 +1,377 @@
+#ifndef COURSE_SEARCH_H
+#define COURSE_SEARCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <unistd.h>
+#include "utils.h"
+#include "db_version.h"
+#include "catalogue_cache.h"
+#include "render.h"
+
+#define SEARCH_MAX_QUERY   64
+#define SEARCH_PAGE_SIZE   10
+#define SEARCH_MAX_CHANGES 256   ///< Changed courses checked in place; more means a rebuild
+
+/**
+ * @brief Course search over the catalogue by code and name.
+ *
+ * Each catalogue entry is indexed by the 1-, 2- and 3-grams of its lowercased
+ * "code\x01name" text (grams spanning the separator are skipped). A query of
+ * up to three characters is exactly one gram, so its posting list is the
+ * answer. A longer query looks up each of its trigrams, takes the shortest
+ * posting list and verifies only those candidates. Posting lists are in
+ * catalogue order, so results are too.
+ *
+ * The index is built from the catalogue cache. Most new data versions only
+ * change seat counts, so on a new version the courses the version log names
+ * are compared with the indexed texts, and the index is rebuilt only when a
+ * course was added or removed or its code or name changed.
+ */
+
+/**
+ * @brief A course search: substring of code or name, plus optional filters.
+ */
+typedef struct {
+    const char *text;   ///< Case-insensitive substring of code or name ("" for any)
+    int credits;        ///< Exact credits, 0 for any
+    int min_seats;      ///< Minimum seats left, 0 for any
+    int faculty_id;     ///< Offering faculty, 0 for any
+    int offset;         ///< Number of matches to skip
+    int limit;          ///< Page size
+} CourseQuery;
+
+/**
+ * @brief Catalogue row of a course id.
+ */
+typedef struct {
+    int id;
+    int row;
+} SearchRow;
+
+/**
+ * @brief Trigram index over the codes and names of one version of the catalogue.
+ */
+typedef struct {
+    unsigned long version;  ///< Latest catalogue version the index is known to match
+    int loaded;
+    int count;              ///< Catalogue entries indexed
+    SearchRow *rows;        ///< Rows by course id, sorted by id
+    char *texts;            ///< Lowercased "code\x01name" of every entry, NUL-separated
+    int *text_off;          ///< Offset of each entry's text in texts
+    uint32_t *keys;         ///< Distinct grams, sorted
+    int *first;             ///< Postings of keys[k]: postings[first[k]..first[k + 1])
+    int *postings;          ///< Entry indexes, ascending within each gram
+    int key_count;
+} CourseSearchIndex;
+
+/**
+ * @brief Packs a gram of 1 to 3 lowercased bytes, and its length, into a key.
+ */
+static inline uint32_t search_gram(const char *p, int n) {
+    uint32_t key = (uint32_t)n << 24;
+    for (int k = 0; k < n; k++) key |= (uint32_t)(unsigned char)p[k] << (16 - 8 * k);
+    return key;
+}
+
+static int search_row_cmp(const void *a, const void *b) {
+    const SearchRow *x = a, *y = b;
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+static inline void search_index_free(CourseSearchIndex *ix) {
+    free(ix->rows);
+    free(ix->texts);
+    free(ix->text_off);
+    free(ix->keys);
+    free(ix->first);
+    free(ix->postings);
+    memset(ix, 0, sizeof(*ix));
+}
+
+/**
+ * @brief Builds the trigram index of a catalogue.
+ *
+ * (gram, entry) pairs are produced in entry order and radix-sorted by gram
+ * with a stable two-pass LSD sort, so each posting list comes out already
+ * ascending and duplicates are adjacent.
+ *
+ * @return SUCCESS or FILE_ERROR if out of memory.
+ */
+static inline int search_index_build(CourseSearchIndex *ix, const CatalogueCache *cat) {
+    size_t text_len = 0;
+    for (int i = 0; i < cat->count; i++) {
+        text_len += strlen(catalogue_str(cat, cat->codes[i])) + strlen(catalogue_str(cat, cat->names[i])) + 2;
+    }
+
+    ix->rows = malloc((cat->count + 1) * sizeof(SearchRow));
+    ix->texts = malloc(text_len + 1);
+    ix->text_off = malloc((cat->count + 1) * sizeof(int));
+    uint64_t *pairs = malloc((3 * text_len + 1) * sizeof(uint64_t));
+    uint64_t *sorted = malloc((3 * text_len + 1) * sizeof(uint64_t));
+    int *counts = malloc(8193 * sizeof(int));
+    if (!ix->rows || !ix->texts || !ix->text_off || !pairs || !sorted || !counts) {
+        free(pairs);
+        free(sorted);
+        free(counts);
+        search_index_free(ix);
+        return FILE_ERROR;
+    }
+
+    // Lowercased texts, and their grams as (gram << 32 | entry)
+    size_t pos = 0, pair_count = 0;
+    for (int i = 0; i < cat->count; i++) {
+        char *text = ix->texts + pos;
+        int len = snprintf(text, text_len + 1 - pos, "%s\x01%s", catalogue_str(cat, cat->codes[i]),
+                           catalogue_str(cat, cat->names[i]));
+        for (int k = 0; k < len; k++) text[k] = (char)tolower((unsigned char)text[k]);
+        ix->text_off[i] = (int)pos;
+        pos += len + 1;
+        ix->rows[i] = (SearchRow){ cat->ids[i], i };
+
+        for (int k = 0; k < len; k++) {
+            for (int n = 1; n <= 3 && k + n <= len && text[k + n - 1] != '\x01'; n++) {
+                pairs[pair_count++] = ((uint64_t)search_gram(text + k, n) << 32) | (uint32_t)i;
+            }
+        }
+    }
+
+    // Stable LSD radix sort on the 26-bit gram key, 13 bits per pass
+    for (int shift = 32; shift < 58; shift += 13) {
+        memset(counts, 0, 8193 * sizeof(int));
+        for (size_t k = 0; k < pair_count; k++) counts[((pairs[k] >> shift) & 0x1fff) + 1]++;
+        for (int b = 0; b < 8192; b++) counts[b + 1] += counts[b];
+        for (size_t k = 0; k < pair_count; k++) sorted[counts[(pairs[k] >> shift) & 0x1fff]++] = pairs[k];
+        uint64_t *swap = pairs;
+        pairs = sorted;
+        sorted = swap;
+    }
+    free(sorted);
+    free(counts);
+
+    // Compress into distinct keys with their posting lists
+    ix->keys = malloc((pair_count + 1) * sizeof(uint32_t));
+    ix->first = malloc((pair_count + 2) * sizeof(int));
+    ix->postings = malloc((pair_count + 1) * sizeof(int));
+    if (!ix->keys || !ix->first || !ix->postings) {
+        free(pairs);
+        search_index_free(ix);
+        return FILE_ERROR;
+    }
+
+    int posting_count = 0;
+    ix->key_count = 0;
+    for (size_t k = 0; k < pair_count; k++) {
+        if (k > 0 && pairs[k] == pairs[k - 1]) continue; // Gram repeated within one entry
+        uint32_t key = (uint32_t)(pairs[k] >> 32);
+        if (ix->key_count == 0 || ix->keys[ix->key_count - 1] != key) {
+            ix->keys[ix->key_count] = key;
+            ix->first[ix->key_count++] = posting_count;
+        }
+        ix->postings[posting_count++] = (int)(uint32_t)pairs[k];
+    }
+    ix->first[ix->key_count] = posting_count;
+
+    free(pairs);
+    ix->count = cat->count;
+    qsort(ix->rows, ix->count, sizeof(SearchRow), search_row_cmp);
+    return SUCCESS;
+}
+
+/**
+ * @brief Checks whether the index still matches a newer catalogue.
+ *
+ * Only the courses the version log names as changed are compared: each must
+ * still be in the same row with the same code and name. The catalogue keeps
+ * its rows in place when courses are updated, so the other rows match too.
+ *
+ * @return 1 if the index matches, 0 if it must be rebuilt.
+ */
+static inline int search_index_current(const CourseSearchIndex *ix, const CatalogueCache *cat) {
+    if (cat->count != ix->count) return 0; // Courses added or removed
+
+    int ids[SEARCH_MAX_CHANGES];
+    int n = db_version_changes(ix->version, cat->version, ids, SEARCH_MAX_CHANGES);
+    if (n < 0) return 0;
+
+    for (int k = 0; k < n; k++) {
+        SearchRow key = { .id = ids[k] };
+        const SearchRow *r = bsearch(&key, ix->rows, ix->count, sizeof(SearchRow), search_row_cmp);
+        if (!r || cat->ids[r->row] != r->id) return 0;
+
+        // Same text as indexed, compared without building the lowercased copy
+        const char *text = ix->texts + ix->text_off[r->row];
+        const char *parts[2] = { catalogue_str(cat, cat->codes[r->row]), catalogue_str(cat, cat->names[r->row]) };
+        for (int part = 0; part < 2; part++) {
+            for (const char *p = parts[part]; *p; p++, text++) {
+                if (*text != (char)tolower((unsigned char)*p)) return 0;
+            }
+            if (*text++ != (part ? '\0' : '\x01')) return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Returns the search index for the current catalogue, rebuilding it if
+ *        a course's code or name changed.
+ *
+ * @param cat Current catalogue, from catalogue_get().
+ * @return Pointer to the process-wide index, or NULL if out of memory.
+ */
+static inline const CourseSearchIndex *search_index_get(const CatalogueCache *cat) {
+    static CourseSearchIndex index;
+
+    if (index.loaded && (index.version == cat->version || search_index_current(&index, cat))) {
+        index.version = cat->version;
+        return &index;
+    }
+
+    search_index_free(&index);
+    if (search_index_build(&index, cat) != SUCCESS) return NULL;
+    index.version = cat->version;
+    index.loaded = 1;
+    return &index;
+}
+
+/**
+ * @brief Finds the posting list of a gram.
+ * @return Number of postings (0 if the gram occurs nowhere); *list is set
+ *         to the first one.
+ */
+static inline int search_postings(const CourseSearchIndex *ix, uint32_t key, const int **list) {
+    int lo = 0, hi = ix->key_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (ix->keys[mid] < key) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == ix->key_count || ix->keys[lo] != key) return 0;
+    *list = &ix->postings[ix->first[lo]];
+    return ix->first[lo + 1] - ix->first[lo];
+}
+
+/**
+ * @brief Checks catalogue row i against the query's filters.
+ */
+static inline int search_filters_match(const CourseQuery *q, const CatalogueCache *cat, int i) {
+    if (q->credits > 0 && cat->credits[i] != q->credits) return 0;
+    if (q->min_seats > 0 && cat->capacity[i] - cat->enrolled[i] < q->min_seats) return 0;
+    if (q->faculty_id > 0 && cat->faculty_ids[i] != q->faculty_id) return 0;
+    return 1;
+}
+
+/**
+ * @brief Counts a text match that passes the filters, keeping it if it falls on the page.
+ */
+static inline void search_accept(const CourseQuery *q, const CatalogueCache *cat, int i,
+                                 int *results, int *matched, int *page) {
+    if (!search_filters_match(q, cat, i)) return;
+    if (*matched >= q->offset && *page < q->limit) results[(*page)++] = i;
+    (*matched)++;
+}
+
+/**
+ * @brief Searches the catalogue.
+ *
+ * @param cat     Current catalogue, from catalogue_get().
+ * @param q       Query; offset and limit select the page.
+ * @param results Receives the catalogue rows of up to q->limit matches, in catalogue order.
+ * @param total   Receives the number of matches over all pages.
+ * @return Number of entries on the page, or FILE_ERROR.
+ */
+static inline int search_courses(const CatalogueCache *cat, const CourseQuery *q, int *results, int *total) {
+    const CourseSearchIndex *ix = cat ? search_index_get(cat) : NULL;
+    if (!ix) return FILE_ERROR;
+
+    char needle[SEARCH_MAX_QUERY];
+    int len = 0;
+    for (const char *p = q->text ? q->text : ""; *p && len < SEARCH_MAX_QUERY - 1; p++) {
+        needle[len++] = (char)tolower((unsigned char)*p);
+    }
+    needle[len] = '\0';
+
+    int matched = 0, page = 0;
+    if (len == 0) {
+        for (int i = 0; i < cat->count; i++) search_accept(q, cat, i, results, &matched, &page);
+    } else {
+        // Candidates: the query's own gram, or its rarest trigram
+        const int *candidates = NULL;
+        int candidate_count = -1;
+        for (int k = 0; k + 3 <= len || (k == 0 && len < 3); k++) {
+            const int *list = NULL;
+            int n = search_postings(ix, search_gram(needle + k, len < 3 ? len : 3), &list);
+            if (candidate_count < 0 || n < candidate_count) {
+                candidates = list;
+                candidate_count = n;
+            }
+            if (n == 0) break;
+        }
+
+        // Queries longer than one trigram are verified against the text
+        for (int c = 0; c < candidate_count; c++) {
+            int i = candidates[c];
+            if (len > 3 && !strstr(ix->texts + ix->text_off[i], needle)) continue;
+            search_accept(q, cat, i, results, &matched, &page);
+        }
+    }
+    *total = matched;
+    return page;
+}
+
+static RenderBox search_box = RENDER_TABLE(
+    "║ Course ID ║   Code    ║  Credits  ║ Seats ║          Course Name           ║       Faculty       ║\n",
+    "dsddss", 9, 9, 9, 5, 30, 19);
+
+/**
+ * @brief Prints one page of search results, rendered into one buffer and
+ *        written at once.
+ *
+ * @param q Query; offset and limit select the page.
+ * @return Number of matches over all pages, or FILE_ERROR.
+ */
+static inline int print_course_search(const CourseQuery *q) {
+    int results[SEARCH_PAGE_SIZE];
+    CourseQuery page_query = *q;
+    if (page_query.limit <= 0 || page_query.limit > SEARCH_PAGE_SIZE) page_query.limit = SEARCH_PAGE_SIZE;
+
+    int total = 0;
+    const CatalogueCache *cat = catalogue_get();
+    int count = search_courses(cat, &page_query, results, &total);
+    if (count < 0) {
+        const char *err_msg = "Error opening courses file\n";
+        write(STDERR_FILENO, err_msg, strlen(err_msg));
+        return FILE_ERROR;
+    }
+
+    RenderBuf out = {0};
+    render_text(&out, "\n");
+    render_rule(&out, &search_box, RULE_TOP);
+    render_title(&out, &search_box, "SEARCH RESULTS");
+    render_rule(&out, &search_box, RULE_SPLIT);
+    render_header(&out, &search_box);
+    render_rule(&out, &search_box, count ? RULE_MID : RULE_MERGE);
+    for (int i = 0; i < count; i++) {
+        int row = results[i];
+        render_row(&out, &search_box, cat->ids[row], catalogue_str(cat, cat->codes[row]), cat->credits[row],
+                   cat->capacity[row] - cat->enrolled[row], catalogue_str(cat, cat->names[row]),
+                   catalogue_str(cat, cat->faculty_names[row]));
+    }
+    if (count) render_rule(&out, &search_box, RULE_MERGE);
+    if (total == 0) {
+        render_line(&out, &search_box, "No courses match the search");
+    } else if (count == 0) {
+        render_line(&out, &search_box, "No more results");
+    } else {
+        render_line(&out, &search_box, "Showing %d-%d of %d", page_query.offset + 1, page_query.offset + count, total);
+    }
+    render_rule(&out, &search_box, RULE_BOTTOM);
+    render_flush(&out, STDOUT_FILENO);
+    render_free(&out);
+    return total;
+}
+
+#endif // COURSE_SEARCH_H
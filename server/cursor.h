@@ -0,0 +1,182 @@
+#ifndef CURSOR_H
+#define CURSOR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "utils.h"
+#include "snapshot.h"
+
+#define LIST_PAGE_SIZE 20
+#define CURSOR_TOKEN_LEN 96
+
+/**
+ * @brief Cursor-based paging over table listings.
+ *
+ * A cursor remembers where the previous page ended: the byte offset of the
+ * next row in the table snapshot it was read from, and the id of the last row
+ * returned. While the snapshot is unchanged the next page starts with one
+ * seek; after a writer has published a new version the cursor resumes after
+ * its last id instead. Each page reads only as many rows as it shows (plus
+ * the ones a filter skips), so the first row of every page costs the same
+ * however big the table is, and nothing beyond one page is held in memory.
+ */
+
+/**
+ * @brief Position of a paged listing.
+ */
+typedef struct {
+    unsigned long version;  ///< Snapshot the position refers to (inode, or catalogue version)
+    struct timespec mtime;  ///< With version and size, identifies a table snapshot;
+    off_t size;             ///< inodes of replaced snapshots are reused
+    long position;          ///< Byte offset of the next row, or index of the next entry
+    int last_id;            ///< Id of the last row returned
+    int started;            ///< 0 before the first page
+    int done;               ///< 1 once the last row was returned
+} ListCursor;
+
+/**
+ * @brief Called for each row of a page.
+ * @return 1 if the row was shown, 0 if it was filtered out.
+ */
+typedef int (*CursorRowFn)(const char *line, void *ctx);
+
+static inline void cursor_reset(ListCursor *c) {
+    memset(c, 0, sizeof(*c));
+}
+
+/**
+ * @brief Writes a cursor as a token a remote client sends back for the next page.
+ */
+static inline void cursor_token(const ListCursor *c, char *buf, size_t len) {
+    snprintf(buf, len, "%lx.%lx.%lx.%lx.%lx.%x", c->version, (unsigned long)c->mtime.tv_sec,
+             (unsigned long)c->mtime.tv_nsec, (unsigned long)c->size, (unsigned long)c->position,
+             (unsigned)c->last_id);
+}
+
+/**
+ * @brief Restores a cursor from a token written by cursor_token().
+ *
+ * The token comes from the client, so it is only trusted as far as the
+ * listings check it: a position that is not a row boundary of the same
+ * snapshot is ignored (see cursor_seek()).
+ *
+ * @return SUCCESS, or FAILURE if the token is malformed.
+ */
+static inline int cursor_parse_token(const char *token, ListCursor *c) {
+    unsigned long version, sec, nsec, size, position;
+    unsigned last_id;
+    char extra;
+    cursor_reset(c);
+    if (sscanf(token, "%lx.%lx.%lx.%lx.%lx.%x%c", &version, &sec, &nsec, &size, &position, &last_id, &extra) != 6 ||
+        (long)position < 0 || (long)size < 0) return FAILURE;
+    c->version = version;
+    c->mtime.tv_sec = (time_t)sec;
+    c->mtime.tv_nsec = (long)nsec;
+    c->size = (off_t)size;
+    c->position = (long)position;
+    c->last_id = (int)last_id;
+    c->started = 1;
+    return SUCCESS;
+}
+
+/**
+ * @brief Checks whether a cursor was taken from the snapshot st describes.
+ *
+ * The inode alone is not enough: once a replaced snapshot is closed, the
+ * next one published may get its inode.
+ */
+static inline int cursor_same_snapshot(const ListCursor *c, const struct stat *st) {
+    return c->version == (unsigned long)st->st_ino && c->size == st->st_size &&
+           c->mtime.tv_sec == st->st_mtim.tv_sec && c->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+/**
+ * @brief Moves a file to where a cursor's next page starts.
+ *
+ * On the snapshot the cursor was taken from this is a seek, if the offset
+ * is a row boundary. On a newer one the file is scanned for the last row
+ * returned; if that row is gone the old offset is used, rounded to the next
+ * row boundary.
+ */
+static inline void cursor_seek(FILE *file, const ListCursor *c, const struct stat *st) {
+    if (!c->started) return;
+    if (cursor_same_snapshot(c, st) && c->position > 0 && c->position <= st->st_size &&
+        fseeko(file, c->position - 1, SEEK_SET) == 0) {
+        if (fgetc(file) == '\n') return;
+        rewind(file);
+    }
+
+    char *line = NULL;
+    size_t cap = 0;
+    while (getline(&line, &cap, file) > 0) {
+        if (line[0] >= '0' && line[0] <= '9' && atoi(line) == c->last_id) {
+            free(line);
+            return;
+        }
+    }
+    free(line);
+
+    clearerr(file);
+    if (c->position > 0 && fseeko(file, c->position - 1, SEEK_SET) == 0) {
+        int ch;
+        while ((ch = fgetc(file)) != EOF && ch != '\n') {}
+    }
+}
+
+/**
+ * @brief Reads the next page of a table.
+ *
+ * The header row is skipped. Rows are passed to fn until it has shown limit
+ * of them or the table ends, and the cursor is moved past the last row read.
+ *
+ * @param path  Table to list.
+ * @param c     Cursor, cursor_reset() before the first page.
+ * @param limit Rows per page.
+ * @param fn    Row callback.
+ * @param ctx   Passed to fn.
+ * @return Number of rows shown, or FILE_ERROR.
+ */
+static inline int cursor_fetch(const char *path, ListCursor *c, int limit, CursorRowFn fn, void *ctx) {
+    FILE *file = snapshot_fopen(path);
+    if (!file) return FILE_ERROR;
+
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0) memset(&st, 0, sizeof(st));
+    cursor_seek(file, c, &st);
+
+    char *line = NULL;
+    size_t cap = 0;
+    int shown = 0;
+    c->done = 1;
+    while (shown < limit) {
+        if (getline(&line, &cap, file) <= 0) break;
+        if (line[0] < '0' || line[0] > '9') continue; // Header or blank
+
+        if (fn(line, ctx)) {
+            shown++;
+            c->last_id = atoi(line);
+        }
+    }
+    if (shown == limit) {
+        // Only done if nothing follows
+        int ch = fgetc(file);
+        if (ch != EOF) {
+            ungetc(ch, file);
+            c->done = 0;
+        }
+    }
+
+    c->position = ftello(file);
+    c->version = (unsigned long)st.st_ino;
+    c->mtime = st.st_mtim;
+    c->size = st.st_size;
+    c->started = 1;
+    free(line);
+    fclose(file);
+    return shown;
+}
+
+#endif // CURSOR_H
@@ -0,0 +1,175 @@
+#ifndef DB_VERSION_H
+#define DB_VERSION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#define DB_VERSION_FILE    "../database/version"
+#define DB_VERSION_LOG     "../database/version.log"
+#define DB_VERSION_LOG_MAX (256 * 1024)
+
+/**
+ * @brief Reads the current catalogue data version.
+ *
+ * The version is a counter stored as text in DB_VERSION_FILE. Every write that
+ * changes what the course catalogue looks like bumps it, so readers can use it
+ * as a cheap key for cached results.
+ *
+ * @return unsigned long Current version, or 0 if the file does not exist yet.
+ */
+static inline unsigned long db_version_read(void) {
+    int fd = open(DB_VERSION_FILE, O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct flock lock = { .l_type = F_RDLCK, .l_whence = SEEK_SET };
+    if (fcntl(fd, F_SETLKW, &lock) == -1) {
+        close(fd);
+        return 0;
+    }
+
+    char buf[32] = {0};
+    pread(fd, buf, sizeof(buf) - 1, 0);
+
+    lock.l_type = F_UNLCK;
+    fcntl(fd, F_SETLK, &lock);
+    close(fd);
+    return strtoul(buf, NULL, 10);
+}
+
+/**
+ * @brief Appends a version's changed courses to the change log.
+ *
+ * The log holds one line per version: the version, then the ids of the
+ * courses whose catalogue rows it changed, or "*" if any row may have
+ * changed. Its first line, "since N", says it covers every version after N.
+ * Once it outgrows DB_VERSION_LOG_MAX it starts over, so readers that are
+ * further behind than that fall back to reading the whole catalogue. The
+ * caller holds the version file's write lock.
+ */
+static inline void db_version_log(unsigned long version, const int *ids, int count) {
+    int fd = open(DB_VERSION_LOG, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0) return;
+
+    char buf[512];
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size == 0 || size > DB_VERSION_LOG_MAX) {
+        ftruncate(fd, 0);
+        int len = snprintf(buf, sizeof(buf), "since %lu\n", version - 1);
+        write(fd, buf, len);
+    }
+
+    // One write() per line, split only for very long id lists
+    int len = snprintf(buf, sizeof(buf), "%lu", version);
+    if (count == 0) len += snprintf(buf + len, sizeof(buf) - len, " *");
+    for (int i = 0; i < count; i++) {
+        if (len > (int)sizeof(buf) - 16) {
+            write(fd, buf, len);
+            len = 0;
+        }
+        len += snprintf(buf + len, sizeof(buf) - len, " %d", ids[i]);
+    }
+    buf[len++] = '\n';
+    write(fd, buf, len);
+    close(fd);
+}
+
+/**
+ * @brief Increments the catalogue data version and records which courses changed.
+ *
+ * Must be called after the change it announces is visible in the CSV files,
+ * so that a reader never caches old data under a new version.
+ *
+ * @param ids   Courses whose catalogue rows changed (added, removed or updated).
+ * @param count Number of ids, or 0 if any row may have changed.
+ * @return unsigned long The new version, or 0 on failure.
+ */
+static inline unsigned long db_version_bump_courses(const int *ids, int count) {
+    int fd = open(DB_VERSION_FILE, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return 0;
+
+    struct flock lock = { .l_type = F_WRLCK, .l_whence = SEEK_SET };
+    if (fcntl(fd, F_SETLKW, &lock) == -1) {
+        close(fd);
+        return 0;
+    }
+
+    char buf[32] = {0};
+    pread(fd, buf, sizeof(buf) - 1, 0);
+    unsigned long version = strtoul(buf, NULL, 10) + 1;
+
+    int len = snprintf(buf, sizeof(buf), "%lu\n", version);
+    pwrite(fd, buf, len, 0);
+    ftruncate(fd, len);
+    db_version_log(version, ids, count);
+
+    lock.l_type = F_UNLCK;
+    fcntl(fd, F_SETLK, &lock);
+    close(fd);
+    return version;
+}
+
+/**
+ * @brief Increments the catalogue data version for a change that may touch any course.
+ * @return unsigned long The new version, or 0 on failure.
+ */
+static inline unsigned long db_version_bump(void) {
+    return db_version_bump_courses(NULL, 0);
+}
+
+/**
+ * @brief Lists the courses changed by the versions after from, up to to.
+ *
+ * @param from Version the caller has.
+ * @param to   Version the caller wants.
+ * @param ids  Receives the course ids, possibly repeated.
+ * @param max  Capacity of ids.
+ * @return Number of ids, or -1 if the log cannot tell (it does not reach back
+ *         to from, a version changed every course, or there are more than max).
+ */
+static inline int db_version_changes(unsigned long from, unsigned long to, int *ids, int max) {
+    int fd = open(DB_VERSION_FILE, O_RDONLY);
+    if (fd < 0) return -1;
+
+    // Writers append and restart the log under the version file's lock
+    struct flock lock = { .l_type = F_RDLCK, .l_whence = SEEK_SET };
+    FILE *log = NULL;
+    if (fcntl(fd, F_SETLKW, &lock) == 0) log = fopen(DB_VERSION_LOG, "r");
+
+    int count = -1;
+    char *line = NULL;
+    size_t cap = 0;
+    if (log && getline(&line, &cap, log) > 0) {
+        unsigned long since;
+        if (sscanf(line, "since %lu", &since) == 1 && since <= from) count = 0;
+        while (count >= 0 && getline(&line, &cap, log) > 0) {
+            char *p;
+            unsigned long version = strtoul(line, &p, 10);
+            if (version <= from || version > to) continue;
+            if (strchr(p, '*')) {
+                count = -1;
+                break;
+            }
+            for (char *end; ; p = end) {
+                long id = strtol(p, &end, 10);
+                if (end == p) break;
+                if (count == max) {
+                    count = -1;
+                    break;
+                }
+                ids[count++] = (int)id;
+            }
+        }
+    }
+    free(line);
+    if (log) fclose(log);
+
+    lock.l_type = F_UNLCK;
+    fcntl(fd, F_SETLK, &lock);
+    close(fd);
+    return count;
+}
+
+#endif // DB_VERSION_H
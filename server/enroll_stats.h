@@ -0,0 +1,619 @@
+#ifndef ENROLL_STATS_H
+#define ENROLL_STATS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "utils.h"
+#include "snapshot.h"
+#include "render.h"
+
+#define DB_STATS            "../database/stats.bin"
+#define STATS_COURSES_DB    "../database/courses.csv"
+#define STATS_MAGIC         0x53544132u  ///< "STA2"
+#define STATS_TOP_K         10
+#define STATS_DEPTS         64
+#define STATS_DEPT_LEN      8
+#define STATS_BUCKETS       11           ///< 0-9%, 10-19%, ..., 90-99%, full
+#define STATS_WINDOW        60           ///< Seconds per velocity window
+#define STATS_NEAR_FULL     90           ///< Fill percentage counted as near capacity
+#define STATS_MIN_SLOTS     1024
+
+/**
+ * @brief Incrementally maintained enrollment statistics.
+ *
+ * DB_STATS is a fixed-layout file every client process maps shared: a header
+ * with catalogue totals, a per-department fill histogram and the top-K
+ * hottest courses, followed by an open-addressing hash table of per-course
+ * counters keyed by course id. Every write that changes a course's enrolled
+ * count adjusts its slot, its department's histogram and the totals in O(1),
+ * and a seat granted also updates the course's velocity and, in O(K), the
+ * top-K list. print_enrollment_stats() serves all of it from the mapping, so
+ * monitoring never reads the CSV tables or takes their locks.
+ *
+ * Every writer of the file holds the courses table's writer lock, which
+ * already orders all changes to enrolled counts. Writers mark the file
+ * pending, commit, record the committed change and clear the mark before they
+ * release the lock, so no other writer sees the table ahead of the file.
+ * A mark still set under the lock means a writer died between its commit and
+ * its update, and the file is rebuilt from the table. Readers take no lock: a
+ * sequence counter bumped around each update lets them retry a torn read.
+ *
+ * The file is built from courses.csv when it is missing (delete it while no
+ * clients are running to force a rebuild) and when the hash table is half
+ * full. The new file replaces the old one
+ * by rename, and the old one is marked retired so that other processes map
+ * the new one on their next access.
+ */
+
+/**
+ * @brief Counters of one course.
+ */
+typedef struct {
+    int course_id;              ///< 0 for a free slot
+    int capacity;
+    int enrolled;
+    int dept;                   ///< Index into StatsHeader.dept
+    char code[16];
+    long window;                ///< Velocity window of cur (time / STATS_WINDOW)
+    int cur, prev;              ///< Seats granted in that window and the one before
+    long joins;                 ///< Seats granted since the file was built
+} StatsCourse;
+
+/**
+ * @brief Fill histogram of one department (the letter prefix of course codes).
+ */
+typedef struct {
+    char name[STATS_DEPT_LEN];
+    int courses;
+    long capacity, enrolled;
+    int fill[STATS_BUCKETS];    ///< Courses per fill bucket
+} StatsDept;
+
+/**
+ * @brief Start of DB_STATS; the course slots follow it.
+ */
+typedef struct {
+    unsigned magic;
+    volatile unsigned seq;      ///< Odd while an update is in progress
+    volatile int retired;       ///< 1 once a rebuilt file has replaced this one
+    volatile int pending;       ///< 1 while a writer may have committed a change not yet counted
+    int slots;                  ///< Size of the course table, a power of two
+    int courses, depts;
+    long capacity, enrolled;
+    int full, near_full;
+    long joins, leaves;         ///< Seats granted and given up since the build
+    long built;                 ///< Build time
+    int top[STATS_TOP_K];       ///< Hottest course ids, 0 for a free entry
+    StatsDept dept[STATS_DEPTS];
+} StatsHeader;
+
+/**
+ * @brief This process's mapping of DB_STATS.
+ */
+typedef struct {
+    StatsHeader *header;
+    size_t size;
+} StatsMap;
+
+static StatsMap stats_mapping;
+
+static inline StatsCourse *stats_courses(StatsHeader *h) {
+    return (StatsCourse *)(h + 1);
+}
+
+static inline size_t stats_file_size(int slots) {
+    return sizeof(StatsHeader) + (size_t)slots * sizeof(StatsCourse);
+}
+
+static inline void stats_unmap(void) {
+    if (stats_mapping.header) munmap(stats_mapping.header, stats_mapping.size);
+    memset(&stats_mapping, 0, sizeof(stats_mapping));
+}
+
+/**
+ * @brief Maps the current DB_STATS, replacing a retired mapping.
+ * @return The header, or NULL if the file is missing or invalid.
+ */
+static inline StatsHeader *stats_map(void) {
+    if (stats_mapping.header && !stats_mapping.header->retired) return stats_mapping.header;
+    stats_unmap();
+
+    int fd = open(DB_STATS, O_RDWR);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    StatsHeader *h = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(StatsHeader)) {
+        h = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (h == MAP_FAILED) return NULL;
+
+    if (h->magic != STATS_MAGIC || h->slots <= 0 || stats_file_size(h->slots) != (size_t)st.st_size) {
+        munmap(h, st.st_size);
+        return NULL;
+    }
+    stats_mapping.header = h;
+    stats_mapping.size = st.st_size;
+    return h;
+}
+
+static inline void stats_write_begin(StatsHeader *h) {
+    h->seq++;
+    __sync_synchronize();
+}
+
+static inline void stats_write_end(StatsHeader *h) {
+    __sync_synchronize();
+    h->seq++;
+}
+
+/**
+ * @brief Returns the fill bucket of a course.
+ */
+static inline int stats_bucket(int enrolled, int capacity) {
+    if (capacity <= 0 || enrolled >= capacity) return STATS_BUCKETS - 1;
+    if (enrolled <= 0) return 0;
+    return (int)((long)enrolled * (STATS_BUCKETS - 1) / capacity);
+}
+
+static inline int stats_near_full(int enrolled, int capacity) {
+    return capacity > 0 && (long)enrolled * 100 >= (long)capacity * STATS_NEAR_FULL;
+}
+
+/**
+ * @brief Finds the slot of a course, or the free slot it would take.
+ * @return Slot, or NULL if the course is absent and the table is full.
+ */
+static inline StatsCourse *stats_slot(StatsHeader *h, int course_id) {
+    StatsCourse *slots = stats_courses(h);
+    unsigned mask = h->slots - 1;
+    unsigned i = ((unsigned)course_id * 2654435761u) & mask;
+    for (int probes = 0; probes < h->slots; probes++, i = (i + 1) & mask) {
+        if (slots[i].course_id == course_id || slots[i].course_id == 0) return &slots[i];
+    }
+    return NULL;
+}
+
+/**
+ * @brief Finds a course's department, adding it if new.
+ *
+ * Departments past STATS_DEPTS share the last entry.
+ */
+static inline int stats_dept_of(StatsHeader *h, const char *code) {
+    char name[STATS_DEPT_LEN] = "";
+    int n = 0;
+    while (n < STATS_DEPT_LEN - 1 && isalpha((unsigned char)code[n])) {
+        name[n] = toupper((unsigned char)code[n]);
+        n++;
+    }
+    if (n == 0) strcpy(name, "-");
+
+    for (int d = 0; d < h->depts; d++) {
+        if (strcmp(h->dept[d].name, name) == 0) return d;
+    }
+    if (h->depts == STATS_DEPTS) return STATS_DEPTS - 1;
+    int d = h->depts++;
+    strcpy(h->dept[d].name, h->depts == STATS_DEPTS ? "*" : name);
+    return d;
+}
+
+/**
+ * @brief Adds or removes a course's counters from its department and the totals.
+ */
+static inline void stats_account(StatsHeader *h, const StatsCourse *c, int sign) {
+    StatsDept *d = &h->dept[c->dept];
+    d->courses += sign;
+    d->capacity += sign * c->capacity;
+    d->enrolled += sign * c->enrolled;
+    d->fill[stats_bucket(c->enrolled, c->capacity)] += sign;
+
+    h->courses += sign;
+    h->capacity += sign * c->capacity;
+    h->enrolled += sign * c->enrolled;
+    if (c->capacity > 0 && c->enrolled >= c->capacity) h->full += sign;
+    if (stats_near_full(c->enrolled, c->capacity)) h->near_full += sign;
+}
+
+/**
+ * @brief Seats granted per STATS_WINDOW, with the previous window's count
+ *        fading out as the current one fills in.
+ * @return Rate in seats per window, scaled by STATS_WINDOW.
+ */
+static inline long stats_velocity(const StatsCourse *c, long now) {
+    long window = now / STATS_WINDOW, elapsed = now % STATS_WINDOW;
+    if (c->window == window) return (long)c->cur * STATS_WINDOW + (long)c->prev * (STATS_WINDOW - elapsed);
+    if (c->window == window - 1) return (long)c->cur * (STATS_WINDOW - elapsed);
+    return 0;
+}
+
+/**
+ * @brief Offers a course to the top-K list after it was granted a seat.
+ *
+ * The course replaces the coldest entry (scores are re-read at the current
+ * time) if it is hotter. O(STATS_TOP_K).
+ */
+static inline void stats_top_offer(StatsHeader *h, const StatsCourse *c, long now) {
+    int coldest = -1;
+    long coldest_score = 0;
+    for (int k = 0; k < STATS_TOP_K; k++) {
+        if (h->top[k] == c->course_id) return;
+        const StatsCourse *other = h->top[k] ? stats_slot(h, h->top[k]) : NULL;
+        long score = other && other->course_id == h->top[k] ? stats_velocity(other, now) : -1;
+        if (coldest < 0 || score < coldest_score) {
+            coldest = k;
+            coldest_score = score;
+        }
+    }
+    if (stats_velocity(c, now) > coldest_score) h->top[coldest] = c->course_id;
+}
+
+/**
+ * @brief Writes a fresh DB_STATS from the current courses table.
+ *
+ * The caller must hold the courses table's writer lock.
+ *
+ * @param extra Courses the new table must have room for beyond the current ones.
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int stats_rebuild(int extra) {
+    FILE *in = snapshot_fopen(STATS_COURSES_DB);
+    if (!in) return FILE_ERROR;
+
+    // Size the table for at most half load
+    int count = 0, ch, prev = '\n';
+    while ((ch = fgetc(in)) != EOF) {
+        if (prev == '\n' && ch >= '0' && ch <= '9') count++;
+        prev = ch;
+    }
+    int slots = STATS_MIN_SLOTS;
+    while (slots < 2 * (count + extra)) slots *= 2;
+    rewind(in);
+
+    char temp_path[SNAPSHOT_PATH_LEN];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", DB_STATS);
+    size_t size = stats_file_size(slots);
+    int fd = open(temp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    StatsHeader *h = MAP_FAILED;
+    if (fd >= 0 && ftruncate(fd, size) == 0) {
+        h = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (h == MAP_FAILED) {
+        if (fd >= 0) close(fd);
+        unlink(temp_path);
+        fclose(in);
+        return FILE_ERROR;
+    }
+
+    h->slots = slots;
+    h->built = time(NULL);
+    char *line = NULL;
+    size_t cap = 0;
+    while (getline(&line, &cap, in) > 0) {
+        int id, capacity, enrolled;
+        char code[32];
+        if (sscanf(line, "%d,%31[^,],%*[^,],%d,%d", &id, code, &capacity, &enrolled) != 4 || id == 0) continue;
+
+        StatsCourse *c = stats_slot(h, id);
+        if (!c || c->course_id) continue; // Duplicate id keeps its first row
+        c->course_id = id;
+        c->capacity = capacity;
+        c->enrolled = enrolled;
+        c->dept = stats_dept_of(h, code);
+        snprintf(c->code, sizeof(c->code), "%.*s", (int)sizeof(c->code) - 1, code);
+        stats_account(h, c, 1);
+    }
+    free(line);
+    fclose(in);
+    h->magic = STATS_MAGIC;
+
+    int status = msync(h, size, MS_SYNC) == 0 && fsync(fd) == 0 ? SUCCESS : FILE_ERROR;
+    munmap(h, size);
+    close(fd);
+
+    int old_fd = open(DB_STATS, O_RDWR);
+    if (status != SUCCESS || rename(temp_path, DB_STATS) != 0) {
+        if (old_fd >= 0) close(old_fd);
+        unlink(temp_path);
+        return FILE_ERROR;
+    }
+
+    // Send every process still using the old file to the new one
+    if (old_fd >= 0) {
+        int retired = 1;
+        pwrite(old_fd, &retired, sizeof(retired), offsetof(StatsHeader, retired));
+        close(old_fd);
+    }
+    stats_unmap();
+    return SUCCESS;
+}
+
+/**
+ * @brief Records a change to a course's enrolled count.
+ *
+ * Called by writers holding the courses table's writer lock, between
+ * stats_commit_begin() and stats_commit_end(), once the change has committed.
+ * Does nothing while DB_STATS does not exist.
+ *
+ * @param course_id Course ID.
+ * @param delta     Change to the enrolled count.
+ * @param joins     Seats granted by the change (for velocity and the top-K list).
+ */
+static inline void stats_enrolled(int course_id, int delta, int joins) {
+    StatsHeader *h = stats_map();
+    if (!h) return;
+    StatsCourse *c = stats_slot(h, course_id);
+    if (!c || !c->course_id) return;
+
+    long now = time(NULL);
+    stats_write_begin(h);
+    stats_account(h, c, -1);
+    c->enrolled += delta;
+    stats_account(h, c, 1);
+
+    long window = now / STATS_WINDOW;
+    if (c->window != window) {
+        c->prev = c->window == window - 1 ? c->cur : 0;
+        c->cur = 0;
+        c->window = window;
+    }
+    c->cur = c->cur + joins > 0 ? c->cur + joins : 0;
+    c->joins += joins;
+    h->joins += joins;
+    h->leaves += joins - delta;
+    if (joins > 0) stats_top_offer(h, c, now);
+    stats_write_end(h);
+}
+
+/**
+ * @brief Records a new course.
+ *
+ * Called while holding the courses table's writer lock, after the course's
+ * row has committed. Rebuilds DB_STATS if the course table is half full.
+ *
+ * @param course_id Course ID.
+ * @param code      Course code.
+ * @param capacity  Seats.
+ * @param enrolled  Students already enrolled.
+ */
+static inline void stats_course_add(int course_id, const char *code, int capacity, int enrolled) {
+    StatsHeader *h = stats_map();
+    if (!h) return;
+    if (2 * (h->courses + 1) > h->slots) {
+        // The rebuild reads the new course from the table
+        stats_rebuild(h->courses + 1);
+        return;
+    }
+
+    StatsCourse *c = stats_slot(h, course_id);
+    if (!c || c->course_id) return;
+    stats_write_begin(h);
+    memset(c, 0, sizeof(*c));
+    c->capacity = capacity;
+    c->enrolled = enrolled;
+    c->dept = stats_dept_of(h, code);
+    snprintf(c->code, sizeof(c->code), "%.*s", (int)sizeof(c->code) - 1, code);
+    c->course_id = course_id;
+    stats_account(h, c, 1);
+    stats_write_end(h);
+}
+
+/**
+ * @brief Forgets a removed course.
+ *
+ * Called while holding the courses table's writer lock, after the removal
+ * has committed. Slots after it in its probe run are shifted back, so lookups
+ * never need tombstones.
+ *
+ * @param course_id Course ID.
+ */
+static inline void stats_course_remove(int course_id) {
+    StatsHeader *h = stats_map();
+    if (!h) return;
+    StatsCourse *c = stats_slot(h, course_id);
+    if (!c || !c->course_id) return;
+
+    stats_write_begin(h);
+    stats_account(h, c, -1);
+    for (int k = 0; k < STATS_TOP_K; k++) {
+        if (h->top[k] == course_id) h->top[k] = 0;
+    }
+
+    StatsCourse *slots = stats_courses(h);
+    unsigned mask = h->slots - 1;
+    unsigned hole = c - slots;
+    for (unsigned i = (hole + 1) & mask; slots[i].course_id; i = (i + 1) & mask) {
+        unsigned home = ((unsigned)slots[i].course_id * 2654435761u) & mask;
+        // Move the entry into the hole unless its home lies cyclically in (hole, i]
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            slots[hole] = slots[i];
+            hole = i;
+        }
+    }
+    memset(&slots[hole], 0, sizeof(StatsCourse));
+    stats_write_end(h);
+}
+
+/**
+ * @brief Marks DB_STATS as possibly behind the courses table, before a commit.
+ *
+ * Called holding the courses table's writer lock. If the mark, or an update,
+ * was left unfinished by a writer that died, the file is rebuilt first.
+ */
+static inline void stats_commit_begin(void) {
+    StatsHeader *h = stats_map();
+    if (!h) return;
+    if (h->pending || (h->seq & 1)) {
+        if (stats_rebuild(0) != SUCCESS || !(h = stats_map())) return;
+    }
+    h->pending = 1;
+}
+
+/**
+ * @brief Clears the mark of stats_commit_begin() once the change is counted.
+ */
+static inline void stats_commit_end(void) {
+    StatsHeader *h = stats_map();
+    if (h) h->pending = 0;
+}
+
+/**
+ * @brief Rebuilds DB_STATS from courses.csv if a writer died before counting
+ *        a change it committed.
+ *
+ * Called at startup, after txn_recover().
+ */
+static inline void stats_recover(void) {
+    if (!stats_map()) return; // Built from the table on first use anyway
+
+    int lock_fd = snapshot_lock(STATS_COURSES_DB);
+    if (lock_fd < 0) return;
+    StatsHeader *h = stats_map();
+    if (h && (h->pending || (h->seq & 1))) stats_rebuild(0);
+    snapshot_unlock(lock_fd, STATS_COURSES_DB);
+}
+
+/**
+ * @brief Maps DB_STATS, building it first if it does not exist yet.
+ * @return The header, or NULL on error.
+ */
+static inline StatsHeader *stats_open(void) {
+    StatsHeader *h = stats_map();
+    if (h) return h;
+
+    int lock_fd = snapshot_lock(STATS_COURSES_DB);
+    if (lock_fd < 0) return NULL;
+    h = stats_map(); // Another process may have built it meanwhile
+    if (!h && stats_rebuild(0) == SUCCESS) h = stats_map();
+    snapshot_unlock(lock_fd, STATS_COURSES_DB);
+    return h;
+}
+
+/**
+ * @brief A course in the stats report.
+ */
+typedef struct {
+    StatsCourse course;
+    long score;
+} StatsEntry;
+
+static int stats_entry_cmp(const void *a, const void *b) {
+    long x = ((const StatsEntry *)a)->score, y = ((const StatsEntry *)b)->score;
+    return (x < y) - (x > y);
+}
+
+/**
+ * @brief Layout of the department table; the histogram column holds one
+ *        5-wide cell per bucket but the last.
+ */
+static RenderBox stats_box = RENDER_BOX("sssss", 5, 5, 5, 5 * (STATS_BUCKETS - 1) - 2, 3);
+
+/**
+ * @brief Prints the enrollment dashboard: totals, the fill histogram of every
+ *        department, the hottest courses and the courses near capacity.
+ *
+ * Everything is read from the shared statistics; the CSV tables are only read
+ * if the statistics have to be built first.
+ *
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int print_enrollment_stats(void) {
+    StatsHeader *h = stats_open();
+    if (!h) return FILE_ERROR;
+
+    // Header and hottest courses, consistent with each other
+    long now = time(NULL);
+    StatsHeader copy;
+    StatsEntry hot[STATS_TOP_K];
+    int hot_count;
+    unsigned seq;
+    do {
+        while ((seq = h->seq) & 1) usleep(100);
+        __sync_synchronize();
+        copy = *h;
+        hot_count = 0;
+        for (int k = 0; k < STATS_TOP_K; k++) {
+            const StatsCourse *c = copy.top[k] ? stats_slot(h, copy.top[k]) : NULL;
+            if (!c || c->course_id != copy.top[k]) continue;
+            hot[hot_count].course = *c;
+            hot[hot_count].score = stats_velocity(c, now);
+            if (hot[hot_count].score > 0) hot_count++;
+        }
+        __sync_synchronize();
+    } while (h->seq != seq);
+    qsort(hot, hot_count, sizeof(StatsEntry), stats_entry_cmp);
+
+    // Fullest courses, from one pass over the slots; a course updated
+    // meanwhile shows either its old or its new count
+    StatsEntry near[STATS_TOP_K];
+    int near_count = 0;
+    const StatsCourse *slots = stats_courses(h);
+    for (int i = 0; i < copy.slots && copy.near_full; i++) {
+        StatsCourse c = slots[i];
+        if (!c.course_id || !stats_near_full(c.enrolled, c.capacity)) continue;
+        long score = (long)c.enrolled * 1000 / c.capacity;
+        if (near_count == STATS_TOP_K && score <= near[near_count - 1].score) continue;
+        int k = near_count < STATS_TOP_K ? near_count++ : STATS_TOP_K - 1;
+        while (k > 0 && near[k - 1].score < score) {
+            near[k] = near[k - 1];
+            k--;
+        }
+        near[k].course = c;
+        near[k].score = score;
+    }
+
+    RenderBuf w = {0};
+    render_text(&w, "\n");
+    render_rule(&w, &stats_box, RULE_TOP);
+    render_line(&w, &stats_box, "ENROLLMENT STATISTICS");
+    render_rule(&w, &stats_box, RULE_LINE);
+    render_line(&w, &stats_box, "Courses %d   Seats %ld   Enrolled %ld   Fill %.1f%%   Full %d", copy.courses,
+                copy.capacity, copy.enrolled, copy.capacity ? 100.0 * copy.enrolled / copy.capacity : 0.0,
+                copy.full);
+    render_line(&w, &stats_box, "Near capacity (>= %d%%) %d   Seats granted %ld   Seats given up %ld",
+                STATS_NEAR_FULL, copy.near_full, copy.joins, copy.leaves);
+    render_rule(&w, &stats_box, RULE_SPLIT);
+    render_text(&w, "║ Dept  ║Courses║ Fill  ║");
+    for (int b = 0; b < STATS_BUCKETS - 1; b++) render_printf(&w, "%3d%% ", b * (100 / (STATS_BUCKETS - 1)));
+    render_text(&w, "║Full ║\n");
+    render_rule(&w, &stats_box, RULE_MID);
+    for (int d = 0; d < copy.depts; d++) {
+        const StatsDept *dept = &copy.dept[d];
+        if (dept->courses == 0) continue;
+        render_printf(&w, "║ %-6s║%6d ║%5.1f%% ║", dept->name, dept->courses,
+                      dept->capacity ? 100.0 * dept->enrolled / dept->capacity : 0.0);
+        for (int b = 0; b < STATS_BUCKETS - 1; b++) render_printf(&w, "%4d ", dept->fill[b]);
+        render_printf(&w, "║%4d ║\n", dept->fill[STATS_BUCKETS - 1]);
+    }
+    render_rule(&w, &stats_box, RULE_BOTTOM_COLUMNS);
+
+    render_printf(&w, "\nHottest courses (seats granted per %d s):\n", STATS_WINDOW);
+    if (hot_count == 0) render_printf(&w, "  none in the last %d seconds\n", 2 * STATS_WINDOW);
+    for (int i = 0; i < hot_count; i++) {
+        const StatsCourse *c = &hot[i].course;
+        render_printf(&w, "  %2d. %-12s %6.1f  (%d/%d enrolled, %ld granted)\n", i + 1, c->code,
+                      (double)hot[i].score / STATS_WINDOW, c->enrolled, c->capacity, c->joins);
+    }
+
+    render_printf(&w, "\nNearest to capacity:\n");
+    if (near_count == 0) render_printf(&w, "  none at or above %d%%\n", STATS_NEAR_FULL);
+    for (int i = 0; i < near_count; i++) {
+        const StatsCourse *c = &near[i].course;
+        render_printf(&w, "  %2d. %-12s %5.1f%%  (%d/%d enrolled)\n", i + 1, c->code,
+                      near[i].score / 10.0, c->enrolled, c->capacity);
+    }
+    render_flush(&w, STDOUT_FILENO);
+    render_free(&w);
+    return SUCCESS;
+}
+
+#endif // ENROLL_STATS_H
@@ -11,6 +11,18 @@
 #include <sys/file.h>
 #include "types.h"
 #include "utils.h"
+#include "trace.h"
+#include "probes.h"
+#include "db_version.h"
+#include "auth_version.h"
+#include "snapshot.h"
+#include "txn.h"
+#include "waitlist.h"
+#include "schedule.h"
+#include "prereq.h"
+#include "faculty_index.h"
+#include "enroll_stats.h"
+#include "render.h"
 
 #define MAX_LINE_LEN 512
 
@@ -39,17 +51,9 @@ static void strip_quotes(char *str) {
  * @return 1 if exists, 0 otherwise.
  */
 static int check_course_id_exists(int id) {
-    int fd = open(COURSE_DB, O_RDONLY);
+    int fd = snapshot_open(COURSE_DB);
     if (fd < 0) return 0;
 
-    // Shared lock for reading
-    struct flock lock = { .l_type = F_RDLCK, .l_whence = SEEK_SET };
-    if (fcntl(fd, F_SETLKW, &lock) == -1) {
-        perror("fcntl lock");
-        close(fd);
-        return 0;
-    }
-
     char line[MAX_LINE_LEN];
     int exists = 0;
 
@@ -61,43 +65,20 @@ static int check_course_id_exists(int id) {
         }
     }
 
-    // Release lock
-    lock.l_type = F_UNLCK;
-    fcntl(fd, F_SETLK, &lock);
     close(fd);
     return exists;
 }
 
 /**
- * @brief Updates the list of offered courses for a faculty.
+ * @brief Copies faculty.csv with one faculty's offered courses updated.
+ * @param faculty Current version of the table.
+ * @param temp New version being written.
  * @param faculty_id Faculty ID.
  * @param course_code Course code.
  * @param add 1 to add, 0 to remove the course.
- * @return SUCCESS, FILE_ERROR, or USER_NOT_FOUND.
+ * @return 1 if the faculty was found, 0 otherwise.
  */
-static int update_faculty_courses(int faculty_id, const char *course_code, int add) {
-    char temp_file[] = "../database/faculty_temp.csv";
-    int fd = open(FACULTY_DB, O_RDWR);
-    if (fd < 0) return FILE_ERROR;
-
-    // Exclusive lock for modification
-    struct flock lock = { .l_type = F_WRLCK, .l_whence = SEEK_SET };
-    if (fcntl(fd, F_SETLKW, &lock) == -1) {
-        close(fd);
-        return FILE_ERROR;
-    }
-
-    FILE *faculty = fdopen(fd, "r+");
-    FILE *temp = fopen(temp_file, "w");
-    if (!faculty || !temp) {
-        if (faculty) fclose(faculty);
-        if (temp) fclose(temp);
-        lock.l_type = F_UNLCK;
-        fcntl(fd, F_SETLK, &lock);
-        close(fd);
-        return FILE_ERROR;
-    }
-
+static int copy_faculty_courses(FILE *faculty, FILE *temp, int faculty_id, const char *course_code, int add) {
     char line[MAX_LINE_LEN];
     int updated = 0;
 
@@ -151,101 +132,126 @@ static int update_faculty_courses(int faculty_id, const char *course_code, int a
             fprintf(temp, "%s\n", line);
         }
     }
-
-    // Cleanup
-    fclose(faculty);
-    fclose(temp);
-    lock.l_type = F_UNLCK;
-    fcntl(fd, F_SETLK, &lock);
-    close(fd);
-
-    if (!updated) {
-        remove(temp_file);
-        return USER_NOT_FOUND;
-    }
-
-    // Replace old file
-    if (rename(temp_file, FACULTY_DB) < 0) {
-        remove(temp_file);
-        return FILE_ERROR;
-    }
-
-    return SUCCESS;
+    return updated;
 }
 
 /**
  * @brief Adds a new course to the system.
+ *
+ * The course row, the faculty's offered courses, the course's meeting times
+ * and its prerequisites are written in one transaction, so a course is
+ * never visible without its timetable or prerequisites.
+ *
  * @param id Course ID.
  * @param code Course code.
  * @param name Course name.
  * @param capacity Max students.
  * @param credits Credit value.
  * @param faculty_id Owner faculty ID.
- * @return SUCCESS, DUPLICATE_ID, FILE_ERROR.
+ * @param slots Meeting times.
+ * @param slot_count Number of meeting times (0 for none).
+ * @param requires Prerequisite codes, comma-separated ("" for none).
+ * @return SUCCESS, DUPLICATE_ID, PREREQ_CYCLE, USER_NOT_FOUND, FILE_ERROR.
  */
-int add_course(int id, const char *code, const char *name, int capacity, int credits, int faculty_id) {
-    if (check_course_id_exists(id)) return DUPLICATE_ID;
-
-    int fd = open(COURSE_DB, O_RDWR | O_CREAT, 0644);
-    if (fd < 0) return FILE_ERROR;
+int add_course(int id, const char *code, const char *name, int capacity, int credits, int faculty_id,
+               const TimeSlot *slots, int slot_count, const char *requires) {
+    // Hold the locks across the duplicate check so two adds cannot race
+    Txn txn;
+    if (txn_begin(&txn, 4, COURSE_DB, FACULTY_DB, DB_SCHEDULE, DB_PREREQS) != SUCCESS) return FILE_ERROR;
+
+    if (check_course_id_exists(id)) {
+        txn_abort(&txn);
+        return DUPLICATE_ID;
+    }
 
-    // Lock file exclusively
-    struct flock lock = { .l_type = F_WRLCK, .l_whence = SEEK_SET };
-    if (fcntl(fd, F_SETLKW, &lock) == -1) {
-        close(fd);
+    // Stage the course table with the new row at the end
+    int course_fd = snapshot_open(COURSE_DB);
+    FILE *temp = txn_write(&txn, COURSE_DB);
+    if (!temp) {
+        if (course_fd >= 0) close(course_fd);
+        txn_abort(&txn);
         return FILE_ERROR;
     }
+    char buf[8192], last = 0;
+    ssize_t n;
+    while (course_fd >= 0 && (n = read(course_fd, buf, sizeof(buf))) > 0) {
+        fwrite(buf, 1, n, temp);
+        last = buf[n - 1];
+    }
+    if (!last) {
+        fprintf(temp, "id,code,course_name,capacity,enrolled,credits,f_id,students\n");
+    } else if (last != '\n') {
+        fputc('\n', temp);
+    }
+    if (course_fd >= 0) close(course_fd);
+    fprintf(temp, "%d,%s,%s,%d,0,%d,%d,\"\"\n", id, code, name, capacity, credits, faculty_id);
 
-    FILE *course_file = fdopen(fd, "a+");
-    if (!course_file) {
-        lock.l_type = F_UNLCK;
-        fcntl(fd, F_SETLK, &lock);
-        close(fd);
+    // Add it to the faculty's offered courses
+    FILE *faculty = snapshot_fopen(FACULTY_DB);
+    FILE *temp_faculty = faculty ? txn_write(&txn, FACULTY_DB) : NULL;
+    if (!temp_faculty) {
+        if (faculty) fclose(faculty);
+        txn_abort(&txn);
         return FILE_ERROR;
     }
-
-    fseek(course_file, 0, SEEK_END);
-    if (ftell(course_file) == 0) {
-        fprintf(course_file, "id,code,course_name,capacity,enrolled,credits,f_id,students\n");
+    int updated = copy_faculty_courses(faculty, temp_faculty, faculty_id, code, 1);
+    fclose(faculty);
+    if (!updated) {
+        txn_abort(&txn);
+        return USER_NOT_FOUND;
     }
 
-    fprintf(course_file, "%d,%s,%s,%d,0,%d,%d,\"\"\n", id, code, name, capacity, credits, faculty_id);
-
-    lock.l_type = F_UNLCK;
-    fcntl(fd, F_SETLK, &lock);
-    fclose(course_file);
+    int status = SUCCESS;
+    if (slot_count > 0) status = schedule_stage_set(&txn, code, slots, slot_count);
+    if (status == SUCCESS && requires && requires[0]) status = prereq_stage_set(&txn, code, requires);
+    if (status != SUCCESS) {
+        txn_abort(&txn);
+        return status;
+    }
 
-    return update_faculty_courses(faculty_id, code, 1);
+    // Count the course in the statistics before other writers can see it
+    stats_commit_begin();
+    status = txn_publish(&txn);
+    if (status == SUCCESS) stats_course_add(id, code, capacity, 0);
+    stats_commit_end();
+    txn_release(&txn);
+    if (status == SUCCESS) db_version_bump_courses(&id, 1);
+    return status;
 }
 
 /**
- * @brief Removes a course from the system.
+ * @brief Removes a course, recording each phase in the given trace.
+ *
+ * The course row, the enrolled students' course lists, the faculty's
+ * offered courses, the course's waitlist and its meeting times are rewritten
+ * in one transaction, so the tables never disagree about whether the course exists.
+ *
  * @param id Course ID.
  * @param faculty_id Faculty who owns it.
+ * @param trace Trace record receiving the phase breakdown.
  * @return SUCCESS, FILE_ERROR, NOT_FOUND.
  */
-
-
-// Fix the remove_course function to remove unused variable and add proper return value
-int remove_course(int id, int faculty_id) {
-    char temp_file[] = "../database/courses_temp.csv";
+static int remove_course_phases(int id, int faculty_id, OpTrace *trace) {
     char course_code[32] = "";
     int found = 0;
 
-    int fd = open(COURSE_DB, O_RDWR);
-    if (fd < 0) return FILE_ERROR;
-
-    struct flock lock = { .l_type = F_WRLCK, .l_whence = SEEK_SET };
-    if (fcntl(fd, F_SETLKW, &lock) == -1) {
-        close(fd);
-        return FILE_ERROR;
+    // Refuse courses the faculty does not own before taking any lock; the
+    // scan below re-checks against the locked version
+    const FacultyIndex *ix = faculty_index_get();
+    if (ix) {
+        const FacultyCourse *own = NULL;
+        int own_count = faculty_courses(ix, faculty_id, &own), owned = 0;
+        for (int i = 0; i < own_count && !owned; i++) owned = own[i].id == id;
+        if (!owned) return NOT_FOUND;
     }
 
-    FILE *course_file = fdopen(fd, "r+");
+    Txn txn;
+    if (txn_begin(&txn, 6, COURSE_DB, STUDENT_DB, FACULTY_DB, DB_WAITLIST, DB_SCHEDULE, DB_PREREQS) != SUCCESS) return FILE_ERROR;
+    trace_phase(trace, "lock");
+
+    FILE *course_file = snapshot_fopen(COURSE_DB);
     if (!course_file) {
-        lock.l_type = F_UNLCK;
-        fcntl(fd, F_SETLK, &lock);
-        close(fd);
+        txn_abort(&txn);
         return FILE_ERROR;
     }
 
@@ -255,16 +261,17 @@ int remove_course(int id, int faculty_id) {
     // First, find the course and get its code and enrolled students
     if (fgets(line, sizeof(line), course_file)) {
         // Skip header
+        trace_scan(trace, strlen(line));
     }
 
     while (fgets(line, sizeof(line), course_file)) {
+        trace_scan(trace, strlen(line));
         int c_id, c_fid;
         if (sscanf(line, "%d,%31[^,],", &c_id, course_code) == 2 && c_id == id) {
             // Also check if this faculty is authorized to remove this course
             if (sscanf(line, "%*d,%*[^,],%*[^,],%*d,%*d,%*d,%d", &c_fid) == 1 && c_fid != faculty_id) {
-                lock.l_type = F_UNLCK;
-                fcntl(fd, F_SETLK, &lock);
                 fclose(course_file);
+                txn_abort(&txn);
                 return NOT_FOUND; // Not authorized
             }
             
@@ -284,97 +291,84 @@ int remove_course(int id, int faculty_id) {
         }
     }
 
+    trace_phase(trace, "course_scan");
+
     // If course not found or not owned by this faculty, return error
     if (!found) {
-        lock.l_type = F_UNLCK;
-        fcntl(fd, F_SETLK, &lock);
         fclose(course_file);
+        txn_abort(&txn);
         return NOT_FOUND;
     }
 
-    // Now directly update the students.csv file to remove the course code from all enrolled students
+    // Remove the course code from all enrolled students
     if (strlen(students_list) > 0) {
-        int students_fd = open(STUDENT_DB, O_RDWR);
-        if (students_fd >= 0) {
-            struct flock students_lock = { .l_type = F_WRLCK, .l_whence = SEEK_SET };
-            if (fcntl(students_fd, F_SETLKW, &students_lock) != -1) {
-                FILE *students_file = fdopen(students_fd, "r+");
-                if (students_file) {
-                    char temp_students_file[] = "../database/students_temp.csv";
-                    FILE *temp_students = fopen(temp_students_file, "w");
+        FILE *students_file = snapshot_fopen(STUDENT_DB);
+        FILE *temp_students = students_file ? txn_write(&txn, STUDENT_DB) : NULL;
+        if (!temp_students) {
+            if (students_file) fclose(students_file);
+            fclose(course_file);
+            txn_abort(&txn);
+            return FILE_ERROR;
+        }
+
+        char student_line[512];
+        // Copy header
+        if (fgets(student_line, sizeof(student_line), students_file)) {
+            fputs(student_line, temp_students);
+        }
+        
+        // Process each student
+        while (fgets(student_line, sizeof(student_line), students_file)) {
+            trace_scan(trace, strlen(student_line));
+            int student_id;
+            char name[100], email[100], password[100], enrolled_courses[512];
+            int active;
+            
+            // Remove newline if present
+            student_line[strcspn(student_line, "\n")] = '\0';
+            
+            if (sscanf(student_line, "%d,%[^,],%[^,],%[^,],%d,%[^\n]", 
+                      &student_id, name, email, password, &active, enrolled_courses) >= 5) {
+                
+                // Check if this student is enrolled in the course being removed
+                if (strstr(enrolled_courses, course_code)) {
+                    // Remove the course code from enrolled_courses
+                    char new_enrolled[512] = "";
+                    char *token = strtok(enrolled_courses, ",");
+                    int first = 1;
                     
-                    if (temp_students) {
-                        char student_line[512];
-                        // Copy header
-                        if (fgets(student_line, sizeof(student_line), students_file)) {
-                            fputs(student_line, temp_students);
-                        }
-                        
-                        // Process each student
-                        while (fgets(student_line, sizeof(student_line), students_file)) {
-                            int student_id;
-                            char name[100], email[100], password[100], enrolled_courses[512];
-                            int active;
-                            
-                            // Remove newline if present
-                            student_line[strcspn(student_line, "\n")] = '\0';
-                            
-                            if (sscanf(student_line, "%d,%[^,],%[^,],%[^,],%d,%[^\n]", 
-                                      &student_id, name, email, password, &active, enrolled_courses) >= 5) {
-                                
-                                // Check if this student is enrolled in the course being removed
-                                if (strstr(enrolled_courses, course_code)) {
-                                    // Remove the course code from enrolled_courses
-                                    char new_enrolled[512] = "";
-                                    char *token = strtok(enrolled_courses, ",");
-                                    int first = 1;
-                                    
-                                    while (token) {
-                                        if (strcmp(token, course_code) != 0) {
-                                            if (!first) strcat(new_enrolled, ",");
-                                            strcat(new_enrolled, token);
-                                            first = 0;
-                                        }
-                                        token = strtok(NULL, ",");
-                                    }
-                                    
-                                    // Write updated student record
-                                    fprintf(temp_students, "%d,%s,%s,%s,%d,%s\n", 
-                                           student_id, name, email, password, active, new_enrolled);
-                                } else {
-                                    // Student not enrolled in this course, write unchanged
-                                    fprintf(temp_students, "%s\n", student_line);
-                                }
-                            } else {
-                                // Line doesn't match expected format, write as is
-                                fprintf(temp_students, "%s\n", student_line);
-                            }
+                    while (token) {
+                        if (strcmp(token, course_code) != 0) {
+                            if (!first) strcat(new_enrolled, ",");
+                            strcat(new_enrolled, token);
+                            first = 0;
                         }
-                        
-                        fclose(temp_students);
-                        fclose(students_file);
-                        
-                        // Replace the original file with the temp file
-                        rename(temp_students_file, STUDENT_DB);
-                    } else {
-                        fclose(students_file);
+                        token = strtok(NULL, ",");
                     }
+                    
+                    // Write updated student record
+                    trace_rows(trace, 1);
+                    fprintf(temp_students, "%d,%s,%s,%s,%d,%s\n", 
+                           student_id, name, email, password, active, new_enrolled);
+                } else {
+                    // Student not enrolled in this course, write unchanged
+                    fprintf(temp_students, "%s\n", student_line);
                 }
-                
-                students_lock.l_type = F_UNLCK;
-                fcntl(students_fd, F_SETLK, &students_lock);
+            } else {
+                // Line doesn't match expected format, write as is
+                fprintf(temp_students, "%s\n", student_line);
             }
-            close(students_fd);
         }
+        fclose(students_file);
+        trace_phase(trace, "student_rewrite");
     }
 
     // Now proceed with course removal
     rewind(course_file);
-    FILE *temp = fopen(temp_file, "w");
+    FILE *temp = txn_write(&txn, COURSE_DB);
     if (!temp) {
-        lock.l_type = F_UNLCK;
-        fcntl(fd, F_SETLK, &lock);
         fclose(course_file);
+        txn_abort(&txn);
         return FILE_ERROR;
     }
 
@@ -385,25 +379,79 @@ int remove_course(int id, int faculty_id) {
 
     // Copy all lines except the one to be removed
     while (fgets(line, sizeof(line), course_file)) {
+        trace_scan(trace, strlen(line));
         int c_id;
         if (sscanf(line, "%d,", &c_id) == 1 && c_id == id) {
+            trace_rows(trace, 1);
             continue; // Skip this line (remove the course)
         }
         fputs(line, temp);
     }
-
     fclose(course_file);
-    fclose(temp);
-    lock.l_type = F_UNLCK;
-    fcntl(fd, F_SETLK, &lock);
-    close(fd);
+    trace_phase(trace, "course_rewrite");
 
-    if (rename(temp_file, COURSE_DB) < 0) {
-        remove(temp_file);
+    // Drop the course from the faculty's offered courses
+    FILE *faculty = snapshot_fopen(FACULTY_DB);
+    FILE *temp_faculty = faculty ? txn_write(&txn, FACULTY_DB) : NULL;
+    if (!temp_faculty) {
+        if (faculty) fclose(faculty);
+        txn_abort(&txn);
         return FILE_ERROR;
     }
+    int updated = copy_faculty_courses(faculty, temp_faculty, faculty_id, course_code, 0);
+    fclose(faculty);
+    if (!updated) {
+        txn_abort(&txn);
+        return USER_NOT_FOUND;
+    }
+    trace_phase(trace, "faculty_rewrite");
+
+    // Drop the course's waitlist; nobody can be promoted into a removed course
+    Waitlist w = { .course_id = id };
+    int status = waitlist_load(&w, 1);
+    if (status == SUCCESS && w.count) {
+        w.count = 0;
+        w.changed = 1;
+        status = waitlist_stage(&txn, &w, 1);
+    }
+    waitlist_free(&w, 1);
+
+    // Drop its meeting times and prerequisite edges too, so a later course
+    // reusing the code starts clean
+    if (status == SUCCESS) status = schedule_stage_remove(&txn, course_code);
+    if (status == SUCCESS) status = prereq_stage_remove(&txn, course_code);
+    if (status != SUCCESS) {
+        txn_abort(&txn);
+        return status;
+    }
 
-    return update_faculty_courses(faculty_id, course_code, 0);
+    // Publish every changed table together, drop the course from the
+    // enrollment statistics while it is still locked, then release the locks
+    stats_commit_begin();
+    status = txn_publish(&txn);
+    if (status == SUCCESS) stats_course_remove(id);
+    stats_commit_end();
+    txn_release(&txn);
+    trace_phase(trace, "commit");
+    return status;
+}
+
+/**
+ * @brief Removes a course from the system.
+ *
+ * Operations slower than ACADEMIA_SLOW_OP_MS are written to the slow-operation log.
+ *
+ * @param id Course ID.
+ * @param faculty_id Faculty who owns it.
+ * @return SUCCESS, FILE_ERROR, NOT_FOUND.
+ */
+int remove_course(int id, int faculty_id) {
+    OpTrace trace;
+    trace_begin(&trace, "remove_course");
+    int status = remove_course_phases(id, faculty_id, &trace);
+    if (status == SUCCESS) db_version_bump_courses(&id, 1);
+    trace_end(&trace, status);
+    return status;
 }
 
 /**
@@ -414,20 +462,14 @@ int remove_course(int id, int faculty_id) {
  * @return SUCCESS, NOT_FOUND, or FAILURE.
  */
 int change_password(const char *faculty_file, int faculty_id, const char *newpass) {
-    int fd = open(faculty_file, O_RDONLY);
-    if (fd < 0) return FAILURE;
-
-    struct flock lock = { .l_type = F_RDLCK, .l_whence = SEEK_SET };
-    if (fcntl(fd, F_SETLKW, &lock) == -1) {
-        close(fd);
-        return FAILURE;
-    }
-
-    int temp_fd = open("../database/faculty_temp.csv", O_WRONLY | O_CREAT | O_TRUNC, 0644);
-    if (temp_fd < 0) {
-        lock.l_type = F_UNLCK;
-        fcntl(fd, F_SETLK, &lock);
-        close(fd);
+    int lock_fd = txn_lock(faculty_file);
+    if (lock_fd < 0) return FAILURE;
+
+    int fd = snapshot_open(faculty_file);
+    SnapshotWriter writer;
+    if (fd < 0 || !snapshot_rewrite_begin(&writer, faculty_file)) {
+        if (fd >= 0) close(fd);
+        snapshot_unlock(lock_fd, faculty_file);
         return FAILURE;
     }
 
@@ -436,7 +478,7 @@ int change_password(const char *faculty_file, int faculty_id, const char *newpas
 
     while (read_line(fd, line, sizeof(line)) > 0) {
         if (strncmp(line, "id,", 3) == 0) {
-            write(temp_fd, line, strlen(line));
+            fputs(line, writer.out);
             continue;
         }
 
@@ -449,209 +491,133 @@ int change_password(const char *faculty_file, int faculty_id, const char *newpas
         char *rest = strtok(NULL, "\n");
 
         if (atoi(id) == faculty_id) {
-            char new_line[MAX_LINE_LEN];
-            int len = rest ? snprintf(new_line, sizeof(new_line), "%s,%s,%s,%s,%s\n", id, name, email, newpass, rest)
-                           : snprintf(new_line, sizeof(new_line), "%s,%s,%s,%s\n", id, name, email, newpass);
-            write(temp_fd, new_line, len);
+            if (rest) fprintf(writer.out, "%s,%s,%s,%s,%s\n", id, name, email, newpass, rest);
+            else      fprintf(writer.out, "%s,%s,%s,%s\n", id, name, email, newpass);
             found = 1;
         } else {
-            write(temp_fd, line, strlen(line));
+            fputs(line, writer.out);
         }
     }
-
-    lock.l_type = F_UNLCK;
-    fcntl(fd, F_SETLK, &lock);
     close(fd);
-    close(temp_fd);
 
-    if (!found) {
-        unlink("../database/faculty_temp.csv");
-        return NOT_FOUND;
+    int status = NOT_FOUND;
+    if (found) {
+        status = snapshot_rewrite_commit(&writer) == SUCCESS ? SUCCESS : FAILURE;
+    } else {
+        snapshot_rewrite_abort(&writer);
     }
+    snapshot_unlock(lock_fd, faculty_file);
 
-    unlink(faculty_file);
-    rename("../database/faculty_temp.csv", faculty_file);
-    return SUCCESS;
+    if (status == SUCCESS) auth_version_bump();
+    return status;
 }
-// Fix the view_enrollments function to return a value and remove unused variable
+static int enrollment_id_cmp(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static RenderBox roster_box = RENDER_TABLE(
+    "║ Student ID ║ Student Name                                             ║\n", "ds", 10, 56);
+
 /**
- * @brief Displays enrollments for a specific course taught by a faculty member.
+ * @brief Renders the enrollments of a course taught by a faculty member.
  *
- * This function reads the course database to find the specified course,
- * then displays all students enrolled in that course in a formatted table.
- * It uses file locking to ensure data consistency during reads.
+ * The course is found through the courses-by-faculty index, so only the
+ * faculty's own courses are looked at, and its row is read back with one
+ * pread(). The names of all enrolled students are then resolved in a single
+ * pass over a snapshot of the students table, so it never waits for writers.
  *
+ * @param out Output
  * @param faculty_id ID of the faculty member
  * @param selected_course_code Code of the course to view enrollments for
  * @return SUCCESS on success, FAILURE on error
  */
-int view_enrollments(int faculty_id, const char *selected_course_code) {
-    int courses_fd = open(COURSE_DB, O_RDONLY);
-    if (courses_fd < 0) return FAILURE;
-    
-    // Acquire shared lock for reading
-    struct flock lock;
-    memset(&lock, 0, sizeof(lock));
-    lock.l_type = F_RDLCK;
-    lock.l_whence = SEEK_SET;
-    lock.l_start = 0;
-    lock.l_len = 0; // Lock the entire file
-    
-    if (fcntl(courses_fd, F_SETLKW, &lock) == -1) {
-        perror("fcntl lock");
-        close(courses_fd);
+static inline int render_enrollments(RenderBuf *out, int faculty_id, const char *selected_course_code) {
+    const FacultyIndex *ix = faculty_index_get();
+    if (!ix) return FAILURE;
+
+    RenderBox *box = &roster_box;
+    render_text(out, "\n");
+    render_rule(out, box, RULE_TOP);
+
+    const FacultyCourse *course = faculty_course_find(ix, faculty_id, selected_course_code);
+    char line[MAX_LINE_LEN];
+    if (!course || faculty_course_row(ix, course, line, sizeof(line)) != SUCCESS) {
+        // Course not found
+        render_line(out, box, "Course not found or you are not authorized to view this course.");
+        render_rule(out, box, RULE_BOTTOM);
         return FAILURE;
     }
-    
-    char line[MAX_LINE_LEN];
-    ssize_t bytes_read;
-    
-    // Skip header line
-    read_line(courses_fd, line, sizeof(line));
-    
-    while ((bytes_read = read_line(courses_fd, line, sizeof(line))) > 0) {
-        int id, capacity, enrolled, credits, fid;
-        char code[50], name[100], student_ids_raw[256];
-        
-        // Initialize student_ids_raw in case there's no enrolled list
-        strcpy(student_ids_raw, "");
-        
-        int fields = sscanf(line, "%d,%49[^,],%99[^,],%d,%d,%d,%d,%255[^\n]",
-                            &id, code, name, &capacity, &enrolled, &credits, &fid, student_ids_raw);
-        
-        if (fields < 7) continue;
-        
-        if (strcmp(code, selected_course_code) == 0 && fid == faculty_id) {
-            const char *header1 = "\n╔═══════════════════════════════════════════════════════════════════════╗\n";
-            write(STDOUT_FILENO, header1, strlen(header1));
-            
-            char course_info[256];
-            int len = snprintf(course_info, sizeof(course_info), 
-                              "║ Course: %-30s (%-8s)                     ║\n", name, code);
-            write(STDOUT_FILENO, course_info, len);
-            
-            const char *header2 = "╠═══════════════════════════════════════════════════════════════════════╣\n"
-                                 "║ Enrolled Students:                                                    ║\n";
-            write(STDOUT_FILENO, header2, strlen(header2));
-            
-            if (fields < 8 || strlen(student_ids_raw) == 0) {
-                const char *no_students = "║ No students enrolled.                                                ║\n"
-                                         "╚═══════════════════════════════════════════════════════════════════════╝\n";
-                write(STDOUT_FILENO, no_students, strlen(no_students));
-                
-                // Release lock
-                lock.l_type = F_UNLCK;
-                fcntl(courses_fd, F_SETLK, &lock);
-                close(courses_fd);
-                return SUCCESS;
-            }
-            
-            // Strip quotes if present
-            if (strlen(student_ids_raw) > 0) {
-                strip_quotes(student_ids_raw);
-            }
-            
-            if (strlen(student_ids_raw) == 0) {
-                const char *no_students = "║ No students enrolled.                                                ║\n"
-                                         "╚═══════════════════════════════════════════════════════════════════════╝\n";
-                write(STDOUT_FILENO, no_students, strlen(no_students));
-                
-                // Release lock
-                lock.l_type = F_UNLCK;
-                fcntl(courses_fd, F_SETLK, &lock);
-                close(courses_fd);
-                return SUCCESS;
-            }
-            
-            char student_list[256];
-            strcpy(student_list, student_ids_raw);
-            
-            const char *table_header = "╠═══════════╦═══════════════════════════════════════════════════════════╣\n"
-                                      "║ Student ID ║ Student Name                                             ║\n"
-                                      "╠═══════════╬═══════════════════════════════════════════════════════════╣\n";
-            write(STDOUT_FILENO, table_header, strlen(table_header));
-            
-            char *sid_token = strtok(student_list, ",");
-            
-            while (sid_token) {
-                int students_fd = open(STUDENT_DB, O_RDONLY);
-                if (students_fd < 0) {
-                    // Release lock
-                    lock.l_type = F_UNLCK;
-                    fcntl(courses_fd, F_SETLK, &lock);
-                    close(courses_fd);
-                    return FAILURE;
-                }
-                
-                // Acquire shared lock for reading students file
-                struct flock stu_lock;
-                memset(&stu_lock, 0, sizeof(stu_lock));
-                stu_lock.l_type = F_RDLCK;
-                stu_lock.l_whence = SEEK_SET;
-                stu_lock.l_start = 0;
-                stu_lock.l_len = 0; // Lock the entire file
-                
-                if (fcntl(students_fd, F_SETLKW, &stu_lock) == -1) {
-                    perror("fcntl lock");
-                    close(students_fd);
-                    continue;
-                }
-                
-                // Skip header
-                char stu_line[MAX_LINE_LEN];
-                read_line(students_fd, stu_line, sizeof(stu_line));
-                
-                int student_found = 0;
-                while (read_line(students_fd, stu_line, sizeof(stu_line)) > 0) {
-                    char sid[10], sname[100];
-                    sscanf(stu_line, "%9[^,],%99[^,]", sid, sname);
-                    
-                    if (atoi(sid) == atoi(sid_token)) {
-                        char student_row[256];
-                        int len = snprintf(student_row, sizeof(student_row),
-                                          "║ %-9s ║ %-55s ║\n", sid, sname);
-                        write(STDOUT_FILENO, student_row, len);
-                        student_found = 1;
-                        break;
-                    }
-                }
-                
-                // Release lock on students file
-                stu_lock.l_type = F_UNLCK;
-                fcntl(students_fd, F_SETLK, &stu_lock);
-                close(students_fd);
-                
-                if (!student_found) {
-                    char unknown_student[256];
-                    int len = snprintf(unknown_student, sizeof(unknown_student),
-                                      "║ %-9s ║ %-55s ║\n", sid_token, "Unknown student");
-                    write(STDOUT_FILENO, unknown_student, len);
-                }
-                
-                sid_token = strtok(NULL, ",");
-            }
-            
-            const char *table_footer = "╚═══════════╩═══════════════════════════════════════════════════════════╝\n";
-            write(STDOUT_FILENO, table_footer, strlen(table_footer));
-            
-            // Release lock
-            lock.l_type = F_UNLCK;
-            fcntl(courses_fd, F_SETLK, &lock);
-            close(courses_fd);
-            return SUCCESS;
-        }
+
+    int id, capacity, enrolled, credits, fid;
+    char code[50], name[100], student_ids_raw[256] = "";
+    int fields = sscanf(line, "%d,%49[^,],%99[^,],%d,%d,%d,%d,%255[^\n]",
+                        &id, code, name, &capacity, &enrolled, &credits, &fid, student_ids_raw);
+
+    render_line(out, box, "Course: %-30s (%-8s)", name, code);
+    render_rule(out, box, RULE_LINE);
+    render_line(out, box, "Enrolled Students:");
+
+    // Strip quotes if present
+    if (fields >= 8) strip_quotes(student_ids_raw);
+
+    int ids[128], sorted[128], count = 0;
+    for (char *tok = strtok(student_ids_raw, ","); tok && count < 128; tok = strtok(NULL, ",")) {
+        ids[count++] = atoi(tok);
     }
-    
-    // Release lock
-    lock.l_type = F_UNLCK;
-    fcntl(courses_fd, F_SETLK, &lock);
-    close(courses_fd);
-    
-    // Course not found
-    const char *not_found_msg = "\n╔═══════════════════════════════════════════════════════════════════════╗\n"
-                               "║ Course not found or you are not authorized to view this course.        ║\n"
-                               "╚═══════════════════════════════════════════════════════════════════════╝\n";
-    write(STDOUT_FILENO, not_found_msg, strlen(not_found_msg));
-    return FAILURE;
+
+    if (fields < 8 || count == 0) {
+        render_line(out, box, "No students enrolled.");
+        render_rule(out, box, RULE_BOTTOM);
+        return SUCCESS;
+    }
+
+    // Resolve every name in one pass over the students table
+    char names[128][100];
+    memcpy(sorted, ids, count * sizeof(int));
+    qsort(sorted, count, sizeof(int), enrollment_id_cmp);
+    for (int i = 0; i < count; i++) names[i][0] = '\0';
+
+    FILE *students = snapshot_fopen(STUDENT_DB);
+    if (!students) return FAILURE;
+    char stu_line[MAX_LINE_LEN];
+    while (fgets(stu_line, sizeof(stu_line), students)) {
+        int sid;
+        char sname[100];
+        if (sscanf(stu_line, "%d,%99[^,]", &sid, sname) != 2) continue;
+        int *hit = bsearch(&sid, sorted, count, sizeof(int), enrollment_id_cmp);
+        if (hit) snprintf(names[hit - sorted], sizeof(names[0]), "%s", sname);
+    }
+    fclose(students);
+
+    render_rule(out, box, RULE_SPLIT);
+    render_header(out, box);
+    render_rule(out, box, RULE_MID);
+
+    for (int i = 0; i < count; i++) {
+        int *hit = bsearch(&ids[i], sorted, count, sizeof(int), enrollment_id_cmp);
+        const char *sname = names[hit - sorted][0] ? names[hit - sorted] : "Unknown student";
+        render_row(out, box, ids[i], sname);
+    }
+
+    render_rule(out, box, RULE_BOTTOM_COLUMNS);
+    return SUCCESS;
+}
+
+/**
+ * @brief Displays enrollments for a specific course taught by a faculty member.
+ *
+ * The table is rendered into one buffer and written at once; see render_enrollments().
+ *
+ * @param faculty_id ID of the faculty member
+ * @param selected_course_code Code of the course to view enrollments for
+ * @return SUCCESS on success, FAILURE on error
+ */
+int view_enrollments(int faculty_id, const char *selected_course_code) {
+    RenderBuf out = {0};
+    int status = render_enrollments(&out, faculty_id, selected_course_code);
+    render_flush(&out, STDOUT_FILENO);
+    render_free(&out);
+    return status;
 }
 #endif // FACULTY_ACTIONS_H
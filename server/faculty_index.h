@@ -0,0 +1,403 @@
+#ifndef FACULTY_INDEX_H
+#define FACULTY_INDEX_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "types.h"
+#include "utils.h"
+#include "db_version.h"
+#include "snapshot.h"
+#include "strpool.h"
+
+#define FACULTY_INDEX_DB          "../database/courses.csv"
+#define FACULTY_INDEX_MAX_CHANGES 256   ///< Changed courses applied in place; more means a rebuild
+#define FACULTY_ROW_PREFIX        512   ///< Bytes of a row that hold everything up to faculty_id
+
+/**
+ * @brief Secondary index of courses by faculty.
+ *
+ * One scan of a courses.csv snapshot records, for every course, its owner,
+ * code, name and the byte offset of its row, grouped by faculty. The index
+ * keeps that snapshot open, so a course row can be read back with one pread()
+ * even after writers have published newer versions. Faculty operations thus
+ * cost O(own courses) instead of a scan of the whole catalogue.
+ *
+ * When the table changes (a new inode or mtime), the version log names the
+ * courses whose rows changed. Only those rows are read from the new snapshot;
+ * the offsets of the others move by the change in length of the changed rows
+ * before them. Rows are checked against their ids and the file size against
+ * the sum of the row lengths. If a check fails, the log cannot tell, or a
+ * course was added, removed or moved to another faculty, the index is
+ * rebuilt from a full scan.
+ */
+
+/**
+ * @brief One course in the index.
+ */
+typedef struct {
+    int id;
+    int faculty_id;
+    off_t offset;           ///< Start of the course's row in the indexed snapshot
+    size_t len;             ///< Length of the row, with its newline
+    StrId code;             ///< In FacultyIndex.strings
+    StrId name;
+} FacultyCourse;
+
+/**
+ * @brief Position of a course in FacultyIndex.courses.
+ */
+typedef struct {
+    int id;
+    int pos;
+} FacultyById;
+
+/**
+ * @brief Courses of one snapshot of courses.csv, grouped by faculty.
+ */
+typedef struct {
+    int fd;                 ///< The indexed snapshot, kept open for pread()
+    ino_t inode;
+    struct timespec mtime;
+    off_t size;
+    unsigned long version;  ///< Catalogue version the index is known to be current with
+    unsigned long generation; ///< Bumped whenever the index changes
+    int loaded;
+    FacultyCourse *courses; ///< Sorted by faculty, then by row order
+    int count;
+    FacultyById *by_id;     ///< Positions in courses, sorted by course id
+    int *faculty_ids;       ///< Distinct faculty ids, sorted
+    int *first;             ///< Courses of faculty_ids[k]: courses[first[k]..first[k + 1])
+    int faculty_count;
+    StrPool strings;        ///< Course codes and names
+} FacultyIndex;
+
+static int faculty_course_cmp(const void *a, const void *b) {
+    const FacultyCourse *x = a, *y = b;
+    if (x->faculty_id != y->faculty_id) return (x->faculty_id > y->faculty_id) - (x->faculty_id < y->faculty_id);
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+static int faculty_id_cmp(const void *a, const void *b) {
+    const FacultyById *x = a, *y = b;
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+static int faculty_offset_cmp(const void *a, const void *b) {
+    const FacultyCourse *x = *(const FacultyCourse *const *)a, *y = *(const FacultyCourse *const *)b;
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+static inline void faculty_index_free(FacultyIndex *ix) {
+    unsigned long generation = ix->generation;
+    if (ix->loaded && ix->fd >= 0) close(ix->fd);
+    free(ix->courses);
+    free(ix->by_id);
+    free(ix->faculty_ids);
+    free(ix->first);
+    strpool_free(&ix->strings);
+    memset(ix, 0, sizeof(*ix));
+    ix->fd = -1;
+    ix->generation = generation;
+}
+
+/**
+ * @brief Parses the start of a course row.
+ *
+ * @param line    Row, or at least its first FACULTY_ROW_PREFIX bytes.
+ * @param c       Receives the id and faculty id.
+ * @param code    Receives the code (32 bytes).
+ * @param name    Receives the name (MAX_COURSE_NAME_LEN bytes).
+ * @return SUCCESS, or FAILURE for the header or a malformed row.
+ */
+static inline int faculty_parse_row(const char *line, FacultyCourse *c, char *code, char *name) {
+    int capacity, enrolled, credits;
+    if (sscanf(line, "%d,%31[^,],%99[^,],%d,%d,%d,%d", &c->id, code, name,
+               &capacity, &enrolled, &credits, &c->faculty_id) != 7) {
+        return FAILURE;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Finds a course by id.
+ * @return Its position in ix->courses, or -1.
+ */
+static inline int faculty_index_find_id(const FacultyIndex *ix, int id) {
+    int lo = 0, hi = ix->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (ix->by_id[mid].id < id) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < ix->count && ix->by_id[lo].id == id ? ix->by_id[lo].pos : -1;
+}
+
+/**
+ * @brief Scans a snapshot of courses.csv into the index.
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int faculty_index_build(FacultyIndex *ix, int fd) {
+    int scan_fd = dup(fd);
+    FILE *file = scan_fd >= 0 ? fdopen(scan_fd, "r") : NULL;
+    if (!file) {
+        if (scan_fd >= 0) close(scan_fd);
+        return FILE_ERROR;
+    }
+
+    int cap = 0;
+    char *line = NULL;
+    size_t line_cap = 0;
+    ssize_t len;
+    off_t offset = 0;
+    while ((len = getline(&line, &line_cap, file)) > 0) {
+        off_t row = offset;
+        offset += len;
+
+        FacultyCourse c;
+        char code[32], name[MAX_COURSE_NAME_LEN];
+        if (faculty_parse_row(line, &c, code, name) != SUCCESS) continue; // Header or malformed
+        c.offset = row;
+        c.len = len;
+        c.code = strpool_intern(&ix->strings, code);
+        c.name = strpool_intern(&ix->strings, name);
+        if (c.code == STR_NONE || c.name == STR_NONE) {
+            free(line);
+            fclose(file);
+            return FILE_ERROR;
+        }
+
+        if (ix->count == cap) {
+            cap = cap ? cap * 2 : 256;
+            FacultyCourse *grown = realloc(ix->courses, cap * sizeof(FacultyCourse));
+            if (!grown) {
+                free(line);
+                fclose(file);
+                return FILE_ERROR;
+            }
+            ix->courses = grown;
+        }
+        ix->courses[ix->count++] = c;
+    }
+    free(line);
+    fclose(file);
+
+    qsort(ix->courses, ix->count, sizeof(FacultyCourse), faculty_course_cmp);
+
+    ix->by_id = malloc((ix->count + 1) * sizeof(FacultyById));
+    ix->faculty_ids = malloc((ix->count + 1) * sizeof(int));
+    ix->first = malloc((ix->count + 2) * sizeof(int));
+    if (!ix->by_id || !ix->faculty_ids || !ix->first) return FILE_ERROR;
+    for (int i = 0; i < ix->count; i++) ix->by_id[i] = (FacultyById){ ix->courses[i].id, i };
+    qsort(ix->by_id, ix->count, sizeof(FacultyById), faculty_id_cmp);
+    for (int i = 0; i < ix->count; i++) {
+        if (ix->faculty_count == 0 || ix->faculty_ids[ix->faculty_count - 1] != ix->courses[i].faculty_id) {
+            ix->faculty_ids[ix->faculty_count] = ix->courses[i].faculty_id;
+            ix->first[ix->faculty_count++] = i;
+        }
+    }
+    ix->first[ix->faculty_count] = ix->count;
+    return SUCCESS;
+}
+
+/**
+ * @brief Reads one row of a snapshot of courses.csv.
+ *
+ * @param fd     Snapshot.
+ * @param offset Start of the row.
+ * @param c      Receives the id and faculty id.
+ * @param code   Receives the code (32 bytes).
+ * @param name   Receives the name (MAX_COURSE_NAME_LEN bytes).
+ * @param len    Receives the length of the row, with its newline.
+ * @return SUCCESS, or FAILURE if there is no complete course row at offset.
+ */
+static inline int faculty_read_row(int fd, off_t offset, FacultyCourse *c, char *code, char *name, size_t *len) {
+    char buf[FACULTY_ROW_PREFIX];
+    ssize_t n = pread(fd, buf, sizeof(buf) - 1, offset);
+    if (n <= 0) return FAILURE;
+    buf[n] = '\0';
+    if (faculty_parse_row(buf, c, code, name) != SUCCESS) return FAILURE;
+
+    // Student lists make rows longer than the prefix; look further for the newline
+    for (size_t seen = 0; ; ) {
+        char *nl = memchr(buf, '\n', n);
+        if (nl) {
+            *len = seen + (nl - buf) + 1;
+            return SUCCESS;
+        }
+        seen += n;
+        n = pread(fd, buf, sizeof(buf), offset + seen);
+        if (n <= 0) return FAILURE;
+    }
+}
+
+/**
+ * @brief Brings the index up to a newer snapshot by re-reading only the rows
+ *        the version log says have changed.
+ *
+ * On FAILURE the index is left half updated and must be rebuilt.
+ *
+ * @param ix      Index, current with ix->version.
+ * @param fd      New snapshot.
+ * @param st      Its fstat().
+ * @param version Catalogue version read before the snapshot was opened.
+ * @return SUCCESS, or FAILURE if the index must be rebuilt.
+ */
+static inline int faculty_index_update(FacultyIndex *ix, int fd, const struct stat *st, unsigned long version) {
+    int ids[FACULTY_INDEX_MAX_CHANGES];
+    int n = db_version_changes(ix->version, version, ids, FACULTY_INDEX_MAX_CHANGES);
+    if (n < 0) return FAILURE;
+
+    FacultyCourse *changed[FACULTY_INDEX_MAX_CHANGES];
+    int k = 0;
+    for (int i = 0; i < n; i++) {
+        int pos = faculty_index_find_id(ix, ids[i]);
+        if (pos < 0) return FAILURE; // Added course
+        int seen = 0;
+        for (int j = 0; j < k && !seen; j++) seen = changed[j] == &ix->courses[pos];
+        if (!seen) changed[k++] = &ix->courses[pos];
+    }
+    qsort(changed, k, sizeof(*changed), faculty_offset_cmp);
+
+    // shift[j]: how far rows after the changed row j have moved
+    off_t old_offset[FACULTY_INDEX_MAX_CHANGES], shift[FACULTY_INDEX_MAX_CHANGES];
+    off_t delta = 0;
+    for (int j = 0; j < k; j++) {
+        FacultyCourse *c = changed[j], row;
+        char code[32], name[MAX_COURSE_NAME_LEN];
+        size_t len;
+        if (faculty_read_row(fd, c->offset + delta, &row, code, name, &len) != SUCCESS ||
+            row.id != c->id || row.faculty_id != c->faculty_id) {
+            return FAILURE; // Removed, or moved to another faculty
+        }
+        c->code = strpool_intern(&ix->strings, code);
+        c->name = strpool_intern(&ix->strings, name);
+        if (c->code == STR_NONE || c->name == STR_NONE) return FAILURE;
+
+        old_offset[j] = c->offset;
+        delta += (off_t)len - (off_t)c->len;
+        shift[j] = delta;
+        c->len = len;
+    }
+    if (ix->size + delta != st->st_size) return FAILURE;
+
+    for (int i = 0; i < ix->count && k > 0; i++) {
+        // Changed rows that start before this one
+        int lo = 0, hi = k;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (old_offset[mid] < ix->courses[i].offset) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo > 0) ix->courses[i].offset += shift[lo - 1];
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Returns the index for the current courses table, updating it if
+ *        the table has changed.
+ *
+ * @return Pointer to the process-wide index, or NULL on error.
+ */
+static inline const FacultyIndex *faculty_index_get(void) {
+    static FacultyIndex index = { .fd = -1 };
+
+    struct stat st;
+    if (index.loaded && stat(FACULTY_INDEX_DB, &st) == 0 && st.st_ino == index.inode &&
+        st.st_mtim.tv_sec == index.mtime.tv_sec && st.st_mtim.tv_nsec == index.mtime.tv_nsec) {
+        return &index;
+    }
+
+    // Read first: the snapshot then holds at least every change up to version
+    unsigned long version = db_version_read();
+    int fd = snapshot_open(FACULTY_INDEX_DB);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) close(fd);
+        faculty_index_free(&index);
+        return NULL;
+    }
+
+    if (index.loaded && faculty_index_update(&index, fd, &st, version) == SUCCESS) {
+        close(index.fd);
+    } else {
+        faculty_index_free(&index);
+        if (faculty_index_build(&index, fd) != SUCCESS) {
+            close(fd);
+            faculty_index_free(&index);
+            return NULL;
+        }
+    }
+    index.fd = fd;
+    index.inode = st.st_ino;
+    index.mtime = st.st_mtim;
+    index.size = st.st_size;
+    index.version = version;
+    index.generation++;
+    index.loaded = 1;
+    return &index;
+}
+
+/**
+ * @brief Finds the courses of one faculty.
+ *
+ * @param ix         Index.
+ * @param faculty_id Faculty ID.
+ * @param list       Set to the faculty's first course, in row order.
+ * @return Number of courses (0 if none).
+ */
+static inline int faculty_courses(const FacultyIndex *ix, int faculty_id, const FacultyCourse **list) {
+    int lo = 0, hi = ix->faculty_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (ix->faculty_ids[mid] < faculty_id) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == ix->faculty_count || ix->faculty_ids[lo] != faculty_id) return 0;
+    *list = &ix->courses[ix->first[lo]];
+    return ix->first[lo + 1] - ix->first[lo];
+}
+
+/**
+ * @brief Returns one of the index's strings.
+ */
+static inline const char *faculty_index_str(const FacultyIndex *ix, StrId id) {
+    return strpool_get(&ix->strings, id);
+}
+
+/**
+ * @brief Finds a faculty's course by code.
+ * @return The course, or NULL if the faculty does not offer it.
+ */
+static inline const FacultyCourse *faculty_course_find(const FacultyIndex *ix, int faculty_id, const char *code) {
+    StrId id = strpool_find(&ix->strings, code);
+    if (id == STR_NONE) return NULL;
+
+    const FacultyCourse *list = NULL;
+    int count = faculty_courses(ix, faculty_id, &list);
+    for (int i = 0; i < count; i++) {
+        if (list[i].code == id) return &list[i];
+    }
+    return NULL;
+}
+
+/**
+ * @brief Reads a course's full row from the indexed snapshot.
+ *
+ * @param ix  Index the course came from.
+ * @param c   Course.
+ * @param buf Receives the row, without its newline.
+ * @param len Size of buf.
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int faculty_course_row(const FacultyIndex *ix, const FacultyCourse *c, char *buf, size_t len) {
+    ssize_t n = pread(ix->fd, buf, len - 1, c->offset);
+    if (n <= 0) return FILE_ERROR;
+    buf[n] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+    return atoi(buf) == c->id ? SUCCESS : FILE_ERROR;
+}
+
+#endif // FACULTY_INDEX_H
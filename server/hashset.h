@@ -0,0 +1,90 @@
+#ifndef HASHSET_H
+#define HASHSET_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+/**
+ * @brief Set of strings with open addressing and linear probing.
+ *
+ * Keys are copied into the set. The table is kept at most half full, so
+ * membership tests and inserts are O(1) on average.
+ */
+typedef struct {
+    char **keys;
+    size_t cap;     ///< Number of slots (power of two), 0 until first insert
+    size_t count;
+} HashSet;
+
+/**
+ * @brief FNV-1a hash of a string.
+ */
+static inline size_t hashset_hash(const char *key) {
+    size_t h = 1469598103934665603ULL;
+    for (; *key; key++) {
+        h ^= (unsigned char)*key;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/**
+ * @brief Returns the slot holding a key, or the empty slot where it belongs.
+ */
+static inline size_t hashset_slot(const HashSet *s, const char *key) {
+    size_t i = hashset_hash(key) & (s->cap - 1);
+    while (s->keys[i] && strcmp(s->keys[i], key) != 0) i = (i + 1) & (s->cap - 1);
+    return i;
+}
+
+/**
+ * @brief Doubles the number of slots and rehashes every key.
+ * @return SUCCESS or FAILURE if out of memory.
+ */
+static inline int hashset_grow(HashSet *s) {
+    HashSet bigger = { calloc(s->cap ? s->cap * 2 : 64, sizeof(char *)), s->cap ? s->cap * 2 : 64, s->count };
+    if (!bigger.keys) return FAILURE;
+
+    for (size_t i = 0; i < s->cap; i++) {
+        if (s->keys[i]) bigger.keys[hashset_slot(&bigger, s->keys[i])] = s->keys[i];
+    }
+    free(s->keys);
+    *s = bigger;
+    return SUCCESS;
+}
+
+/**
+ * @brief Checks whether a key is in the set.
+ * @return 1 if present, 0 otherwise.
+ */
+static inline int hashset_contains(const HashSet *s, const char *key) {
+    return s->cap && s->keys[hashset_slot(s, key)] != NULL;
+}
+
+/**
+ * @brief Adds a key to the set.
+ * @return 1 if the key was added, 0 if it was already present, FAILURE if out
+ *         of memory.
+ */
+static inline int hashset_add(HashSet *s, const char *key) {
+    if ((s->count + 1) * 2 > s->cap && hashset_grow(s) != SUCCESS) return FAILURE;
+
+    size_t i = hashset_slot(s, key);
+    if (s->keys[i]) return 0;
+    if (!(s->keys[i] = strdup(key))) return FAILURE;
+    s->count++;
+    return 1;
+}
+
+/**
+ * @brief Frees every key and the slot array.
+ */
+static inline void hashset_free(HashSet *s) {
+    for (size_t i = 0; i < s->cap; i++) free(s->keys[i]);
+    free(s->keys);
+    s->keys = NULL;
+    s->cap = s->count = 0;
+}
+
+#endif // HASHSET_H
@@ -0,0 +1,409 @@
+#ifndef LOGIN_SNAPSHOT_H
+#define LOGIN_SNAPSHOT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "types.h"
+#include "utils.h"
+#include "snapshot.h"
+#include "auth_version.h"
+
+#define LOGIN_SNAPSHOT   "../database/logins.snap"
+#define LOGIN_SNAP_MAGIC 0x32474f4cu   ///< "LOG2"
+#define LOGIN_TABLES     3
+
+/**
+ * @brief Binary snapshot of the user tables for logins.
+ *
+ * The snapshot holds every admin, student and faculty login (id, active flag,
+ * email, name, password) with a hash index by email, laid out so it can be
+ * used straight from an mmap() of the file. The server maps it at start and
+ * authenticates from it in O(1) without parsing any CSV. The snapshot records
+ * the login data version (auth_version.h) it was built under; once a login
+ * changes, lookups fall back to the CSV scan until a fresh snapshot is in
+ * place. Enrollments rewrite the student table without touching a login, so
+ * they leave the snapshot in use.
+ *
+ * The snapshot also records the inode, mtime and size of each table it was
+ * built from. These catch any change at all, made by this server or not; they
+ * are only compared at start and on shutdown.
+ *
+ * Snapshots are built from table snapshots by login_snapshot_build(), either
+ * in a background process started when the mapped one is found stale or on
+ * clean shutdown, and published with rename() like the tables themselves.
+ *
+ * File layout: header, then per table its records and its slots, then the
+ * strings. All offsets are from the start of the file.
+ */
+
+/**
+ * @brief Version of a table a snapshot was built from.
+ */
+typedef struct {
+    uint64_t inode;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    int64_t size;
+} LoginStamp;
+
+typedef struct {
+    int32_t id;
+    int32_t active;         ///< Always 1 for admins and faculty
+    uint32_t email;         ///< Offsets of NUL-terminated strings
+    uint32_t name;
+    uint32_t password;
+    uint32_t hash;          ///< Of the email
+} LoginRecord;
+
+typedef struct {
+    uint32_t count;
+    uint32_t slot_count;    ///< Power of two
+    uint64_t records;       ///< LoginRecord[count]
+    uint64_t slots;         ///< uint32_t[slot_count], record index + 1, 0 if free
+} LoginTable;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t size;          ///< Of the whole file
+    uint64_t auth_version;  ///< Login data version the tables were read under
+    LoginStamp stamps[LOGIN_TABLES];
+    LoginTable tables[LOGIN_TABLES];
+} LoginSnapHeader;
+
+/**
+ * @brief A login found in the snapshot; strings point into the mapping.
+ */
+typedef struct {
+    int id;
+    int active;
+    const char *name;
+    const char *password;
+} LoginEntry;
+
+/**
+ * @brief The process's mapping of the snapshot.
+ */
+typedef struct {
+    const LoginSnapHeader *h;   ///< NULL if none is mapped
+    size_t size;
+    ino_t inode;
+} LoginSnapMap;
+
+static LoginSnapMap login_snap_map;
+
+/**
+ * @brief Returns the table holding a role's users.
+ */
+static inline const char *login_table_path(int role) {
+    switch (role) {
+        case ADMIN:   return "../database/admins.csv";
+        case STUDENT: return "../database/students.csv";
+        case FACULTY: return "../database/faculty.csv";
+        default:      return NULL;
+    }
+}
+
+static inline uint32_t login_hash(const char *s) {
+    uint32_t h = 2166136261u;
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static inline LoginStamp login_stamp(const struct stat *st) {
+    LoginStamp s = { (uint64_t)st->st_ino, st->st_mtim.tv_sec, st->st_mtim.tv_nsec, st->st_size };
+    return s;
+}
+
+/**
+ * @brief Maps the current snapshot file if it is not the one already mapped.
+ *
+ * Cheap when nothing changed (one stat()). A missing or malformed file leaves
+ * nothing mapped.
+ */
+static inline void login_snapshot_refresh(void) {
+    struct stat st;
+    if (stat(LOGIN_SNAPSHOT, &st) != 0) {
+        if (login_snap_map.h) munmap((void *)login_snap_map.h, login_snap_map.size);
+        memset(&login_snap_map, 0, sizeof(login_snap_map));
+        return;
+    }
+    if (login_snap_map.h && st.st_ino == login_snap_map.inode) return;
+
+    int fd = open(LOGIN_SNAPSHOT, O_RDONLY);
+    if (fd < 0) return;
+    const LoginSnapHeader *h = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(LoginSnapHeader)) {
+        h = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (h == MAP_FAILED) return;
+    if (h->magic != LOGIN_SNAP_MAGIC || h->size != (uint64_t)st.st_size) {
+        munmap((void *)h, st.st_size);
+        return;
+    }
+
+    if (login_snap_map.h) munmap((void *)login_snap_map.h, login_snap_map.size);
+    login_snap_map.h = h;
+    login_snap_map.size = st.st_size;
+    login_snap_map.inode = st.st_ino;
+}
+
+/**
+ * @brief Checks whether no login has changed since the mapped snapshot was built.
+ */
+static inline int login_snapshot_current(void) {
+    return login_snap_map.h && login_snap_map.h->auth_version == auth_version_read();
+}
+
+/**
+ * @brief Checks whether a login has changed since the mapped snapshot was built.
+ */
+static inline int login_snapshot_stale(void) {
+    return !login_snapshot_current();
+}
+
+/**
+ * @brief Checks whether any user table has changed in any way since the
+ *        mapped snapshot was built, including columns logins do not use.
+ */
+static inline int login_snapshot_outdated(void) {
+    const LoginSnapHeader *h = login_snap_map.h;
+    if (!h) return 1;
+    for (int role = ADMIN; role <= FACULTY; role++) {
+        struct stat st;
+        if (stat(login_table_path(role), &st) != 0) return 1;
+        LoginStamp now = login_stamp(&st);
+        if (memcmp(&now, &h->stamps[role - 1], sizeof(now)) != 0) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Looks up a login by email.
+ *
+ * @param role  ADMIN, STUDENT or FACULTY.
+ * @param email Email to find.
+ * @param out   Receives the login if found.
+ * @return 1 if found, 0 if the table has no such email, -1 if the snapshot
+ *         cannot answer (none mapped, or a login has changed).
+ */
+static inline int login_snapshot_find(int role, const char *email, LoginEntry *out) {
+    if (role < ADMIN || role > FACULTY || !login_snapshot_current()) return -1;
+
+    const char *base = (const char *)login_snap_map.h;
+    const LoginTable *t = &login_snap_map.h->tables[role - 1];
+    if (t->slot_count == 0) return 0;
+    const LoginRecord *records = (const LoginRecord *)(base + t->records);
+    const uint32_t *slots = (const uint32_t *)(base + t->slots);
+
+    uint32_t hash = login_hash(email);
+    for (uint32_t i = hash & (t->slot_count - 1); slots[i]; i = (i + 1) & (t->slot_count - 1)) {
+        const LoginRecord *r = &records[slots[i] - 1];
+        if (r->hash == hash && strcmp(base + r->email, email) == 0) {
+            out->id = r->id;
+            out->active = r->active;
+            out->name = base + r->name;
+            out->password = base + r->password;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Logins of one table while a snapshot is being built.
+ */
+typedef struct {
+    LoginRecord *records;
+    uint32_t count, cap;
+    uint32_t *slots;
+    uint32_t slot_count;
+} LoginBuildTable;
+
+/**
+ * @brief Appends a NUL-terminated string to the string area.
+ * @return Its offset from the start of the area, or UINT32_MAX if out of memory.
+ */
+static inline uint32_t login_build_str(char **strings, size_t *len, size_t *cap, const char *s) {
+    size_t n = strlen(s) + 1;
+    if (*len + n > *cap) {
+        size_t bigger = *cap ? *cap * 2 : 65536;
+        while (*len + n > bigger) bigger *= 2;
+        char *grown = realloc(*strings, bigger);
+        if (!grown) return UINT32_MAX;
+        *strings = grown;
+        *cap = bigger;
+    }
+    memcpy(*strings + *len, s, n);
+    *len += n;
+    return (uint32_t)(*len - n);
+}
+
+/**
+ * @brief Reads one table's logins, parsed as authenticate_user() parses them.
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int login_build_table(int role, LoginBuildTable *t, LoginStamp *stamp,
+                                    char **strings, size_t *len, size_t *cap) {
+    int fd = snapshot_open(login_table_path(role));
+    struct stat st;
+    FILE *file = fd >= 0 ? fdopen(fd, "r") : NULL;
+    if (!file || fstat(fd, &st) != 0) {
+        if (file) fclose(file);
+        else if (fd >= 0) close(fd);
+        return FILE_ERROR;
+    }
+    *stamp = login_stamp(&st);
+
+    char *line = NULL;
+    size_t line_cap = 0;
+    int status = SUCCESS;
+    while (getline(&line, &line_cap, file) > 0) {
+        LoginRecord r = { .active = 1 };
+        char name[MAX_NAME_LEN], mail[MAX_EMAIL_LEN], pass[MAX_PASS_LEN];
+        if (role == STUDENT) {
+            if (sscanf(line, "%d,%99[^,],%99[^,],%63[^,],%d", &r.id, name, mail, pass, &r.active) < 5) continue;
+        } else if (sscanf(line, "%d,%99[^,],%99[^,],%63[^,\n]", &r.id, name, mail, pass) < 4) {
+            continue;
+        }
+        mail[strcspn(mail, "\r\n")] = '\0';
+        pass[strcspn(pass, "\r\n")] = '\0';
+
+        if (t->count == t->cap) {
+            t->cap = t->cap ? t->cap * 2 : 256;
+            LoginRecord *grown = realloc(t->records, t->cap * sizeof(LoginRecord));
+            if (!grown) {
+                status = FILE_ERROR;
+                break;
+            }
+            t->records = grown;
+        }
+        r.hash = login_hash(mail);
+        r.email = login_build_str(strings, len, cap, mail);
+        r.name = login_build_str(strings, len, cap, name);
+        r.password = login_build_str(strings, len, cap, pass);
+        if (r.email == UINT32_MAX || r.name == UINT32_MAX || r.password == UINT32_MAX) {
+            status = FILE_ERROR;
+            break;
+        }
+        t->records[t->count++] = r;
+    }
+    free(line);
+    fclose(file);
+    if (status != SUCCESS) return status;
+
+    // Index by email at most half full; a repeated email keeps its first
+    // row, which is the one the CSV scan would match
+    t->slot_count = 16;
+    while (t->slot_count < 2 * t->count) t->slot_count *= 2;
+    t->slots = calloc(t->slot_count, sizeof(uint32_t));
+    if (!t->slots) return FILE_ERROR;
+    for (uint32_t k = 0; k < t->count; k++) {
+        const LoginRecord *r = &t->records[k];
+        uint32_t i = r->hash & (t->slot_count - 1);
+        int duplicate = 0;
+        while (t->slots[i] && !duplicate) {
+            const LoginRecord *held = &t->records[t->slots[i] - 1];
+            duplicate = held->hash == r->hash && strcmp(*strings + held->email, *strings + r->email) == 0;
+            i = (i + 1) & (t->slot_count - 1);
+        }
+        if (!duplicate) t->slots[i] = k + 1;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes a new snapshot from the current user tables and publishes it.
+ *
+ * Readers keep their mapping of the previous file; they pick the new one up
+ * with login_snapshot_refresh().
+ *
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int login_snapshot_build(void) {
+    LoginBuildTable tables[LOGIN_TABLES] = {{0}};
+    LoginSnapHeader h = { .magic = LOGIN_SNAP_MAGIC };
+    char *strings = NULL;
+    size_t len = 0, cap = 0;
+    int status = SUCCESS;
+
+    // Read before the tables: a login changed meanwhile bumps it past this one
+    h.auth_version = auth_version_read();
+
+    for (int role = ADMIN; role <= FACULTY && status == SUCCESS; role++) {
+        status = login_build_table(role, &tables[role - 1], &h.stamps[role - 1], &strings, &len, &cap);
+    }
+
+    // Lay out records and slots after the header, then the strings
+    uint64_t offset = sizeof(h);
+    for (int k = 0; k < LOGIN_TABLES; k++) {
+        h.tables[k].count = tables[k].count;
+        h.tables[k].slot_count = tables[k].slot_count;
+        h.tables[k].records = offset;
+        offset += tables[k].count * sizeof(LoginRecord);
+        h.tables[k].slots = offset;
+        offset += tables[k].slot_count * sizeof(uint32_t);
+    }
+    for (int k = 0; k < LOGIN_TABLES; k++) {
+        for (uint32_t i = 0; i < tables[k].count; i++) {
+            tables[k].records[i].email += offset;
+            tables[k].records[i].name += offset;
+            tables[k].records[i].password += offset;
+        }
+    }
+    h.size = offset + len;
+    if (h.size > UINT32_MAX) status = FILE_ERROR;
+
+    char temp_path[SNAPSHOT_PATH_LEN];
+    snprintf(temp_path, sizeof(temp_path), "%s.%d.tmp", LOGIN_SNAPSHOT, (int)getpid());
+    FILE *out = status == SUCCESS ? fopen(temp_path, "w") : NULL;
+    if (out) {
+        int ok = fwrite(&h, sizeof(h), 1, out) == 1;
+        for (int k = 0; k < LOGIN_TABLES && ok; k++) {
+            ok = fwrite(tables[k].records, sizeof(LoginRecord), tables[k].count, out) == tables[k].count &&
+                 fwrite(tables[k].slots, sizeof(uint32_t), tables[k].slot_count, out) == tables[k].slot_count;
+        }
+        ok = ok && fwrite(strings, 1, len, out) == len && fflush(out) == 0 && fsync(fileno(out)) == 0;
+        if (fclose(out) != 0) ok = 0;
+        if (!ok || rename(temp_path, LOGIN_SNAPSHOT) != 0) {
+            unlink(temp_path);
+            status = FILE_ERROR;
+        }
+    } else {
+        status = FILE_ERROR;
+    }
+
+    for (int k = 0; k < LOGIN_TABLES; k++) {
+        free(tables[k].records);
+        free(tables[k].slots);
+    }
+    free(strings);
+    return status;
+}
+
+/**
+ * @brief Builds a new snapshot in a background process.
+ *
+ * The caller keeps serving (from the CSV tables where its snapshot is stale)
+ * and should reap the process and call login_snapshot_refresh() once it exits.
+ *
+ * @return The builder's pid, or -1 if it could not be started.
+ */
+static inline pid_t login_snapshot_build_async(void) {
+    pid_t pid = fork();
+    if (pid == 0) _exit(login_snapshot_build() == SUCCESS ? 0 : 1);
+    return pid;
+}
+
+#endif // LOGIN_SNAPSHOT_H
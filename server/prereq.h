@@ -0,0 +1,452 @@
+#ifndef PREREQ_H
+#define PREREQ_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include "utils.h"
+#include "snapshot.h"
+#include "txn.h"
+
+#define DB_PREREQS   "../database/prereqs.csv"
+#define DB_COMPLETED "../database/completed.csv"
+#define PREREQS_HEADER "code,requires\n"
+#define PREREQ_MAX_CODES 16
+
+/**
+ * @brief Course prerequisites with a precomputed transitive closure.
+ *
+ * The prerequisite table has one row per edge, "code,requires": the course
+ * `code` may only be taken after `requires`. The edges must form a DAG.
+ * The completed table has one row per student with the courses they have
+ * passed: "student_id,\"CS101,CS102\"".
+ *
+ * When the graph is loaded every course gets two bitsets over the courses of
+ * the graph: its direct prerequisites, and its closure (the course itself
+ * plus everything it transitively requires). Passing a course implies having
+ * met everything in its closure, so a student's met set is the union of the
+ * closures of their completed courses, computed once per request. A course
+ * is then eligible when its direct prerequisites are a subset of the met
+ * set: a few word operations, with no graph walk.
+ */
+
+/**
+ * @brief The prerequisite DAG and its reachability bitsets.
+ */
+typedef struct {
+    char (*codes)[32];      ///< Course codes of the graph, sorted
+    int count;
+    int words;              ///< 64-bit words per bitset
+    uint64_t *direct;       ///< count bitsets: direct prerequisites
+    uint64_t *closure;      ///< count bitsets: course plus all transitive prerequisites
+    ino_t inode;            ///< Version of the table the graph was built from
+    struct timespec mtime;
+    int loaded;
+} PrereqGraph;
+
+static int prereq_code_cmp(const void *a, const void *b) {
+    return strcmp((const char *)a, (const char *)b);
+}
+
+/**
+ * @brief Returns the index of a course in the graph, or -1 if it has no
+ *        prerequisites and is nobody's prerequisite.
+ */
+static inline int prereq_index(const PrereqGraph *g, const char *code) {
+    char key[32];
+    snprintf(key, sizeof(key), "%s", code);
+    const char (*hit)[32] = bsearch(key, g->codes, g->count, sizeof(g->codes[0]), prereq_code_cmp);
+    return hit ? (int)(hit - g->codes) : -1;
+}
+
+static inline void prereq_free(PrereqGraph *g) {
+    free(g->codes);
+    free(g->direct);
+    free(g->closure);
+    g->codes = NULL;
+    g->direct = g->closure = NULL;
+    g->count = g->words = g->loaded = 0;
+}
+
+/**
+ * @brief Builds the graph and its closure from the prerequisite table.
+ *
+ * Closures are computed in topological order (Kahn's algorithm), so each one
+ * is the union of already finished closures: O(V + E) bitset unions. Courses
+ * on a cycle are reported and keep only their direct prerequisites.
+ *
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int prereq_build(PrereqGraph *g, FILE *file) {
+    struct { char code[32], requires[32]; } *edges = NULL;
+    int edge_count = 0, edge_cap = 0;
+    char line[128];
+
+    while (fgets(line, sizeof(line), file)) {
+        char code[32], requires[32];
+        if (sscanf(line, "%31[^,],%31[^,\r\n]", code, requires) != 2 || strcmp(code, "code") == 0) continue;
+        if (edge_count == edge_cap) {
+            edge_cap = edge_cap ? edge_cap * 2 : 64;
+            void *grown = realloc(edges, edge_cap * sizeof(*edges));
+            if (!grown) {
+                free(edges);
+                return FILE_ERROR;
+            }
+            edges = grown;
+        }
+        strcpy(edges[edge_count].code, code);
+        strcpy(edges[edge_count].requires, requires);
+        edge_count++;
+    }
+
+    // Nodes: every code named by an edge, sorted for binary search
+    g->codes = malloc((2 * edge_count + 1) * sizeof(g->codes[0]));
+    if (!g->codes) {
+        free(edges);
+        return FILE_ERROR;
+    }
+    for (int i = 0; i < edge_count; i++) {
+        strcpy(g->codes[2 * i], edges[i].code);
+        strcpy(g->codes[2 * i + 1], edges[i].requires);
+    }
+    qsort(g->codes, 2 * edge_count, sizeof(g->codes[0]), prereq_code_cmp);
+    g->count = 0;
+    for (int i = 0; i < 2 * edge_count; i++) {
+        if (g->count == 0 || strcmp(g->codes[g->count - 1], g->codes[i]) != 0) {
+            memmove(g->codes[g->count++], g->codes[i], sizeof(g->codes[0]));
+        }
+    }
+
+    int n = g->count;
+    g->words = (n + 63) / 64;
+    g->direct = calloc((size_t)n * g->words + 1, sizeof(uint64_t));
+    g->closure = calloc((size_t)n * g->words + 1, sizeof(uint64_t));
+    int *pending = calloc(n + 1, sizeof(int));          // Unfinished prerequisites per course
+    int *order = malloc((n + 1) * sizeof(int));
+    int *first = calloc(n + 2, sizeof(int));            // Dependents of course p: next[first[p]..first[p + 1])
+    int *next = malloc((edge_count + 1) * sizeof(int));
+    int *from = malloc((edge_count + 1) * sizeof(int));
+    int *to = malloc((edge_count + 1) * sizeof(int));
+    int status = SUCCESS;
+    if (!g->direct || !g->closure || !pending || !order || !first || !next || !from || !to) {
+        status = FILE_ERROR;
+        goto done;
+    }
+
+    // Direct bitsets; duplicate edges are counted once
+    int unique = 0;
+    for (int i = 0; i < edge_count; i++) {
+        int v = prereq_index(g, edges[i].code), p = prereq_index(g, edges[i].requires);
+        uint64_t *bits = &g->direct[(size_t)v * g->words];
+        if (bits[p / 64] & (1ULL << (p % 64))) continue;
+        bits[p / 64] |= 1ULL << (p % 64);
+        pending[v]++;
+        first[p + 1]++;
+        from[unique] = p;
+        to[unique++] = v;
+    }
+    for (int p = 0; p < n; p++) first[p + 1] += first[p];
+    for (int i = 0; i < unique; i++) next[first[from[i]]++] = to[i];
+    for (int p = n; p > 0; p--) first[p] = first[p - 1];
+    first[0] = 0;
+
+    // Kahn: start from courses without prerequisites
+    int head = 0, tail = 0;
+    for (int v = 0; v < n; v++) {
+        g->closure[(size_t)v * g->words + v / 64] |= 1ULL << (v % 64);
+        if (pending[v] == 0) order[tail++] = v;
+    }
+    while (head < tail) {
+        int p = order[head++];
+        const uint64_t *finished = &g->closure[(size_t)p * g->words];
+
+        // Every course that directly requires p inherits p's closure
+        for (int i = first[p]; i < first[p + 1]; i++) {
+            int v = next[i];
+            uint64_t *bits = &g->closure[(size_t)v * g->words];
+            for (int w = 0; w < g->words; w++) bits[w] |= finished[w];
+            if (--pending[v] == 0) order[tail++] = v;
+        }
+    }
+    if (tail < n) fprintf(stderr, "prereqs: %d courses are on a prerequisite cycle\n", n - tail);
+
+done:
+    free(edges);
+    free(pending);
+    free(order);
+    free(first);
+    free(next);
+    free(from);
+    free(to);
+    if (status != SUCCESS) prereq_free(g);
+    return status;
+}
+
+/**
+ * @brief Returns the prerequisite graph for the current prerequisite table.
+ *
+ * The graph is built once per process and rebuilt only when the table is
+ * replaced or modified.
+ *
+ * @return Pointer to the process-wide graph, or NULL if it could not be built.
+ */
+static inline const PrereqGraph *prereq_get(void) {
+    static PrereqGraph graph;
+
+    FILE *file = snapshot_fopen(DB_PREREQS);
+    if (!file) {
+        // No table: no course has prerequisites
+        prereq_free(&graph);
+        graph.loaded = 1;
+        return &graph;
+    }
+
+    struct stat st;
+    if (fstat(fileno(file), &st) == 0 && graph.loaded && graph.inode == st.st_ino &&
+        graph.mtime.tv_sec == st.st_mtim.tv_sec && graph.mtime.tv_nsec == st.st_mtim.tv_nsec) {
+        fclose(file);
+        return &graph;
+    }
+
+    prereq_free(&graph);
+    int status = prereq_build(&graph, file);
+    fclose(file);
+    if (status != SUCCESS) return NULL;
+
+    graph.inode = st.st_ino;
+    graph.mtime = st.st_mtim;
+    graph.loaded = 1;
+    return &graph;
+}
+
+/**
+ * @brief Computes the set of courses a student has met from their completed courses.
+ *
+ * @param g         Prerequisite graph.
+ * @param completed Completed course codes, comma-separated.
+ * @return Bitset of g->words words (free() it), or NULL if out of memory.
+ */
+static inline uint64_t *prereq_met(const PrereqGraph *g, const char *completed) {
+    uint64_t *met = calloc(g->words + 1, sizeof(uint64_t));
+    if (!met) return NULL;
+
+    char code[32];
+    for (const char *p = completed; p && *p; ) {
+        while (*p == ' ' || *p == ',' || *p == '"') p++;
+        size_t len = strcspn(p, ",\"\r\n");
+        if (len == 0) break;
+        snprintf(code, sizeof(code), "%.*s", (int)len, p);
+        p += len;
+
+        int i = prereq_index(g, code);
+        if (i < 0) continue;
+        const uint64_t *bits = &g->closure[(size_t)i * g->words];
+        for (int w = 0; w < g->words; w++) met[w] |= bits[w];
+    }
+    return met;
+}
+
+/**
+ * @brief Checks whether a student with the given met set may take a course.
+ */
+static inline int prereq_eligible(const PrereqGraph *g, const uint64_t *met, const char *code) {
+    int i = prereq_index(g, code);
+    if (i < 0) return 1;
+    const uint64_t *need = &g->direct[(size_t)i * g->words];
+    for (int w = 0; w < g->words; w++) {
+        if (need[w] & ~met[w]) return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Reads the courses a student has completed.
+ *
+ * @param student_id Student ID.
+ * @param buf        Receives the comma-separated codes ("" if none).
+ * @param len        Size of buf.
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int prereq_completed(int student_id, char *buf, size_t len) {
+    buf[0] = '\0';
+    FILE *file = snapshot_fopen(DB_COMPLETED);
+    if (!file) return SUCCESS; // Nobody has completed anything yet
+
+    char *line = NULL;
+    size_t cap = 0;
+    while (getline(&line, &cap, file) > 0) {
+        char *end;
+        long id = strtol(line, &end, 10);
+        if (end == line || *end != ',' || id != student_id) continue;
+        snprintf(buf, len, "%s", end + 1);
+        break;
+    }
+    free(line);
+    fclose(file);
+    return SUCCESS;
+}
+
+/**
+ * @brief Checks whether a student meets the prerequisites of a course.
+ * @return 1 if eligible, 0 if not, FILE_ERROR on failure.
+ */
+static inline int prereq_check(int student_id, const char *code) {
+    const PrereqGraph *g = prereq_get();
+    if (!g) return FILE_ERROR;
+    if (prereq_index(g, code) < 0) return 1; // No prerequisites
+
+    char completed[2048];
+    if (prereq_completed(student_id, completed, sizeof(completed)) != SUCCESS) return FILE_ERROR;
+
+    uint64_t *met = prereq_met(g, completed);
+    if (!met) return FILE_ERROR;
+    int eligible = prereq_eligible(g, met, code);
+    free(met);
+    return eligible;
+}
+
+/**
+ * @brief Copies the prerequisite table to out, leaving out every edge that
+ *        names a course, on either side.
+ */
+static inline void prereq_copy_without(FILE *out, const char *code) {
+    fputs(PREREQS_HEADER, out);
+
+    FILE *in = snapshot_fopen(DB_PREREQS);
+    if (!in) return;
+
+    char line[128];
+    while (fgets(line, sizeof(line), in)) {
+        char from[32], to[32];
+        if (sscanf(line, "%31[^,],%31[^,\r\n]", from, to) != 2 || strcmp(from, "code") == 0) continue;
+        if (strcmp(from, code) == 0 || strcmp(to, code) == 0) continue;
+        fprintf(out, "%s,%s\n", from, to);
+    }
+    fclose(in);
+}
+
+/**
+ * @brief Parses a course's new prerequisites, refusing any that would close a cycle.
+ *
+ * A prerequisite that already (transitively) requires the course would close
+ * a cycle. The caller holds the prerequisite table's lock.
+ *
+ * @param code     Course code.
+ * @param requires Prerequisite codes, comma-separated ("" for none).
+ * @param codes    Receives the codes.
+ * @return Number of codes, PREREQ_CYCLE or FILE_ERROR.
+ */
+static inline int prereq_parse_requires(const char *code, const char *requires, char codes[][32]) {
+    const PrereqGraph *g = prereq_get();
+    if (!g) return FILE_ERROR;
+    int self = prereq_index(g, code);
+
+    int count = 0;
+    for (const char *p = requires; *p && count < PREREQ_MAX_CODES; ) {
+        while (*p == ' ' || *p == ',') p++;
+        size_t len = strcspn(p, ", \r\n");
+        if (len == 0) break;
+        snprintf(codes[count], 32, "%.*s", (int)len, p);
+        p += len;
+
+        int i = prereq_index(g, codes[count]);
+        if (strcmp(codes[count], code) == 0 ||
+            (self >= 0 && i >= 0 && (g->closure[(size_t)i * g->words + self / 64] & (1ULL << (self % 64))))) {
+            return PREREQ_CYCLE;
+        }
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Writes a new version of the prerequisite table with a course's own
+ *        prerequisites replaced; courses that require it keep their edges.
+ */
+static inline void prereq_write(FILE *out, const char *code, char codes[][32], int count) {
+    fputs(PREREQS_HEADER, out);
+    FILE *in = snapshot_fopen(DB_PREREQS);
+    char line[128];
+    while (in && fgets(line, sizeof(line), in)) {
+        char from[32], to[32];
+        if (sscanf(line, "%31[^,],%31[^,\r\n]", from, to) != 2 || strcmp(from, "code") == 0) continue;
+        if (strcmp(from, code) == 0) continue;
+        fprintf(out, "%s,%s\n", from, to);
+    }
+    if (in) fclose(in);
+    for (int i = 0; i < count; i++) fprintf(out, "%s,%s\n", code, codes[i]);
+}
+
+/**
+ * @brief Replaces the prerequisites of a course.
+ *
+ * The course's existing prerequisites are replaced; courses that require it
+ * keep their edges. A prerequisite that already (transitively) requires the
+ * course would close a cycle and is refused.
+ *
+ * @param code     Course code.
+ * @param requires Prerequisite codes, comma-separated ("" for none).
+ * @return SUCCESS, PREREQ_CYCLE or FILE_ERROR.
+ */
+static inline int set_course_prereqs(const char *code, const char *requires) {
+    int lock_fd = txn_lock(DB_PREREQS);
+    if (lock_fd < 0) return FILE_ERROR;
+
+    // Checked under the lock, against the table about to be replaced
+    char codes[PREREQ_MAX_CODES][32];
+    int count = prereq_parse_requires(code, requires, codes);
+    if (count < 0) {
+        snapshot_unlock(lock_fd, DB_PREREQS);
+        return count;
+    }
+
+    SnapshotWriter writer;
+    if (!snapshot_rewrite_begin(&writer, DB_PREREQS)) {
+        snapshot_unlock(lock_fd, DB_PREREQS);
+        return FILE_ERROR;
+    }
+    prereq_write(writer.out, code, codes, count);
+
+    int status = snapshot_rewrite_commit(&writer);
+    snapshot_unlock(lock_fd, DB_PREREQS);
+    return status;
+}
+
+/**
+ * @brief Stages new prerequisites of a course in a transaction.
+ * @param txn      Transaction holding DB_PREREQS.
+ * @param code     Course code.
+ * @param requires Prerequisite codes, comma-separated ("" for none).
+ * @return SUCCESS, PREREQ_CYCLE or FILE_ERROR.
+ */
+static inline int prereq_stage_set(Txn *txn, const char *code, const char *requires) {
+    char codes[PREREQ_MAX_CODES][32];
+    int count = prereq_parse_requires(code, requires, codes);
+    if (count < 0) return count;
+
+    FILE *out = txn_write(txn, DB_PREREQS);
+    if (!out) return FILE_ERROR;
+    prereq_write(out, code, codes, count);
+    return SUCCESS;
+}
+
+/**
+ * @brief Stages removal of every edge naming a course in a transaction.
+ * @param txn  Transaction holding DB_PREREQS.
+ * @param code Course code.
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int prereq_stage_remove(Txn *txn, const char *code) {
+    const PrereqGraph *g = prereq_get();
+    if (!g) return FILE_ERROR;
+    if (prereq_index(g, code) < 0) return SUCCESS; // Nothing to remove
+
+    FILE *out = txn_write(txn, DB_PREREQS);
+    if (!out) return FILE_ERROR;
+    prereq_copy_without(out, code);
+    return SUCCESS;
+}
+
+#endif // PREREQ_H
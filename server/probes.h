@@ -0,0 +1,98 @@
+#ifndef PROBES_H
+#define PROBES_H
+
+/**
+ * @brief Static tracepoints (USDT) for the request and storage hot paths.
+ *
+ * When <sys/sdt.h> is available the probes compile to a single nop plus an
+ * ELF note, so they cost nothing until a tracer attaches to them:
+ *
+ *     bpftrace -e 'usdt:./bin/client:academia:lock_acquire { printf("%s\n", str(arg0)); }'
+ *     perf probe -x ./bin/server sdt_academia:conn_accept
+ *
+ * Where <sys/sdt.h> is missing, GCC and Clang builds for x86-64 and AArch64
+ * ELF targets emit the same nop and SystemTap note with the minimal macros
+ * below; every argument is passed as a signed 64-bit value, which is what
+ * the tracers read anyway. Other targets without <sys/sdt.h> get a build
+ * warning and no probes. Build with -DACADEMIA_NO_USDT to drop them quietly.
+ *
+ * Probe list (provider "academia"):
+ *   conn_accept(fd, port)              server accepted a connection
+ *   conn_shed(fd, retry_ms)            server turned a connection away as busy
+ *   auth_start(role)                   authentication began
+ *   auth_finish(role, status, id)      authentication finished
+ *   action_dispatch(role, choice, id)  a menu action is about to run
+ *   lock_acquire(path, type)           fcntl lock granted on a table
+ *   lock_release(path)                 fcntl lock released on a table
+ *   rewrite_begin(path)                table rewrite through a temp file started
+ *   rewrite_end(path, status)          table rewrite finished (0 on success)
+ */
+
+#if !defined(ACADEMIA_NO_USDT) && defined(__has_include)
+#  if __has_include(<sys/sdt.h>)
+#    include <sys/sdt.h>
+#    define ACADEMIA_HAVE_USDT 1
+#  endif
+#endif
+
+#ifdef ACADEMIA_HAVE_USDT
+#  define ACADEMIA_PROBE1(name, a)          DTRACE_PROBE1(academia, name, a)
+#  define ACADEMIA_PROBE2(name, a, b)       DTRACE_PROBE2(academia, name, a, b)
+#  define ACADEMIA_PROBE3(name, a, b, c)    DTRACE_PROBE3(academia, name, a, b, c)
+#elif !defined(ACADEMIA_NO_USDT) && defined(__GNUC__) && defined(__ELF__) && \
+      (defined(__x86_64__) || defined(__aarch64__))
+/*
+ * One .note.stapsdt entry per probe site, laid out as <sys/sdt.h> does: the
+ * address of the nop, the address of _.stapsdt.base (so tracers can account
+ * for prelinking), no semaphore, then provider, name and argument specs
+ * ("-8@<operand>" per argument).
+ */
+#  define ACADEMIA_SDT(name, args, ...)                                        \
+    __asm__ __volatile__(                                                      \
+        "990: nop\n"                                                           \
+        ".pushsection .note.stapsdt,\"?\",\"note\"\n"                          \
+        ".balign 4\n"                                                          \
+        ".4byte 992f-991f, 994f-993f, 3\n"                                     \
+        "991: .asciz \"stapsdt\"\n"                                            \
+        "992: .balign 4\n"                                                     \
+        "993: .8byte 990b\n"                                                   \
+        ".8byte _.stapsdt.base\n"                                              \
+        ".8byte 0\n"                                                           \
+        ".asciz \"academia\"\n"                                                \
+        ".asciz \"" #name "\"\n"                                               \
+        ".asciz \"" args "\"\n"                                                \
+        "994: .balign 4\n"                                                     \
+        ".popsection\n"                                                        \
+        ".ifndef _.stapsdt.base\n"                                             \
+        ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+        ".weak _.stapsdt.base\n"                                               \
+        ".hidden _.stapsdt.base\n"                                             \
+        "_.stapsdt.base: .space 1\n"                                           \
+        ".size _.stapsdt.base, 1\n"                                            \
+        ".popsection\n"                                                        \
+        ".endif\n"                                                             \
+        :: __VA_ARGS__)
+#  define ACADEMIA_PROBE1(name, a)          ACADEMIA_SDT(name, "-8@%0", "nor"((long)(a)))
+#  define ACADEMIA_PROBE2(name, a, b)       ACADEMIA_SDT(name, "-8@%0 -8@%1", "nor"((long)(a)), "nor"((long)(b)))
+#  define ACADEMIA_PROBE3(name, a, b, c)    ACADEMIA_SDT(name, "-8@%0 -8@%1 -8@%2", "nor"((long)(a)), \
+                                                     "nor"((long)(b)), "nor"((long)(c)))
+#else
+#  ifndef ACADEMIA_NO_USDT
+#    warning "USDT probes disabled: <sys/sdt.h> not found; build with -DACADEMIA_NO_USDT to silence"
+#  endif
+#  define ACADEMIA_PROBE1(name, a)          do { (void)(a); } while (0)
+#  define ACADEMIA_PROBE2(name, a, b)       do { (void)(a); (void)(b); } while (0)
+#  define ACADEMIA_PROBE3(name, a, b, c)    do { (void)(a); (void)(b); (void)(c); } while (0)
+#endif
+
+#define PROBE_CONN_ACCEPT(fd, port)             ACADEMIA_PROBE2(conn_accept, fd, port)
+#define PROBE_CONN_SHED(fd, retry_ms)           ACADEMIA_PROBE2(conn_shed, fd, retry_ms)
+#define PROBE_AUTH_START(role)                  ACADEMIA_PROBE1(auth_start, role)
+#define PROBE_AUTH_FINISH(role, status, id)     ACADEMIA_PROBE3(auth_finish, role, status, id)
+#define PROBE_ACTION_DISPATCH(role, choice, id) ACADEMIA_PROBE3(action_dispatch, role, choice, id)
+#define PROBE_LOCK_ACQUIRE(path, type)          ACADEMIA_PROBE2(lock_acquire, path, type)
+#define PROBE_LOCK_RELEASE(path)                ACADEMIA_PROBE1(lock_release, path)
+#define PROBE_REWRITE_BEGIN(path)               ACADEMIA_PROBE1(rewrite_begin, path)
+#define PROBE_REWRITE_END(path, status)         ACADEMIA_PROBE2(rewrite_end, path, status)
+
+#endif // PROBES_H
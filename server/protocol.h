@@ -0,0 +1,316 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/uio.h>
+#include "utils.h"
+#include "compress.h"
+
+#define FRAME_MAX (64u << 20)  ///< Largest payload accepted
+#define SESSION_MAX 65536       ///< Session numbers per connection
+#define FRAME_COMPRESS_MIN 1024  ///< Smallest reply worth compressing, unless negotiated otherwise
+
+#define PROTO_ROLE_PROMPT "Enter role (1-Admin, 2-Student, 3-Faculty): "
+#define ROLE_FRAMED       0x4d415246  ///< Role answer that skips the prompted login ("FRAM")
+#define PROTO_BUSY        "Server busy, retry after "  ///< Sent instead of the role prompt, then "<ms> ms\n"
+
+/**
+ * @brief Framed requests over the connection that stays open after login.
+ *
+ * Every message is an 8-byte header (type and payload length, both in network
+ * byte order) followed by the payload. The client sends a request frame and
+ * the server answers with exactly one frame, in request order, so a client
+ * may send several requests before reading the replies (pipelining).
+ *
+ * A connection is either opened by the prompted login, whose user is
+ * session 0, or by answering the role prompt with ROLE_FRAMED, after which
+ * only frames are exchanged and any number of users log in with
+ * FRAME_LOGIN. Session numbers are chosen by the client, so requests for a
+ * session may be pipelined right behind its login.
+ *
+ * A client that sends FRAME_OPTIONS "compress=lz,lz-dict [min=N]" may get
+ * any reply of at least N bytes as FRAME_COMPRESSED, if that is smaller by
+ * at least an eighth: the original type and length (network byte order), a
+ * codec byte and the compressed block (see compress.h). frame_recv() undoes
+ * it, so callers only ever see the original frame.
+ *
+ * A server under load may answer a connection with PROTO_BUSY instead of the
+ * role prompt and close it, and a login with FRAME_RETRY; both say after how
+ * many ms to try again (see admission.h).
+ */
+
+enum FrameType {
+    FRAME_CATALOGUE_SYNC = 1,   ///< Client: cached catalogue version ("" if none)
+    FRAME_CATALOGUE_DELTA,      ///< Server: catalogue changes since that version
+    FRAME_ERROR,                ///< Server: request not understood; payload says why
+    FRAME_ACTION,               ///< Client: one action line for session 0, e.g. "enroll 12"
+    FRAME_RESULT,               ///< Server: the status code, as text
+    FRAME_LOGIN,                ///< Client: "<session> <role> <email> <password>"; result is the user id
+    FRAME_LOGOUT,               ///< Client: "<session>"
+    FRAME_SESSION_ACTION,       ///< Client: "<session> <action line>"
+    FRAME_OPTIONS,              ///< Client: "compress=<codecs> [min=N]"; result is what the server chose
+    FRAME_COMPRESSED,           ///< Server: another frame, compressed
+    FRAME_LIST,                 ///< Client: "<session> rows|table <listing> [args] [page=<token>]"
+    FRAME_LISTING,              ///< Server: "<status>[ next=<token>]\n" and the listing, or one page of it
+    FRAME_RETRY                 ///< Server: request not run, try again after the payload's ms
+};
+
+enum FrameCodec {
+    CODEC_NONE,
+    CODEC_LZ,                   ///< compress.h block
+    CODEC_LZ_DICT               ///< compress.h block, window preset with lz_dictionary
+};
+
+/**
+ * @brief Compression of the replies this process sends.
+ *
+ * The server forks per connection, so this is per connection.
+ */
+typedef struct {
+    int codec;
+    uint32_t min;
+} FrameCompression;
+
+static inline FrameCompression *frame_compression(void) {
+    static FrameCompression c = { CODEC_NONE, FRAME_COMPRESS_MIN };
+    return &c;
+}
+
+typedef struct {
+    uint32_t type;
+    uint32_t length;
+} FrameHeader;
+
+/**
+ * @brief Checks whether the server's first message turns the connection away.
+ *
+ * @param greeting What the server sent in place of the role prompt, NUL-terminated.
+ * @return The ms to wait before connecting again, or -1 if it is not PROTO_BUSY.
+ */
+static inline int proto_busy_delay(const char *greeting) {
+    size_t len = strlen(PROTO_BUSY);
+    return strncmp(greeting, PROTO_BUSY, len) == 0 ? atoi(greeting + len) : -1;
+}
+
+/**
+ * @brief Growable buffer for building a frame's payload.
+ */
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} FrameBuf;
+
+/**
+ * @brief Makes room for at least extra more bytes (plus a terminating NUL).
+ * @return SUCCESS or FAILURE if out of memory.
+ */
+static inline int framebuf_reserve(FrameBuf *b, size_t extra) {
+    if (b->len + extra + 1 <= b->cap) return SUCCESS;
+    size_t bigger = b->cap ? b->cap * 2 : 4096;
+    while (b->len + extra + 1 > bigger) bigger *= 2;
+    char *grown = (char *)realloc(b->data, bigger);
+    if (!grown) return FAILURE;
+    b->data = grown;
+    b->cap = bigger;
+    return SUCCESS;
+}
+
+/**
+ * @brief Appends formatted text.
+ * @return SUCCESS or FAILURE if out of memory.
+ */
+static inline int framebuf_printf(FrameBuf *b, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(b->data ? b->data + b->len : NULL, b->data ? b->cap - b->len : 0, fmt, ap);
+    va_end(ap);
+    if (n < 0) return FAILURE;
+    if (b->len + n + 1 > b->cap) {
+        if (framebuf_reserve(b, n) != SUCCESS) return FAILURE;
+        va_start(ap, fmt);
+        vsnprintf(b->data + b->len, b->cap - b->len, fmt, ap);
+        va_end(ap);
+    }
+    b->len += n;
+    return SUCCESS;
+}
+
+static inline void framebuf_free(FrameBuf *b) {
+    free(b->data);
+    memset(b, 0, sizeof(*b));
+}
+
+/**
+ * @brief Reads exactly len bytes.
+ * @return SUCCESS, or FAILURE on error or end of stream.
+ */
+static inline int frame_read_all(int fd, void *buf, size_t len) {
+    char *p = (char *)buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n <= 0) return FAILURE;
+        p += n;
+        len -= n;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Sends one frame as it is; header and payload go out in a single writev().
+ * @return SUCCESS or FAILURE.
+ */
+static inline int frame_send_raw(int fd, uint32_t type, const void *payload, uint32_t len) {
+    FrameHeader h = { htonl(type), htonl(len) };
+    struct iovec iov[2] = { { &h, sizeof(h) }, { (void *)payload, len } };
+    size_t left = sizeof(h) + len;
+    int cnt = len ? 2 : 1;
+    struct iovec *v = iov;
+    while (left > 0) {
+        ssize_t n = writev(fd, v, cnt);
+        if (n <= 0) return FAILURE;
+        left -= n;
+        while (cnt > 0 && (size_t)n >= v->iov_len) {
+            n -= v->iov_len;
+            v++;
+            cnt--;
+        }
+        if (cnt > 0) {
+            v->iov_base = (char *)v->iov_base + n;
+            v->iov_len -= n;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Sends one frame, compressed if that was negotiated and pays off.
+ * @return SUCCESS or FAILURE.
+ */
+static inline int frame_send(int fd, uint32_t type, const void *payload, uint32_t len) {
+    const FrameCompression *c = frame_compression();
+    if (c->codec == CODEC_NONE || len < c->min || len < 64) return frame_send_raw(fd, type, payload, len);
+
+    size_t head = 2 * sizeof(uint32_t) + 1;
+    uint8_t *packed = (uint8_t *)malloc(head + lz_bound(len));
+    size_t n = packed ? lz_compress((const char *)payload, len, packed + head, c->codec == CODEC_LZ_DICT) : 0;
+    if (n == 0 || n > len - len / 8) {
+        free(packed);
+        return frame_send_raw(fd, type, payload, len);
+    }
+
+    uint32_t orig[2] = { htonl(type), htonl(len) };
+    memcpy(packed, orig, sizeof(orig));
+    packed[sizeof(orig)] = (uint8_t)c->codec;
+    int status = frame_send_raw(fd, FRAME_COMPRESSED, packed, head + n);
+    free(packed);
+    return status;
+}
+
+/**
+ * @brief Replaces a FRAME_COMPRESSED payload with the frame it holds.
+ * @return SUCCESS, or FAILURE if it is malformed.
+ */
+static inline int frame_unpack(uint32_t *type, char **payload, uint32_t *len) {
+    size_t head = 2 * sizeof(uint32_t) + 1;
+    if (*len < head) return FAILURE;
+    uint32_t orig[2];
+    memcpy(orig, *payload, sizeof(orig));
+    uint32_t raw_len = ntohl(orig[1]);
+    int codec = (uint8_t)(*payload)[sizeof(orig)];
+    if (raw_len > FRAME_MAX || (codec != CODEC_LZ && codec != CODEC_LZ_DICT)) return FAILURE;
+
+    char *raw = (char *)malloc(raw_len + 1);
+    if (!raw) return FAILURE;
+    if (lz_decompress((const uint8_t *)*payload + head, *len - head, raw, raw_len, codec == CODEC_LZ_DICT) != SUCCESS) {
+        free(raw);
+        return FAILURE;
+    }
+    raw[raw_len] = '\0';
+    free(*payload);
+    *payload = raw;
+    *type = ntohl(orig[0]);
+    *len = raw_len;
+    return SUCCESS;
+}
+
+/**
+ * @brief Receives one frame.
+ *
+ * @param fd      Connection.
+ * @param type    Receives the frame type.
+ * @param payload Receives the payload, NUL-terminated; the caller frees it.
+ * @param len     Receives the payload length.
+ * @return SUCCESS, or FAILURE on error, end of stream or an oversized frame.
+ */
+static inline int frame_recv(int fd, uint32_t *type, char **payload, uint32_t *len) {
+    FrameHeader h;
+    if (frame_read_all(fd, &h, sizeof(h)) != SUCCESS) return FAILURE;
+    *type = ntohl(h.type);
+    *len = ntohl(h.length);
+    if (*len > FRAME_MAX) return FAILURE;
+
+    *payload = (char *)malloc(*len + 1);
+    if (!*payload) return FAILURE;
+    if (frame_read_all(fd, *payload, *len) != SUCCESS) {
+        free(*payload);
+        *payload = NULL;
+        return FAILURE;
+    }
+    (*payload)[*len] = '\0';
+    if (*type == FRAME_COMPRESSED && frame_unpack(type, payload, len) != SUCCESS) {
+        free(*payload);
+        *payload = NULL;
+        return FAILURE;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Server side of FRAME_OPTIONS: picks the best codec the client offers.
+ * @return SUCCESS, or FAILURE if the reply could not be sent.
+ */
+static inline int frame_serve_options(int fd, const char *payload) {
+    FrameCompression *c = frame_compression();
+    const char *offer = strstr(payload, "compress=");
+    if (offer) {
+        char codecs[64];
+        offer += strlen("compress=");
+        snprintf(codecs, sizeof(codecs), "%.*s", (int)strcspn(offer, " "), offer);
+        c->codec = CODEC_NONE;
+        for (char *name = strtok(codecs, ","); name; name = strtok(NULL, ",")) {
+            if (strcmp(name, "lz-dict") == 0) c->codec = CODEC_LZ_DICT;
+            else if (strcmp(name, "lz") == 0 && c->codec == CODEC_NONE) c->codec = CODEC_LZ;
+        }
+    }
+    const char *min = strstr(payload, "min=");
+    if (min) c->min = (uint32_t)strtoul(min + 4, NULL, 10);
+
+    char reply[64];
+    int len = snprintf(reply, sizeof(reply), "compress=%s min=%u",
+                       c->codec == CODEC_LZ_DICT ? "lz-dict" : c->codec == CODEC_LZ ? "lz" : "none", c->min);
+    return frame_send_raw(fd, FRAME_RESULT, reply, len);
+}
+
+/**
+ * @brief Client side of FRAME_OPTIONS: asks for compressed replies of at least min bytes.
+ * @return SUCCESS, or FAILURE if the connection failed.
+ */
+static inline int frame_negotiate(int fd, uint32_t min) {
+    char request[64];
+    int len = snprintf(request, sizeof(request), "compress=lz-dict,lz min=%u", min);
+    uint32_t type, reply_len;
+    char *reply;
+    if (frame_send_raw(fd, FRAME_OPTIONS, request, len) != SUCCESS) return FAILURE;
+    if (frame_recv(fd, &type, &reply, &reply_len) != SUCCESS) return FAILURE;
+    free(reply);
+    return SUCCESS;
+}
+
+#endif // PROTOCOL_H
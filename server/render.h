@@ -0,0 +1,305 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include "utils.h"
+
+#define RENDER_MAX_COLUMNS 8
+#define RENDER_RULE_MAX    640      ///< Bytes of one rule line (each '═' is 3)
+
+/**
+ * @brief Rendering of the box-drawn tables.
+ *
+ * A listing is formatted into a growable RenderBuf and written with a single
+ * render_flush(), so a table costs one write() instead of one per row. The
+ * box drawing of a table comes from a RenderBox: its column widths, from
+ * which the rule lines and the row format are built once, on first use. After
+ * that a rule is one memcpy() and a row one vsnprintf() into the buffer.
+ * Text cells are cut to their column width, so rows never break the box.
+ *
+ * A buffer in rows mode keeps the data without the drawing: every
+ * render_row() becomes one line of tab-separated fields and everything else
+ * is dropped. The server answers structured listing requests this way, and
+ * the client renders them itself (see render_rows()).
+ */
+
+/**
+ * @brief Growable output buffer.
+ */
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+    int rows;               ///< 1 to keep only the rows, as tab-separated fields
+} RenderBuf;
+
+/**
+ * @brief Horizontal rules of a box.
+ */
+enum RenderRule {
+    RULE_TOP,               ///< ╔═════╗ above a full-width line
+    RULE_TOP_COLUMNS,       ///< ╔══╦══╗
+    RULE_SPLIT,             ///< ╠══╦══╣ from a full-width line to columns
+    RULE_MID,               ///< ╠══╬══╣
+    RULE_MERGE,             ///< ╠══╩══╣ from columns to a full-width line
+    RULE_LINE,              ///< ╠═════╣
+    RULE_BOTTOM_COLUMNS,    ///< ╚══╩══╝
+    RULE_BOTTOM,            ///< ╚═════╝
+    RULE_COUNT
+};
+
+/**
+ * @brief Layout of a table, with its precomputed rules and row format.
+ *
+ * Declare one per table with RENDER_BOX(), usually as a static.
+ */
+typedef struct {
+    const char *kinds;                  ///< Conversion of each column: 'd' (int) or 's' (string)
+    const char *header;                 ///< Column titles row, or NULL
+    int widths[RENDER_MAX_COLUMNS];     ///< Text width of each column
+    int ready;
+    int columns;
+    int inner;                          ///< Text width of a full-width line
+    char row[RENDER_MAX_COLUMNS * 16 + 8];
+    char rules[RULE_COUNT][RENDER_RULE_MAX];
+    size_t rule_len[RULE_COUNT];
+} RenderBox;
+
+#define RENDER_BOX(kinds, ...) { kinds, NULL, { __VA_ARGS__ }, 0, 0, 0, "", { "" }, { 0 } }
+#define RENDER_TABLE(header, kinds, ...) { kinds, header, { __VA_ARGS__ }, 0, 0, 0, "", { "" }, { 0 } }
+
+/**
+ * @brief Makes room for at least extra more bytes (plus a terminating NUL).
+ * @return SUCCESS or FAILURE if out of memory.
+ */
+static inline int render_reserve(RenderBuf *b, size_t extra) {
+    if (b->len + extra + 1 <= b->cap) return SUCCESS;
+    size_t bigger = b->cap ? b->cap * 2 : 8192;
+    while (b->len + extra + 1 > bigger) bigger *= 2;
+    char *grown = (char *)realloc(b->data, bigger);
+    if (!grown) return FAILURE;
+    b->data = grown;
+    b->cap = bigger;
+    return SUCCESS;
+}
+
+/**
+ * @brief Appends len bytes.
+ */
+static inline void render_append(RenderBuf *b, const char *s, size_t len) {
+    if (render_reserve(b, len) != SUCCESS) return;
+    memcpy(b->data + b->len, s, len);
+    b->len += len;
+    b->data[b->len] = '\0';
+}
+
+static inline void render_text(RenderBuf *b, const char *s) {
+    if (!b->rows) render_append(b, s, strlen(s));
+}
+
+static inline void render_vprintf(RenderBuf *b, const char *fmt, va_list ap) {
+    va_list again;
+    va_copy(again, ap);
+    int n = vsnprintf(b->data ? b->data + b->len : NULL, b->data ? b->cap - b->len : 0, fmt, ap);
+    if (n >= 0 && b->len + n + 1 > b->cap) {
+        if (render_reserve(b, n) != SUCCESS) n = -1;
+        else vsnprintf(b->data + b->len, b->cap - b->len, fmt, again);
+    }
+    va_end(again);
+    if (n >= 0) b->len += n;
+}
+
+/**
+ * @brief Appends formatted text.
+ */
+static inline void render_printf(RenderBuf *b, const char *fmt, ...) {
+    if (b->rows) return;
+    va_list ap;
+    va_start(ap, fmt);
+    render_vprintf(b, fmt, ap);
+    va_end(ap);
+}
+
+/**
+ * @brief Writes out everything buffered and empties the buffer, keeping its memory.
+ * @return SUCCESS, or FAILURE if the write failed.
+ */
+static inline int render_flush(RenderBuf *b, int fd) {
+    if (fd == STDOUT_FILENO) fflush(stdout); // Keep the order of earlier printf() output
+    size_t off = 0;
+    while (off < b->len) {
+        ssize_t n = write(fd, b->data + off, b->len - off);
+        if (n <= 0) break;
+        off += n;
+    }
+    int status = off == b->len ? SUCCESS : FAILURE;
+    b->len = 0;
+    return status;
+}
+
+static inline void render_free(RenderBuf *b) {
+    free(b->data);
+    memset(b, 0, sizeof(*b));
+}
+
+/**
+ * @brief Builds one rule line: left, the columns' fill separated by joint, right.
+ */
+static inline void render_box_rule(RenderBox *box, int rule, const char *left, const char *joint, const char *right) {
+    char *p = box->rules[rule], *end = p + RENDER_RULE_MAX - 8;
+    p += sprintf(p, "%s", left);
+    for (int col = 0; col < box->columns; col++) {
+        if (col) p += sprintf(p, "%s", joint);
+        for (int i = 0; i < box->widths[col] + 2 && p < end; i++) p += sprintf(p, "═");
+    }
+    p += sprintf(p, "%s\n", right);
+    box->rule_len[rule] = p - box->rules[rule];
+}
+
+/**
+ * @brief Builds a box's rules and row format on first use.
+ */
+static inline RenderBox *render_box(RenderBox *box) {
+    if (box->ready) return box;
+
+    box->columns = (int)strlen(box->kinds);
+    if (box->columns > RENDER_MAX_COLUMNS) box->columns = RENDER_MAX_COLUMNS;
+    box->inner = -3;
+    char *p = box->row;
+    for (int col = 0; col < box->columns; col++) {
+        int w = box->widths[col];
+        box->inner += w + 3;
+        p += box->kinds[col] == 'd' ? sprintf(p, "║ %%-%dd ", w) : sprintf(p, "║ %%-%d.%ds ", w, w);
+    }
+    sprintf(p, "║\n");
+
+    render_box_rule(box, RULE_TOP, "╔", "═", "╗");
+    render_box_rule(box, RULE_TOP_COLUMNS, "╔", "╦", "╗");
+    render_box_rule(box, RULE_SPLIT, "╠", "╦", "╣");
+    render_box_rule(box, RULE_MID, "╠", "╬", "╣");
+    render_box_rule(box, RULE_MERGE, "╠", "╩", "╣");
+    render_box_rule(box, RULE_LINE, "╠", "═", "╣");
+    render_box_rule(box, RULE_BOTTOM_COLUMNS, "╚", "╩", "╝");
+    render_box_rule(box, RULE_BOTTOM, "╚", "═", "╝");
+    box->ready = 1;
+    return box;
+}
+
+/**
+ * @brief Appends one of a box's rules.
+ */
+static inline void render_rule(RenderBuf *b, RenderBox *box, int rule) {
+    if (b->rows) return;
+    render_box(box);
+    render_append(b, box->rules[rule], box->rule_len[rule]);
+}
+
+/**
+ * @brief Appends the box's column titles row.
+ */
+static inline void render_header(RenderBuf *b, RenderBox *box) {
+    if (box->header) render_text(b, box->header);
+}
+
+/**
+ * @brief Appends a row; the arguments are the cells, one per column, of the
+ *        types given by the box's kinds.
+ */
+static inline void render_row(RenderBuf *b, RenderBox *box, ...) {
+    render_box(box);
+    va_list ap;
+    va_start(ap, box);
+    if (!b->rows) {
+        render_vprintf(b, box->row, ap);
+    } else {
+        for (int col = 0; col < box->columns; col++) {
+            if (col) render_append(b, "\t", 1);
+            if (box->kinds[col] == 'd') {
+                char num[16];
+                render_append(b, num, snprintf(num, sizeof(num), "%d", va_arg(ap, int)));
+            } else {
+                const char *cell = va_arg(ap, const char *);
+                render_append(b, cell, strlen(cell));
+            }
+        }
+        render_append(b, "\n", 1);
+    }
+    va_end(ap);
+}
+
+/**
+ * @brief Renders rows received in rows mode, one table row per line.
+ *
+ * Every cell is drawn as text, so numbers keep their digits exactly.
+ *
+ * @param b    Output.
+ * @param box  Layout the rows were produced with.
+ * @param rows Tab-separated rows; modified while parsing.
+ * @return Number of rows rendered.
+ */
+static inline int render_rows(RenderBuf *b, RenderBox *box, char *rows) {
+    render_box(box);
+    int count = 0;
+    for (char *line = rows; *line; count++) {
+        char *end = line + strcspn(line, "\n");
+        char *next = *end ? end + 1 : end;
+        *end = '\0';
+        for (int col = 0; col < box->columns; col++) {
+            char *cell = line;
+            line += strcspn(line, "\t");
+            if (*line) *line++ = '\0';
+            render_printf(b, "║ %-*.*s ", box->widths[col], box->widths[col], cell);
+        }
+        render_text(b, "║\n");
+        line = next;
+    }
+    return count;
+}
+
+/**
+ * @brief Appends a line spanning the whole box, e.g. a title or a message.
+ */
+static inline void render_line(RenderBuf *b, RenderBox *box, const char *fmt, ...) {
+    if (b->rows) return;
+    render_box(box);
+    char text[RENDER_RULE_MAX];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+    render_printf(b, "║ %-*.*s ║\n", box->inner, box->inner, text);
+}
+
+/**
+ * @brief Appends a full-width line with the text centred.
+ */
+static inline void render_title(RenderBuf *b, RenderBox *box, const char *text) {
+    render_box(box);
+    int len = (int)strlen(text);
+    render_line(b, box, "%*s", len + (box->inner - len) / 2, text);
+}
+
+/**
+ * @brief Renders the top of a table for rows received in rows mode: the
+ *        title, if any, and the column titles. The rows follow with
+ *        render_rows() and the table ends with RULE_BOTTOM_COLUMNS.
+ */
+static inline void render_listing_begin(RenderBuf *b, RenderBox *box, const char *title) {
+    if (title) {
+        render_rule(b, box, RULE_TOP);
+        render_title(b, box, title);
+        render_rule(b, box, RULE_SPLIT);
+    } else {
+        render_rule(b, box, RULE_TOP_COLUMNS);
+    }
+    if (box->header) {
+        render_header(b, box);
+        render_rule(b, box, RULE_MID);
+    }
+}
+
+#endif // RENDER_H
@@ -0,0 +1,514 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include "types.h"
+#include "utils.h"
+#include "snapshot.h"
+#include "txn.h"
+
+#define DB_SCHEDULE "../database/schedule.csv"
+#define SCHEDULE_HEADER "code,day,start,end\n"
+#define MINUTES_PER_DAY (24 * 60)
+#define SCHEDULE_TIMETABLES 64     ///< Student timetables kept by schedule_check()
+
+/**
+ * @brief Course meeting times and timetable conflict checks.
+ *
+ * The schedule table holds one row per weekly meeting of a course:
+ * "code,day,start,end", e.g. "CS101,Mon,09:00,10:30". It is keyed by course
+ * code because students' rows list their courses by code.
+ *
+ * A student's timetable is kept as an interval index: the meeting times of
+ * their courses as week minutes, merged into disjoint intervals sorted by
+ * start. Because the intervals are disjoint, their ends are sorted too, so a
+ * new meeting overlaps the timetable exactly when the last interval starting
+ * before it ends ends after it starts — one binary search per meeting.
+ *
+ * schedule_check() keeps both between calls: the whole table, reloaded only
+ * when the file changes, and the timetables of recently checked students,
+ * which grow in place as the student enrolls in more courses.
+ */
+
+static const char *const schedule_days[7] = { "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun" };
+
+/**
+ * @brief The meeting times of one course.
+ */
+typedef struct {
+    char code[32];
+    TimeSlot slots[MAX_SLOTS_PER_COURSE];
+    int count;
+} CourseSchedule;
+
+/**
+ * @brief Disjoint time intervals (week minutes) sorted by start.
+ */
+typedef struct {
+    int *start;
+    int *end;
+    int count, size;
+} IntervalIndex;
+
+static inline int schedule_day_index(const char *day) {
+    for (int i = 0; i < 7; i++) {
+        if (strncasecmp(day, schedule_days[i], 3) == 0) return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Parses "HH:MM" into minutes since midnight.
+ * @return Minutes, or -1 if the time is invalid.
+ */
+static inline int schedule_parse_time(const char *text) {
+    int h, m;
+    char extra;
+    if (sscanf(text, "%d:%d%c", &h, &m, &extra) != 2 || h < 0 || h > 24 || m < 0 || m > 59) return -1;
+    if (h * 60 + m > MINUTES_PER_DAY) return -1;
+    return h * 60 + m;
+}
+
+/**
+ * @brief Builds a slot from its day, start and end texts.
+ * @return SUCCESS or FAILURE if any part is invalid or the slot is empty.
+ */
+static inline int schedule_make_slot(const char *day, const char *start, const char *end, TimeSlot *slot) {
+    slot->day = schedule_day_index(day);
+    slot->start = schedule_parse_time(start);
+    slot->end = schedule_parse_time(end);
+    return (slot->day < 0 || slot->start < 0 || slot->end <= slot->start) ? FAILURE : SUCCESS;
+}
+
+/**
+ * @brief Parses meeting times typed as "Mon 09:00-10:30, Wed 09:00-10:30".
+ *
+ * @param text  Comma-separated slots; an empty string means no meetings.
+ * @param slots Receives the slots.
+ * @param max   Capacity of slots.
+ * @return Number of slots, or FAILURE if a slot is malformed or there are too many.
+ */
+static inline int schedule_parse(const char *text, TimeSlot *slots, int max) {
+    int count = 0;
+    const char *p = text;
+
+    while (*p) {
+        while (*p == ' ' || *p == ',') p++;
+        if (!*p) break;
+
+        char day[8], start[8], end[8];
+        int used = 0;
+        if (count == max || sscanf(p, "%7s %7[0-9:]-%7[0-9:]%n", day, start, end, &used) != 3 ||
+            schedule_make_slot(day, start, end, &slots[count]) != SUCCESS) return FAILURE;
+        count++;
+        p += used;
+    }
+    return count;
+}
+
+/**
+ * @brief Formats a slot as "Mon 09:00-10:30".
+ */
+static inline void schedule_format_slot(const TimeSlot *slot, char *buf, size_t len) {
+    snprintf(buf, len, "%s %02d:%02d-%02d:%02d", schedule_days[slot->day % 7],
+             slot->start / 60, slot->start % 60, slot->end / 60, slot->end % 60);
+}
+
+static int schedule_code_cmp(const void *a, const void *b) {
+    return strcmp(((const CourseSchedule *)a)->code, ((const CourseSchedule *)b)->code);
+}
+
+/**
+ * @brief Finds a course's schedule in an array sorted by code.
+ */
+static inline CourseSchedule *schedule_find(CourseSchedule *list, int count, const char *code) {
+    CourseSchedule key;
+    snprintf(key.code, sizeof(key.code), "%s", code);
+    return bsearch(&key, list, count, sizeof(CourseSchedule), schedule_code_cmp);
+}
+
+/**
+ * @brief Sorts schedules by code and removes duplicate codes.
+ * @return Number of distinct codes.
+ */
+static inline int schedule_unique(CourseSchedule *list, int count) {
+    qsort(list, count, sizeof(CourseSchedule), schedule_code_cmp);
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        if (n == 0 || strcmp(list[n - 1].code, list[i].code) != 0) list[n++] = list[i];
+    }
+    return n;
+}
+
+/**
+ * @brief Loads the meeting times of several courses in one scan.
+ *
+ * @param list  Schedules sorted by code, with only the code set and count 0.
+ *              With count < 0 every course in the table is loaded instead and
+ *              *list is allocated by this function.
+ * @param count Number of schedules.
+ * @return Number of schedules in the list, or FILE_ERROR.
+ */
+static inline int schedule_load(CourseSchedule **list, int count) {
+    int load_all = count < 0, size = 0;
+    if (load_all) {
+        *list = NULL;
+        count = 0;
+    }
+
+    FILE *file = snapshot_fopen(DB_SCHEDULE);
+    if (!file) return count; // No schedules yet
+
+    char line[256];
+    int status = SUCCESS;
+    while (status == SUCCESS && fgets(line, sizeof(line), file)) {
+        char code[32], day[8], start[8], end[8];
+        TimeSlot slot;
+        if (sscanf(line, "%31[^,],%7[^,],%7[^,],%7[^,\r\n]", code, day, start, end) != 4 ||
+            schedule_make_slot(day, start, end, &slot) != SUCCESS) continue; // Header or malformed row
+
+        CourseSchedule *c;
+        if (load_all) {
+            c = (count && strcmp((*list)[count - 1].code, code) == 0) ? &(*list)[count - 1] : NULL;
+            if (!c) {
+                if (count == size) {
+                    int bigger = size ? size * 2 : 64;
+                    CourseSchedule *p = realloc(*list, bigger * sizeof(CourseSchedule));
+                    if (!p) {
+                        status = FILE_ERROR;
+                        break;
+                    }
+                    *list = p;
+                    size = bigger;
+                }
+                c = &(*list)[count++];
+                snprintf(c->code, sizeof(c->code), "%s", code);
+                c->count = 0;
+            }
+        } else {
+            c = schedule_find(*list, count, code);
+        }
+        if (c && c->count < MAX_SLOTS_PER_COURSE) c->slots[c->count++] = slot;
+    }
+    fclose(file);
+
+    if (status != SUCCESS) {
+        if (load_all) free(*list);
+        return FILE_ERROR;
+    }
+
+    // Rows of one course are normally adjacent; merge any that are not
+    if (load_all && count > 1) {
+        qsort(*list, count, sizeof(CourseSchedule), schedule_code_cmp);
+        int n = 0;
+        for (int i = 0; i < count; i++) {
+            CourseSchedule *prev = n ? &(*list)[n - 1] : NULL;
+            if (prev && strcmp(prev->code, (*list)[i].code) == 0) {
+                for (int k = 0; k < (*list)[i].count && prev->count < MAX_SLOTS_PER_COURSE; k++) {
+                    prev->slots[prev->count++] = (*list)[i].slots[k];
+                }
+            } else {
+                (*list)[n++] = (*list)[i];
+            }
+        }
+        count = n;
+    }
+    return count;
+}
+
+/**
+ * @brief Returns the index of the first interval starting at or after a time.
+ */
+static inline int interval_index_lower(const IntervalIndex *idx, int time) {
+    int lo = 0, hi = idx->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (idx->start[mid] < time) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * @brief Checks whether a slot overlaps any interval of the index, in O(log n).
+ */
+static inline int interval_index_overlaps(const IntervalIndex *idx, const TimeSlot *slot) {
+    int start = slot->day * MINUTES_PER_DAY + slot->start;
+    int end = slot->day * MINUTES_PER_DAY + slot->end;
+
+    // Last interval starting before the slot ends; it has the largest end of those
+    int i = interval_index_lower(idx, end) - 1;
+    return i >= 0 && idx->end[i] > start;
+}
+
+/**
+ * @brief Adds a slot to the index, merging it with the intervals it overlaps.
+ * @return SUCCESS or FAILURE if out of memory.
+ */
+static inline int interval_index_add(IntervalIndex *idx, const TimeSlot *slot) {
+    int start = slot->day * MINUTES_PER_DAY + slot->start;
+    int end = slot->day * MINUTES_PER_DAY + slot->end;
+
+    if (idx->count == idx->size) {
+        int bigger = idx->size ? idx->size * 2 : 2 * MAX_COURSES_PER_STUDENT;
+        int *s = realloc(idx->start, bigger * sizeof(int));
+        if (!s) return FAILURE;
+        idx->start = s;
+        int *e = realloc(idx->end, bigger * sizeof(int));
+        if (!e) return FAILURE;
+        idx->end = e;
+        idx->size = bigger;
+    }
+
+    // Intervals [first, last) overlap or touch the new one
+    int first = interval_index_lower(idx, start);
+    if (first > 0 && idx->end[first - 1] >= start) first--;
+    int last = first;
+    while (last < idx->count && idx->start[last] <= end) last++;
+
+    if (last > first) {
+        if (idx->start[first] < start) start = idx->start[first];
+        if (idx->end[last - 1] > end) end = idx->end[last - 1];
+    }
+    int shift = 1 - (last - first);
+    memmove(&idx->start[last + shift], &idx->start[last], (idx->count - last) * sizeof(int));
+    memmove(&idx->end[last + shift], &idx->end[last], (idx->count - last) * sizeof(int));
+    idx->start[first] = start;
+    idx->end[first] = end;
+    idx->count += shift;
+    return SUCCESS;
+}
+
+static inline void interval_index_free(IntervalIndex *idx) {
+    free(idx->start);
+    free(idx->end);
+    memset(idx, 0, sizeof(*idx));
+}
+
+/**
+ * @brief Checks whether any meeting of a course overlaps a timetable.
+ */
+static inline int schedule_conflicts(const IntervalIndex *idx, const CourseSchedule *course) {
+    for (int i = 0; course && i < course->count; i++) {
+        if (interval_index_overlaps(idx, &course->slots[i])) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Adds every meeting of a course to a timetable.
+ * @return SUCCESS or FAILURE if out of memory.
+ */
+static inline int schedule_index_course(IntervalIndex *idx, const CourseSchedule *course) {
+    for (int i = 0; course && i < course->count; i++) {
+        if (interval_index_add(idx, &course->slots[i]) != SUCCESS) return FAILURE;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Every course's meeting times, as of one version of the table.
+ */
+typedef struct {
+    ino_t inode;
+    struct timespec mtime;
+    off_t size;
+    unsigned long generation;   ///< Bumped on every reload
+    int loaded;
+    CourseSchedule *list;       ///< Sorted by code
+    int count;
+} ScheduleTable;
+
+/**
+ * @brief A student's timetable, built from one version of the table.
+ */
+typedef struct {
+    int student_id;             ///< 0 if the slot is free
+    unsigned long generation;   ///< ScheduleTable.generation it was built from
+    char *enrolled;             ///< Course codes it holds, as passed to schedule_check()
+    IntervalIndex times;
+} StudentTimetable;
+
+/**
+ * @brief Returns the whole schedule table, reloading it if the file changed.
+ * @return The process-wide table, or NULL on error.
+ */
+static inline const ScheduleTable *schedule_table_get(void) {
+    static ScheduleTable table;
+
+    struct stat st;
+    int exists = stat(DB_SCHEDULE, &st) == 0;
+    if (table.loaded && (exists ? st.st_ino == table.inode && st.st_size == table.size &&
+                                  st.st_mtim.tv_sec == table.mtime.tv_sec &&
+                                  st.st_mtim.tv_nsec == table.mtime.tv_nsec
+                                : table.inode == 0)) {
+        return &table;
+    }
+
+    // Identity first, so a table replaced while loading is reloaded next time
+    free(table.list);
+    table.list = NULL;
+    table.loaded = 0;
+    table.count = schedule_load(&table.list, -1);
+    if (table.count < 0) return NULL;
+    table.inode = exists ? st.st_ino : 0;
+    table.mtime = exists ? st.st_mtim : (struct timespec){0};
+    table.size = exists ? st.st_size : 0;
+    table.generation++;
+    table.loaded = 1;
+    return &table;
+}
+
+/**
+ * @brief Adds the meetings of a comma-separated list of course codes to a timetable.
+ * @return SUCCESS or FAILURE if out of memory.
+ */
+static inline int schedule_index_codes(IntervalIndex *idx, const ScheduleTable *table, const char *codes) {
+    char *copy = strdup(codes);
+    if (!copy) return FAILURE;
+    int status = SUCCESS;
+    for (char *tok = strtok(copy, ", \r\n"); tok && status == SUCCESS; tok = strtok(NULL, ", \r\n")) {
+        status = schedule_index_course(idx, schedule_find(table->list, table->count, tok));
+    }
+    free(copy);
+    return status;
+}
+
+/**
+ * @brief Checks whether a course clashes with a student's enrolled courses.
+ *
+ * The student's timetable is kept for the next call. If the student's list
+ * has only grown since, just the new courses are added to it; otherwise, or
+ * after the schedule table changed, it is built again.
+ *
+ * @param student_id Student ID.
+ * @param code       Code of the course to join.
+ * @param enrolled   The student's enrolled course codes, comma-separated.
+ * @return 1 on a clash, 0 if the course fits, FILE_ERROR on failure.
+ */
+static inline int schedule_check(int student_id, const char *code, const char *enrolled) {
+    static StudentTimetable timetables[SCHEDULE_TIMETABLES];
+
+    const ScheduleTable *table = schedule_table_get();
+    if (!table) return FILE_ERROR;
+
+    StudentTimetable *t = &timetables[(unsigned)student_id % SCHEDULE_TIMETABLES];
+    size_t kept = t->enrolled ? strlen(t->enrolled) : 0;
+    const char *added = enrolled;
+    if (t->student_id == student_id && t->generation == table->generation &&
+        strncmp(enrolled, t->enrolled, kept) == 0 && (enrolled[kept] == ',' || enrolled[kept] == '\0')) {
+        added = enrolled + kept; // Only courses appended since the last check
+    } else {
+        t->times.count = 0;
+    }
+
+    char *copy = strdup(enrolled);
+    if (!copy || schedule_index_codes(&t->times, table, added) != SUCCESS) {
+        free(copy);
+        free(t->enrolled);
+        interval_index_free(&t->times);
+        memset(t, 0, sizeof(*t));
+        return FILE_ERROR;
+    }
+    free(t->enrolled);
+    t->enrolled = copy;
+    t->student_id = student_id;
+    t->generation = table->generation;
+
+    return schedule_conflicts(&t->times, schedule_find(table->list, table->count, code));
+}
+
+/**
+ * @brief Copies the schedule table to a new version without one course's rows.
+ */
+static inline void schedule_copy_without(FILE *out, const char *code) {
+    fputs(SCHEDULE_HEADER, out);
+
+    FILE *in = snapshot_fopen(DB_SCHEDULE);
+    if (!in) return;
+
+    char line[256];
+    size_t len = strlen(code);
+    while (fgets(line, sizeof(line), in)) {
+        if (strncmp(line, "code,", 5) == 0) continue; // Header, written above
+        if (strncmp(line, code, len) == 0 && line[len] == ',') continue;
+        fputs(line, out);
+    }
+    fclose(in);
+}
+
+/**
+ * @brief Writes a new version of the schedule table with a course's meeting times replaced.
+ */
+static inline void schedule_write(FILE *out, const char *code, const TimeSlot *slots, int count) {
+    schedule_copy_without(out, code);
+    for (int i = 0; i < count; i++) {
+        fprintf(out, "%s,%s,%02d:%02d,%02d:%02d\n", code, schedule_days[slots[i].day % 7],
+                slots[i].start / 60, slots[i].start % 60, slots[i].end / 60, slots[i].end % 60);
+    }
+}
+
+/**
+ * @brief Replaces the meeting times of a course.
+ *
+ * @param code  Course code.
+ * @param slots New meeting times.
+ * @param count Number of slots (0 removes the course's schedule).
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int set_course_schedule(const char *code, const TimeSlot *slots, int count) {
+    int lock_fd = txn_lock(DB_SCHEDULE);
+    if (lock_fd < 0) return FILE_ERROR;
+
+    SnapshotWriter writer;
+    if (!snapshot_rewrite_begin(&writer, DB_SCHEDULE)) {
+        snapshot_unlock(lock_fd, DB_SCHEDULE);
+        return FILE_ERROR;
+    }
+    schedule_write(writer.out, code, slots, count);
+
+    int status = snapshot_rewrite_commit(&writer);
+    snapshot_unlock(lock_fd, DB_SCHEDULE);
+    return status;
+}
+
+/**
+ * @brief Stages new meeting times of a course in a transaction.
+ * @param txn   Transaction holding DB_SCHEDULE.
+ * @param code  Course code.
+ * @param slots New meeting times.
+ * @param count Number of slots.
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int schedule_stage_set(Txn *txn, const char *code, const TimeSlot *slots, int count) {
+    FILE *out = txn_write(txn, DB_SCHEDULE);
+    if (!out) return FILE_ERROR;
+    schedule_write(out, code, slots, count);
+    return SUCCESS;
+}
+
+/**
+ * @brief Stages removal of a course's meeting times in a transaction.
+ * @param txn  Transaction holding DB_SCHEDULE.
+ * @param code Course code.
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int schedule_stage_remove(Txn *txn, const char *code) {
+    CourseSchedule c;
+    snprintf(c.code, sizeof(c.code), "%s", code);
+    c.count = 0;
+    CourseSchedule *list = &c;
+    if (schedule_load(&list, 1) < 0) return FILE_ERROR;
+    if (c.count == 0) return SUCCESS; // Nothing to remove
+
+    FILE *out = txn_write(txn, DB_SCHEDULE);
+    if (!out) return FILE_ERROR;
+    schedule_copy_without(out, code);
+    return SUCCESS;
+}
+
+#endif // SCHEDULE_H
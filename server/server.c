@@ -1,9 +1,12 @@
+#define _GNU_SOURCE // ppoll()
 #include "server.h"
 #include "auth.h"
 #include "types.h"
+#include "probes.h"
 #include "../client/admin_client.h"
 #include "../client/faculty_client.h"
 #include "../client/student_client.h"
+#include "session_actions.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -15,20 +18,228 @@
 #include <sys/socket.h>
 #include <sys/wait.h>
 #include <errno.h>
+#include <poll.h>
+#include <signal.h>
+
+static volatile sig_atomic_t stop_requested = 0;
+
+/**
+ * @brief Asks the accept loop to stop; the server then shuts down cleanly.
+ */
+static void request_stop(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+/**
+ * @brief Wakes the accept loop when a handler exits, so a queued connection
+ *        can take its place.
+ */
+static void child_exited(int sig) {
+    (void)sig;
+}
+
+/**
+ * @brief Reaps finished children.
+ *
+ * @param builder  Pid of the running login snapshot builder, or -1; updated.
+ * @param handlers Number of running connection handlers; updated.
+ */
+static void reap_children(pid_t *builder, int *handlers) {
+    pid_t pid;
+    while ((pid = waitpid(-1, NULL, WNOHANG)) > 0) {
+        if (pid == *builder) *builder = -1;
+        else if (*handlers > 0) (*handlers)--;
+    }
+}
+
+/**
+ * @brief Once the login snapshot builder has exited, maps what it published;
+ *        starts a new builder if a login has changed since it was built.
+ *
+ * @param builder Pid of the running builder, or -1; updated.
+ */
+static void maintain_login_snapshot(pid_t *builder) {
+    if (*builder > 0) return;
+
+    login_snapshot_refresh();
+    if (login_snapshot_stale()) *builder = login_snapshot_build_async();
+}
+
+/**
+ * @brief Forks a handler for a client connection.
+ *
+ * @param server_fd Listening socket, closed in the handler.
+ * @param client_fd Client connection; closed here either way.
+ * @param mask      Signal mask the handler runs with.
+ * @return SUCCESS, or FAILURE if the fork failed and the connection was shed.
+ */
+static int start_handler(int server_fd, int client_fd, const sigset_t *mask) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        signal(SIGCHLD, SIG_DFL);
+        sigprocmask(SIG_SETMASK, mask, NULL);
+        close(server_fd);          // child doesn't need the listener socket
+        handle_client(client_fd);  // handle authentication and interaction
+        close(client_fd);
+        exit(0);                   // child exits after handling client
+    }
+    if (pid < 0) {
+        admit_shed(client_fd, admit_backoff());
+        return FAILURE;
+    }
+
+    // Parent process: close client_fd as child is handling it
+    close(client_fd);
+    return SUCCESS;
+}
+
+/**
+ * @brief Handles FRAME_LOGIN: "<session> <role> <email> <password>".
+ */
+static int serve_login(int client_fd, SessionTable *sessions, char *payload) {
+    char *argv[4];
+    if (action_split(payload, argv, 4) != 4) return frame_send(client_fd, FRAME_ERROR, "malformed request", 17);
+
+    long number = strtol(argv[0], NULL, 10);
+    int role = atoi(argv[1]);
+    char reply[16];
+    int len;
+
+    // Under load new logins wait (see admission.h)
+    int wait = admit_login(role, argv[2]);
+    if (wait) {
+        session_clear(sessions, number);
+        len = snprintf(reply, sizeof(reply), "%d", wait);
+        return frame_send(client_fd, FRAME_RETRY, reply, len);
+    }
+
+    char name[MAX_NAME_LEN];
+    int result = auth_lookup(role, argv[2], argv[3], name);
+    if (result > 0 && session_set(sessions, number, role, result) != SUCCESS) {
+        return frame_send(client_fd, FRAME_ERROR, "bad session number", 18);
+    }
+    if (result <= 0) session_clear(sessions, number);
+
+    len = snprintf(reply, sizeof(reply), "%d", result);
+    return frame_send(client_fd, FRAME_RESULT, reply, len);
+}
+
+/**
+ * @brief Answers framed requests (see protocol.h) until the client disconnects.
+ *
+ * @param client_fd Client connection.
+ * @param sessions  Users logged in on the connection.
+ */
+static void serve_requests(int client_fd, SessionTable *sessions) {
+    uint32_t type, len;
+    char *payload;
+    while (frame_recv(client_fd, &type, &payload, &len) == SUCCESS) {
+        int status;
+        char *rest;
+        long number;
+        switch (type) {
+            case FRAME_CATALOGUE_SYNC:
+                status = sessions->active ? catalogue_serve_sync(client_fd, payload)
+                                          : frame_send(client_fd, FRAME_ERROR, "not logged in", 13);
+                break;
+            case FRAME_ACTION:
+                status = session_serve_action(client_fd, session_get(sessions, 0), payload);
+                break;
+            case FRAME_SESSION_ACTION:
+                number = strtol(payload, &rest, 10);
+                status = session_serve_action(client_fd, rest == payload ? NULL : session_get(sessions, number), rest);
+                break;
+            case FRAME_LOGIN:
+                status = serve_login(client_fd, sessions, payload);
+                break;
+            case FRAME_LIST:
+                number = strtol(payload, &rest, 10);
+                status = session_serve_list(client_fd, rest == payload ? NULL : session_get(sessions, number), rest);
+                break;
+            case FRAME_OPTIONS:
+                status = frame_serve_options(client_fd, payload);
+                break;
+            case FRAME_LOGOUT:
+                session_clear(sessions, strtol(payload, NULL, 10));
+                status = frame_send(client_fd, FRAME_RESULT, "0", 1);
+                break;
+            default:
+                status = frame_send(client_fd, FRAME_ERROR, "unknown request", 15);
+                break;
+        }
+        free(payload);
+        if (status != SUCCESS) break;
+    }
+}
 
 /**
  * @brief Entry point for the server.
  *        Sets up socket, listens for connections, forks for each client.
+ *
+ * Logins are served from the mapped login snapshot as soon as the socket is
+ * up; a stale or missing snapshot is rebuilt in the background meanwhile.
+ * Connections beyond what the server can handle at once wait in a bounded
+ * queue or are turned away with a retry delay (see admission.h).
+ * SIGINT or SIGTERM stops the server after writing a current snapshot.
  * 
  * @return int Exit status.
  */
 int main() {
     system("clear");
+
+    // Finish any multi-table write a crash interrupted before serving clients,
+    // and recount the statistics if it also cut off their update
+    txn_recover();
+    stats_recover();
+
+    // These signals are only let in while waiting in ppoll(), which they
+    // interrupt, so none is missed between a check and the wait
+    struct sigaction stop = { .sa_handler = request_stop };
+    sigemptyset(&stop.sa_mask);
+    sigaction(SIGINT, &stop, NULL);
+    sigaction(SIGTERM, &stop, NULL);
+    struct sigaction exited = { .sa_handler = child_exited, .sa_flags = SA_NOCLDSTOP };
+    sigemptyset(&exited.sa_mask);
+    sigaction(SIGCHLD, &exited, NULL);
+    sigset_t blocked, waiting;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGINT);
+    sigaddset(&blocked, SIGTERM);
+    sigaddset(&blocked, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &blocked, &waiting);
+
+    // Handlers inherit the admission buckets, so map them before the first fork
+    if (!admit_shared()) fprintf(stderr, "Admission control disabled: cannot map its buckets\n");
+
+    pid_t builder = -1;
+    int handlers = 0;
+    AdmitQueue queue = {0};
+
+    // Tables changed while the server was down (or since its last snapshot)
+    // may hold changed logins; have them read from the CSV until rebuilt
+    login_snapshot_refresh();
+    if (login_snapshot_outdated()) auth_version_bump();
+    maintain_login_snapshot(&builder);
+
     int server_fd = setup_server_socket(PORT);
     printf("Server listening on port %d...\n", PORT);
 
-    while (1) {
+    while (!stop_requested) {
+        reap_children(&builder, &handlers);
+
+        // Queued connections go first, as handlers free up
+        while (handlers < ADMIT_MAX_HANDLERS && queue.count) {
+            if (start_handler(server_fd, admit_queue_pop(&queue), &waiting) == SUCCESS) handlers++;
+        }
+        int timeout = admit_queue_expire(&queue, admit_now_ms());
+
         printf("Waiting for a new connection...\n");
+        struct pollfd listener = { server_fd, POLLIN, 0 };
+        struct timespec wait_for = { timeout / 1000, (timeout % 1000) * 1000000L };
+        if (ppoll(&listener, 1, timeout < 0 ? NULL : &wait_for, &waiting) <= 0) continue;
 
         struct sockaddr_in client_addr;
         socklen_t addr_len = sizeof(client_addr);
@@ -36,23 +247,41 @@ int main() {
         // Accept new client connection
         int client_fd = accept(server_fd, (struct sockaddr *)&client_addr, &addr_len);
         if (client_fd < 0) {
-            perror("Client Connection");
+            if (errno != EINTR) perror("Client Connection");
             continue;
         }
+        PROBE_CONN_ACCEPT(client_fd, ntohs(client_addr.sin_port));
 
-        // Fork a child to handle each client separately
-        if (fork() == 0) {
-            close(server_fd);          // child doesn't need the listener socket
-            handle_client(client_fd);  // handle authentication and interaction
-            close(client_fd);
-            exit(0);                   // child exits after handling client
+        // One address may only open connections so fast
+        int wait = admit_connection(client_addr.sin_addr.s_addr);
+        if (wait) {
+            admit_shed(client_fd, wait);
+            continue;
         }
 
-        // Parent process: close client_fd as child is handling it
-        close(client_fd);
+        // The child inherits whichever snapshot is mapped now
+        reap_children(&builder, &handlers);
+        maintain_login_snapshot(&builder);
+
+        // Fork a child to handle each client separately, or wait for one to finish
+        if (handlers < ADMIT_MAX_HANDLERS && !queue.count) {
+            if (start_handler(server_fd, client_fd, &waiting) == SUCCESS) handlers++;
+        } else if (admit_queue_push(&queue, client_fd, admit_now_ms()) != SUCCESS) {
+            admit_shed(client_fd, admit_backoff());
+        }
     }
 
+    // Connections still waiting for a handler are turned away
+    while (queue.count) admit_shed(admit_queue_pop(&queue), admit_backoff());
     close(server_fd);
+
+    // Leave a current snapshot for the next start
+    printf("Shutting down...\n");
+    if (builder > 0) waitpid(builder, NULL, 0);
+    login_snapshot_refresh();
+    if (login_snapshot_outdated() && login_snapshot_build() != SUCCESS) {
+        fprintf(stderr, "Failed to write the login snapshot\n");
+    }
     return 0;
 }
 
@@ -86,7 +315,7 @@ int setup_server_socket(int port) {
     }
 
     // Start listening for incoming connections
-    if (listen(sockfd, 5) < 0) {
+    if (listen(sockfd, ADMIT_BACKLOG) < 0) {
         perror("Listen");
         exit(EXIT_FAILURE);
     }
@@ -96,7 +325,8 @@ int setup_server_socket(int port) {
 
 /**
  * @brief Handles an individual client connection.
- *        Authenticates user and maintains connection until client disconnects.
+ *        Authenticates user, then serves framed requests (see protocol.h)
+ *        until the client disconnects.
  * 
  * @param client_fd Socket file descriptor for connected client.
  * @return int Status (0 on success, -1 on auth failure).
@@ -104,13 +334,22 @@ int setup_server_socket(int port) {
 int handle_client(int client_fd) {
     int role;
 
+    SessionTable sessions = {0};
+
     // Prompt user to select a role (Admin, Student, Faculty)
-    write(client_fd, "Enter role (1-Admin, 2-Student, 3-Faculty): ", 45);
+    write(client_fd, PROTO_ROLE_PROMPT, sizeof(PROTO_ROLE_PROMPT));
     if (read(client_fd, &role, sizeof(role)) <= 0) {
         perror("Failed to read role");
         return -1;
     }
 
+    // Client library connections log their users in with frames
+    if (role == ROLE_FRAMED) {
+        serve_requests(client_fd, &sessions);
+        free(sessions.slots);
+        return 0;
+    }
+
     // Validate role
     if (role < 1 || role > 3) {
         int status = INCORRECT_ROLE;
@@ -126,11 +365,9 @@ int handle_client(int client_fd) {
         return -1;
     }
 
-    // If authentication succeeded, keep connection alive until client disconnects
-    char buffer[1024];
-    while (read(client_fd, buffer, sizeof(buffer)) > 0) {
-        // No server interaction after auth; keeps connection alive
-    }
-
+    // If authentication succeeded, the user is session 0 of the connection
+    session_set(&sessions, 0, role, auth_result);
+    serve_requests(client_fd, &sessions);
+    free(sessions.slots);
     return 0;
 }
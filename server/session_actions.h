@@ -0,0 +1,351 @@
+#ifndef SESSION_ACTIONS_H
+#define SESSION_ACTIONS_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "types.h"
+#include "utils.h"
+#include "protocol.h"
+#include "arena.h"
+#include "render.h"
+#include "admin_actions.h"
+#include "faculty_actions.h"
+#include "student_actions.h"
+
+#define ACTION_MAX_ARGS 8
+#define LISTING_PAGE_SIZE 256   ///< Rows per FRAME_LISTING reply of a paged listing
+
+/**
+ * @brief Actions the server runs for an authenticated connection.
+ *
+ * A FRAME_ACTION payload is one line: an operation name and its arguments,
+ * separated by spaces, with double quotes around arguments that contain
+ * spaces. The action runs on the server as the logged-in user (a student
+ * can only enroll themselves, a faculty can only remove their own courses)
+ * and the reply is a FRAME_RESULT with the action's status code, or a
+ * FRAME_ERROR saying why the line was refused.
+ *
+ * A FRAME_LIST request asks for one of the listings below, either as the
+ * rendered table ("table") or as its rows only ("rows", tab-separated
+ * fields), which the client can render itself with the listing's box.
+ */
+
+/**
+ * @brief A user logged in on a connection.
+ */
+typedef struct {
+    int role;               ///< ADMIN, STUDENT or FACULTY; 0 if the slot is free
+    int user_id;
+} Session;
+
+/**
+ * @brief Sessions of one connection, indexed by the client's session number.
+ */
+typedef struct {
+    Session *slots;
+    int size;
+    int active;             ///< Number of logged-in sessions
+} SessionTable;
+
+/**
+ * @brief Returns a logged-in session, or NULL.
+ */
+static inline const Session *session_get(const SessionTable *t, long number) {
+    if (number < 0 || number >= t->size || !t->slots[number].role) return NULL;
+    return &t->slots[number];
+}
+
+/**
+ * @brief Records a login under a session number, replacing any earlier one.
+ * @return SUCCESS, or FAILURE if the number is out of range or out of memory.
+ */
+static inline int session_set(SessionTable *t, long number, int role, int user_id) {
+    if (number < 0 || number >= SESSION_MAX) return FAILURE;
+    if (number >= t->size) {
+        int bigger = t->size ? t->size : 16;
+        while (bigger <= number) bigger *= 2;
+        Session *grown = (Session *)realloc(t->slots, bigger * sizeof(Session));
+        if (!grown) return FAILURE;
+        memset(grown + t->size, 0, (bigger - t->size) * sizeof(Session));
+        t->slots = grown;
+        t->size = bigger;
+    }
+    if (!t->slots[number].role) t->active++;
+    t->slots[number].role = role;
+    t->slots[number].user_id = user_id;
+    return SUCCESS;
+}
+
+static inline void session_clear(SessionTable *t, long number) {
+    if (!session_get(t, number)) return;
+    t->slots[number].role = 0;
+    t->active--;
+}
+
+typedef int (*ActionFn)(const Session *s, char **argv);
+
+/**
+ * @brief One operation a session may request.
+ */
+typedef struct {
+    const char *name;
+    int role;               ///< Role allowed to run it, 0 for any
+    int argc;               ///< Arguments after the name
+    ActionFn run;
+} ActionOp;
+
+static inline int action_ping(const Session *s, char **argv) {
+    (void)s; (void)argv;
+    return SUCCESS;
+}
+
+static inline int action_enroll(const Session *s, char **argv) {
+    return enroll_course(s->user_id, atoi(argv[0]));
+}
+
+static inline int action_unenroll(const Session *s, char **argv) {
+    return unenroll_course(s->user_id, atoi(argv[0]));
+}
+
+static inline int action_student_password(const Session *s, char **argv) {
+    return change_student_password(s->user_id, argv[0]);
+}
+
+static inline int action_faculty_password(const Session *s, char **argv) {
+    return change_password(FACULTY_DB, s->user_id, argv[0]);
+}
+
+static inline int action_add_course(const Session *s, char **argv) {
+    return add_course(atoi(argv[0]), argv[1], argv[2], atoi(argv[3]), atoi(argv[4]), s->user_id, NULL, 0, "");
+}
+
+static inline int action_remove_course(const Session *s, char **argv) {
+    return remove_course(atoi(argv[0]), s->user_id);
+}
+
+static inline int action_add_student(const Session *s, char **argv) {
+    (void)s;
+    return add_student(STUDENT_DB, atoi(argv[0]), argv[1], argv[2], argv[3], 1);
+}
+
+static inline int action_add_faculty(const Session *s, char **argv) {
+    (void)s;
+    return add_faculty(FACULTY_DB, atoi(argv[0]), argv[1], argv[2], argv[3]);
+}
+
+static const ActionOp action_ops[] = {
+    { "ping",          0,       0, action_ping },
+    { "enroll",        STUDENT, 1, action_enroll },
+    { "unenroll",      STUDENT, 1, action_unenroll },
+    { "password",      STUDENT, 1, action_student_password },
+    { "password",      FACULTY, 1, action_faculty_password },
+    { "add_course",    FACULTY, 5, action_add_course },
+    { "remove_course", FACULTY, 1, action_remove_course },
+    { "add_student",   ADMIN,   4, action_add_student },
+    { "add_faculty",   ADMIN,   4, action_add_faculty },
+};
+
+/**
+ * @brief Renders a listing, or one page of it.
+ *
+ * A paged listing renders at most LISTING_PAGE_SIZE rows from the cursor on
+ * and advances it; the others render everything and leave it done.
+ */
+typedef int (*ListingFn)(const Session *s, char **argv, ListCursor *cursor, RenderBuf *out);
+
+/**
+ * @brief One listing a session may request.
+ */
+typedef struct {
+    const char *name;
+    int role;               ///< Role allowed to request it
+    int argc;               ///< Arguments after the name
+    int paged;              ///< 1 if it takes a "page=<token>" argument
+    ListingFn run;
+    RenderBox *box;         ///< Layout of its rows
+    const char *title;      ///< Title of the rendered table, or NULL
+} ListingOp;
+
+static inline int listing_enrollments(const Session *s, char **argv, ListCursor *cursor, RenderBuf *out) {
+    (void)argv; (void)cursor;
+    return render_enrollments_st(out, s->user_id);
+}
+
+static inline int listing_available(const Session *s, char **argv, ListCursor *cursor, RenderBuf *out) {
+    (void)argv;
+    return render_available_courses(out, s->user_id, cursor, LISTING_PAGE_SIZE);
+}
+
+static inline int listing_roster(const Session *s, char **argv, ListCursor *cursor, RenderBuf *out) {
+    (void)cursor;
+    return render_enrollments(out, s->user_id, argv[0]);
+}
+
+static inline int listing_users(const char *db, ListCursor *cursor, RenderBuf *out) {
+    int shown = render_users(out, db, cursor, LISTING_PAGE_SIZE);
+    return shown < 0 ? shown : SUCCESS;
+}
+
+static inline int listing_students(const Session *s, char **argv, ListCursor *cursor, RenderBuf *out) {
+    (void)s; (void)argv;
+    return listing_users(STUDENT_DB, cursor, out);
+}
+
+static inline int listing_faculty(const Session *s, char **argv, ListCursor *cursor, RenderBuf *out) {
+    (void)s; (void)argv;
+    return listing_users(FACULTY_DB, cursor, out);
+}
+
+static const ListingOp listing_ops[] = {
+    { "enrollments", STUDENT, 0, 0, listing_enrollments, &enrolled_box,    "YOUR ENROLLED COURSES" },
+    { "available",   STUDENT, 0, 1, listing_available,   &available_box,   "AVAILABLE COURSES FOR ENROLLMENT" },
+    { "roster",      FACULTY, 1, 0, listing_roster,      &roster_box,      NULL },
+    { "students",    ADMIN,   0, 1, listing_students,    &users_box,       NULL },
+    { "faculty",     ADMIN,   0, 1, listing_faculty,     &users_box_plain, NULL },
+};
+
+/**
+ * @brief Finds a listing by name.
+ * @return The listing, or NULL.
+ */
+static inline const ListingOp *listing_find(const char *name) {
+    for (size_t i = 0; i < sizeof(listing_ops) / sizeof(listing_ops[0]); i++) {
+        if (strcmp(listing_ops[i].name, name) == 0) return &listing_ops[i];
+    }
+    return NULL;
+}
+
+/**
+ * @brief Characters no argument may contain: they would end a CSV field or
+ *        row when the action writes the argument to a table, or a field of a
+ *        listing in rows mode.
+ */
+#define ACTION_FORBIDDEN ",\"\t\r\n"
+
+/**
+ * @brief Splits an action line into words in place.
+ *
+ * Words are separated by spaces or tabs; a word in double quotes may contain
+ * spaces. At most max words are stored. A line with a word containing any of
+ * ACTION_FORBIDDEN is refused as a whole, before any action sees it.
+ *
+ * @return Number of words, or -1 if there are more than max, a quote is
+ *         unterminated or a word contains a forbidden character.
+ */
+static inline int action_split(char *line, char **argv, int max) {
+    int argc = 0;
+    char *p = line;
+    while (1) {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+        if (!*p) return argc;
+        if (argc == max) return -1;
+
+        int last = 0;
+        if (*p == '"') {
+            argv[argc++] = ++p;
+            p = strchr(p, '"');
+            if (!p) return -1;
+        } else {
+            argv[argc++] = p;
+            p += strcspn(p, " \t\r\n");
+            last = !*p;
+        }
+        *p = '\0';
+        if (strpbrk(argv[argc - 1], ACTION_FORBIDDEN)) return -1;
+        if (last) return argc;
+        p++;
+    }
+}
+
+/**
+ * @brief Runs one action request and sends the reply.
+ *
+ * @param fd      Client connection.
+ * @param s       Logged-in user, or NULL if the session is not logged in.
+ * @param payload Action line; modified.
+ * @return SUCCESS, or FAILURE if the reply could not be sent.
+ */
+static inline int session_serve_action(int fd, const Session *s, char *payload) {
+    if (!s) return frame_send(fd, FRAME_ERROR, "not logged in", 13);
+
+    char *argv[ACTION_MAX_ARGS + 1];
+    int argc = action_split(payload, argv, ACTION_MAX_ARGS + 1);
+    const char *error = argc <= 0 ? "malformed request" : "unknown operation";
+
+    for (size_t i = 0; argc > 0 && i < sizeof(action_ops) / sizeof(action_ops[0]); i++) {
+        const ActionOp *op = &action_ops[i];
+        if (strcmp(op->name, argv[0]) != 0) continue;
+        if (op->role && op->role != s->role) {
+            error = "operation not allowed for this role";
+            continue;
+        }
+        if (argc - 1 != op->argc) {
+            error = "wrong number of arguments";
+            break;
+        }
+
+        int status = op->run(s, argv + 1);
+        arena_reset(request_arena());
+        char reply[16];
+        int len = snprintf(reply, sizeof(reply), "%d", status);
+        return frame_send(fd, FRAME_RESULT, reply, len);
+    }
+    return frame_send(fd, FRAME_ERROR, error, strlen(error));
+}
+
+/**
+ * @brief Runs one FRAME_LIST request and sends the reply.
+ *
+ * A paged listing sends one page per request. If rows follow, the status
+ * line carries "next=<token>"; the client asks for the next page by adding
+ * "page=<token>" to the request. The token is the listing's cursor (see
+ * cursor_token()), so the server keeps no state between pages.
+ *
+ * @param fd      Client connection.
+ * @param s       Logged-in user, or NULL if the session is not logged in.
+ * @param payload "rows|table <listing> [args] [page=<token>]"; modified.
+ * @return SUCCESS, or FAILURE if the reply could not be sent.
+ */
+static inline int session_serve_list(int fd, const Session *s, char *payload) {
+    if (!s) return frame_send(fd, FRAME_ERROR, "not logged in", 13);
+
+    char *argv[ACTION_MAX_ARGS + 3];
+    int argc = action_split(payload, argv, ACTION_MAX_ARGS + 3);
+    const char *error = NULL;
+    const ListingOp *op = argc >= 2 ? listing_find(argv[1]) : NULL;
+    ListCursor cursor = {0};
+    if (op && op->paged && argc - 2 == op->argc + 1 && strncmp(argv[argc - 1], "page=", 5) == 0) {
+        if (cursor_parse_token(argv[argc - 1] + 5, &cursor) != SUCCESS) error = "malformed page token";
+        argc--;
+    }
+    if (argc < 2 || (strcmp(argv[0], "rows") != 0 && strcmp(argv[0], "table") != 0)) error = "malformed request";
+    else if (!op) error = "unknown listing";
+    else if (op->role != s->role) error = "listing not allowed for this role";
+    else if (argc - 2 != op->argc) error = "wrong number of arguments";
+    if (error) return frame_send(fd, FRAME_ERROR, error, strlen(error));
+
+    RenderBuf out = { .rows = strcmp(argv[0], "rows") == 0 };
+    cursor.done = 1;
+    int result = op->run(s, argv + 2, &cursor, &out);
+    char status[CURSOR_TOKEN_LEN + 32], token[CURSOR_TOKEN_LEN];
+    int len;
+    if (result == SUCCESS && !cursor.done) {
+        cursor_token(&cursor, token, sizeof(token));
+        len = snprintf(status, sizeof(status), "%d next=%s\n", result, token);
+    } else {
+        len = snprintf(status, sizeof(status), "%d\n", result);
+    }
+
+    char *reply = (char *)malloc(len + out.len + 1);
+    int sent = FAILURE;
+    if (reply) {
+        memcpy(reply, status, len);
+        if (out.len) memcpy(reply + len, out.data, out.len);
+        sent = frame_send(fd, FRAME_LISTING, reply, len + out.len);
+    }
+    free(reply);
+    render_free(&out);
+    return sent;
+}
+
+#endif // SESSION_ACTIONS_H
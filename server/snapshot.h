@@ -0,0 +1,181 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "utils.h"
+#include "probes.h"
+
+#define SNAPSHOT_PATH_LEN 256
+
+/**
+ * @brief Copy-on-write snapshots of the CSV tables.
+ *
+ * Every table is treated as an immutable version. Writers never modify a
+ * table in place: they write a complete new version to a temp file and
+ * publish it with rename(), which atomically swaps the directory entry.
+ *
+ * Readers open the table without taking any lock. The open descriptor pins
+ * the version that was current at open() time, so a reader always sees one
+ * consistent table even while writers publish newer versions, and it never
+ * blocks or is blocked by them. The kernel reclaims an old version once its
+ * last reader closes it, which gives deferred reclamation for free.
+ *
+ * Writers serialise among themselves on a sidecar "<table>.lock" file. The
+ * lock file is never replaced, so unlike a lock on the table itself it stays
+ * valid across renames.
+ */
+
+/**
+ * @brief In-progress rewrite of one table.
+ */
+typedef struct {
+    const char *path;                      ///< Table being replaced
+    char temp_path[SNAPSHOT_PATH_LEN];     ///< New version being written
+    FILE *out;                             ///< Stream for the new version
+} SnapshotWriter;
+
+/**
+ * @brief Opens the current version of a table for lock-free reading.
+ * @param path Table path.
+ * @return File descriptor pinned to the current version, or -1 on error.
+ */
+static inline int snapshot_open(const char *path) {
+    return open(path, O_RDONLY);
+}
+
+/**
+ * @brief Opens the current version of a table as a stream for lock-free reading.
+ * @param path Table path.
+ * @return FILE stream pinned to the current version, or NULL on error.
+ */
+static inline FILE *snapshot_fopen(const char *path) {
+    return fopen(path, "r");
+}
+
+/**
+ * @brief Acquires the writer lock of a table.
+ *
+ * Blocks until no other writer holds the table. Readers are not affected.
+ *
+ * @param path Table path.
+ * @return Lock descriptor to pass to snapshot_unlock(), or -1 on error.
+ */
+static inline int snapshot_lock(const char *path) {
+    char lock_path[SNAPSHOT_PATH_LEN];
+    snprintf(lock_path, sizeof(lock_path), "%s.lock", path);
+
+    int fd = open(lock_path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return -1;
+
+    struct flock lock = { .l_type = F_WRLCK, .l_whence = SEEK_SET };
+    if (fcntl(fd, F_SETLKW, &lock) == -1) {
+        perror("fcntl lock");
+        close(fd);
+        return -1;
+    }
+    PROBE_LOCK_ACQUIRE(path, F_WRLCK);
+    return fd;
+}
+
+/**
+ * @brief Releases a writer lock taken with snapshot_lock().
+ * @param lock_fd Descriptor returned by snapshot_lock().
+ * @param path    Table path (for tracing).
+ */
+static inline void snapshot_unlock(int lock_fd, const char *path) {
+    if (lock_fd < 0) return;
+    struct flock lock = { .l_type = F_UNLCK, .l_whence = SEEK_SET };
+    fcntl(lock_fd, F_SETLK, &lock);
+    close(lock_fd);
+    PROBE_LOCK_RELEASE(path);
+}
+
+/**
+ * @brief Starts writing a new version of a table to "<path><suffix>".
+ *
+ * The caller must hold the table's writer lock until the rewrite is
+ * committed or aborted.
+ *
+ * @param w      Writer state to initialise.
+ * @param path   Table path.
+ * @param suffix Suffix of the temp file holding the new version.
+ * @return Stream for the new version, or NULL on error.
+ */
+static inline FILE *snapshot_rewrite_begin_as(SnapshotWriter *w, const char *path, const char *suffix) {
+    w->path = path;
+    snprintf(w->temp_path, sizeof(w->temp_path), "%s%s", path, suffix);
+    PROBE_REWRITE_BEGIN(path);
+    w->out = fopen(w->temp_path, "w");
+    if (!w->out) PROBE_REWRITE_END(path, FILE_ERROR);
+    return w->out;
+}
+
+/**
+ * @brief Starts writing a new version of a table to "<path>.tmp".
+ * @see snapshot_rewrite_begin_as()
+ */
+static inline FILE *snapshot_rewrite_begin(SnapshotWriter *w, const char *path) {
+    return snapshot_rewrite_begin_as(w, path, ".tmp");
+}
+
+/**
+ * @brief Discards a new version without publishing it.
+ */
+static inline void snapshot_rewrite_abort(SnapshotWriter *w) {
+    if (w->out) fclose(w->out);
+    w->out = NULL;
+    unlink(w->temp_path);
+    PROBE_REWRITE_END(w->path, FILE_ERROR);
+}
+
+/**
+ * @brief Makes the new version durable without publishing it yet.
+ *
+ * On failure the temp file is removed and the old version is left untouched.
+ *
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int snapshot_rewrite_prepare(SnapshotWriter *w) {
+    int status = SUCCESS;
+    if (fflush(w->out) != 0 || fsync(fileno(w->out)) != 0) status = FILE_ERROR;
+    if (fclose(w->out) != 0) status = FILE_ERROR;
+    w->out = NULL;
+
+    if (status != SUCCESS) {
+        unlink(w->temp_path);
+        PROBE_REWRITE_END(w->path, status);
+    }
+    return status;
+}
+
+/**
+ * @brief Publishes a prepared version atomically.
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int snapshot_rewrite_publish(SnapshotWriter *w) {
+    int status = rename(w->temp_path, w->path) < 0 ? FILE_ERROR : SUCCESS;
+    if (status != SUCCESS) unlink(w->temp_path);
+    PROBE_REWRITE_END(w->path, status);
+    return status;
+}
+
+/**
+ * @brief Makes the new version durable and publishes it atomically.
+ *
+ * Readers that already hold the old version keep reading it; new readers see
+ * the new version.
+ *
+ * @return SUCCESS, or FILE_ERROR if the new version could not be published
+ *         (the old version is then left untouched).
+ */
+static inline int snapshot_rewrite_commit(SnapshotWriter *w) {
+    int status = snapshot_rewrite_prepare(w);
+    if (status != SUCCESS) return status;
+    return snapshot_rewrite_publish(w);
+}
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,172 @@
+#ifndef STRPOOL_H
+#define STRPOOL_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+#define STR_EMPTY 0u            ///< Id of "" in every pool
+#define STR_NONE  UINT32_MAX    ///< Returned when a string is absent or out of memory
+
+/**
+ * @brief Interned strings with 32-bit ids.
+ *
+ * Each distinct string is stored once, back to back in one buffer, and
+ * identified by a small integer, so tables that repeat the same course codes
+ * and faculty names hold 4-byte ids instead of fixed-size char arrays, and two
+ * strings of the same pool are equal exactly when their ids are. Ids are
+ * dense (0 is always ""), so callers can index side arrays by them. A hash
+ * table of ids with open addressing and linear probing finds existing
+ * strings in O(1) on average.
+ *
+ * Pointers returned by strpool_get() stay valid until the next string is
+ * added to the pool.
+ */
+
+typedef uint32_t StrId;
+
+typedef struct {
+    char *bytes;            ///< NUL-terminated strings back to back
+    size_t len, cap;
+    uint32_t *offsets;      ///< Start of each string in bytes, indexed by id
+    uint32_t count, size;
+    uint32_t *slots;        ///< id + 1 per slot, 0 for a free slot
+    uint32_t slot_count;    ///< Power of two, 0 until the first string
+} StrPool;
+
+static inline size_t strpool_hash(const char *s, size_t n) {
+    size_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < n; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static inline const char *strpool_get(const StrPool *p, StrId id) {
+    return id < p->count ? p->bytes + p->offsets[id] : "";
+}
+
+/**
+ * @brief Returns the slot holding a string, or the free slot where it belongs.
+ */
+static inline uint32_t strpool_slot(const StrPool *p, const char *s, size_t n) {
+    uint32_t mask = p->slot_count - 1;
+    uint32_t i = strpool_hash(s, n) & mask;
+    while (p->slots[i]) {
+        const char *held = p->bytes + p->offsets[p->slots[i] - 1];
+        if (strncmp(held, s, n) == 0 && held[n] == '\0') break;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/**
+ * @brief Doubles the hash table and re-inserts every id.
+ * @return SUCCESS or FAILURE if out of memory.
+ */
+static inline int strpool_grow_slots(StrPool *p) {
+    uint32_t bigger = p->slot_count ? p->slot_count * 2 : 256;
+    uint32_t *slots = calloc(bigger, sizeof(uint32_t));
+    if (!slots) return FAILURE;
+
+    free(p->slots);
+    p->slots = slots;
+    p->slot_count = bigger;
+    for (uint32_t id = 0; id < p->count; id++) {
+        const char *s = p->bytes + p->offsets[id];
+        p->slots[strpool_slot(p, s, strlen(s))] = id + 1;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Finds the id of the first n bytes of a string without adding it.
+ * @return The id, or STR_NONE if the pool does not hold the string.
+ */
+static inline StrId strpool_find_n(const StrPool *p, const char *s, size_t n) {
+    if (n == 0) return STR_EMPTY;
+    if (!p->slot_count) return STR_NONE;
+    uint32_t slot = p->slots[strpool_slot(p, s, n)];
+    return slot ? slot - 1 : STR_NONE;
+}
+
+static inline StrId strpool_find(const StrPool *p, const char *s) {
+    return strpool_find_n(p, s, strlen(s));
+}
+
+/**
+ * @brief Interns the first n bytes of a string (which need not be terminated there).
+ *
+ * The string must not point into the pool itself.
+ *
+ * @return The string's id, or STR_NONE if out of memory.
+ */
+static inline StrId strpool_intern_n(StrPool *p, const char *s, size_t n) {
+    if ((p->count + 2) * 2 > p->slot_count && strpool_grow_slots(p) != SUCCESS) return STR_NONE;
+    if (p->count == 0) {
+        // Id 0 is ""
+        if (!p->bytes) {
+            p->cap = 4096;
+            if (!(p->bytes = malloc(p->cap))) return STR_NONE;
+        }
+        if (!p->offsets) {
+            p->size = 256;
+            if (!(p->offsets = malloc(p->size * sizeof(uint32_t)))) return STR_NONE;
+        }
+        p->bytes[0] = '\0';
+        p->len = 1;
+        p->offsets[p->count++] = 0;
+        p->slots[strpool_slot(p, "", 0)] = 1;
+    }
+    if (n == 0) return STR_EMPTY;
+
+    uint32_t i = strpool_slot(p, s, n);
+    if (p->slots[i]) return p->slots[i] - 1;
+
+    if (p->len + n + 1 > p->cap) {
+        size_t bigger = p->cap * 2;
+        while (p->len + n + 1 > bigger) bigger *= 2;
+        char *grown = realloc(p->bytes, bigger);
+        if (!grown) return STR_NONE;
+        p->bytes = grown;
+        p->cap = bigger;
+    }
+    if (p->count == p->size) {
+        uint32_t *grown = realloc(p->offsets, p->size * 2 * sizeof(uint32_t));
+        if (!grown) return STR_NONE;
+        p->offsets = grown;
+        p->size *= 2;
+    }
+
+    StrId id = p->count++;
+    p->offsets[id] = p->len;
+    memcpy(p->bytes + p->len, s, n);
+    p->bytes[p->len + n] = '\0';
+    p->len += n + 1;
+    p->slots[i] = id + 1;
+    return id;
+}
+
+static inline StrId strpool_intern(StrPool *p, const char *s) {
+    return strpool_intern_n(p, s, strlen(s));
+}
+
+/**
+ * @brief Forgets every string, keeping the allocated memory.
+ */
+static inline void strpool_clear(StrPool *p) {
+    p->count = 0;
+    p->len = 0;
+    if (p->slots) memset(p->slots, 0, p->slot_count * sizeof(uint32_t));
+}
+
+static inline void strpool_free(StrPool *p) {
+    free(p->bytes);
+    free(p->offsets);
+    free(p->slots);
+    memset(p, 0, sizeof(*p));
+}
+
+#endif // STRPOOL_H
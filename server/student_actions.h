@@ -10,6 +10,19 @@
 #include <sys/file.h>
 #include "types.h"
 #include "utils.h"
+#include "trace.h"
+#include "probes.h"
+#include "catalogue_cache.h"
+#include "auth_version.h"
+#include "snapshot.h"
+#include "txn.h"
+#include "waitlist.h"
+#include "schedule.h"
+#include "prereq.h"
+#include "cursor.h"
+#include "render.h"
+#include "enroll_stats.h"
+#include "arena.h"
 
 #define MAX_ERROR_MSG 512
 #define MAX_BUFFER 2048
@@ -21,37 +34,80 @@
 #define DB_FACULTY "../database/faculty.csv"
 
 /**
- * @brief Lists available courses for a student to enroll in.
+ * @brief Row buffer in the request arena that grows to the longest row read.
+ */
+typedef struct {
+    char *data;
+    size_t cap;
+} RowBuf;
+
+/**
+ * @brief Reads one row of any length from a file descriptor.
+ *
+ * Like read_line(), but a row longer than the buffer (a course with a long
+ * roster) makes the buffer grow instead of being cut into pieces. The buffer
+ * lives in the request arena, so error paths need no cleanup.
+ *
+ * @return Number of bytes read, 0 on EOF, -1 on error or out of memory.
+ */
+static inline ssize_t read_row(int fd, RowBuf *row) {
+    size_t len = 0;
+    while (1) {
+        if (len + 2 > row->cap) {
+            size_t bigger = row->cap ? row->cap * 2 : MAX_BUFFER;
+            char *grown = arena_alloc(request_arena(), bigger);
+            if (!grown) return -1;
+            if (len) memcpy(grown, row->data, len);
+            row->data = grown;
+            row->cap = bigger;
+        }
+        ssize_t n = read_line(fd, row->data + len, row->cap - len);
+        if (n < 0 && !len) return n;
+        if (n <= 0) break;
+        len += n;
+        if (row->data[len - 1] == '\n') break;
+    }
+    row->data[len] = '\0';
+    return len;
+}
+
+/**
+ * @brief Layouts of the student tables.
+ */
+static RenderBox available_box = RENDER_TABLE(
+    "║ Course ID ║   Code    ║  Credits  ║          Course Name           ║       Faculty       ║   Seats   ║\n",
+    "dsdsss", 9, 9, 9, 30, 19, 9);
+static RenderBox enrolled_box = RENDER_TABLE(
+    "║ Course ID ║   Code    ║          Course Name           ║  Credits  ║       Faculty       ║\n",
+    "dssds", 9, 9, 30, 9, 19);
+static RenderBox student_message_box = RENDER_BOX("s", 57);
+
+/**
+ * @brief Renders the courses a student can enroll in.
  *
  * This function checks the student's enrollment status and lists courses that are 
- * available for enrollment. It uses file locks to ensure safe concurrent access 
- * to the student, course, and faculty databases.
+ * available for enrollment. The catalogue itself comes from the shared catalogue
+ * cache; only the student's enrolled courses and courses whose prerequisites
+ * the student has not met are filtered here. Full courses are shown with
+ * "Waitlist" in place of their free seats.
+ *
+ * The cursor holds the catalogue position; if the catalogue changed since the
+ * previous call, listing resumes after the last course rendered.
  *
+ * @param out Output.
  * @param student_id ID of the student.
+ * @param cursor Where the list starts; advanced past the last course rendered.
+ * @param limit Most courses to render.
  * @return SUCCESS on success, USER_NOT_FOUND if student is not found, FILE_ERROR on file operation errors.
  */
-int list_available_courses(int student_id) {
-    int student_fd = open(DB_STUDENTS, O_RDONLY);
+static inline int render_available_courses(RenderBuf *out, int student_id, ListCursor *cursor, int limit) {
+    // Read the current students snapshot; no lock, so writers are never stalled
+    int student_fd = snapshot_open(DB_STUDENTS);
     if (student_fd < 0) {
         const char *err_msg = "Error opening students file\n";
         write(STDERR_FILENO, err_msg, strlen(err_msg));
         return FILE_ERROR;
     }
-    
-    // Acquire shared lock for reading student file
-    struct flock lock;
-    memset(&lock, 0, sizeof(lock));
-    lock.l_type = F_RDLCK;
-    lock.l_whence = SEEK_SET;
-    lock.l_start = 0;
-    lock.l_len = 0;
-    
-    if (fcntl(student_fd, F_SETLKW, &lock) == -1) {
-        const char *err_msg = "Failed to acquire lock on students file\n";
-        write(STDERR_FILENO, err_msg, strlen(err_msg));
-        close(student_fd);
-        return FILE_ERROR;
-    }
 
     char line[MAX_LINE];
     Student student;
@@ -83,180 +139,163 @@ int list_available_courses(int student_id) {
         }
     }
     
-    // Release lock on student file
-    lock.l_type = F_UNLCK;
-    fcntl(student_fd, F_SETLK, &lock);
     close(student_fd);
 
     if (!found) {
-        // Use a larger buffer to avoid truncation
-        char error_msg[MAX_ERROR_MSG];
-        snprintf(error_msg, sizeof(error_msg),
-                "\n╔════════════════════════════════════════════════╗"
-                "\n║ Error: Student with ID %d not found in system. ║"
-                "\n╚════════════════════════════════════════════════╝\n", 
-                student_id);
-        write(STDOUT_FILENO, error_msg, strlen(error_msg));
+        render_text(out, "\n");
+        render_rule(out, &student_message_box, RULE_TOP);
+        render_line(out, &student_message_box, "Error: Student with ID %d not found in system.", student_id);
+        render_rule(out, &student_message_box, RULE_BOTTOM);
         return USER_NOT_FOUND;
     }
 
-    int course_fd = open(DB_COURSES, O_RDONLY);
-    if (course_fd < 0) {
+    const CatalogueCache *catalogue = catalogue_get();
+    if (!catalogue) {
         const char *err_msg = "Error opening courses file\n";
         write(STDERR_FILENO, err_msg, strlen(err_msg));
         return FILE_ERROR;
     }
-    
-    // Acquire shared lock for reading course file
-    memset(&lock, 0, sizeof(lock));
-    lock.l_type = F_RDLCK;
-    lock.l_whence = SEEK_SET;
-    lock.l_start = 0;
-    lock.l_len = 0;
-    
-    if (fcntl(course_fd, F_SETLKW, &lock) == -1) {
-        const char *err_msg = "Failed to acquire lock on courses file\n";
+
+    // The student's met set is computed once; each course is then a bitset test
+    const PrereqGraph *prereqs = prereq_get();
+    char completed[MAX_BUFFER];
+    uint64_t *met = NULL;
+    if (prereqs && prereq_completed(student_id, completed, sizeof(completed)) == SUCCESS) {
+        met = prereq_met(prereqs, completed);
+    }
+    if (!met) {
+        const char *err_msg = "Error opening prerequisites file\n";
         write(STDERR_FILENO, err_msg, strlen(err_msg));
-        close(course_fd);
         return FILE_ERROR;
     }
 
-    const char *header = "\n╔══════════════════════════════════════════════════════════════════════════════════════════╗"
-                         "\n║                              AVAILABLE COURSES FOR ENROLLMENT                            ║"
-                         "\n╠═══════════╦═══════════╦═══════════╦════════════════════════════════╦═════════════════════╣"
-                         "\n║ Course ID ║   Code    ║  Credits  ║          Course Name           ║       Faculty       ║"
-                         "\n╠═══════════╬═══════════╬═══════════╬════════════════════════════════╬═════════════════════╣";
-    write(STDOUT_FILENO, header, strlen(header));
-
-    int count = 0;
-
-    // Skip header
-    read_line(course_fd, line, sizeof(line));
-    
-    while ((bytes_read = read_line(course_fd, line, sizeof(line))) > 0) {
-        struct Course course;
-        char *token = strtok(line, ",");
-        if (!token) continue;
-        course.id = atoi(token);
-        token = strtok(NULL, ",");
-        if (token) strcpy(course.code, token);
-        token = strtok(NULL, ",");
-        if (token) strcpy(course.name, token);
-        token = strtok(NULL, ",");
-        if (token) course.capacity = atoi(token);
-        token = strtok(NULL, ",");
-        if (token) course.enrolled = atoi(token);
-        token = strtok(NULL, ",");
-        if (token) course.credits = atoi(token);
-        token = strtok(NULL, ",");
-        if (token) course.faculty_id = atoi(token);
-
-        // Skip if already enrolled or full
-        if ((strlen(student.enrolled_courses) > 0 && strstr(student.enrolled_courses, course.code)) || 
-            course.enrolled >= course.capacity) {
-            continue;
-        }
-
-        // Get faculty name
-        char faculty_name[100] = "Unknown";
-        int faculty_fd = open(DB_FACULTY, O_RDONLY);
-        if (faculty_fd >= 0) {
-            struct flock fac_lock;
-            memset(&fac_lock, 0, sizeof(fac_lock));
-            fac_lock.l_type = F_RDLCK;
-            fac_lock.l_whence = SEEK_SET;
-            fac_lock.l_start = 0;
-            fac_lock.l_len = 0;
-            
-            if (fcntl(faculty_fd, F_SETLKW, &fac_lock) == -1) {
-                const char *err_msg = "Failed to acquire lock on faculty file\n";
-                write(STDERR_FILENO, err_msg, strlen(err_msg));
-            } else {
-                char faculty_line[MAX_LINE];
-                while (read_line(faculty_fd, faculty_line, sizeof(faculty_line)) > 0) {
-                    int fid;
-                    char *ftoken = strtok(faculty_line, ",");
-                    if (!ftoken) continue;
-                    fid = atoi(ftoken);
-                    if (fid == course.faculty_id) {
-                        ftoken = strtok(NULL, ",");
-                        if (ftoken) strcpy(faculty_name, ftoken);
-                        break;
-                    }
-                }
-                
-                // Release lock on faculty file
-                fac_lock.l_type = F_UNLCK;
-                fcntl(faculty_fd, F_SETLK, &fac_lock);
+    render_text(out, "\n");
+    render_rule(out, &available_box, RULE_TOP);
+    render_title(out, &available_box, "AVAILABLE COURSES FOR ENROLLMENT");
+    render_rule(out, &available_box, RULE_SPLIT);
+    render_header(out, &available_box);
+    render_rule(out, &available_box, RULE_MID);
+
+    // Resume where the previous page ended, or after its last course if the
+    // catalogue has changed since
+    long start = cursor->started ? cursor->position : 0;
+    if (start < 0 || start > catalogue->count) start = catalogue->count;
+    if (cursor->started && cursor->version != catalogue->version) {
+        for (int i = 0; i < catalogue->count; i++) {
+            if (catalogue->ids[i] == cursor->last_id) {
+                start = i + 1;
+                break;
             }
-            close(faculty_fd);
         }
+    }
 
-        char course_line[256];
-        int len = snprintf(course_line, sizeof(course_line),
-                          "\n║ %-9d ║ %-9s ║ %-9d ║ %-30s ║ %-19s ║",
-                          course.id, course.code, course.credits, course.name, faculty_name);
-        write(STDOUT_FILENO, course_line, len);
+    int count = 0, i;
+
+    // The student's courses as catalogue string ids, so the enrolled check
+    // is a handful of integer compares per course
+    StrId enrolled_ids[sizeof(student.enrolled_courses) / 2];
+    int enrolled_count = catalogue_code_ids(catalogue, student.enrolled_courses, enrolled_ids,
+                                            sizeof(enrolled_ids) / sizeof(enrolled_ids[0]));
+
+    // Overlay the student's own view on the shared catalogue
+    for (i = start; i < catalogue->count && count < limit; i++) {
+        // Skip if already enrolled or not yet eligible. Full courses stay
+        // listed, since enrolling in one joins its waitlist
+        StrId code = catalogue->codes[i];
+        int enrolled = 0;
+        for (int k = 0; k < enrolled_count && !enrolled; k++) enrolled = enrolled_ids[k] == code;
+        if (enrolled || !prereq_eligible(prereqs, met, catalogue_str(catalogue, code))) continue;
+
+        char seats[16] = "Waitlist";
+        int free_seats = catalogue->capacity[i] - catalogue->enrolled[i];
+        if (free_seats > 0) snprintf(seats, sizeof(seats), "%d free", free_seats);
+        render_row(out, &available_box, catalogue->ids[i], catalogue_str(catalogue, code), catalogue->credits[i],
+                   catalogue_str(catalogue, catalogue->names[i]),
+                   catalogue_str(catalogue, catalogue->faculty_names[i]), seats);
+        cursor->last_id = catalogue->ids[i];
         count++;
     }
+    cursor->version = catalogue->version;
+    cursor->position = i;
+    cursor->started = 1;
+    cursor->done = i >= catalogue->count;
 
     if (count == 0) {
-        const char *no_courses = "\n║                      No available courses for enrollment at this time                     ║";
-        write(STDOUT_FILENO, no_courses, strlen(no_courses));
+        render_rule(out, &available_box, RULE_MERGE);
+        render_title(out, &available_box, start == 0 ? "No available courses for enrollment at this time"
+                                                     : "No more available courses");
+        render_rule(out, &available_box, RULE_BOTTOM);
+    } else {
+        render_rule(out, &available_box, RULE_BOTTOM_COLUMNS);
     }
-
-    const char *footer = "\n╚═══════════╩═══════════╩═══════════╩════════════════════════════════╩═════════════════════╝\n";
-    write(STDOUT_FILENO, footer, strlen(footer));
-
-    // Release lock on course file
-    lock.l_type = F_UNLCK;
-    fcntl(course_fd, F_SETLK, &lock);
-    close(course_fd);
+    free(met);
     
     return SUCCESS;
 }
 
+/**
+ * @brief Lists available courses for a student to enroll in.
+ *
+ * One page of up to LIST_PAGE_SIZE courses is printed per call, rendered into
+ * one buffer and written at once; see render_available_courses().
+ *
+ * @param student_id ID of the student.
+ * @param cursor Where the page starts; advanced to the next page.
+ * @return SUCCESS on success, USER_NOT_FOUND if student is not found, FILE_ERROR on file operation errors.
+ */
+int list_available_courses(int student_id, ListCursor *cursor) {
+    RenderBuf out = {0};
+    int status = render_available_courses(&out, student_id, cursor, LIST_PAGE_SIZE);
+    render_flush(&out, STDOUT_FILENO);
+    render_free(&out);
+    return status;
+}
+
 
 /**
  * @brief Enrolls a student in a course, updating both course and student records.
+ *
+ * Both tables are locked once, checked and rewritten inside one transaction,
+ * so either both records change or neither does. An enrollment whose meeting
+ * times clash with the student's timetable, or whose prerequisites the student
+ * has not completed, is refused; if the course is full the student is
+ * appended to its waitlist instead. Each phase (lock, scans,
+ * rewrites, commit) is recorded in the given trace for the slow-operation log.
  * 
  * @param student_id ID of the student.
  * @param course_id ID of the course.
- * @return int Status code (SUCCESS, ALREADY_ENROLLED, FILE_ERROR, etc).
+ * @param trace Trace record receiving the phase breakdown.
+ * @return int Status code (SUCCESS, WAITLISTED, ALREADY_ENROLLED, SCHEDULE_CONFLICT,
+ *         PREREQ_MISSING, FILE_ERROR, etc).
  */
-static inline int enroll_course(int student_id, int course_id) {
+static inline int enroll_course_phases(int student_id, int course_id, OpTrace *trace) {
+    Txn txn;
+    if (txn_begin(&txn, 3, DB_COURSES, DB_STUDENTS, DB_WAITLIST) != SUCCESS) return FILE_ERROR;
+    trace_phase(trace, "lock");
+
     // 1) Look up course and check if student is already enrolled
-    int cf = open(DB_COURSES, O_RDONLY);
-    if (cf < 0) return FILE_ERROR;
-    
-    // Acquire shared lock for reading
-    struct flock lock;
-    memset(&lock, 0, sizeof(lock));
-    lock.l_type = F_RDLCK;
-    lock.l_whence = SEEK_SET;
-    lock.l_start = 0;
-    lock.l_len = 0; // Lock the entire file
-    
-    if (fcntl(cf, F_SETLKW, &lock) == -1) {
-        const char *err_msg = "Failed to acquire lock on courses file\n";
-        write(STDERR_FILENO, err_msg, strlen(err_msg));
-        close(cf);
+    int cf = snapshot_open(DB_COURSES);
+    if (cf < 0) {
+        txn_abort(&txn);
         return FILE_ERROR;
     }
 
-    char line[MAX_LINE];
+    RowBuf row = {0};
+    char *line;
     char course_code[64] = "";
     int found_course = 0;
     int cap = 0, enrolled = 0, credits = 0, fid = 0;
     char name_c[128] = "";
-    char students_raw[MAX_BUFFER] = "";
+    const char *students_raw = "";
     ssize_t bytes_read;
 
     // Skip header
-    read_line(cf, line, sizeof(line));
+    trace_scan(trace, read_row(cf, &row));
 
     // Find the course
-    while ((bytes_read = read_line(cf, line, sizeof(line))) > 0) {
+    while ((bytes_read = read_row(cf, &row)) > 0) {
+        trace_scan(trace, bytes_read);
+        line = row.data;
         int cid;
         if (sscanf(line, "%d", &cid) == 1 && cid == course_id) {
             found_course = 1;
@@ -302,7 +341,12 @@ static inline int enroll_course(int student_id, int course_id) {
                     end--;
                 }
                 
-                strncpy(students_raw, start, sizeof(students_raw) - 1);
+                students_raw = arena_strdup(request_arena(), start);
+                if (!students_raw) {
+                    close(cf);
+                    txn_abort(&txn);
+                    return FILE_ERROR;
+                }
             }
             
             // Check if student is already enrolled
@@ -310,8 +354,8 @@ static inline int enroll_course(int student_id, int course_id) {
                 char student_id_str[16];
                 snprintf(student_id_str, sizeof(student_id_str), "%d", student_id);
                 
-                char *students_copy = strdup(students_raw);
-                char *student_token = strtok(students_copy, ",");
+                char *students_copy = arena_strdup(request_arena(), students_raw);
+                char *student_token = students_copy ? strtok(students_copy, ",") : NULL;
                 
                 while (student_token) {
                     // Trim whitespace
@@ -323,45 +367,35 @@ static inline int enroll_course(int student_id, int course_id) {
                     }
                     
                     if (strcmp(student_token, student_id_str) == 0) {
-                        free(students_copy);
-                        lock.l_type = F_UNLCK;
-                        fcntl(cf, F_SETLK, &lock);
                         close(cf);
+                        txn_abort(&txn);
                         return ALREADY_ENROLLED;
                     }
                     
                     student_token = strtok(NULL, ",");
                 }
-                
-                free(students_copy);
             }
             
             break;
         }
     }
     
-    // Release lock
-    lock.l_type = F_UNLCK;
-    fcntl(cf, F_SETLK, &lock);
     close(cf);
     
-    if (!found_course) return COURSE_NOT_FOUND;
+    trace_phase(trace, "course_scan");
+    if (bytes_read < 0) {
+        txn_abort(&txn);
+        return FILE_ERROR;
+    }
+    if (!found_course) {
+        txn_abort(&txn);
+        return COURSE_NOT_FOUND;
+    }
     
     // 2) Check if student exists and get their enrolled courses
-    int sf = open(DB_STUDENTS, O_RDONLY);
-    if (sf < 0) return FILE_ERROR;
-    
-    // Acquire shared lock for reading
-    memset(&lock, 0, sizeof(lock));
-    lock.l_type = F_RDLCK;
-    lock.l_whence = SEEK_SET;
-    lock.l_start = 0;
-    lock.l_len = 0; // Lock the entire file
-    
-    if (fcntl(sf, F_SETLKW, &lock) == -1) {
-        const char *err_msg = "Failed to acquire lock on students file\n";
-        write(STDERR_FILENO, err_msg, strlen(err_msg));
-        close(sf);
+    int sf = snapshot_open(DB_STUDENTS);
+    if (sf < 0) {
+        txn_abort(&txn);
         return FILE_ERROR;
     }
 
@@ -370,12 +404,14 @@ static inline int enroll_course(int student_id, int course_id) {
     char student_email[64] = "";
     char student_pass[64] = "";
     int student_active = 0;
-    char student_enrolled[MAX_BUFFER] = "";
+    const char *student_enrolled = "";
     
     // Skip header
-    read_line(sf, line, sizeof(line));
+    trace_scan(trace, read_row(sf, &row));
     
-    while ((bytes_read = read_line(sf, line, sizeof(line))) > 0) {
+    while ((bytes_read = read_row(sf, &row)) > 0) {
+        trace_scan(trace, bytes_read);
+        line = row.data;
         int sid;
         if (sscanf(line, "%d", &sid) == 1 && sid == student_id) {
             found_student = 1;
@@ -410,13 +446,18 @@ static inline int enroll_course(int student_id, int course_id) {
                     end--;
                 }
                 
-                strncpy(student_enrolled, token, sizeof(student_enrolled) - 1);
+                student_enrolled = arena_strdup(request_arena(), token);
+                if (!student_enrolled) {
+                    close(sf);
+                    txn_abort(&txn);
+                    return FILE_ERROR;
+                }
             }
             
             // Check if already enrolled in this course
             if (strlen(student_enrolled) > 0) {
-                char *enrolled_copy = strdup(student_enrolled);
-                char *course_token = strtok(enrolled_copy, ",");
+                char *enrolled_copy = arena_strdup(request_arena(), student_enrolled);
+                char *course_token = enrolled_copy ? strtok(enrolled_copy, ",") : NULL;
                 
                 while (course_token) {
                     // Trim whitespace
@@ -428,526 +469,1078 @@ static inline int enroll_course(int student_id, int course_id) {
                     }
                     
                     if (strcmp(course_token, course_code) == 0) {
-                        free(enrolled_copy);
-                        lock.l_type = F_UNLCK;
-                        fcntl(sf, F_SETLK, &lock);
                         close(sf);
+                        txn_abort(&txn);
                         return ALREADY_ENROLLED;
                     }
                     
                     course_token = strtok(NULL, ",");
                 }
-                
-                free(enrolled_copy);
             }
             
             break;
         }
     }
     
-    // Release lock
-    lock.l_type = F_UNLCK;
-    fcntl(sf, F_SETLK, &lock);
     close(sf);
     
-    if (!found_student) return USER_NOT_FOUND;
-
-    // 3) Update courses file - add student to course's students list
-    cf = open(DB_COURSES, O_RDWR);
-    if (cf < 0) return FILE_ERROR;
-    
-    // Acquire exclusive lock for writing
-    memset(&lock, 0, sizeof(lock));
-    lock.l_type = F_WRLCK;
-    lock.l_whence = SEEK_SET;
-    lock.l_start = 0;
-    lock.l_len = 0; // Lock the entire file
-    
-    if (fcntl(cf, F_SETLKW, &lock) == -1) {
-        const char *err_msg = "Failed to acquire lock on courses file\n";
-        write(STDERR_FILENO, err_msg, strlen(err_msg));
-        close(cf);
+    trace_phase(trace, "student_scan");
+    if (bytes_read < 0) {
+        txn_abort(&txn);
         return FILE_ERROR;
     }
+    if (!found_student) {
+        txn_abort(&txn);
+        return USER_NOT_FOUND;
+    }
+
+    // 3) Prerequisites: checked against the precomputed closure
+    int eligible = prereq_check(student_id, course_code);
+    trace_phase(trace, "prereq_check");
+    if (eligible != 1) {
+        txn_abort(&txn);
+        return eligible < 0 ? FILE_ERROR : PREREQ_MISSING;
+    }
 
-    char temp_file[] = "../database/courses_temp.csv";
-    FILE *temp = fopen(temp_file, "w");
+    // 4) Timetable clash: checked against the student's interval index
+    int clash = schedule_check(student_id, course_code, student_enrolled);
+    trace_phase(trace, "schedule_check");
+    if (clash) {
+        txn_abort(&txn);
+        return clash < 0 ? FILE_ERROR : SCHEDULE_CONFLICT;
+    }
+
+    // 5) Full course: queue the student instead
+    if (enrolled >= cap) {
+        Waitlist w = { .course_id = course_id };
+        int status = waitlist_load(&w, 1);
+        if (status == SUCCESS && waitlist_push(&w, student_id) < 0) status = FILE_ERROR;
+        if (status == SUCCESS) status = waitlist_stage(&txn, &w, 1);
+        waitlist_free(&w, 1);
+        trace_phase(trace, "waitlist_rewrite");
+
+        if (status != SUCCESS) {
+            txn_abort(&txn);
+            return status;
+        }
+        status = txn_commit(&txn);
+        trace_phase(trace, "commit");
+        return status == SUCCESS ? WAITLISTED : status;
+    }
+
+    // 6) Stage courses file - add student to course's students list
+    cf = snapshot_open(DB_COURSES);
+    FILE *temp = cf < 0 ? NULL : txn_write(&txn, DB_COURSES);
     if (!temp) {
-        lock.l_type = F_UNLCK;
-        fcntl(cf, F_SETLK, &lock);
-        close(cf);
+        if (cf >= 0) close(cf);
+        txn_abort(&txn);
         return FILE_ERROR;
     }
     
     // Copy header
-    lseek(cf, 0, SEEK_SET);
-    read_line(cf, line, sizeof(line));
-    fprintf(temp, "%s", line);
+    if (read_row(cf, &row) > 0) fprintf(temp, "%s", row.data);
     
     // Copy all lines, updating the course
-    while (read_line(cf, line, sizeof(line)) > 0) {
+    while ((bytes_read = read_row(cf, &row)) > 0) {
+        trace_scan(trace, bytes_read);
+        line = row.data;
         int cid;
         if (sscanf(line, "%d", &cid) == 1 && cid == course_id) {
+            trace_rows(trace, 1);
             // Update this line
-            char new_students[MAX_BUFFER];
-            if (strlen(students_raw) > 0) {
-                snprintf(new_students, sizeof(new_students), "%s,%d", students_raw, student_id);
-            } else {
-                snprintf(new_students, sizeof(new_students), "%d", student_id);
-            }
-            
-            fprintf(temp, "%d,%s,%s,%d,%d,%d,%d,\"%s\"\n",
-                   course_id, course_code, name_c, cap, enrolled+1, credits, fid, new_students);
+            fprintf(temp, "%d,%s,%s,%d,%d,%d,%d,\"%s%s%d\"\n",
+                   course_id, course_code, name_c, cap, enrolled+1, credits, fid,
+                   students_raw, students_raw[0] ? "," : "", student_id);
         } else {
             // Copy line unchanged
             fprintf(temp, "%s", line);
         }
     }
     
-    fclose(temp);
-    
-    // Release lock
-    lock.l_type = F_UNLCK;
-    fcntl(cf, F_SETLK, &lock);
     close(cf);
-    
-    // Replace original file with temp file
-    if (rename(temp_file, DB_COURSES) < 0) {
-        unlink(temp_file);
-        return FILE_ERROR;
-    }
-
-    // 4) Update students file - add course to student's enrolled courses
-    sf = open(DB_STUDENTS, O_RDWR);
-    if (sf < 0) return FILE_ERROR;
-    
-    // Acquire exclusive lock for writing
-    memset(&lock, 0, sizeof(lock));
-    lock.l_type = F_WRLCK;
-    lock.l_whence = SEEK_SET;
-    lock.l_start = 0;
-    lock.l_len = 0; // Lock the entire file
-    
-    if (fcntl(sf, F_SETLKW, &lock) == -1) {
-        const char *err_msg = "Failed to acquire lock on students file\n";
-        write(STDERR_FILENO, err_msg, strlen(err_msg));
-        close(sf);
+    trace_phase(trace, "course_rewrite");
+    if (bytes_read < 0) {
+        txn_abort(&txn);
         return FILE_ERROR;
     }
 
-    char temp_student_file[] = "../database/students_temp.csv";
-    temp = fopen(temp_student_file, "w");
+    // 7) Stage students file - add course to student's enrolled courses
+    sf = snapshot_open(DB_STUDENTS);
+    temp = sf < 0 ? NULL : txn_write(&txn, DB_STUDENTS);
     if (!temp) {
-        lock.l_type = F_UNLCK;
-        fcntl(sf, F_SETLK, &lock);
-        close(sf);
+        if (sf >= 0) close(sf);
+        txn_abort(&txn);
         return FILE_ERROR;
     }
     
     // Copy header
-    lseek(sf, 0, SEEK_SET);
-    read_line(sf, line, sizeof(line));
-    fprintf(temp, "%s", line);
+    if (read_row(sf, &row) > 0) fprintf(temp, "%s", row.data);
     
     // Copy all lines, updating the student
-    while (read_line(sf, line, sizeof(line)) > 0) {
+    while ((bytes_read = read_row(sf, &row)) > 0) {
+        trace_scan(trace, bytes_read);
+        line = row.data;
         int sid;
         if (sscanf(line, "%d", &sid) == 1 && sid == student_id) {
+            trace_rows(trace, 1);
             // Update this line
-            char new_enrolled[MAX_BUFFER];
-            if (strlen(student_enrolled) > 0) {
-                snprintf(new_enrolled, sizeof(new_enrolled), "%s,%s", student_enrolled, course_code);
-            } else {
-                snprintf(new_enrolled, sizeof(new_enrolled), "%s", course_code);
-            }
-            
-            fprintf(temp, "%d,%s,%s,%s,%d,%s\n",
-                   student_id, student_name, student_email, student_pass, student_active, new_enrolled);
+            fprintf(temp, "%d,%s,%s,%s,%d,%s%s%s\n",
+                   student_id, student_name, student_email, student_pass, student_active,
+                   student_enrolled, student_enrolled[0] ? "," : "", course_code);
         } else {
             // Copy line unchanged
             fprintf(temp, "%s", line);
         }
     }
     
-    fclose(temp);
-    
-    // Release lock
-    lock.l_type = F_UNLCK;
-    fcntl(sf, F_SETLK, &lock);
     close(sf);
-    
-    // Replace original file with temp file
-    if (rename(temp_student_file, DB_STUDENTS) < 0) {
-        unlink(temp_student_file);
+    trace_phase(trace, "student_rewrite");
+    if (bytes_read < 0) {
+        txn_abort(&txn);
         return FILE_ERROR;
     }
+    
+    // 8) Publish both new versions together, count the seat in the statistics
+    //    while the course is still locked, then release the locks
+    stats_commit_begin();
+    int status = txn_publish(&txn);
+    if (status == SUCCESS) stats_enrolled(course_id, 1, 1);
+    stats_commit_end();
+    txn_release(&txn);
+    trace_phase(trace, "commit");
+    return status;
+}
 
-    return SUCCESS;
+/**
+ * @brief Enrolls a student in a course, updating both course and student records.
+ *
+ * Operations slower than ACADEMIA_SLOW_OP_MS are written to the slow-operation log.
+ * 
+ * @param student_id ID of the student.
+ * @param course_id ID of the course.
+ * @return int Status code (SUCCESS, WAITLISTED, ALREADY_ENROLLED, SCHEDULE_CONFLICT,
+ *         PREREQ_MISSING, FILE_ERROR, etc).
+ */
+static inline int enroll_course(int student_id, int course_id) {
+    OpTrace trace;
+    trace_begin(&trace, "enroll_course");
+    ArenaMark mark = arena_mark(request_arena());
+    int status = enroll_course_phases(student_id, course_id, &trace);
+    arena_rewind(request_arena(), mark);
+    if (status == SUCCESS) db_version_bump_courses(&course_id, 1);
+    trace_end(&trace, status);
+    return status;
+}
+
+/**
+ * @brief Checks whether a comma-separated list of ids contains an id.
+ */
+static inline int id_in_list(const char *list, int id) {
+    for (const char *p = list; *p; ) {
+        char *end;
+        long v = strtol(p, &end, 10);
+        if (end == p) {
+            p++;
+            continue;
+        }
+        if (v == id) return 1;
+        p = end;
+    }
+    return 0;
 }
 
 /**
  * @brief Unenrolls a student from a course, updating both course and student records.
  * 
  * This function removes a student from a course's enrollment list and removes the course
- * from the student's enrolled courses list. It uses file locking to ensure data consistency
- * during the update operations.
+ * from the student's enrolled courses list. The freed seat goes to the first student on
+ * the course's waitlist who meets its prerequisites and whose timetable it fits, who is
+ * enrolled by the same change. A student who is only
+ * waitlisted is taken off the waitlist instead. Courses, students and waitlists are
+ * locked once, checked and rewritten inside one transaction, so either every record
+ * changes or none does; concurrent readers are never blocked.
  * 
  * @param student_id ID of the student.
  * @param course_id ID of the course.
+ * @param trace Trace record receiving the phase breakdown.
  * @return int Status code (SUCCESS, NOT_ENROLLED, FILE_ERROR, etc).
  */
-int unenroll_course(int student_id, int course_id) {
+static inline int unenroll_course_phases(int student_id, int course_id, OpTrace *trace) {
+    Txn txn;
+    if (txn_begin(&txn, 3, DB_COURSES, DB_STUDENTS, DB_WAITLIST) != SUCCESS) return FILE_ERROR;
+    trace_phase(trace, "lock");
+
     // 1) Look up course code and check if student is enrolled
-    int cf = open(DB_COURSES, O_RDONLY);
-    if (cf < 0) return FILE_ERROR;
-    
-    // Acquire shared lock for reading
-    struct flock lock;
-    memset(&lock, 0, sizeof(lock));
-    lock.l_type = F_RDLCK;
-    lock.l_whence = SEEK_SET;
-    lock.l_start = 0;
-    lock.l_len = 0; // Lock the entire file
-    
-    if (fcntl(cf, F_SETLKW, &lock) == -1) {
-        perror("fcntl lock");
-        close(cf);
+    int cf = snapshot_open(DB_COURSES);
+    if (cf < 0) {
+        txn_abort(&txn);
         return FILE_ERROR;
     }
 
-    char line[MAX_LINE];
+    RowBuf row = {0};
+    char *line;
     char course_code[64] = "";
-    int found_course = 0;
+    int found_course = 0, student_found = 0;
     int cap, enrolled, credits, fid;
-    char name_c[128], students_list[MAX_BUFFER] = ""; // Increased buffer size
-    char updated_courses[MAX_COURSE_BUFFER] = ""; // Increased buffer size
-
-    // preserve header
+    char name_c[128];
+    char *students_list = "";
     ssize_t bytes_read;
-    if ((bytes_read = read_line(cf, line, sizeof(line))) > 0 && strncmp(line, "id,", 3)==0) {
-        // Check if the line already ends with a newline
-        if (line[bytes_read-1] == '\n') {
-            strcat(updated_courses, line);
-        } else {
-            strcat(updated_courses, line);
-            strcat(updated_courses, "\n");
-        }
-    } else {
-        lseek(cf, 0, SEEK_SET);
-    }
 
-    while ((bytes_read = read_line(cf, line, sizeof(line))) > 0) {
+    while ((bytes_read = read_row(cf, &row)) > 0) {
+        trace_scan(trace, bytes_read);
+        line = row.data;
         line[strcspn(line, "\r\n")] = '\0';
 
-        int cid;
+        int cid, list_at = -1;
         int fields = sscanf(line,
-            "%d,%63[^,],%127[^,],%d,%d,%d,%d,\"%511[^\"]\"",
-            &cid, course_code, name_c, &cap, &enrolled, &credits, &fid, students_list);
+            "%d,%63[^,],%127[^,],%d,%d,%d,%d,\"%n",
+            &cid, course_code, name_c, &cap, &enrolled, &credits, &fid, &list_at);
 
-        if (cid == course_id) {
+        if (fields >= 1 && cid == course_id) {
             found_course = 1;
             
             // Check if student is enrolled
-            int student_found = 0;
-            if (fields == 8 && strlen(students_list)) {
-                char temp_list[MAX_BUFFER]; // Increased buffer size
-                strcpy(temp_list, students_list);
-                char *tok = strtok(temp_list, ",");
-                while (tok) {
-                    if (atoi(tok) == student_id) {
-                        student_found = 1;
-                        break;
-                    }
-                    tok = strtok(NULL, ",");
+            if (fields == 7 && list_at >= 0) {
+                students_list = arena_strndup(request_arena(), line + list_at,
+                                              strcspn(line + list_at, "\""));
+                if (!students_list) {
+                    close(cf);
+                    txn_abort(&txn);
+                    return FILE_ERROR;
                 }
-            }
-            if (!student_found) {
-                // Release lock
-                lock.l_type = F_UNLCK;
-                fcntl(cf, F_SETLK, &lock);
-                close(cf);
-                return NOT_ENROLLED;
+                student_found = id_in_list(students_list, student_id);
             }
             break;
         }
     }
     
-    // Release lock
-    lock.l_type = F_UNLCK;
-    fcntl(cf, F_SETLK, &lock);
     close(cf);
     
-    if (!found_course) return COURSE_NOT_FOUND;
+    trace_phase(trace, "course_scan");
+    if (bytes_read < 0) {
+        txn_abort(&txn);
+        return FILE_ERROR;
+    }
+    if (!found_course) {
+        txn_abort(&txn);
+        return COURSE_NOT_FOUND;
+    }
 
-    // 2) Check if student exists and is enrolled in the course
-    int sf = open(DB_STUDENTS, O_RDONLY);
-    if (sf < 0) return FILE_ERROR;
-    
-    // Acquire shared lock for reading
-    memset(&lock, 0, sizeof(lock));
-    lock.l_type = F_RDLCK;
-    lock.l_whence = SEEK_SET;
-    lock.l_start = 0;
-    lock.l_len = 0; // Lock the entire file
-    
-    if (fcntl(sf, F_SETLKW, &lock) == -1) {
-        perror("fcntl lock");
-        close(sf);
+    Waitlist w = { .course_id = course_id };
+    if (waitlist_load(&w, 1) != SUCCESS) {
+        txn_abort(&txn);
+        return FILE_ERROR;
+    }
+
+    // A waitlisted student just leaves the waitlist
+    if (!student_found) {
+        int status = waitlist_remove(&w, student_id) ? waitlist_stage(&txn, &w, 1) : NOT_ENROLLED;
+        waitlist_free(&w, 1);
+        if (status != SUCCESS) {
+            txn_abort(&txn);
+            return status;
+        }
+        status = txn_commit(&txn);
+        trace_phase(trace, "commit");
+        return status;
+    }
+
+    // 2) Check if student exists and is enrolled in the course; note which
+    //    waitlisted students still exist
+    int sf = snapshot_open(DB_STUDENTS);
+    Arena *arena = request_arena();
+    char **waiting_courses = w.count ? arena_calloc(arena, w.count, sizeof(char *)) : NULL;
+    if (sf < 0 || (w.count && !waiting_courses)) {
+        if (sf >= 0) close(sf);
+        waitlist_free(&w, 1);
+        txn_abort(&txn);
         return FILE_ERROR;
     }
 
     int found_student = 0;
-    char student_enrolled[MAX_BUFFER] = ""; // Increased buffer size
     
-    while ((bytes_read = read_line(sf, line, sizeof(line))) > 0) {
-        int sid;
-        if (sscanf(line, "%d,%*[^,],%*[^,],%*[^,],%*d,%[^\n]", &sid, student_enrolled) >= 1) {
-            if (sid == student_id) {
-                found_student = 1;
-                // Check if enrolled in this course
-                if (!strstr(student_enrolled, course_code)) {
-                    // Release lock
-                    lock.l_type = F_UNLCK;
-                    fcntl(sf, F_SETLK, &lock);
-                    close(sf);
-                    return NOT_ENROLLED;
-                }
-                break;
+    while ((bytes_read = read_row(sf, &row)) > 0) {
+        trace_scan(trace, bytes_read);
+        line = row.data;
+        line[strcspn(line, "\r\n")] = '\0';
+
+        int sid, enrolled_at = -1;
+        if (sscanf(line, "%d,%*[^,],%*[^,],%*[^,],%*d,%n", &sid, &enrolled_at) < 1) continue;
+        const char *student_enrolled = enrolled_at >= 0 ? line + enrolled_at : "";
+
+        // Waitlisted students that exist get their enrolled courses recorded
+        int pos = waitlist_index(&w, sid);
+        if (pos && !waiting_courses[pos - 1]) waiting_courses[pos - 1] = arena_strdup(arena, student_enrolled);
+
+        if (sid == student_id) {
+            found_student = 1;
+            // Check if enrolled in this course
+            if (!strstr(student_enrolled, course_code)) {
+                close(sf);
+                waitlist_free(&w, 1);
+                txn_abort(&txn);
+                return NOT_ENROLLED;
             }
+            if (!w.count) break; // Nobody to promote
         }
     }
     
-    // Release lock
-    lock.l_type = F_UNLCK;
-    fcntl(sf, F_SETLK, &lock);
     close(sf);
     
-    if (!found_student) return USER_NOT_FOUND;
-
-    // 3) Update courses file - remove student from course's students list
-    cf = open(DB_COURSES, O_RDONLY);
-    if (cf < 0) return FILE_ERROR;
-    
-    // Acquire shared lock for reading
-    memset(&lock, 0, sizeof(lock));
-    lock.l_type = F_RDLCK;
-    lock.l_whence = SEEK_SET;
-    lock.l_start = 0;
-    lock.l_len = 0; // Lock the entire file
-    
-    if (fcntl(cf, F_SETLKW, &lock) == -1) {
-        perror("fcntl lock");
-        close(cf);
+    trace_phase(trace, "student_scan");
+    if (bytes_read < 0) {
+        waitlist_free(&w, 1);
+        txn_abort(&txn);
         return FILE_ERROR;
     }
-
-    updated_courses[0] = '\0';
-    if ((bytes_read = read_line(cf, line, sizeof(line))) > 0 && strncmp(line, "id,", 3)==0) {
-        // Check if the line already ends with a newline
-        if (line[bytes_read-1] == '\n') {
-            strcat(updated_courses, line);
-        } else {
-            strcat(updated_courses, line);
-            strcat(updated_courses, "\n");
+    int promoted = 0;
+    if (found_student) {
+        // The freed seat goes to the first waitlisted student who meets the
+        // prerequisites and whose timetable it fits. Students who no longer
+        // exist or already hold a seat are dropped; students it clashes for or
+        // who lack a prerequisite keep their place.
+        int kept = 0;
+        for (int i = 0; i < w.count; i++) {
+            int candidate = w.students[i];
+            if (promoted || !waiting_courses[i] || id_in_list(students_list, candidate)) {
+                if (promoted) w.students[kept++] = candidate;
+                continue;
+            }
+            if (prereq_check(candidate, course_code) == 1 &&
+                schedule_check(candidate, course_code, waiting_courses[i]) == 0) promoted = candidate;
+            else w.students[kept++] = candidate;
         }
-    } else {
-        lseek(cf, 0, SEEK_SET);
+        w.changed = kept != w.count;
+        w.count = kept;
+    }
+
+    if (!found_student) {
+        waitlist_free(&w, 1);
+        txn_abort(&txn);
+        return USER_NOT_FOUND;
+    }
+
+    // 3) Stage courses file - remove student from course's students list
+    cf = snapshot_open(DB_COURSES);
+    FILE *temp = cf < 0 ? NULL : txn_write(&txn, DB_COURSES);
+    if (!temp) {
+        if (cf >= 0) close(cf);
+        waitlist_free(&w, 1);
+        txn_abort(&txn);
+        return FILE_ERROR;
     }
 
-    while ((bytes_read = read_line(cf, line, sizeof(line))) > 0) {
+    while ((bytes_read = read_row(cf, &row)) > 0) {
+        trace_scan(trace, bytes_read);
+        line = row.data;
         line[strcspn(line, "\r\n")] = '\0';
 
         int cid;
-        if (sscanf(line, "%d", &cid) == 1) {
-            if (cid == course_id) {
-                // Remove student from students_list
-                char new_students[MAX_BUFFER] = ""; // Increased buffer size
-                char temp_list[MAX_BUFFER]; // Increased buffer size
-                strcpy(temp_list, students_list);
-                
-                char *tok = strtok(temp_list, ",");
-                int first = 1;
-                while (tok) {
-                    if (atoi(tok) != student_id) {
-                        if (!first) {
-                            strcat(new_students, ",");
-                        }
-                        strcat(new_students, tok);
-                        first = 0;
-                    }
-                    tok = strtok(NULL, ",");
-                }
-
-                char buf[MAX_COURSE_BUFFER]; // Increased buffer size
-                if (snprintf(buf, sizeof(buf),
-                    "%d,%s,%s,%d,%d,%d,%d,\"%s\"\n",
-                    cid, course_code, name_c, cap, enrolled-1, credits, fid, new_students) >= (int)sizeof(buf)) {
-                    // Buffer would overflow, handle error
-                    lock.l_type = F_UNLCK;
-                    fcntl(cf, F_SETLK, &lock);
-                    close(cf);
-                    return FILE_ERROR;
-                }
-                strcat(updated_courses, buf);
-            } else {
-                strcat(updated_courses, line);
-                strcat(updated_courses, "\n");
+        if (sscanf(line, "%d", &cid) == 1 && cid == course_id) {
+            trace_rows(trace, 1);
+            // Write the students list without the student, plus the promoted one
+            fprintf(temp, "%d,%s,%s,%d,%d,%d,%d,\"", cid, course_code, name_c, cap,
+                    enrolled - 1 + (promoted != 0), credits, fid);
+            int first = 1;
+            for (char *tok = strtok(students_list, ","); tok; tok = strtok(NULL, ",")) {
+                if (atoi(tok) == student_id) continue;
+                fprintf(temp, first ? "%s" : ",%s", tok);
+                first = 0;
             }
+            if (promoted) fprintf(temp, first ? "%d" : ",%d", promoted);
+            fputs("\"\n", temp);
+        } else {
+            // Header and other courses are copied unchanged
+            fprintf(temp, "%s\n", line);
         }
     }
     
-    // Release lock
-    lock.l_type = F_UNLCK;
-    fcntl(cf, F_SETLK, &lock);
     close(cf);
-
-    // Write back to courses file with exclusive lock
-    cf = open(DB_COURSES, O_WRONLY | O_TRUNC);
-    if (cf < 0) return FILE_ERROR;
-    
-    // Acquire exclusive lock for writing
-    memset(&lock, 0, sizeof(lock));
-    lock.l_type = F_WRLCK;
-    lock.l_whence = SEEK_SET;
-    lock.l_start = 0;
-    lock.l_len = 0; // Lock the entire file
-    
-    if (fcntl(cf, F_SETLKW, &lock) == -1) {
-        perror("fcntl lock");
-        close(cf);
+    trace_phase(trace, "course_rewrite");
+    if (bytes_read < 0) {
+        waitlist_free(&w, 1);
+        txn_abort(&txn);
         return FILE_ERROR;
     }
-    
-    write(cf, updated_courses, strlen(updated_courses));
-    
-    // Release lock
-    lock.l_type = F_UNLCK;
-    fcntl(cf, F_SETLK, &lock);
-    close(cf);
 
-    // 4) Update students file - remove course from student's enrolled courses
-    sf = open(DB_STUDENTS, O_RDONLY);
-    if (sf < 0) return FILE_ERROR;
-    
-    // Acquire shared lock for reading
-    memset(&lock, 0, sizeof(lock));
-    lock.l_type = F_RDLCK;
-    lock.l_whence = SEEK_SET;
-    lock.l_start = 0;
-    lock.l_len = 0; // Lock the entire file
-    
-    if (fcntl(sf, F_SETLKW, &lock) == -1) {
-        perror("fcntl lock");
-        close(sf);
+    // 4) Stage students file - remove course from student's enrolled courses
+    //    and add it to the promoted student's
+    sf = snapshot_open(DB_STUDENTS);
+    temp = sf < 0 ? NULL : txn_write(&txn, DB_STUDENTS);
+    if (!temp) {
+        if (sf >= 0) close(sf);
+        waitlist_free(&w, 1);
+        txn_abort(&txn);
         return FILE_ERROR;
     }
 
-    char updated_students[MAX_STUDENT_BUFFER] = ""; // Increased buffer size
-    if ((bytes_read = read_line(sf, line, sizeof(line))) > 0 && strncmp(line, "id,", 3)==0) {
-        // Check if the line already ends with a newline
-        if (line[bytes_read-1] == '\n') {
-            strcat(updated_students, line);
+    while ((bytes_read = read_row(sf, &row)) > 0) {
+        trace_scan(trace, bytes_read);
+        line = row.data;
+        line[strcspn(line, "\r\n")] = '\0';
+
+        int sid, active, enrolled_at = -1;
+        char name_s[64], email_s[64], pass[64];
+        int fields = sscanf(line, "%d,%63[^,],%63[^,],%63[^,],%d,%n", &sid, name_s, email_s, pass, &active, &enrolled_at);
+        if (fields >= 5 && sid == student_id) {
+            trace_rows(trace, 1);
+            // Write enrolled courses without this course directly to the new version
+            fprintf(temp, "%d,%s,%s,%s,%d,", sid, name_s, email_s, pass, active);
+            int first = 1;
+            char *enrolled_s = enrolled_at >= 0 ? line + enrolled_at : "";
+            for (char *tok = strtok(enrolled_s, ","); tok; tok = strtok(NULL, ",")) {
+                if (strcmp(tok, course_code) == 0) continue;
+                fprintf(temp, first ? "%s" : ",%s", tok);
+                first = 0;
+            }
+            fputc('\n', temp);
+        } else if (fields >= 1 && promoted && sid == promoted) {
+            trace_rows(trace, 1);
+            size_t len = strlen(line);
+            fprintf(temp, "%s%s%s\n", line, len && line[len - 1] == ',' ? "" : ",", course_code);
         } else {
-            strcat(updated_students, line);
-            strcat(updated_students, "\n");
+            // Header and other students are copied unchanged
+            fprintf(temp, "%s\n", line);
         }
+    }
+    
+    close(sf);
+    trace_phase(trace, "student_rewrite");
+    if (bytes_read < 0) {
+        waitlist_free(&w, 1);
+        txn_abort(&txn);
+        return FILE_ERROR;
+    }
+
+    // 5) Stage the shortened waitlist
+    int status = waitlist_stage(&txn, &w, 1);
+    waitlist_free(&w, 1);
+    if (status != SUCCESS) {
+        txn_abort(&txn);
+        return status;
+    }
+    trace_phase(trace, "waitlist_rewrite");
+
+    // 6) Publish every new version together, count the freed seat (and the
+    //    promoted student's) while the course is still locked, then release
+    stats_commit_begin();
+    status = txn_publish(&txn);
+    if (status == SUCCESS) stats_enrolled(course_id, promoted ? 0 : -1, promoted != 0);
+    stats_commit_end();
+    txn_release(&txn);
+    trace_phase(trace, "commit");
+    return status;
+}
+
+/**
+ * @brief Unenrolls a student from a course, updating both course and student records.
+ *
+ * Operations slower than ACADEMIA_SLOW_OP_MS are written to the slow-operation log.
+ * 
+ * @param student_id ID of the student.
+ * @param course_id ID of the course.
+ * @return int Status code (SUCCESS, NOT_ENROLLED, FILE_ERROR, etc).
+ */
+int unenroll_course(int student_id, int course_id) {
+    OpTrace trace;
+    trace_begin(&trace, "unenroll_course");
+    ArenaMark mark = arena_mark(request_arena());
+    int status = unenroll_course_phases(student_id, course_id, &trace);
+    arena_rewind(request_arena(), mark);
+    if (status == SUCCESS) db_version_bump_courses(&course_id, 1);
+    trace_end(&trace, status);
+    return status;
+}
+
+#define BATCH_ALL_OR_NOTHING 1   ///< batch_enroll() flag: apply every item or none
+
+/**
+ * @brief One enrollment change in a batch.
+ */
+typedef struct {
+    int student_id;
+    int course_id;
+    int enroll;     ///< 1 to enroll, 0 to unenroll
+    int status;     ///< Result: SUCCESS, WAITLISTED, ALREADY_ENROLLED, NOT_ENROLLED,
+                    ///< SCHEDULE_CONFLICT, PREREQ_MISSING, COURSE_NOT_FOUND or USER_NOT_FOUND
+} BatchItem;
+
+/**
+ * @brief Fields shared by every row a batch touches; first member of each row type.
+ */
+typedef struct {
+    int id;
+    int changed;            ///< 1 if the row must be rewritten
+    char *row;              ///< Copy of the line in the request arena, NULL if the row does not exist
+} BatchRow;
+
+/**
+ * @brief A course row touched by a batch, parsed in place.
+ */
+typedef struct {
+    BatchRow base;
+    StrId code;             ///< In the batch's string pool
+    char *name;
+    int cap, enrolled, credits, fid;
+    int loaded;             ///< enrolled as read from the table
+    int joins;              ///< Seats the batch granted
+    int *students;          ///< Enrolled student ids
+    int count, size;
+} BatchCourse;
+
+/**
+ * @brief A student row touched by a batch, parsed in place.
+ */
+typedef struct {
+    BatchRow base;
+    char *name, *email, *pass;
+    int active;
+    StrId *codes;           ///< Enrolled course codes, in the batch's string pool
+    int count, size;
+    IntervalIndex times;    ///< Timetable, built on first use
+    int times_ready;
+    uint64_t *met;          ///< Prerequisites met, loaded on first use
+} BatchStudent;
+
+/**
+ * @brief Everything a batch has loaded, shared by the apply steps.
+ */
+typedef struct {
+    BatchStudent *students;
+    int student_count;
+    CourseSchedule *schedules;  ///< Every course's meeting times, sorted by code
+    int schedule_count;
+    const PrereqGraph *prereqs;
+    const StrPool *codes;       ///< Course codes of the loaded rows
+} BatchCtx;
+
+static int batch_id_cmp(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Sorts ids and removes duplicates.
+ * @return Number of distinct ids.
+ */
+static inline int batch_unique(int *ids, int count) {
+    qsort(ids, count, sizeof(int), batch_id_cmp);
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        if (n == 0 || ids[n - 1] != ids[i]) ids[n++] = ids[i];
+    }
+    return n;
+}
+
+/**
+ * @brief Finds a row by id in an array of rows sorted by id.
+ */
+static inline void *batch_find(void *rows, int count, size_t size, int id) {
+    return bsearch(&id, rows, count, size, batch_id_cmp);
+}
+
+/**
+ * @brief Grows a pointer-sized or int array so it can hold one more element.
+ * @return SUCCESS or FAILURE if out of memory.
+ */
+static inline int batch_reserve(void **array, int count, int *size, size_t elem) {
+    if (count < *size) return SUCCESS;
+    int bigger = *size ? *size * 2 : 8;
+    void *p = realloc(*array, bigger * elem);
+    if (!p) return FAILURE;
+    *array = p;
+    *size = bigger;
+    return SUCCESS;
+}
+
+/**
+ * @brief Splits the next comma-separated field off a row in place.
+ */
+static inline char *batch_field(char **p) {
+    char *field = *p;
+    char *comma = strchr(field, ',');
+    if (comma) {
+        *comma = '\0';
+        *p = comma + 1;
     } else {
-        lseek(sf, 0, SEEK_SET);
+        *p = field + strlen(field);
+    }
+    return field;
+}
+
+static inline int batch_parse_course(BatchCourse *c, char *row, StrPool *codes) {
+    char *p = row;
+    batch_field(&p);
+    c->base.row = row;
+    c->code = strpool_intern(codes, batch_field(&p));
+    if (c->code == STR_NONE) return FAILURE;
+    c->name = batch_field(&p);
+    c->cap = atoi(batch_field(&p));
+    c->enrolled = c->loaded = atoi(batch_field(&p));
+    c->credits = atoi(batch_field(&p));
+    c->fid = atoi(batch_field(&p));
+
+    // The rest is the quoted students list
+    for (char *tok = strtok(p, ",\" "); tok; tok = strtok(NULL, ",\" ")) {
+        if (batch_reserve((void **)&c->students, c->count, &c->size, sizeof(int)) != SUCCESS) return FAILURE;
+        c->students[c->count++] = atoi(tok);
     }
+    return SUCCESS;
+}
 
-    while ((bytes_read = read_line(sf, line, sizeof(line))) > 0) {
+static inline int batch_parse_student(BatchStudent *s, char *row, StrPool *codes) {
+    char *p = row;
+    batch_field(&p);
+    s->base.row = row;
+    s->name = batch_field(&p);
+    s->email = batch_field(&p);
+    s->pass = batch_field(&p);
+    s->active = atoi(batch_field(&p));
+
+    for (char *tok = strtok(p, ", "); tok; tok = strtok(NULL, ", ")) {
+        if (batch_reserve((void **)&s->codes, s->count, &s->size, sizeof(StrId)) != SUCCESS) return FAILURE;
+        if ((s->codes[s->count++] = strpool_intern(codes, tok)) == STR_NONE) return FAILURE;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Reads one table and keeps a parsed copy of the rows whose id is wanted.
+ *
+ * @param path  Table path.
+ * @param rows  Rows sorted by id, with only the id set.
+ * @param count Number of rows.
+ * @param size  Size of one row structure.
+ * @param parse Parser for a matching line.
+ * @param codes String pool the course codes are interned in.
+ * @param trace Trace record.
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int batch_load(const char *path, void *rows, int count, size_t size,
+                             int (*parse)(void *, char *, StrPool *), StrPool *codes, OpTrace *trace) {
+    FILE *file = snapshot_fopen(path);
+    if (!file) return FILE_ERROR;
+
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    int status = SUCCESS;
+
+    while (status == SUCCESS && (len = getline(&line, &cap, file)) > 0) {
+        trace_scan(trace, len);
         line[strcspn(line, "\r\n")] = '\0';
 
-        int sid, active;
-        char name_s[64], email_s[64], pass[64], enrolled_s[MAX_BUFFER] = ""; // Increased buffer size
-        if (sscanf(line, "%d,%[^,],%[^,],%[^,],%d,%[^\n]", &sid, name_s, email_s, pass, &active, enrolled_s) >= 5) {
-            if (sid == student_id) {
-                // Remove course from enrolled courses
-                char new_enrolled[MAX_BUFFER] = ""; // Increased buffer size
-                char temp_ec[MAX_BUFFER]; // Increased buffer size
-                strcpy(temp_ec, enrolled_s);
-                
-                char *tok = strtok(temp_ec, ",");
-                int first = 1;
-                while (tok) {
-                    if (strcmp(tok, course_code) != 0) {
-                        if (!first) {
-                            strcat(new_enrolled, ",");
-                        }
-                        strcat(new_enrolled, tok);
-                        first = 0;
-                    }
-                    tok = strtok(NULL, ",");
-                }
+        char *end;
+        long id = strtol(line, &end, 10);
+        if (end == line || *end != ',') continue; // Header or malformed row
 
-                char buf[MAX_STUDENT_BUFFER]; // Increased buffer size
-                if (snprintf(buf, sizeof(buf),
-                         "%d,%s,%s,%s,%d,%s\n",
-                         sid, name_s, email_s, pass, active, new_enrolled) >= (int)sizeof(buf)) {
-                    // Buffer would overflow, handle error
-                    lock.l_type = F_UNLCK;
-                    fcntl(sf, F_SETLK, &lock);
-                    close(sf);
-                    return FILE_ERROR;
-                }
-                strcat(updated_students, buf);
-            } else {
-                strcat(updated_students, line);
-                strcat(updated_students, "\n");
-            }
+        BatchRow *row = batch_find(rows, count, size, (int)id);
+        if (!row || row->row) continue; // Not wanted, or a duplicate id
+
+        char *copy = arena_strdup(request_arena(), line);
+        if (!copy || parse(row, copy, codes) != SUCCESS) status = FILE_ERROR;
+    }
+
+    free(line);
+    fclose(file);
+    return status;
+}
+
+static inline int batch_has_student(const BatchCourse *c, int student_id) {
+    for (int i = 0; i < c->count; i++) {
+        if (c->students[i] == student_id) return 1;
+    }
+    return 0;
+}
+
+static inline int batch_has_code(const BatchStudent *s, StrId code) {
+    for (int i = 0; i < s->count; i++) {
+        if (s->codes[i] == code) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Enrolls a loaded student in a loaded course.
+ * @return SUCCESS or FILE_ERROR if out of memory.
+ */
+static inline int batch_add(BatchCourse *c, BatchStudent *s) {
+    if (batch_reserve((void **)&c->students, c->count, &c->size, sizeof(int)) != SUCCESS ||
+        batch_reserve((void **)&s->codes, s->count, &s->size, sizeof(StrId)) != SUCCESS) return FILE_ERROR;
+    c->students[c->count++] = s->base.id;
+    s->codes[s->count++] = c->code;
+    c->enrolled++;
+    c->joins++;
+    c->base.changed = s->base.changed = 1;
+    return SUCCESS;
+}
+
+/**
+ * @brief Checks a course against a student's timetable, building it on first use.
+ * @return 1 on a clash, 0 if the course fits, FILE_ERROR if out of memory.
+ */
+static inline int batch_clashes(BatchStudent *s, const BatchCourse *c, const BatchCtx *ctx) {
+    if (!s->times_ready) {
+        s->times.count = 0;
+        for (int i = 0; i < s->count; i++) {
+            const CourseSchedule *cs = schedule_find(ctx->schedules, ctx->schedule_count,
+                                                     strpool_get(ctx->codes, s->codes[i]));
+            if (schedule_index_course(&s->times, cs) != SUCCESS) return FILE_ERROR;
         }
+        s->times_ready = 1;
     }
-    
-    // Release lock
-    lock.l_type = F_UNLCK;
-    fcntl(sf, F_SETLK, &lock);
-    close(sf);
+    return schedule_conflicts(&s->times, schedule_find(ctx->schedules, ctx->schedule_count,
+                                                       strpool_get(ctx->codes, c->code)));
+}
 
-    // Write back to students file with exclusive lock
-    sf = open(DB_STUDENTS, O_WRONLY | O_TRUNC);
-    if (sf < 0) return FILE_ERROR;
-    
-    // Acquire exclusive lock for writing
-    memset(&lock, 0, sizeof(lock));
-    lock.l_type = F_WRLCK;
-    lock.l_whence = SEEK_SET;
-    lock.l_start = 0;
-    lock.l_len = 0; // Lock the entire file
-    
-    if (fcntl(sf, F_SETLKW, &lock) == -1) {
-        perror("fcntl lock");
-        close(sf);
+/**
+ * @brief Checks a student's prerequisites for a course, loading their met set on first use.
+ * @return 1 if eligible, 0 if not, FILE_ERROR on failure.
+ */
+static inline int batch_eligible(BatchStudent *s, const BatchCourse *c, const BatchCtx *ctx) {
+    const char *code = strpool_get(ctx->codes, c->code);
+    if (prereq_index(ctx->prereqs, code) < 0) return 1;
+    if (!s->met) {
+        char completed[MAX_BUFFER];
+        if (prereq_completed(s->base.id, completed, sizeof(completed)) != SUCCESS) return FILE_ERROR;
+        if (!(s->met = prereq_met(ctx->prereqs, completed))) return FILE_ERROR;
+    }
+    return prereq_eligible(ctx->prereqs, s->met, code);
+}
+
+/**
+ * @brief Enrolls a loaded student in a loaded course and books its meeting times.
+ * @return SUCCESS or FILE_ERROR if out of memory.
+ */
+static inline int batch_book(BatchCourse *c, BatchStudent *s, const BatchCtx *ctx) {
+    if (batch_add(c, s) != SUCCESS) return FILE_ERROR;
+    const CourseSchedule *cs = schedule_find(ctx->schedules, ctx->schedule_count, strpool_get(ctx->codes, c->code));
+    return schedule_index_course(&s->times, cs) == SUCCESS ? SUCCESS : FILE_ERROR;
+}
+
+/**
+ * @brief Fills free seats of a course from the head of its waitlist.
+ *
+ * Waitlisted students that no longer exist or already hold a seat are dropped;
+ * students the course clashes for or who lack a prerequisite keep their place.
+ *
+ * @return SUCCESS or FILE_ERROR if out of memory.
+ */
+static inline int batch_promote(BatchCourse *c, Waitlist *w, const BatchCtx *ctx) {
+    int kept = 0, status = SUCCESS;
+    for (int i = 0; i < w->count; i++) {
+        int candidate = w->students[i];
+        if (c->enrolled >= c->cap || status != SUCCESS) {
+            w->students[kept++] = candidate;
+            continue;
+        }
+
+        BatchStudent *s = batch_find(ctx->students, ctx->student_count, sizeof(BatchStudent), candidate);
+        if (!s || !s->base.row || batch_has_student(c, candidate) || batch_has_code(s, c->code)) continue;
+
+        int eligible = batch_eligible(s, c, ctx);
+        int clash = eligible == 1 ? batch_clashes(s, c, ctx) : 0;
+        if (eligible < 0 || clash < 0) status = FILE_ERROR;
+        else if (!eligible || clash) w->students[kept++] = candidate;
+        else status = batch_book(c, s, ctx);
+    }
+    if (kept != w->count) w->changed = 1;
+    w->count = kept;
+    return status;
+}
+
+/**
+ * @brief Applies one batch item to the loaded rows.
+ *
+ * An enrollment the student lacks the prerequisites for or that clashes with
+ * their timetable is refused and one in a full course puts the student on the
+ * waitlist; an unenrollment of a
+ * waitlisted student takes them off it, and a real unenrollment promotes the
+ * head of the waitlist.
+ *
+ * @return The item's status.
+ */
+static inline int batch_apply(BatchItem *item, BatchCourse *c, Waitlist *w, BatchStudent *s, const BatchCtx *ctx) {
+    if (!c || !c->base.row) return COURSE_NOT_FOUND;
+    if (!s || !s->base.row) return USER_NOT_FOUND;
+
+    int in_course = batch_has_student(c, s->base.id);
+    int in_student = batch_has_code(s, c->code);
+
+    if (item->enroll) {
+        if (in_course || in_student) return ALREADY_ENROLLED;
+        int eligible = batch_eligible(s, c, ctx);
+        if (eligible != 1) return eligible < 0 ? FILE_ERROR : PREREQ_MISSING;
+        int clash = batch_clashes(s, c, ctx);
+        if (clash) return clash < 0 ? FILE_ERROR : SCHEDULE_CONFLICT;
+        if (c->enrolled >= c->cap) return waitlist_push(w, s->base.id) < 0 ? FILE_ERROR : WAITLISTED;
+        return batch_book(c, s, ctx);
+    }
+
+    if (!in_course || !in_student) return waitlist_remove(w, s->base.id) ? SUCCESS : NOT_ENROLLED;
+    int k = 0;
+    for (int i = 0; i < c->count; i++) {
+        if (c->students[i] != s->base.id) c->students[k++] = c->students[i];
+    }
+    c->count = k;
+    k = 0;
+    for (int i = 0; i < s->count; i++) {
+        if (s->codes[i] != c->code) s->codes[k++] = s->codes[i];
+    }
+    s->count = k;
+    c->enrolled--;
+    c->base.changed = s->base.changed = 1;
+    s->times_ready = 0; // Rebuilt without this course on next use
+    return batch_promote(c, w, ctx);
+}
+
+/**
+ * @brief Records every course's committed change in the enrollment statistics.
+ */
+static inline void batch_record_stats(const BatchCourse *courses, int count) {
+    for (int i = 0; i < count; i++) {
+        const BatchCourse *c = &courses[i];
+        if (c->base.row && (c->enrolled != c->loaded || c->joins)) {
+            stats_enrolled(c->base.id, c->enrolled - c->loaded, c->joins);
+        }
+    }
+}
+
+/**
+ * @brief Stages a new version of a table with the changed rows replaced.
+ */
+static inline int batch_rewrite(Txn *txn, const char *path, void *rows, int count, size_t size,
+                                void (*emit)(FILE *, const void *, const StrPool *), const StrPool *codes,
+                                OpTrace *trace) {
+    FILE *in = snapshot_fopen(path);
+    FILE *out = in ? txn_write(txn, path) : NULL;
+    if (!out) {
+        if (in) fclose(in);
         return FILE_ERROR;
     }
-    
-    write(sf, updated_students, strlen(updated_students));
-    
-    // Release lock
-    lock.l_type = F_UNLCK;
-    fcntl(sf, F_SETLK, &lock);
-    close(sf);
 
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+
+    while ((len = getline(&line, &cap, in)) > 0) {
+        trace_scan(trace, len);
+        char *end;
+        long id = strtol(line, &end, 10);
+        BatchRow *row = (end != line && *end == ',') ? batch_find(rows, count, size, (int)id) : NULL;
+
+        if (row && row->changed) {
+            trace_rows(trace, 1);
+            emit(out, row, codes);
+            row->changed = 0; // Duplicate ids keep their old rows
+        } else {
+            fputs(line, out);
+            if (line[len - 1] != '\n') fputc('\n', out);
+        }
+    }
+
+    free(line);
+    fclose(in);
     return SUCCESS;
 }
 
+static inline void batch_emit_course(FILE *out, const void *row, const StrPool *codes) {
+    const BatchCourse *c = row;
+    fprintf(out, "%d,%s,%s,%d,%d,%d,%d,\"", c->base.id, strpool_get(codes, c->code), c->name, c->cap, c->enrolled,
+            c->credits, c->fid);
+    for (int i = 0; i < c->count; i++) fprintf(out, i ? ",%d" : "%d", c->students[i]);
+    fputs("\"\n", out);
+}
+
+static inline void batch_emit_student(FILE *out, const void *row, const StrPool *codes) {
+    const BatchStudent *s = row;
+    fprintf(out, "%d,%s,%s,%s,%d,", s->base.id, s->name, s->email, s->pass, s->active);
+    for (int i = 0; i < s->count; i++) fprintf(out, i ? ",%s" : "%s", strpool_get(codes, s->codes[i]));
+    fputc('\n', out);
+}
+
+static int batch_parse_course_row(void *row, char *line, StrPool *codes) {
+    return batch_parse_course(row, line, codes);
+}
+
+static int batch_parse_student_row(void *row, char *line, StrPool *codes) {
+    return batch_parse_student(row, line, codes);
+}
+
 /**
- * @brief Displays all courses the student is currently enrolled in, formatted as a table.
+ * @brief Applies a list of enroll/unenroll changes in one transaction.
+ *
+ * The courses, students and waitlist tables are locked once for the whole
+ * batch. Each table is scanned once to load just the rows the batch touches,
+ * the items are applied in order in memory, and each table is then rewritten
+ * once, so the cost no longer grows with one full rewrite per item. Items are
+ * checked like enroll_course() and unenroll_course(): enrollments that clash
+ * with the student's timetable are refused, enrollments in a full course are
+ * waitlisted, and seats freed by the batch are given to waitlisted students.
+ *
+ * @param items Changes to apply; each item's status is filled in.
+ * @param count Number of items.
+ * @param flags BATCH_ALL_OR_NOTHING to roll everything back unless every item
+ *              succeeds.
+ * @param trace Trace record receiving the phase breakdown.
+ * @return SUCCESS once the changes are committed, FILE_ERROR, or with
+ *         BATCH_ALL_OR_NOTHING the status of the first item that did not
+ *         succeed (then nothing is applied).
+ */
+static inline int batch_enroll_phases(BatchItem *items, int count, int flags, OpTrace *trace) {
+    if (count <= 0) return SUCCESS;
+
+    // Row arrays and row copies live in the request arena
+    Arena *arena = request_arena();
+    int *course_ids = arena_alloc(arena, count * sizeof(int));
+    if (!course_ids) return FILE_ERROR;
+    for (int i = 0; i < count; i++) course_ids[i] = items[i].course_id;
+    int course_count = batch_unique(course_ids, count);
+
+    BatchCourse *courses = arena_calloc(arena, course_count, sizeof(BatchCourse));
+    Waitlist *lists = arena_calloc(arena, course_count, sizeof(Waitlist));
+    for (int i = 0; courses && lists && i < course_count; i++) {
+        courses[i].base.id = lists[i].course_id = course_ids[i];
+    }
+
+    BatchStudent *students = NULL;
+    int student_count = 0;
+
+    Txn txn;
+    int status = (courses && lists) ? txn_begin(&txn, 3, DB_COURSES, DB_STUDENTS, DB_WAITLIST) : FILE_ERROR;
+    if (status != SUCCESS) return FILE_ERROR;
+    trace_phase(trace, "lock");
+
+    // 1) One scan per table loads every row the batch touches, including the
+    //    waitlisted students who may be promoted
+    StrPool codes = {0};
+    status = batch_load(DB_COURSES, courses, course_count, sizeof(BatchCourse), batch_parse_course_row, &codes, trace);
+    if (status == SUCCESS) status = waitlist_load(lists, course_count);
+    trace_phase(trace, "course_scan");
+
+    if (status == SUCCESS) {
+        int waiting = 0;
+        for (int i = 0; i < course_count; i++) waiting += lists[i].count;
+
+        int *student_ids = arena_alloc(arena, (count + waiting) * sizeof(int));
+        if (student_ids) {
+            for (int i = 0; i < count; i++) student_ids[student_count++] = items[i].student_id;
+            for (int i = 0; i < course_count; i++) {
+                for (int k = 0; k < lists[i].count; k++) student_ids[student_count++] = lists[i].students[k];
+            }
+            student_count = batch_unique(student_ids, student_count);
+            students = arena_calloc(arena, student_count, sizeof(BatchStudent));
+            for (int i = 0; students && i < student_count; i++) students[i].base.id = student_ids[i];
+        }
+        status = students ? batch_load(DB_STUDENTS, students, student_count, sizeof(BatchStudent),
+                                       batch_parse_student_row, &codes, trace) : FILE_ERROR;
+    }
+    trace_phase(trace, "student_scan");
+
+    // Meeting times of every course, for the students' timetables, and the
+    // prerequisite graph
+    BatchCtx ctx = { students, student_count, NULL, 0, prereq_get(), &codes };
+    if (status == SUCCESS) {
+        ctx.schedule_count = schedule_load(&ctx.schedules, -1);
+        if (ctx.schedule_count < 0 || !ctx.prereqs) status = FILE_ERROR;
+    }
+
+    // 2) Apply the items in order
+    for (int i = 0; i < count && status == SUCCESS; i++) {
+        BatchCourse *c = batch_find(courses, course_count, sizeof(BatchCourse), items[i].course_id);
+        BatchStudent *s = batch_find(students, student_count, sizeof(BatchStudent), items[i].student_id);
+        Waitlist *w = waitlist_find(lists, course_count, items[i].course_id);
+        items[i].status = batch_apply(&items[i], c, w, s, &ctx);
+
+        if (items[i].status == FILE_ERROR) status = FILE_ERROR;
+        else if (items[i].status != SUCCESS && (flags & BATCH_ALL_OR_NOTHING)) status = items[i].status;
+    }
+    trace_phase(trace, "apply");
+
+    // 3) One rewrite per changed table, then publish them together
+    int changed = 0;
+    for (int i = 0; i < course_count; i++) changed |= courses[i].base.changed;
+
+    if (status == SUCCESS && changed) {
+        status = batch_rewrite(&txn, DB_COURSES, courses, course_count, sizeof(BatchCourse), batch_emit_course, &codes,
+                               trace);
+        trace_phase(trace, "course_rewrite");
+    }
+    if (status == SUCCESS && changed) {
+        status = batch_rewrite(&txn, DB_STUDENTS, students, student_count, sizeof(BatchStudent), batch_emit_student,
+                               &codes, trace);
+        trace_phase(trace, "student_rewrite");
+    }
+    if (status == SUCCESS) status = waitlist_stage(&txn, lists, course_count);
+    if (status == SUCCESS) {
+        stats_commit_begin();
+        status = txn_publish(&txn);
+        if (status == SUCCESS) batch_record_stats(courses, course_count);
+        stats_commit_end();
+        txn_release(&txn);
+        trace_phase(trace, "commit");
+    } else {
+        txn_abort(&txn);
+    }
+
+    for (int i = 0; i < course_count; i++) free(courses[i].students);
+    for (int i = 0; students && i < student_count; i++) {
+        free(students[i].codes);
+        interval_index_free(&students[i].times);
+        free(students[i].met);
+    }
+    free(ctx.schedules);
+    waitlist_free(lists, course_count);
+    strpool_free(&codes);
+    return status;
+}
+
+/**
+ * @brief Applies a list of enroll/unenroll changes in one transaction.
+ *
+ * Operations slower than ACADEMIA_SLOW_OP_MS are written to the slow-operation log.
+ *
+ * @param items Changes to apply; each item's status is filled in.
+ * @param count Number of items.
+ * @param flags 0, or BATCH_ALL_OR_NOTHING.
+ * @return int Status code (see batch_enroll_phases()).
+ */
+static inline int batch_enroll(BatchItem *items, int count, int flags) {
+    OpTrace trace;
+    trace_begin(&trace, "batch_enroll");
+    ArenaMark mark = arena_mark(request_arena());
+    int status = batch_enroll_phases(items, count, flags, &trace);
+    arena_rewind(request_arena(), mark);
+
+    // Announce the courses whose enrolled counts changed
+    int *changed = arena_alloc(request_arena(), count * sizeof(int));
+    int applied = 0;
+    for (int i = 0; i < count && status == SUCCESS; i++) {
+        if (items[i].status != SUCCESS) continue;
+        if (changed) changed[applied] = items[i].course_id;
+        applied++;
+    }
+    if (applied) db_version_bump_courses(changed, changed ? applied : 0);
+    arena_rewind(request_arena(), mark);
+
+    trace_end(&trace, status);
+    return status;
+}
+
+/**
+ * @brief Renders all courses the student is currently enrolled in as a table.
  * 
+ * @param out Output.
  * @param student_id ID of the student.
  * @return int SUCCESS on success, or FILE_ERROR / USER_NOT_FOUND.
  */
-static inline int view_enrollments_st(int student_id) {
-    FILE *student_fp = fopen(DB_STUDENTS, "r");
+static inline int render_enrollments_st(RenderBuf *out, int student_id) {
+    // Snapshot reads: no locks are taken, so enrollment writers are never stalled
+    FILE *student_fp = snapshot_fopen(DB_STUDENTS);
     if (!student_fp) {
         perror("Error opening students file");
         return FILE_ERROR;
     }
-    int student_fp_fd = fileno(student_fp);
-    if (flock(student_fp_fd, LOCK_SH) == -1) {
-        perror("flock");
-        fclose(student_fp);
-        return FILE_ERROR;
-    }
 
     char line[MAX_LINE];
     Student student;
@@ -969,13 +1562,13 @@ static inline int view_enrollments_st(int student_id) {
             }
         }
     }
-    flock(student_fp_fd, LOCK_UN);
     fclose(student_fp);
 
     if (!found) {
-        printf("\n╔════════════════════════════════════════════════╗");
-        printf("\n║ Error: Student with ID %d not found in system. ║", student_id);
-        printf("\n╚════════════════════════════════════════════════╝\n");
+        render_text(out, "\n");
+        render_rule(out, &student_message_box, RULE_TOP);
+        render_line(out, &student_message_box, "Error: Student with ID %d not found in system.", student_id);
+        render_rule(out, &student_message_box, RULE_BOTTOM);
         return USER_NOT_FOUND;
     }
 
@@ -987,44 +1580,32 @@ static inline int view_enrollments_st(int student_id) {
     if (student.enrolled_courses[0] != '\0') {
         char *token = strtok(student.enrolled_courses, ",");
         while (token && course_count < 64) {
-            tokens[course_count++] = strdup(token);
+            tokens[course_count++] = token;
             token = strtok(NULL, ",");
         }
     }
 
     if (course_count == 0) {
-        printf("\n╔═══════════════════════════════════════════════════════════╗");
-        printf("\n║ You are not currently enrolled in any courses.            ║");
-        printf("\n║ Use the 'Enroll in Course' option to register for classes.║");
-        printf("\n╚═══════════════════════════════════════════════════════════╝\n");
+        render_text(out, "\n");
+        render_rule(out, &student_message_box, RULE_TOP);
+        render_line(out, &student_message_box, "You are not currently enrolled in any courses.");
+        render_line(out, &student_message_box, "Use the 'Enroll in Course' option to register for classes.");
+        render_rule(out, &student_message_box, RULE_BOTTOM);
         return SUCCESS;
     }
 
-    FILE *courses_fp = fopen(DB_COURSES, "r");
+    FILE *courses_fp = snapshot_fopen(DB_COURSES);
     if (!courses_fp) {
         perror("Error opening courses file");
-        // Free allocated memory before returning
-        for (int i = 0; i < course_count; ++i) {
-            free(tokens[i]);
-        }
-        return FILE_ERROR;
-    }
-    int courses_fp_fd = fileno(courses_fp);
-    if (flock(courses_fp_fd, LOCK_SH) == -1) {
-        perror("flock");
-        fclose(courses_fp);
-        // Free allocated memory before returning
-        for (int i = 0; i < course_count; ++i) {
-            free(tokens[i]);
-        }
         return FILE_ERROR;
     }
 
-    printf("\n╔═══════════════════════════════════════════════════════════════════════════════════════════╗");
-    printf("\n║                                  YOUR ENROLLED COURSES                                    ║");
-    printf("\n╠═══════════╦═══════════╦════════════════════════════════╦═══════════╦═════════════════════╣");
-    printf("\n║ Course ID ║   Code    ║          Course Name           ║  Credits  ║       Faculty       ║");
-    printf("\n╠═══════════╬═══════════╬════════════════════════════════╬═══════════╬═════════════════════╣");
+    render_text(out, "\n");
+    render_rule(out, &enrolled_box, RULE_TOP);
+    render_title(out, &enrolled_box, "YOUR ENROLLED COURSES");
+    render_rule(out, &enrolled_box, RULE_SPLIT);
+    render_header(out, &enrolled_box);
+    render_rule(out, &enrolled_box, RULE_MID);
 
     int found_courses = 0;
     while (fgets(line, sizeof(line), courses_fp)) {
@@ -1039,31 +1620,23 @@ static inline int view_enrollments_st(int student_id) {
                     found_courses++;
                     // Look up faculty name
                     char faculty_name[100] = "Unknown";
-                    FILE *fac_fp = fopen(DB_FACULTY, "r");
+                    FILE *fac_fp = snapshot_fopen(DB_FACULTY);
                     if (fac_fp) {
-                        int fac_fp_fd = fileno(fac_fp);
-                        if (flock(fac_fp_fd, LOCK_SH) == -1) {
-                            perror("flock");
-                            fclose(fac_fp);
-                        } else {
-                            char fline[MAX_LINE];
-                            while (fgets(fline, sizeof(fline), fac_fp)) {
-                                int fid;
-                                char *ftok = strtok(fline, ",");
-                                if (ftok) fid = atoi(ftok);
-                                if (fid == f_id) {
-                                    ftok = strtok(NULL, ",");
-                                    if (ftok) strcpy(faculty_name, ftok);
-                                    break;
-                                }
+                        char fline[MAX_LINE];
+                        while (fgets(fline, sizeof(fline), fac_fp)) {
+                            int fid = 0;
+                            char *ftok = strtok(fline, ",");
+                            if (ftok) fid = atoi(ftok);
+                            if (fid == f_id) {
+                                ftok = strtok(NULL, ",");
+                                if (ftok) strcpy(faculty_name, ftok);
+                                break;
                             }
-                            flock(fac_fp_fd, LOCK_UN);
                         }
                         fclose(fac_fp);
                     }
 
-                    printf("\n║ %-9d ║ %-9s ║ %-30s ║ %-9d ║ %-19s ║", 
-                           id, code, cname, credits, faculty_name);
+                    render_row(out, &enrolled_box, id, code, cname, credits, faculty_name);
                     break;
                 }
             }
@@ -1072,85 +1645,134 @@ static inline int view_enrollments_st(int student_id) {
 
     // If no courses were found in the database, show a message
     if (found_courses == 0) {
-        printf("\n║                      No matching courses found in the database                        ║");
+        render_rule(out, &enrolled_box, RULE_MERGE);
+        render_title(out, &enrolled_box, "No matching courses found in the database");
+        render_rule(out, &enrolled_box, RULE_BOTTOM);
+    } else {
+        render_rule(out, &enrolled_box, RULE_BOTTOM_COLUMNS);
     }
 
-    printf("\n╚═══════════╩═══════════╩════════════════════════════════╩═══════════╩═════════════════════╝\n");
-
-    flock(courses_fp_fd, LOCK_UN);
     fclose(courses_fp);
-
-    for (int i = 0; i < course_count; ++i)
-        free(tokens[i]);
-
     return SUCCESS;
 }
 
+/**
+ * @brief Displays all courses the student is currently enrolled in, formatted as a table.
+ *
+ * The table is rendered into one buffer and written at once.
+ * 
+ * @param student_id ID of the student.
+ * @return int SUCCESS on success, or FILE_ERROR / USER_NOT_FOUND.
+ */
+static inline int view_enrollments_st(int student_id) {
+    RenderBuf out = {0};
+    int status = render_enrollments_st(&out, student_id);
+    render_flush(&out, STDOUT_FILENO);
+    render_free(&out);
+    return status;
+}
+
+
+/**
+ * @brief Displays the waitlists the student is on, with their position in each.
+ *
+ * @param student_id ID of the student.
+ * @return int Number of waitlists the student is on, or FILE_ERROR.
+ */
+static inline int view_waitlists_st(int student_id) {
+    FILE *fp = snapshot_fopen(DB_WAITLIST);
+    if (!fp) return 0; // No waitlists yet
+
+    char *line = NULL;
+    size_t cap = 0;
+    int shown = 0;
+
+    while (getline(&line, &cap, fp) > 0) {
+        char *end;
+        long course_id = strtol(line, &end, 10);
+        if (end == line || *end != ',') continue; // Header
+
+        Waitlist w = { .course_id = (int)course_id };
+        if (waitlist_parse(&w, end + 1) != SUCCESS) {
+            waitlist_free(&w, 1);
+            free(line);
+            fclose(fp);
+            return FILE_ERROR;
+        }
+        int pos = waitlist_index(&w, student_id);
+        if (pos) {
+            if (shown++ == 0) {
+                printf("\n╔═══════════╦═══════════╦═══════════╗");
+                printf("\n║ Course ID ║ Position  ║  Waiting  ║");
+                printf("\n╠═══════════╬═══════════╬═══════════╣");
+            }
+            printf("\n║ %-9ld ║ %-9d ║ %-9d ║", course_id, pos, w.count);
+        }
+        waitlist_free(&w, 1);
+    }
+    if (shown) printf("\n╚═══════════╩═══════════╩═══════════╝\n");
+
+    free(line);
+    fclose(fp);
+    return shown;
+}
 
 /**
  * @brief Updates a student's password in the student database.
  *
- * This function reads the student database line by line, locks a line exclusively
- * when the student ID matches, updates the password, and then unlocks the line.
+ * The students table is rewritten under its writer lock and published as a
+ * new snapshot, so readers never see a partially updated row.
  *
  * @param student_id ID of the student to update
  * @param new_password New password for the student
  * @return SUCCESS on success, USER_NOT_FOUND if student not found, FILE_ERROR on failure
  */
 static inline int change_student_password(int student_id, const char *new_password) {
-    int fd = open(DB_STUDENTS, O_RDWR);
-    if (fd < 0) return FILE_ERROR;
+    int lock_fd = txn_lock(DB_STUDENTS);
+    if (lock_fd < 0) return FILE_ERROR;
 
-    char line[MAX_BUFFER]; // Increased buffer size
-    off_t offset = 0;
+    FILE *in = snapshot_fopen(DB_STUDENTS);
+    if (!in) {
+        snapshot_unlock(lock_fd, DB_STUDENTS);
+        return FILE_ERROR;
+    }
 
-    while (1) {
-        ssize_t n = pread(fd, line, sizeof(line) - 1, offset);
-        if (n <= 0) break;
-        line[n] = '\0';
-        char *nl = strchr(line, '\n');
-        int linelen = nl ? (nl - line + 1) : n;
+    SnapshotWriter writer;
+    if (!snapshot_rewrite_begin(&writer, DB_STUDENTS)) {
+        fclose(in);
+        snapshot_unlock(lock_fd, DB_STUDENTS);
+        return FILE_ERROR;
+    }
 
-        int sid, active;
-        char name[MAX_LINE], email[MAX_LINE], pass[MAX_LINE], courses[MAX_BUFFER]; // Increased buffer size
+    char line[MAX_BUFFER]; // Increased buffer size
+    int found = 0;
 
-        if (sscanf(line, "%d,%[^,],%[^,],%[^,],%d,%[^\n]", &sid, name, email, pass, &active, courses) >= 5) {
-            if (sid == student_id) {
-                struct flock lock = { .l_type = F_WRLCK, .l_whence = SEEK_SET, .l_start = offset, .l_len = linelen };
-                if (fcntl(fd, F_SETLKW, &lock) < 0) {
-                    close(fd);
-                    return FILE_ERROR;
-                }
+    while (fgets(line, sizeof(line), in)) {
+        int sid, active;
+        char name[MAX_LINE], email[MAX_LINE], pass[MAX_LINE], courses[MAX_BUFFER] = ""; // Increased buffer size
 
-                char updated_line[MAX_BUFFER]; // Increased buffer size
-                // Check if the buffer is large enough
-                int required_size = snprintf(NULL, 0, "%d,%s,%s,%s,%d,%s\n", 
-                                           sid, name, email, new_password, active, courses);
-                
-                if (required_size >= (int)sizeof(updated_line)) {
-                    // Buffer would overflow, handle error
-                    lock.l_type = F_UNLCK;
-                    fcntl(fd, F_SETLK, &lock);
-                    close(fd);
-                    return FILE_ERROR;
-                }
-                
-                snprintf(updated_line, 2566,
-                         "%d,%s,%s,%s,%d,%s\n", sid, name, email, new_password, active, courses);
-                pwrite(fd, updated_line, strlen(updated_line), offset);
-
-                lock.l_type = F_UNLCK;
-                fcntl(fd, F_SETLK, &lock);
-                close(fd);
-                return SUCCESS;
-            }
+        if (!found &&
+            sscanf(line, "%d,%[^,],%[^,],%[^,],%d,%[^\n]", &sid, name, email, pass, &active, courses) >= 5 &&
+            sid == student_id) {
+            fprintf(writer.out, "%d,%s,%s,%s,%d,%s\n", sid, name, email, new_password, active, courses);
+            found = 1;
+        } else {
+            fputs(line, writer.out);
         }
+    }
+    fclose(in);
 
-        offset += linelen;
+    if (!found) {
+        snapshot_rewrite_abort(&writer);
+        snapshot_unlock(lock_fd, DB_STUDENTS);
+        return USER_NOT_FOUND;
     }
 
-    close(fd);
-    return USER_NOT_FOUND;
+    int status = snapshot_rewrite_commit(&writer);
+    snapshot_unlock(lock_fd, DB_STUDENTS);
+
+    if (status == SUCCESS) auth_version_bump();
+    return status;
 }
 
 #endif // STUDENT_ACTIONS_H
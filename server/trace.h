@@ -0,0 +1,151 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+#define SLOW_OP_LOG       "../database/slow_ops.log"
+#define SLOW_OP_ENV       "ACADEMIA_SLOW_OP_MS"
+#define MAX_TRACE_PHASES  8
+
+/**
+ * @brief Time spent in one named phase of a traced operation.
+ */
+typedef struct {
+    const char *name;
+    long usec;
+} TracePhase;
+
+/**
+ * @brief Per-operation timing record for the slow-operation log.
+ *
+ * A trace is started with trace_begin(), split into phases with trace_phase()
+ * and finished with trace_end(). When tracing is disabled every call returns
+ * immediately without reading the clock.
+ */
+typedef struct {
+    const char *op;
+    int enabled;                           ///< 1 if the slow-op log is configured
+    long threshold_us;                     ///< Operations at or above this are logged
+    struct timespec start;                 ///< Start of the whole operation
+    struct timespec mark;                  ///< Start of the current phase
+    TracePhase phases[MAX_TRACE_PHASES];
+    int phase_count;
+    size_t bytes_scanned;                  ///< Bytes read from the CSV tables
+    int rows_touched;                      ///< Rows rewritten by the operation
+} OpTrace;
+
+/**
+ * @brief Returns the slow-operation threshold in microseconds.
+ *
+ * The threshold is read once per process from ACADEMIA_SLOW_OP_MS (milliseconds).
+ * If the variable is unset or invalid, tracing is disabled and -1 is returned.
+ */
+static inline long trace_threshold_us(void) {
+    static long threshold = -2;
+    if (threshold == -2) {
+        const char *env = getenv(SLOW_OP_ENV);
+        char *end = NULL;
+        long ms = env ? strtol(env, &end, 10) : -1;
+        threshold = (env && end != env && ms >= 0) ? ms * 1000 : -1;
+    }
+    return threshold;
+}
+
+/**
+ * @brief Returns the number of microseconds elapsed between two timestamps.
+ */
+static inline long trace_elapsed_us(const struct timespec *from, const struct timespec *to) {
+    return (to->tv_sec - from->tv_sec) * 1000000L + (to->tv_nsec - from->tv_nsec) / 1000L;
+}
+
+/**
+ * @brief Starts tracing an operation.
+ * @param t  Trace record to initialise.
+ * @param op Operation name written to the log (must outlive the trace).
+ */
+static inline void trace_begin(OpTrace *t, const char *op) {
+    memset(t, 0, sizeof(*t));
+    t->op = op;
+    t->threshold_us = trace_threshold_us();
+    t->enabled = (t->threshold_us >= 0);
+    if (!t->enabled) return;
+
+    clock_gettime(CLOCK_MONOTONIC, &t->start);
+    t->mark = t->start;
+}
+
+/**
+ * @brief Closes the current phase under the given name and starts the next one.
+ * @param t    Active trace.
+ * @param name Phase name (string literal).
+ */
+static inline void trace_phase(OpTrace *t, const char *name) {
+    if (!t->enabled || t->phase_count >= MAX_TRACE_PHASES) return;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    t->phases[t->phase_count].name = name;
+    t->phases[t->phase_count].usec = trace_elapsed_us(&t->mark, &now);
+    t->phase_count++;
+    t->mark = now;
+}
+
+/**
+ * @brief Accounts for bytes read from a table during the operation.
+ */
+static inline void trace_scan(OpTrace *t, ssize_t bytes) {
+    if (t->enabled && bytes > 0) t->bytes_scanned += (size_t)bytes;
+}
+
+/**
+ * @brief Accounts for rows rewritten by the operation.
+ */
+static inline void trace_rows(OpTrace *t, int rows) {
+    if (t->enabled) t->rows_touched += rows;
+}
+
+/**
+ * @brief Finishes a trace and logs it if it took at least the threshold.
+ *
+ * The log line is a single key=value record appended with one write(), so
+ * concurrent client processes never interleave partial lines.
+ *
+ * @param t      Active trace.
+ * @param status Return code of the traced operation.
+ */
+static inline void trace_end(OpTrace *t, int status) {
+    if (!t->enabled) return;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long total = trace_elapsed_us(&t->start, &now);
+    if (total < t->threshold_us) return;
+
+    char record[1024];
+    int len = snprintf(record, sizeof(record), "ts=%ld pid=%d op=%s status=%d total_us=%ld",
+                       (long)time(NULL), (int)getpid(), t->op, status, total);
+    for (int i = 0; i < t->phase_count && len < (int)sizeof(record); i++) {
+        len += snprintf(record + len, sizeof(record) - len, " %s_us=%ld",
+                        t->phases[i].name, t->phases[i].usec);
+    }
+    if (len < (int)sizeof(record)) {
+        len += snprintf(record + len, sizeof(record) - len, " bytes_scanned=%zu rows_touched=%d\n",
+                        t->bytes_scanned, t->rows_touched);
+    }
+    if (len >= (int)sizeof(record)) {
+        len = sizeof(record) - 1;
+        record[len - 1] = '\n';
+    }
+
+    int fd = open(SLOW_OP_LOG, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) return;
+    write(fd, record, len);
+    close(fd);
+}
+
+#endif // TRACE_H
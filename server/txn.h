@@ -0,0 +1,368 @@
+#ifndef TXN_H
+#define TXN_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "utils.h"
+#include "snapshot.h"
+
+#define TXN_MAX_TABLES 6
+#define TXN_SUFFIX     ".txn"
+#define TXN_JOURNAL    ".journal"
+#define TXN_COMMIT_MARK "commit"
+
+/**
+ * @brief Every table a transaction may write. A journal left by a crash can
+ *        only name these, and txn_begin_list() looks for journals next to each.
+ */
+static const char *const txn_tables[] = {
+    "../database/courses.csv",
+    "../database/faculty.csv",
+    "../database/prereqs.csv",
+    "../database/schedule.csv",
+    "../database/students.csv",
+    "../database/waitlist.csv",
+};
+
+#define TXN_TABLE_COUNT ((int)(sizeof(txn_tables) / sizeof(txn_tables[0])))
+
+/**
+ * @brief Multi-table transactions on top of the snapshot layer.
+ *
+ * A transaction takes the writer locks of every table it touches up front,
+ * always in the same (lexical path) order so that two transactions can never
+ * deadlock, and holds them until it commits or aborts. Each table it changes is
+ * written to "<table>.txn".
+ *
+ * Commit happens in three steps:
+ *   1. every new version is flushed and fsync'ed;
+ *   2. a redo journal naming the changed tables and ending in "commit" is
+ *      written and fsync'ed next to the first locked table — this is the
+ *      commit point;
+ *   3. the new versions are renamed into place and the journal is removed.
+ *
+ * A failure before the commit point rolls back by deleting the temp files, so
+ * none of the tables change. A crash after it leaves the journal behind. Any
+ * writer that then locks one of the journal's tables first takes the locks of
+ * all of them and finishes the renames, so all tables change together and no
+ * later write is overwritten by the stale redo. Single-table writers lock with
+ * txn_lock() for this reason, never with snapshot_lock() directly.
+ */
+
+/**
+ * @brief One table taking part in a transaction.
+ */
+typedef struct {
+    const char *path;
+    int lock_fd;
+    int staged;                 ///< 1 once a new version is being written
+    SnapshotWriter writer;
+} TxnTable;
+
+/**
+ * @brief An open transaction.
+ */
+typedef struct {
+    TxnTable tables[TXN_MAX_TABLES];
+    int count;
+} Txn;
+
+static inline TxnTable *txn_table(Txn *t, const char *path) {
+    for (int i = 0; i < t->count; i++) {
+        if (strcmp(t->tables[i].path, path) == 0) return &t->tables[i];
+    }
+    return NULL;
+}
+
+static inline void txn_journal_path(const Txn *t, char *buf, size_t len) {
+    snprintf(buf, len, "%s%s", t->tables[0].path, TXN_JOURNAL);
+}
+
+/**
+ * @brief Reads the tables named by a journal.
+ *
+ * @param journal   Journal path.
+ * @param tables    Receives the tables, as entries of txn_tables.
+ * @param committed Receives 1 if the journal ends in the commit mark.
+ * @return Number of tables, or -1 if there is no journal.
+ */
+static inline int txn_journal_read(const char *journal, const char **tables, int *committed) {
+    FILE *fp = fopen(journal, "r");
+    if (!fp) return -1;
+
+    char line[SNAPSHOT_PATH_LEN];
+    int n = 0;
+    *committed = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        line[strcspn(line, "\n")] = '\0';
+        if (strcmp(line, TXN_COMMIT_MARK) == 0) {
+            *committed = 1;
+            break;
+        }
+        for (int i = 0; i < TXN_TABLE_COUNT && n < TXN_MAX_TABLES; i++) {
+            if (strcmp(line, txn_tables[i]) == 0) tables[n++] = txn_tables[i];
+        }
+    }
+    fclose(fp);
+    return n;
+}
+
+/**
+ * @brief Finishes a committed transaction found in a journal, or discards an
+ *        uncommitted one's temp files. The caller holds the locks of every
+ *        table the journal names.
+ */
+static inline void txn_replay(const char *journal, const char **tables, int n, int committed) {
+    for (int i = 0; i < n; i++) {
+        char temp_path[SNAPSHOT_PATH_LEN + sizeof(TXN_SUFFIX)];
+        snprintf(temp_path, sizeof(temp_path), "%s%s", tables[i], TXN_SUFFIX);
+        if (!committed) unlink(temp_path);
+        else if (access(temp_path, F_OK) == 0) rename(temp_path, tables[i]);
+    }
+    unlink(journal);
+}
+
+static int txn_path_cmp(const void *a, const void *b) {
+    return strcmp(((const TxnTable *)a)->path, ((const TxnTable *)b)->path);
+}
+
+/**
+ * @brief Releases every lock held by the transaction, in reverse order.
+ */
+static inline void txn_release(Txn *t) {
+    for (int i = t->count - 1; i >= 0; i--) {
+        snapshot_unlock(t->tables[i].lock_fd, t->tables[i].path);
+    }
+    t->count = 0;
+}
+
+/**
+ * @brief Takes the writer locks of the transaction's tables, in path order.
+ * @return SUCCESS, or FILE_ERROR with no lock held.
+ */
+static inline int txn_lock_all(Txn *t) {
+    qsort(t->tables, t->count, sizeof(TxnTable), txn_path_cmp);
+    for (int i = 0; i < t->count; i++) {
+        t->tables[i].lock_fd = snapshot_lock(t->tables[i].path);
+        if (t->tables[i].lock_fd < 0) {
+            t->count = i;
+            txn_release(t);
+            return FILE_ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Opens a transaction over an array of tables.
+ *
+ * Takes the writer locks of all tables in one go and in a fixed order, then
+ * finishes any transaction a crashed writer left behind on them. When such a
+ * journal also names tables this transaction does not lock, their locks are
+ * taken too (all locks are dropped and retaken, to keep the order) for as
+ * long as the replay needs them. Reads made after this call see the latest
+ * committed version of every table and stay valid until commit.
+ *
+ * @param t     Transaction to initialise.
+ * @param paths Table paths.
+ * @param count Number of tables (at most TXN_MAX_TABLES).
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int txn_begin_list(Txn *t, const char *const *paths, int count) {
+    if (count < 1 || count > TXN_MAX_TABLES) return FILE_ERROR;
+
+    const char *wanted[TXN_MAX_TABLES];
+    int wanted_count = count;
+    for (int i = 0; i < count; i++) wanted[i] = paths[i];
+
+    while (1) {
+        t->count = 0;
+        for (int i = 0; i < wanted_count; i++) {
+            if (txn_table(t, wanted[i])) continue;
+            t->tables[t->count].path = wanted[i];
+            t->tables[t->count].lock_fd = -1;
+            t->tables[t->count].staged = 0;
+            t->count++;
+        }
+        if (txn_lock_all(t) != SUCCESS) return FILE_ERROR;
+
+        // A journal naming a locked table is not being written by a live
+        // transaction (it would hold that lock): it was left by a crash
+        int before = wanted_count;
+        for (int j = 0; j < TXN_TABLE_COUNT; j++) {
+            char journal[SNAPSHOT_PATH_LEN];
+            const char *tables[TXN_MAX_TABLES];
+            int committed;
+            snprintf(journal, sizeof(journal), "%s%s", txn_tables[j], TXN_JOURNAL);
+            int n = txn_journal_read(journal, tables, &committed);
+            if (n <= 0) continue;
+
+            int locked = 0, missing = 0;
+            for (int i = 0; i < n; i++) {
+                if (txn_table(t, tables[i])) locked = 1;
+                else missing = 1;
+            }
+            if (!locked) continue;
+            if (!missing) {
+                txn_replay(journal, tables, n, committed);
+                continue;
+            }
+            for (int i = 0; i < n && wanted_count < TXN_MAX_TABLES; i++) {
+                if (!txn_table(t, tables[i])) wanted[wanted_count++] = tables[i];
+            }
+        }
+        if (wanted_count == before) break;
+        txn_release(t);
+    }
+
+    // Keep only the locks the caller asked for
+    for (int i = 0; i < t->count; i++) {
+        int asked = 0;
+        for (int k = 0; k < count; k++) asked |= strcmp(t->tables[i].path, paths[k]) == 0;
+        if (asked) continue;
+        snapshot_unlock(t->tables[i].lock_fd, t->tables[i].path);
+        t->tables[i--] = t->tables[--t->count];
+    }
+    qsort(t->tables, t->count, sizeof(TxnTable), txn_path_cmp);
+    return SUCCESS;
+}
+
+/**
+ * @brief Opens a transaction over the given tables.
+ * @param t     Transaction to initialise.
+ * @param count Number of table paths that follow (at most TXN_MAX_TABLES).
+ * @return SUCCESS or FILE_ERROR.
+ * @see txn_begin_list()
+ */
+static inline int txn_begin(Txn *t, int count, ...) {
+    if (count < 1 || count > TXN_MAX_TABLES) return FILE_ERROR;
+
+    const char *paths[TXN_MAX_TABLES];
+    va_list ap;
+    va_start(ap, count);
+    for (int i = 0; i < count; i++) paths[i] = va_arg(ap, const char *);
+    va_end(ap);
+    return txn_begin_list(t, paths, count);
+}
+
+/**
+ * @brief Starts writing the new version of one of the transaction's tables.
+ * @return Stream for the new version, or NULL on error (or if the table is
+ *         not part of the transaction).
+ */
+static inline FILE *txn_write(Txn *t, const char *path) {
+    TxnTable *table = txn_table(t, path);
+    if (!table || table->staged) return NULL;
+    if (!snapshot_rewrite_begin_as(&table->writer, path, TXN_SUFFIX)) return NULL;
+    table->staged = 1;
+    return table->writer.out;
+}
+
+/**
+ * @brief Rolls the transaction back: no table changes and all locks are released.
+ */
+static inline void txn_abort(Txn *t) {
+    for (int i = 0; i < t->count; i++) {
+        if (t->tables[i].staged) snapshot_rewrite_abort(&t->tables[i].writer);
+        t->tables[i].staged = 0;
+    }
+    txn_release(t);
+}
+
+/**
+ * @brief Commits every staged table atomically, keeping the locks.
+ *
+ * For writers that must record the committed change elsewhere before other
+ * writers can see it; they call txn_release() after. On failure the staged
+ * tables are rolled back and the locks are still held.
+ *
+ * @return SUCCESS if all changes are committed, FILE_ERROR if the transaction
+ *         was rolled back instead.
+ */
+static inline int txn_publish(Txn *t) {
+    int staged = 0;
+    for (int i = 0; i < t->count; i++) staged += t->tables[i].staged;
+    if (!staged) return SUCCESS;
+
+    // 1) Make every new version durable
+    for (int i = 0; i < t->count; i++) {
+        TxnTable *table = &t->tables[i];
+        if (!table->staged) continue;
+        if (snapshot_rewrite_prepare(&table->writer) != SUCCESS) {
+            table->staged = 0;
+            for (int k = 0; k < t->count; k++) {
+                if (t->tables[k].staged) snapshot_rewrite_abort(&t->tables[k].writer);
+                t->tables[k].staged = 0;
+            }
+            return FILE_ERROR;
+        }
+    }
+
+    // 2) Commit point: the redo journal is durable
+    char journal[SNAPSHOT_PATH_LEN];
+    txn_journal_path(t, journal, sizeof(journal));
+    int fd = open(journal, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int status = fd < 0 ? FILE_ERROR : SUCCESS;
+    for (int i = 0; i < t->count && status == SUCCESS; i++) {
+        if (t->tables[i].staged && dprintf(fd, "%s\n", t->tables[i].path) < 0) status = FILE_ERROR;
+    }
+    if (status == SUCCESS && (dprintf(fd, TXN_COMMIT_MARK "\n") < 0 || fsync(fd) != 0)) status = FILE_ERROR;
+    if (fd >= 0) close(fd);
+
+    if (status != SUCCESS) {
+        unlink(journal);
+        for (int i = 0; i < t->count; i++) {
+            if (t->tables[i].staged) unlink(t->tables[i].writer.temp_path);
+            t->tables[i].staged = 0;
+        }
+        return FILE_ERROR;
+    }
+
+    // 3) Publish; a crash from here on is finished by txn_replay()
+    for (int i = 0; i < t->count; i++) {
+        if (t->tables[i].staged) snapshot_rewrite_publish(&t->tables[i].writer);
+        t->tables[i].staged = 0;
+    }
+    unlink(journal);
+    return SUCCESS;
+}
+
+/**
+ * @brief Commits every staged table atomically and releases all locks.
+ * @return SUCCESS if all changes are committed, FILE_ERROR if the transaction
+ *         was rolled back instead.
+ */
+static inline int txn_commit(Txn *t) {
+    int status = txn_publish(t);
+    txn_release(t);
+    return status;
+}
+
+/**
+ * @brief Takes the writer lock of one table for a single-table write, after
+ *        finishing any transaction a crash left behind on it.
+ *
+ * @param path Table path.
+ * @return Lock descriptor for snapshot_unlock(), or -1 on error.
+ */
+static inline int txn_lock(const char *path) {
+    Txn t;
+    if (txn_begin(&t, 1, path) != SUCCESS) return -1;
+    return t.tables[0].lock_fd;
+}
+
+/**
+ * @brief Finishes any transaction interrupted by a crash, on every table in
+ *        txn_tables. Called once at startup; writers also recover on their own.
+ */
+static inline void txn_recover(void) {
+    // Opening the transaction replays every journal once all locks are held
+    Txn t;
+    if (txn_begin_list(&t, txn_tables, TXN_TABLE_COUNT) == SUCCESS) txn_release(&t);
+}
+
+#endif // TXN_H
@@ -11,6 +11,7 @@
 #define MAX_COURSES_PER_STUDENT  8
 #define MAX_COURSE_CODE_LEN       8
 #define MAX_COURSE_NAME_LEN     100
+#define MAX_SLOTS_PER_COURSE      4
 
 /**
  * @brief Role identifiers used for authentication and access control.
@@ -49,18 +50,31 @@ typedef struct {
     char enrolled_courses[512];            ///< Comma-separated string of course codes
 } Student;
 
+/**
+ * @brief One weekly meeting time of a course.
+ */
+typedef struct {
+    int day;                               ///< 0 = Monday ... 6 = Sunday
+    int start;                             ///< Minutes since midnight
+    int end;                               ///< Minutes since midnight, exclusive
+} TimeSlot;
+
 /**
  * @brief Structure to represent a course.
+ *
+ * Numeric fields come first so the ones checked on every course share a
+ * cache line; the owner is referred to by faculty_id only.
  */
 typedef struct Course {
     int id;
-    char code[MAX_COURSE_CODE_LEN];
-    char name[MAX_COURSE_NAME_LEN];
     int capacity;
     int enrolled;                          ///< Number of students currently enrolled
     int credits;
     int faculty_id;                        ///< Faculty ID who teaches the course
-    Faculty *faculty;                      ///< Runtime pointer association (optional)
+    int slot_count;
+    char code[MAX_COURSE_CODE_LEN];
+    TimeSlot slots[MAX_SLOTS_PER_COURSE];  ///< Weekly meeting times
+    char name[MAX_COURSE_NAME_LEN];
 } Course;
 
 /**
@@ -14,10 +14,15 @@
 #define DUPLICATE_ID   -3
 #define ALREADY_ENROLLED -4
 #define NOT_ENROLLED   -5
+#define WAITLISTED     -7
+#define SCHEDULE_CONFLICT -8
+#define PREREQ_MISSING -9
+#define PREREQ_CYCLE  -10
 #define DEACTIVATED    -3
 #define INCORRECT_ROLE -4
 #define WRONG_PASS     -1
 #define WRONG_USER     -2
+#define LOGIN_BUSY     -5
 
 /**
  * @brief Reads a line from a file descriptor into a buffer.
@@ -0,0 +1,348 @@
+#ifndef WAITLIST_H
+#define WAITLIST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include "utils.h"
+#include "snapshot.h"
+#include "txn.h"
+
+#define DB_WAITLIST "../database/waitlist.csv"
+#define WAITLIST_HEADER "course_id,students\n"
+
+/**
+ * @brief Per-course FIFO waitlists.
+ *
+ * The waitlist table has one row per course with a non-empty waitlist:
+ * "course_id,\"s1,s2,...\"", students in arrival order. Rows are changed only
+ * inside the same transaction as the enrollment change that causes them, so a
+ * seat is never freed without the next waitlisted student taking it.
+ *
+ * While a course has a waitlist it is full: every path that frees a seat
+ * promotes the head of the waitlist in the same transaction.
+ */
+
+/**
+ * @brief The waitlist of one course.
+ */
+typedef struct {
+    int course_id;
+    int *students;      ///< Waiting student ids, head first
+    int count, size;
+    int changed;        ///< 1 if the row must be rewritten
+} Waitlist;
+
+static int waitlist_cmp(const void *a, const void *b) {
+    int x = ((const Waitlist *)a)->course_id, y = ((const Waitlist *)b)->course_id;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Finds the waitlist of a course in an array sorted by course id.
+ */
+static inline Waitlist *waitlist_find(Waitlist *lists, int count, int course_id) {
+    Waitlist key = { .course_id = course_id };
+    return bsearch(&key, lists, count, sizeof(Waitlist), waitlist_cmp);
+}
+
+/**
+ * @brief Parses the quoted students list of a waitlist row into a Waitlist.
+ * @return SUCCESS or FAILURE if out of memory.
+ */
+static inline int waitlist_parse(Waitlist *w, char *list) {
+    for (char *tok = strtok(list, ",\" \r\n"); tok; tok = strtok(NULL, ",\" \r\n")) {
+        if (w->count == w->size) {
+            int bigger = w->size ? w->size * 2 : 8;
+            int *p = realloc(w->students, bigger * sizeof(int));
+            if (!p) return FAILURE;
+            w->students = p;
+            w->size = bigger;
+        }
+        w->students[w->count++] = atoi(tok);
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Loads the waitlists of several courses in one scan.
+ *
+ * @param lists Waitlists sorted by course id, with only course_id set; courses
+ *              without a row keep an empty list.
+ * @param count Number of waitlists.
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int waitlist_load(Waitlist *lists, int count) {
+    FILE *file = snapshot_fopen(DB_WAITLIST);
+    if (!file) return SUCCESS; // No waitlists yet
+
+    char *line = NULL;
+    size_t cap = 0;
+    int status = SUCCESS;
+
+    while (status == SUCCESS && getline(&line, &cap, file) > 0) {
+        char *end;
+        long course_id = strtol(line, &end, 10);
+        if (end == line || *end != ',') continue; // Header
+
+        Waitlist *w = waitlist_find(lists, count, (int)course_id);
+        if (w && w->count == 0 && waitlist_parse(w, end + 1) != SUCCESS) status = FILE_ERROR;
+    }
+
+    free(line);
+    fclose(file);
+    return status;
+}
+
+/**
+ * @brief Returns a student's 1-based position in a waitlist, or 0 if absent.
+ */
+static inline int waitlist_index(const Waitlist *w, int student_id) {
+    for (int i = 0; i < w->count; i++) {
+        if (w->students[i] == student_id) return i + 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Appends a student to the tail of a waitlist (no-op if already waiting).
+ * @return The student's 1-based position, or FAILURE if out of memory.
+ */
+static inline int waitlist_push(Waitlist *w, int student_id) {
+    int pos = waitlist_index(w, student_id);
+    if (pos) return pos;
+
+    if (w->count == w->size) {
+        int bigger = w->size ? w->size * 2 : 8;
+        int *p = realloc(w->students, bigger * sizeof(int));
+        if (!p) return FAILURE;
+        w->students = p;
+        w->size = bigger;
+    }
+    w->students[w->count++] = student_id;
+    w->changed = 1;
+    return w->count;
+}
+
+/**
+ * @brief Removes a student from a waitlist.
+ * @return 1 if the student was waiting, 0 otherwise.
+ */
+static inline int waitlist_remove(Waitlist *w, int student_id) {
+    int pos = waitlist_index(w, student_id);
+    if (!pos) return 0;
+    memmove(&w->students[pos - 1], &w->students[pos], (w->count - pos) * sizeof(int));
+    w->count--;
+    w->changed = 1;
+    return 1;
+}
+
+static inline void waitlist_write_row(FILE *out, const Waitlist *w) {
+    if (w->count == 0) return; // Empty waitlists have no row
+    fprintf(out, "%d,\"", w->course_id);
+    for (int i = 0; i < w->count; i++) fprintf(out, i ? ",%d" : "%d", w->students[i]);
+    fputs("\"\n", out);
+}
+
+/**
+ * @brief Stages a new version of the waitlist table in a transaction.
+ *
+ * Rows of changed waitlists are replaced (or dropped when empty), changed
+ * waitlists without a row are appended, and every other row is copied.
+ * Does nothing if no waitlist changed.
+ *
+ * @param txn   Transaction holding DB_WAITLIST.
+ * @param lists Waitlists sorted by course id.
+ * @param count Number of waitlists.
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int waitlist_stage(Txn *txn, Waitlist *lists, int count) {
+    int changed = 0;
+    for (int i = 0; i < count; i++) changed |= lists[i].changed;
+    if (!changed) return SUCCESS;
+
+    FILE *out = txn_write(txn, DB_WAITLIST);
+    if (!out) return FILE_ERROR;
+    fputs(WAITLIST_HEADER, out);
+
+    FILE *in = snapshot_fopen(DB_WAITLIST);
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+
+    while (in && (len = getline(&line, &cap, in)) > 0) {
+        char *end;
+        long course_id = strtol(line, &end, 10);
+        if (end == line || *end != ',') continue; // Header, written above
+
+        Waitlist *w = waitlist_find(lists, count, (int)course_id);
+        if (w && w->changed) {
+            waitlist_write_row(out, w);
+            w->changed = 0;
+        } else {
+            fputs(line, out);
+            if (line[len - 1] != '\n') fputc('\n', out);
+        }
+    }
+    free(line);
+    if (in) fclose(in);
+
+    for (int i = 0; i < count; i++) {
+        if (lists[i].changed) waitlist_write_row(out, &lists[i]);
+        lists[i].changed = 0;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Frees the student arrays of several waitlists.
+ */
+static inline void waitlist_free(Waitlist *lists, int count) {
+    for (int i = 0; i < count; i++) {
+        free(lists[i].students);
+        lists[i].students = NULL;
+        lists[i].count = lists[i].size = 0;
+    }
+}
+
+/**
+ * @brief One waiting student in the position index.
+ */
+typedef struct {
+    int course_id;          ///< 0 if the slot is free
+    int student_id;
+    int position;           ///< 1-based
+} WaitlistSlot;
+
+/**
+ * @brief Positions of every waiting student in one snapshot of the waitlist
+ *        table, in an open-addressing hash table keyed by course and student.
+ */
+typedef struct {
+    ino_t inode;
+    struct timespec mtime;
+    off_t size;
+    int loaded;
+    WaitlistSlot *slots;
+    size_t mask;            ///< Number of slots minus one; slots is a power of two
+    size_t count;
+} WaitlistIndex;
+
+static inline size_t waitlist_slot_hash(int course_id, int student_id) {
+    uint64_t h = (uint64_t)(uint32_t)course_id << 32 | (uint32_t)student_id;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (size_t)h;
+}
+
+/**
+ * @brief Adds a position to the index, doubling the table when half full.
+ * @return SUCCESS or FAILURE if out of memory.
+ */
+static inline int waitlist_index_put(WaitlistIndex *ix, int course_id, int student_id, int position) {
+    if ((ix->count + 1) * 2 > ix->mask + 1 || !ix->slots) {
+        size_t size = ix->slots ? (ix->mask + 1) * 2 : 1024;
+        WaitlistSlot *slots = calloc(size, sizeof(WaitlistSlot));
+        if (!slots) return FAILURE;
+        for (size_t i = 0; ix->slots && i <= ix->mask; i++) {
+            if (!ix->slots[i].course_id) continue;
+            size_t h = waitlist_slot_hash(ix->slots[i].course_id, ix->slots[i].student_id) & (size - 1);
+            while (slots[h].course_id) h = (h + 1) & (size - 1);
+            slots[h] = ix->slots[i];
+        }
+        free(ix->slots);
+        ix->slots = slots;
+        ix->mask = size - 1;
+    }
+
+    size_t h = waitlist_slot_hash(course_id, student_id) & ix->mask;
+    while (ix->slots[h].course_id) {
+        if (ix->slots[h].course_id == course_id && ix->slots[h].student_id == student_id) return SUCCESS;
+        h = (h + 1) & ix->mask;
+    }
+    ix->slots[h] = (WaitlistSlot){ course_id, student_id, position };
+    ix->count++;
+    return SUCCESS;
+}
+
+/**
+ * @brief Looks up a position in the index.
+ * @return 1-based position, or 0 if the student is not waiting.
+ */
+static inline int waitlist_index_get(const WaitlistIndex *ix, int course_id, int student_id) {
+    if (!ix->slots) return 0;
+    size_t h = waitlist_slot_hash(course_id, student_id) & ix->mask;
+    while (ix->slots[h].course_id) {
+        if (ix->slots[h].course_id == course_id && ix->slots[h].student_id == student_id) return ix->slots[h].position;
+        h = (h + 1) & ix->mask;
+    }
+    return 0;
+}
+
+/**
+ * @brief Indexes every waitlist of a snapshot.
+ * @return SUCCESS or FILE_ERROR.
+ */
+static inline int waitlist_index_build(WaitlistIndex *ix, FILE *file) {
+    char *line = NULL;
+    size_t cap = 0;
+    int status = SUCCESS;
+
+    while (status == SUCCESS && getline(&line, &cap, file) > 0) {
+        char *end;
+        long course_id = strtol(line, &end, 10);
+        if (end == line || *end != ',' || course_id == 0) continue; // Header
+
+        Waitlist w = { .course_id = (int)course_id };
+        if (waitlist_parse(&w, end + 1) != SUCCESS) status = FILE_ERROR;
+        for (int i = 0; status == SUCCESS && i < w.count; i++) {
+            if (waitlist_index_put(ix, w.course_id, w.students[i], i + 1) != SUCCESS) status = FILE_ERROR;
+        }
+        waitlist_free(&w, 1);
+    }
+    free(line);
+    return status;
+}
+
+/**
+ * @brief Returns a student's position on a course's waitlist.
+ *
+ * Positions come from a process-wide index of the waitlist table, built with
+ * one scan the first time after the table changes (a new inode, mtime or
+ * size); a lookup is then one hash probe. No lock is taken.
+ *
+ * @param student_id Student ID.
+ * @param course_id  Course ID.
+ * @return 1-based position, 0 if the student is not waiting, or FILE_ERROR.
+ */
+static inline int waitlist_position(int student_id, int course_id) {
+    static WaitlistIndex index;
+
+    struct stat st;
+    if (stat(DB_WAITLIST, &st) != 0) return 0; // No waitlists yet
+    if (!index.loaded || st.st_ino != index.inode || st.st_size != index.size ||
+        st.st_mtim.tv_sec != index.mtime.tv_sec || st.st_mtim.tv_nsec != index.mtime.tv_nsec) {
+        free(index.slots);
+        memset(&index, 0, sizeof(index));
+
+        FILE *file = snapshot_fopen(DB_WAITLIST);
+        if (!file) return 0;
+        int status = fstat(fileno(file), &st) == 0 ? waitlist_index_build(&index, file) : FILE_ERROR;
+        fclose(file);
+        if (status != SUCCESS) {
+            free(index.slots);
+            memset(&index, 0, sizeof(index));
+            return FILE_ERROR;
+        }
+        index.inode = st.st_ino;
+        index.mtime = st.st_mtim;
+        index.size = st.st_size;
+        index.loaded = 1;
+    }
+    return waitlist_index_get(&index, course_id, student_id);
+}
+
+#endif // WAITLIST_H
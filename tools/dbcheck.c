@@ -0,0 +1,1488 @@
+/**
+ * @file dbcheck.c
+ * @brief Offline consistency checker and repair tool for the CSV database.
+ *
+ * Loads admins.csv, faculty.csv, courses.csv and students.csv in parallel
+ * (one thread per table, each table mmap'ed and parsed in place), resolves
+ * ids and codes to row indexes (dense arrays, or open-addressing hash tables)
+ * and cross-validates, in time linear in the number of rows and memberships:
+ *   - duplicate ids (every table), duplicate emails, duplicate course codes;
+ *   - course `enrolled` count against the quoted students list;
+ *   - course students list against students' `enrolled_courses` (both ways);
+ *   - faculty `offered_courses` against the courses each faculty owns;
+ *   - dangling student ids, course codes and faculty ids.
+ *
+ * It then checks the tables that refer to them:
+ *   - waitlist.csv: unknown courses and students, repeated courses and
+ *     students, students waitlisted for a course they are enrolled in, and
+ *     waitlists of courses that still have free seats;
+ *   - schedule.csv: unknown courses and invalid days or times;
+ *   - prereqs.csv: unknown courses and prerequisite cycles;
+ *   - completed.csv: unknown and repeated students (codes of removed courses
+ *     are kept on purpose);
+ * and reports *.journal, *.txn and *.tmp files a crashed writer left behind.
+ * Any of the four is optional, as the server creates them on first use.
+ *
+ * With -r it writes a repaired snapshot of the four core tables to a
+ * directory; the other tables are only checked.
+ * The courses' students lists are taken as the source of truth for
+ * memberships (they are written first by every enrollment change), restricted
+ * to students that exist; `enrolled`, `enrolled_courses` and `offered_courses`
+ * are rebuilt from them. Rows with a duplicate id or course code are dropped.
+ *
+ * Usage: dbcheck [-d database_dir] [-r repair_dir] [-v]
+ * Run it while no server or client is writing to the database.
+ * Exit status: 0 if consistent, 1 if problems were found, 2 on error.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define DEFAULT_DB_DIR     "../database"
+#define PATH_LEN           512
+#define REPORT_LIMIT       20      ///< Issues printed per category without -v
+#define OUTPUT_BUFFER      (1 << 20)
+
+/* ------------------------------------------------------------------------- */
+/* Rows                                                                      */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * @brief A field pointing into the mmap'ed file; not NUL-terminated.
+ */
+typedef struct {
+    const char *p;
+    int len;
+} Str;
+
+typedef struct {
+    int line, id, active;
+    Str name, email, pass, courses;
+    Str raw;                               ///< Whole line without newline
+} StudentRow;
+
+typedef struct {
+    int line, id, capacity, enrolled, credits, fid;
+    Str code, name, students;              ///< students without the quotes
+    Str raw;
+} CourseRow;
+
+typedef struct {
+    int line, id;
+    Str name, email, pass, offered;
+    Str raw;
+} FacultyRow;
+
+typedef struct {
+    int line, id;
+    Str name, email, pass;
+    Str raw;
+} AdminRow;
+
+typedef struct {
+    int line, course_id;
+    Str students;                          ///< Without the quotes
+} WaitlistRow;
+
+typedef struct {
+    int line;
+    Str code, day, start, end;
+} ScheduleRow;
+
+typedef struct {
+    int line;
+    Str code, requires;
+} PrereqRow;
+
+typedef struct {
+    int line, student_id;
+    Str courses;                           ///< Without the quotes
+} CompletedRow;
+
+/**
+ * @brief The four core tables come first; -r repairs only those.
+ */
+enum TableKind {
+    T_ADMINS, T_FACULTY, T_COURSES, T_STUDENTS,
+    T_CORE, T_WAITLIST = T_CORE, T_SCHEDULE, T_PREREQS, T_COMPLETED,
+    T_COUNT
+};
+
+static const char *table_files[T_COUNT] = {
+    "admins.csv", "faculty.csv", "courses.csv", "students.csv",
+    "waitlist.csv", "schedule.csv", "prereqs.csv", "completed.csv"
+};
+
+/**
+ * @brief Start of each table's header line.
+ */
+static const char *table_headers[T_COUNT] = {
+    "id,", "id,", "id,", "id,", "course_id,", "code,", "code,", "student_id,"
+};
+
+/**
+ * @brief One loaded table.
+ */
+typedef struct {
+    enum TableKind kind;
+    char path[PATH_LEN];
+    char *data;                            ///< mmap'ed file contents
+    size_t size;
+    Str header;
+    void *rows;
+    int count;
+    int malformed;
+    int error;                             ///< errno if the table could not be loaded
+} Table;
+
+/* ------------------------------------------------------------------------- */
+/* Field parsing                                                             */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * @brief Takes the next comma-separated field from [*p, end).
+ */
+static Str next_field(const char **p, const char *end) {
+    Str s = { *p, 0 };
+    const char *comma = memchr(*p, ',', end - *p);
+    const char *stop = comma ? comma : end;
+    s.len = (int)(stop - *p);
+    *p = comma ? comma + 1 : end;
+    return s;
+}
+
+static int str_to_int(Str s, int *out) {
+    if (s.len == 0) return 0;
+    int i = 0, neg = 0;
+    long v = 0;
+    if (s.p[0] == '-') { neg = 1; i = 1; }
+    if (i == s.len) return 0;
+    for (; i < s.len; i++) {
+        if (s.p[i] < '0' || s.p[i] > '9') return 0;
+        v = v * 10 + (s.p[i] - '0');
+        if (v > INT32_MAX) return 0;
+    }
+    *out = (int)(neg ? -v : v);
+    return 1;
+}
+
+static Str str_trim(Str s) {
+    while (s.len && (s.p[0] == ' ' || s.p[0] == '"')) { s.p++; s.len--; }
+    while (s.len && (s.p[s.len - 1] == ' ' || s.p[s.len - 1] == '"' || s.p[s.len - 1] == '\r')) s.len--;
+    return s;
+}
+
+static int str_eq(Str a, Str b) {
+    return a.len == b.len && memcmp(a.p, b.p, a.len) == 0;
+}
+
+/**
+ * @brief Iterates over the comma-separated items of a list field.
+ * @return 1 with *item set, or 0 once the list is exhausted.
+ */
+static int next_item(const char **p, const char *end, Str *item) {
+    while (*p < end) {
+        *item = str_trim(next_field(p, end));
+        if (item->len) return 1;
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Loading                                                                   */
+/* ------------------------------------------------------------------------- */
+
+static int parse_row(Table *t, int line_no, const char *p, const char *end) {
+    Str raw = { p, (int)(end - p) };
+    switch (t->kind) {
+        case T_STUDENTS: {
+            StudentRow *r = &((StudentRow *)t->rows)[t->count];
+            r->line = line_no;
+            r->raw = raw;
+            if (!str_to_int(next_field(&p, end), &r->id)) return 0;
+            r->name = next_field(&p, end);
+            r->email = next_field(&p, end);
+            r->pass = next_field(&p, end);
+            if (!str_to_int(next_field(&p, end), &r->active)) return 0;
+            r->courses = (Str){ p, (int)(end - p) };
+            return 1;
+        }
+        case T_COURSES: {
+            CourseRow *r = &((CourseRow *)t->rows)[t->count];
+            r->line = line_no;
+            r->raw = raw;
+            if (!str_to_int(next_field(&p, end), &r->id)) return 0;
+            r->code = next_field(&p, end);
+            r->name = next_field(&p, end);
+            if (!str_to_int(next_field(&p, end), &r->capacity)) return 0;
+            if (!str_to_int(next_field(&p, end), &r->enrolled)) return 0;
+            if (!str_to_int(next_field(&p, end), &r->credits)) return 0;
+            if (!str_to_int(next_field(&p, end), &r->fid)) return 0;
+            r->students = str_trim((Str){ p, (int)(end - p) });
+            return r->code.len > 0;
+        }
+        case T_FACULTY: {
+            FacultyRow *r = &((FacultyRow *)t->rows)[t->count];
+            r->line = line_no;
+            r->raw = raw;
+            if (!str_to_int(next_field(&p, end), &r->id)) return 0;
+            r->name = next_field(&p, end);
+            r->email = next_field(&p, end);
+            r->pass = next_field(&p, end);
+            r->offered = (Str){ p, (int)(end - p) };
+            return 1;
+        }
+        case T_ADMINS: {
+            AdminRow *r = &((AdminRow *)t->rows)[t->count];
+            r->line = line_no;
+            r->raw = raw;
+            if (!str_to_int(next_field(&p, end), &r->id)) return 0;
+            r->name = next_field(&p, end);
+            r->email = next_field(&p, end);
+            r->pass = next_field(&p, end);
+            return 1;
+        }
+        case T_WAITLIST: {
+            WaitlistRow *r = &((WaitlistRow *)t->rows)[t->count];
+            r->line = line_no;
+            if (!str_to_int(next_field(&p, end), &r->course_id)) return 0;
+            r->students = str_trim((Str){ p, (int)(end - p) });
+            return 1;
+        }
+        case T_SCHEDULE: {
+            ScheduleRow *r = &((ScheduleRow *)t->rows)[t->count];
+            r->line = line_no;
+            r->code = next_field(&p, end);
+            r->day = next_field(&p, end);
+            r->start = next_field(&p, end);
+            r->end = next_field(&p, end);
+            return r->code.len > 0 && p == end;
+        }
+        case T_PREREQS: {
+            PrereqRow *r = &((PrereqRow *)t->rows)[t->count];
+            r->line = line_no;
+            r->code = next_field(&p, end);
+            r->requires = next_field(&p, end);
+            return r->code.len > 0 && r->requires.len > 0 && p == end;
+        }
+        case T_COMPLETED: {
+            CompletedRow *r = &((CompletedRow *)t->rows)[t->count];
+            r->line = line_no;
+            if (!str_to_int(next_field(&p, end), &r->student_id)) return 0;
+            r->courses = str_trim((Str){ p, (int)(end - p) });
+            return 1;
+        }
+        default:
+            return 0;
+    }
+}
+
+static size_t row_size(enum TableKind kind) {
+    switch (kind) {
+        case T_STUDENTS:  return sizeof(StudentRow);
+        case T_COURSES:   return sizeof(CourseRow);
+        case T_FACULTY:   return sizeof(FacultyRow);
+        case T_WAITLIST:  return sizeof(WaitlistRow);
+        case T_SCHEDULE:  return sizeof(ScheduleRow);
+        case T_PREREQS:   return sizeof(PrereqRow);
+        case T_COMPLETED: return sizeof(CompletedRow);
+        default:          return sizeof(AdminRow);
+    }
+}
+
+/**
+ * @brief Thread entry point: maps and parses one table.
+ */
+static void *load_table(void *arg) {
+    Table *t = arg;
+    int fd = open(t->path, O_RDONLY);
+    if (fd < 0) {
+        t->error = errno;
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        t->error = errno;
+        close(fd);
+        return NULL;
+    }
+    t->size = st.st_size;
+    if (t->size == 0) {
+        close(fd);
+        return NULL;
+    }
+
+    t->data = mmap(NULL, t->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (t->data == MAP_FAILED) {
+        t->data = NULL;
+        t->error = errno;
+        return NULL;
+    }
+    madvise(t->data, t->size, MADV_SEQUENTIAL);
+
+    // Upper bound on rows: one per newline, plus a final unterminated line
+    size_t lines = 1;
+    for (const char *p = t->data, *end = t->data + t->size; (p = memchr(p, '\n', end - p)); p++) lines++;
+
+    t->rows = malloc(lines * row_size(t->kind));
+    if (!t->rows) {
+        t->error = ENOMEM;
+        return NULL;
+    }
+
+    const char *p = t->data, *end = t->data + t->size;
+    int line_no = 0;
+    while (p < end) {
+        const char *nl = memchr(p, '\n', end - p);
+        const char *line_end = nl ? nl : end;
+        const char *content_end = line_end;
+        if (content_end > p && content_end[-1] == '\r') content_end--;
+        line_no++;
+
+        size_t header_len = strlen(table_headers[t->kind]);
+        if (line_no == 1 && (size_t)(content_end - p) >= header_len && memcmp(p, table_headers[t->kind], header_len) == 0) {
+            t->header = (Str){ p, (int)(content_end - p) };
+        } else if (content_end > p) {
+            if (parse_row(t, line_no, p, content_end)) t->count++;
+            else t->malformed++;
+        }
+        p = nl ? nl + 1 : end;
+    }
+    return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Hash tables                                                               */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * @brief Open-addressing map from a 64-bit key to a row index.
+ *
+ * Slots hold index + 1 so that zero means empty; keys are hashed with a
+ * 64-bit mix, so ids, (row, row) pairs and string hashes share one table type.
+ */
+typedef struct {
+    uint64_t *keys;
+    int *vals;
+    size_t mask;
+} Map;
+
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static uint64_t str_hash(Str s) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < s.len; i++) {
+        h ^= (unsigned char)s.p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static int map_init(Map *m, size_t expected) {
+    size_t cap = 16;
+    while (cap < expected * 2) cap <<= 1;
+    m->keys = malloc(cap * sizeof(uint64_t));
+    m->vals = calloc(cap, sizeof(int));
+    m->mask = cap - 1;
+    return m->keys && m->vals ? 0 : -1;
+}
+
+static void map_free(Map *m) {
+    free(m->keys);
+    free(m->vals);
+}
+
+/**
+ * @brief Finds the slot of a key, or the empty slot where it would go.
+ * @param eq Optional tie-breaker for keys that are hashes (may be NULL).
+ */
+static size_t map_slot(const Map *m, uint64_t key, int (*eq)(int, const void *), const void *ctx) {
+    size_t i = mix64(key) & m->mask;
+    while (m->vals[i]) {
+        if (m->keys[i] == key && (!eq || eq(m->vals[i] - 1, ctx))) return i;
+        i = (i + 1) & m->mask;
+    }
+    return i;
+}
+
+/**
+ * @brief Looks up a key.
+ * @return Row index, or -1 if absent.
+ */
+static int map_get(const Map *m, uint64_t key, int (*eq)(int, const void *), const void *ctx) {
+    return m->vals[map_slot(m, key, eq, ctx)] - 1;
+}
+
+/**
+ * @brief Inserts a key unless present.
+ * @return -1 if inserted, otherwise the index already stored for the key.
+ */
+static int map_put(Map *m, uint64_t key, int val, int (*eq)(int, const void *), const void *ctx) {
+    size_t i = map_slot(m, key, eq, ctx);
+    if (m->vals[i]) return m->vals[i] - 1;
+    m->keys[i] = key;
+    m->vals[i] = val + 1;
+    return -1;
+}
+
+/**
+ * @brief Maps row ids to row indexes.
+ *
+ * Ids are usually dense, so they are indexed by a plain array over
+ * [min, max]; sparse ids fall back to a hash map.
+ */
+typedef struct {
+    int *slots;                            ///< index + 1 per id, 0 if absent
+    int min, span;
+    Map map;
+    int dense;
+} IdIndex;
+
+static int id_index_init(IdIndex *ix, const Table *t, int (*id_of)(const Table *, int)) {
+    memset(ix, 0, sizeof(*ix));
+    long min = 0, max = -1;
+    for (int i = 0; i < t->count; i++) {
+        int id = id_of(t, i);
+        if (i == 0 || id < min) min = id;
+        if (i == 0 || id > max) max = id;
+    }
+
+    if (max - min < 4L * t->count + 1024) {
+        ix->dense = 1;
+        ix->min = (int)min;
+        ix->span = (int)(max - min + 1);
+        ix->slots = calloc(ix->span > 0 ? ix->span : 1, sizeof(int));
+        return ix->slots ? 0 : -1;
+    }
+    return map_init(&ix->map, t->count);
+}
+
+static void id_index_free(IdIndex *ix) {
+    if (ix->dense) free(ix->slots);
+    else map_free(&ix->map);
+}
+
+static int id_index_get(const IdIndex *ix, int id) {
+    if (!ix->dense) return map_get(&ix->map, (uint32_t)id, NULL, NULL);
+    long k = (long)id - ix->min;
+    return k >= 0 && k < ix->span ? ix->slots[k] - 1 : -1;
+}
+
+/**
+ * @return -1 if inserted, otherwise the index already stored for the id.
+ */
+static int id_index_put(IdIndex *ix, int id, int val) {
+    if (!ix->dense) return map_put(&ix->map, (uint32_t)id, val, NULL, NULL);
+    long k = (long)id - ix->min;
+    if (ix->slots[k]) return ix->slots[k] - 1;
+    ix->slots[k] = val + 1;
+    return -1;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Reporting                                                                 */
+/* ------------------------------------------------------------------------- */
+
+enum Issue {
+    I_MALFORMED, I_DUP_ID, I_DUP_EMAIL, I_DUP_CODE, I_COUNT_MISMATCH, I_OVER_CAPACITY,
+    I_DUP_MEMBER, I_UNKNOWN_STUDENT, I_UNKNOWN_COURSE, I_UNKNOWN_FACULTY,
+    I_MISSING_IN_STUDENT, I_MISSING_IN_COURSE, I_OFFERED_NOT_OWNED, I_OWNED_NOT_OFFERED,
+    I_DUP_ROW, I_WAITLIST_ENROLLED, I_WAITLIST_FREE, I_BAD_SLOT, I_PREREQ_CYCLE, I_LEFTOVER,
+    I_COUNT
+};
+
+static const char *issue_names[I_COUNT] = {
+    "malformed rows", "duplicate ids", "duplicate emails", "duplicate course codes",
+    "enrolled count mismatches", "courses over capacity", "duplicate memberships",
+    "unknown students", "unknown courses", "unknown faculty ids",
+    "memberships missing from students.csv", "memberships missing from courses.csv",
+    "offered courses not owned", "owned courses not offered",
+    "repeated waitlist/completed rows", "waitlisted students already enrolled",
+    "waitlists of courses with free seats", "invalid meeting times",
+    "courses on or after a prerequisite cycle", "files left by unfinished writes"
+};
+
+static long issue_counts[I_COUNT];
+static int verbose;
+static pthread_mutex_t report_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Counts an issue and prints it unless its category is over the limit.
+ *
+ * Safe to call from the checking threads.
+ */
+static void report(enum Issue kind, const char *fmt, ...) {
+    pthread_mutex_lock(&report_lock);
+    if (issue_counts[kind]++ < REPORT_LIMIT || verbose) {
+        va_list ap;
+        va_start(ap, fmt);
+        vprintf(fmt, ap);
+        va_end(ap);
+        putchar('\n');
+    }
+    pthread_mutex_unlock(&report_lock);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Checks                                                                    */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * @brief Rows grouped per owner row, in compressed sparse row form:
+ *        the items of owner i are idx[start[i] .. start[i + 1]).
+ */
+typedef struct {
+    int *idx;
+    int *start;
+} Csr;
+
+static void csr_free(Csr *g) {
+    free(g->idx);
+    free(g->start);
+}
+
+/**
+ * @brief Everything the checks and the repair need.
+ */
+typedef struct {
+    Table *t;
+    StudentRow *students;
+    CourseRow *courses;
+    FacultyRow *faculty;
+    AdminRow *admins;
+    WaitlistRow *waitlists;
+    ScheduleRow *schedule;
+    PrereqRow *prereqs;
+    CompletedRow *completed;
+    char *keep[T_CORE];                    ///< 0 for rows dropped as duplicates
+    IdIndex student_by_id, faculty_by_id, course_by_id;
+    Map course_by_code;
+    Csr members;                           ///< Valid students per course, from courses.csv
+    Csr enrolled;                          ///< Valid courses per student, from students.csv
+} Db;
+
+typedef struct { const Db *db; Str code; } CodeCtx;
+
+static int course_code_eq(int idx, const void *ctx) {
+    const CodeCtx *c = ctx;
+    return str_eq(c->db->courses[idx].code, c->code);
+}
+
+static int find_course(const Db *db, Str code) {
+    CodeCtx ctx = { db, code };
+    return map_get(&db->course_by_code, str_hash(code), course_code_eq, &ctx);
+}
+
+static int row_id(const Table *t, int i) {
+    switch (t->kind) {
+        case T_STUDENTS: return ((StudentRow *)t->rows)[i].id;
+        case T_COURSES:  return ((CourseRow *)t->rows)[i].id;
+        case T_FACULTY:  return ((FacultyRow *)t->rows)[i].id;
+        default:         return ((AdminRow *)t->rows)[i].id;
+    }
+}
+
+static int row_line(const Table *t, int i) {
+    switch (t->kind) {
+        case T_STUDENTS: return ((StudentRow *)t->rows)[i].line;
+        case T_COURSES:  return ((CourseRow *)t->rows)[i].line;
+        case T_FACULTY:  return ((FacultyRow *)t->rows)[i].line;
+        default:         return ((AdminRow *)t->rows)[i].line;
+    }
+}
+
+static Str row_email(const Table *t, int i) {
+    switch (t->kind) {
+        case T_STUDENTS: return ((StudentRow *)t->rows)[i].email;
+        case T_FACULTY:  return ((FacultyRow *)t->rows)[i].email;
+        case T_ADMINS:   return ((AdminRow *)t->rows)[i].email;
+        default:         return (Str){ NULL, 0 };
+    }
+}
+
+typedef struct { const Table *t; Str email; } EmailCtx;
+
+static int email_eq(int idx, const void *ctx) {
+    const EmailCtx *c = ctx;
+    return str_eq(row_email(c->t, idx), c->email);
+}
+
+/**
+ * @brief Flags duplicate ids and emails in one table and builds its id index.
+ * @param by_id Index to fill with id -> row, or NULL if not needed.
+ */
+static int index_table(Db *db, enum TableKind kind, IdIndex *by_id) {
+    Table *t = &db->t[kind];
+    IdIndex ids;
+    Map emails;
+    if (id_index_init(&ids, t, row_id) < 0 || map_init(&emails, t->count) < 0) return -1;
+
+    db->keep[kind] = malloc(t->count ? t->count : 1);
+    if (!db->keep[kind]) return -1;
+
+    for (int i = 0; i < t->count; i++) {
+        db->keep[kind][i] = 1;
+        int first = id_index_put(&ids, row_id(t, i), i);
+        if (first >= 0) {
+            report(I_DUP_ID, "%s:%d: id %d already used on line %d", table_files[kind],
+                   row_line(t, i), row_id(t, i), row_line(t, first));
+            db->keep[kind][i] = 0;
+            continue;
+        }
+
+        if (kind == T_COURSES) continue;
+        EmailCtx ctx = { t, row_email(t, i) };
+        first = map_put(&emails, str_hash(ctx.email), i, email_eq, &ctx);
+        if (first >= 0) {
+            report(I_DUP_EMAIL, "%s:%d: email %.*s already used on line %d", table_files[kind],
+                   row_line(t, i), ctx.email.len, ctx.email.p, row_line(t, first));
+        }
+    }
+
+    map_free(&emails);
+    if (by_id) *by_id = ids;
+    else id_index_free(&ids);
+    return 0;
+}
+
+static int count_items(Str list) {
+    if (!list.len) return 0;
+    int n = 1;
+    for (const char *p = list.p, *end = p + list.len; (p = memchr(p, ',', end - p)); p++) n++;
+    return n;
+}
+
+/**
+ * @brief Indexes course codes and checks course rows on their own.
+ */
+static int index_courses(Db *db) {
+    int nc = db->t[T_COURSES].count;
+    if (map_init(&db->course_by_code, nc) < 0) return -1;
+
+    for (int c = 0; c < nc; c++) {
+        CourseRow *r = &db->courses[c];
+        if (!db->keep[T_COURSES][c]) continue;
+
+        CodeCtx ctx = { db, r->code };
+        int first = map_put(&db->course_by_code, str_hash(r->code), c, course_code_eq, &ctx);
+        if (first >= 0) {
+            report(I_DUP_CODE, "courses.csv:%d: code %.*s already used on line %d",
+                   r->line, r->code.len, r->code.p, db->courses[first].line);
+            db->keep[T_COURSES][c] = 0;
+            continue;
+        }
+
+        if (id_index_get(&db->faculty_by_id, r->fid) < 0) {
+            report(I_UNKNOWN_FACULTY, "courses.csv:%d: course %.*s belongs to unknown faculty %d",
+                   r->line, r->code.len, r->code.p, r->fid);
+        }
+        if (r->enrolled > r->capacity) {
+            report(I_OVER_CAPACITY, "courses.csv:%d: course %.*s has %d enrolled for capacity %d",
+                   r->line, r->code.len, r->code.p, r->enrolled, r->capacity);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Resolves every course's students list (the course side of each membership).
+ *
+ * Unknown and repeated students are reported and left out of db->members.
+ */
+static int load_course_side(Db *db) {
+    int nc = db->t[T_COURSES].count, ns = db->t[T_STUDENTS].count;
+    size_t listed = 0;
+    for (int c = 0; c < nc; c++) listed += count_items(db->courses[c].students);
+
+    Csr *g = &db->members;
+    g->idx = malloc((listed ? listed : 1) * sizeof(int));
+    g->start = malloc((nc + 1) * sizeof(int));
+    int *stamp = calloc(ns ? ns : 1, sizeof(int));   // course + 1 that last listed each student
+    if (!g->idx || !g->start || !stamp) return -1;
+
+    int n = 0;
+    for (int c = 0; c < nc; c++) {
+        CourseRow *r = &db->courses[c];
+        g->start[c] = n;
+        if (!db->keep[T_COURSES][c]) continue;
+
+        int listed_here = 0;
+        const char *p = r->students.p, *end = p + r->students.len;
+        Str item;
+        while (next_item(&p, end, &item)) {
+            listed_here++;
+            int sid;
+            int s = str_to_int(item, &sid) ? id_index_get(&db->student_by_id, sid) : -1;
+            if (s < 0) {
+                report(I_UNKNOWN_STUDENT, "courses.csv:%d: course %.*s lists unknown student %.*s",
+                       r->line, r->code.len, r->code.p, item.len, item.p);
+                continue;
+            }
+            if (stamp[s] == c + 1) {
+                report(I_DUP_MEMBER, "courses.csv:%d: course %.*s lists student %d twice",
+                       r->line, r->code.len, r->code.p, sid);
+                continue;
+            }
+            stamp[s] = c + 1;
+            g->idx[n++] = s;
+        }
+
+        if (listed_here != r->enrolled) {
+            report(I_COUNT_MISMATCH, "courses.csv:%d: course %.*s has enrolled=%d but lists %d students",
+                   r->line, r->code.len, r->code.p, r->enrolled, listed_here);
+        }
+    }
+    g->start[nc] = n;
+    free(stamp);
+    return 0;
+}
+
+/**
+ * @brief Resolves every student's enrolled_courses (the student side of each membership).
+ *
+ * Unknown and repeated courses are reported and left out of db->enrolled.
+ */
+static int load_student_side(Db *db) {
+    int ns = db->t[T_STUDENTS].count;
+    size_t listed = 0;
+    for (int s = 0; s < ns; s++) listed += count_items(db->students[s].courses);
+
+    Csr *g = &db->enrolled;
+    g->idx = malloc((listed ? listed : 1) * sizeof(int));
+    g->start = malloc((ns + 1) * sizeof(int));
+    if (!g->idx || !g->start) return -1;
+
+    int n = 0;
+    for (int s = 0; s < ns; s++) {
+        StudentRow *r = &db->students[s];
+        g->start[s] = n;
+        if (!db->keep[T_STUDENTS][s]) continue;
+
+        const char *p = r->courses.p, *end = p + r->courses.len;
+        Str item;
+        while (next_item(&p, end, &item)) {
+            int c = find_course(db, item);
+            if (c < 0) {
+                report(I_UNKNOWN_COURSE, "students.csv:%d: student %d is enrolled in unknown course %.*s",
+                       r->line, r->id, item.len, item.p);
+                continue;
+            }
+
+            // Students hold a handful of courses, so a linear scan beats a set
+            int repeated = 0;
+            for (int k = g->start[s]; k < n && !repeated; k++) repeated = g->idx[k] == c;
+            if (repeated) {
+                report(I_DUP_MEMBER, "students.csv:%d: student %d lists course %.*s twice",
+                       r->line, r->id, item.len, item.p);
+                continue;
+            }
+            g->idx[n++] = c;
+        }
+    }
+    g->start[ns] = n;
+    return 0;
+}
+
+/**
+ * @brief Regroups a CSR by its items: owner i holding item j becomes item i of owner j.
+ */
+static int csr_transpose(const Csr *in, int owners, int items, Csr *out) {
+    int links = in->start[owners];
+    out->start = calloc(items + 1, sizeof(int));
+    out->idx = malloc((links ? links : 1) * sizeof(int));
+    int *fill = malloc((items ? items : 1) * sizeof(int));
+    if (!out->start || !out->idx || !fill) return -1;
+
+    for (int k = 0; k < links; k++) out->start[in->idx[k] + 1]++;
+    for (int j = 0; j < items; j++) out->start[j + 1] += out->start[j];
+    memcpy(fill, out->start, items * sizeof(int));
+    for (int i = 0; i < owners; i++) {
+        for (int k = in->start[i]; k < in->start[i + 1]; k++) out->idx[fill[in->idx[k]]++] = i;
+    }
+    free(fill);
+    return 0;
+}
+
+/**
+ * @brief Cross-validates faculty offered_courses against course ownership.
+ */
+static int check_faculty(Db *db) {
+    int nc = db->t[T_COURSES].count;
+    char *offered = calloc(nc ? nc : 1, 1);
+    if (!offered) return -1;
+
+    for (int f = 0; f < db->t[T_FACULTY].count; f++) {
+        FacultyRow *r = &db->faculty[f];
+        if (!db->keep[T_FACULTY][f]) continue;
+
+        const char *p = r->offered.p, *end = p + r->offered.len;
+        Str item;
+        while (next_item(&p, end, &item)) {
+            int c = find_course(db, item);
+            if (c < 0) {
+                report(I_UNKNOWN_COURSE, "faculty.csv:%d: faculty %d offers unknown course %.*s",
+                       r->line, r->id, item.len, item.p);
+            } else if (db->courses[c].fid != r->id) {
+                report(I_OFFERED_NOT_OWNED, "faculty.csv:%d: faculty %d offers %.*s, which belongs to faculty %d",
+                       r->line, r->id, item.len, item.p, db->courses[c].fid);
+            } else {
+                offered[c] = 1;
+            }
+        }
+    }
+
+    for (int c = 0; c < nc; c++) {
+        CourseRow *r = &db->courses[c];
+        if (!db->keep[T_COURSES][c] || offered[c]) continue;
+        if (id_index_get(&db->faculty_by_id, r->fid) < 0) continue;
+        report(I_OWNED_NOT_OFFERED, "faculty.csv: faculty %d owns %.*s (courses.csv:%d) but does not offer it",
+               r->fid, r->code.len, r->code.p, r->line);
+    }
+
+    free(offered);
+    return 0;
+}
+
+/**
+ * @brief Checks waitlist.csv against the courses and their students.
+ */
+static int check_waitlists(Db *db) {
+    int nc = db->t[T_COURSES].count, ns = db->t[T_STUDENTS].count;
+    char *seen = calloc(nc ? nc : 1, 1);
+    int *member = calloc(ns ? ns : 1, sizeof(int));    // waitlist row + 1 whose course lists each student
+    int *queued = calloc(ns ? ns : 1, sizeof(int));    // waitlist row + 1 that last listed each student
+    if (!seen || !member || !queued) return -1;
+
+    for (int w = 0; w < db->t[T_WAITLIST].count; w++) {
+        const WaitlistRow *r = &db->waitlists[w];
+        int c = id_index_get(&db->course_by_id, r->course_id);
+        if (c < 0 || !db->keep[T_COURSES][c]) {
+            report(I_UNKNOWN_COURSE, "waitlist.csv:%d: waitlist of unknown course %d", r->line, r->course_id);
+            continue;
+        }
+        const CourseRow *course = &db->courses[c];
+        if (seen[c]) {
+            report(I_DUP_ROW, "waitlist.csv:%d: course %.*s has a second waitlist",
+                   r->line, course->code.len, course->code.p);
+            continue;
+        }
+        seen[c] = 1;
+        for (int k = db->members.start[c]; k < db->members.start[c + 1]; k++) member[db->members.idx[k]] = w + 1;
+
+        int waiting = 0;
+        const char *p = r->students.p, *end = p + r->students.len;
+        Str item;
+        while (next_item(&p, end, &item)) {
+            int sid;
+            int s = str_to_int(item, &sid) ? id_index_get(&db->student_by_id, sid) : -1;
+            if (s < 0 || !db->keep[T_STUDENTS][s]) {
+                report(I_UNKNOWN_STUDENT, "waitlist.csv:%d: course %.*s waitlists unknown student %.*s",
+                       r->line, course->code.len, course->code.p, item.len, item.p);
+                continue;
+            }
+            if (queued[s] == w + 1) {
+                report(I_DUP_MEMBER, "waitlist.csv:%d: course %.*s waitlists student %d twice",
+                       r->line, course->code.len, course->code.p, sid);
+                continue;
+            }
+            queued[s] = w + 1;
+            waiting++;
+            if (member[s] == w + 1) {
+                report(I_WAITLIST_ENROLLED, "waitlist.csv:%d: student %d is waitlisted for %.*s but already enrolled",
+                       r->line, sid, course->code.len, course->code.p);
+            }
+        }
+
+        if (waiting && course->enrolled < course->capacity) {
+            report(I_WAITLIST_FREE, "waitlist.csv:%d: %d students wait for %.*s, which has %d free seats",
+                   r->line, waiting, course->code.len, course->code.p, course->capacity - course->enrolled);
+        }
+    }
+
+    free(seen);
+    free(member);
+    free(queued);
+    return 0;
+}
+
+/**
+ * @brief Parses "HH:MM" (up to 24:00) into minutes of the day.
+ * @return Minutes, or -1 if invalid.
+ */
+static int parse_time(Str s) {
+    const char *colon = memchr(s.p, ':', s.len);
+    int h, m;
+    if (!colon || !str_to_int((Str){ s.p, (int)(colon - s.p) }, &h) ||
+        !str_to_int((Str){ colon + 1, (int)(s.p + s.len - colon - 1) }, &m)) return -1;
+    if (h < 0 || m < 0 || m > 59 || h * 60 + m > 24 * 60) return -1;
+    return h * 60 + m;
+}
+
+/**
+ * @brief Checks schedule.csv: every meeting belongs to a course and has a
+ *        valid day and a start before its end.
+ */
+static int check_schedule(Db *db) {
+    static const char *days[] = { "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun" };
+    for (int i = 0; i < db->t[T_SCHEDULE].count; i++) {
+        const ScheduleRow *r = &db->schedule[i];
+        if (find_course(db, r->code) < 0) {
+            report(I_UNKNOWN_COURSE, "schedule.csv:%d: meeting of unknown course %.*s", r->line, r->code.len, r->code.p);
+        }
+
+        int day = -1;
+        for (int d = 0; d < 7 && day < 0; d++) {
+            if (r->day.len >= 3 && strncasecmp(r->day.p, days[d], 3) == 0) day = d;
+        }
+        int start = parse_time(r->start), end = parse_time(r->end);
+        if (day < 0 || start < 0 || end <= start) {
+            report(I_BAD_SLOT, "schedule.csv:%d: course %.*s meets at invalid time %.*s %.*s-%.*s",
+                   r->line, r->code.len, r->code.p, r->day.len, r->day.p, r->start.len, r->start.p,
+                   r->end.len, r->end.p);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Checks prereqs.csv: every edge joins two courses and the edges form a DAG.
+ *
+ * Kahn's algorithm peels off courses whose prerequisites are all peeled;
+ * whatever is left is on a cycle or requires a course that is.
+ */
+static int check_prereqs(Db *db) {
+    int nc = db->t[T_COURSES].count, ne = db->t[T_PREREQS].count;
+    Csr edges = { malloc((ne ? ne : 1) * sizeof(int)), calloc(nc + 1, sizeof(int)) };
+    int *from = malloc((ne ? ne : 1) * sizeof(int));
+    int *pending = calloc(nc ? nc : 1, sizeof(int));   // prerequisites not peeled yet
+    int *queue = malloc((nc ? nc : 1) * sizeof(int));
+    if (!edges.idx || !edges.start || !from || !pending || !queue) return -1;
+
+    // Edges grouped by prerequisite, each pointing at the course requiring it
+    int n = 0;
+    for (int i = 0; i < ne; i++) {
+        const PrereqRow *r = &db->prereqs[i];
+        int c = find_course(db, r->code), p = find_course(db, r->requires);
+        if (c < 0 || p < 0) {
+            Str unknown = c < 0 ? r->code : r->requires;
+            report(I_UNKNOWN_COURSE, "prereqs.csv:%d: prerequisite edge names unknown course %.*s",
+                   r->line, unknown.len, unknown.p);
+            continue;
+        }
+        from[n] = p;
+        edges.idx[n++] = c;
+        edges.start[p + 1]++;
+        pending[c]++;
+    }
+    for (int c = 0; c < nc; c++) edges.start[c + 1] += edges.start[c];
+    int *fill = malloc((nc ? nc : 1) * sizeof(int));
+    int *to = malloc((n ? n : 1) * sizeof(int));
+    if (!fill || !to) return -1;
+    memcpy(fill, edges.start, nc * sizeof(int));
+    for (int k = 0; k < n; k++) to[fill[from[k]]++] = edges.idx[k];
+    free(edges.idx);
+    edges.idx = to;
+
+    int head = 0, tail = 0;
+    for (int c = 0; c < nc; c++) {
+        if (!pending[c]) queue[tail++] = c;
+    }
+    while (head < tail) {
+        int p = queue[head++];
+        for (int k = edges.start[p]; k < edges.start[p + 1]; k++) {
+            if (--pending[edges.idx[k]] == 0) queue[tail++] = edges.idx[k];
+        }
+    }
+    for (int c = 0; c < nc && tail < nc; c++) {
+        if (!pending[c]) continue;
+        report(I_PREREQ_CYCLE, "prereqs.csv: course %.*s is on or after a prerequisite cycle",
+               db->courses[c].code.len, db->courses[c].code.p);
+    }
+
+    csr_free(&edges);
+    free(from);
+    free(fill);
+    free(pending);
+    free(queue);
+    return 0;
+}
+
+/**
+ * @brief Checks completed.csv: one row per existing student.
+ */
+static int check_completed(Db *db) {
+    int ns = db->t[T_STUDENTS].count;
+    int *seen = calloc(ns ? ns : 1, sizeof(int));      // completed.csv line of each student
+    if (!seen) return -1;
+
+    for (int i = 0; i < db->t[T_COMPLETED].count; i++) {
+        const CompletedRow *r = &db->completed[i];
+        int s = id_index_get(&db->student_by_id, r->student_id);
+        if (s < 0 || !db->keep[T_STUDENTS][s]) {
+            report(I_UNKNOWN_STUDENT, "completed.csv:%d: record of unknown student %d", r->line, r->student_id);
+        } else if (seen[s]) {
+            report(I_DUP_ROW, "completed.csv:%d: student %d already has a record on line %d",
+                   r->line, r->student_id, seen[s]);
+        } else {
+            seen[s] = r->line;
+        }
+    }
+    free(seen);
+    return 0;
+}
+
+/**
+ * @brief Reports the files a writer that crashed mid-write left in the
+ *        database directory.
+ *
+ * A journal means a committed transaction whose tables were not all
+ * published; starting the server or a client finishes it. Temp files of
+ * writes that never committed are removed by the next writer of their table.
+ */
+static int check_leftovers(const char *dir) {
+    static const char *suffixes[] = { ".journal", ".txn", ".tmp" };
+    DIR *d = opendir(dir);
+    if (!d) return -1;
+
+    struct dirent *e;
+    while ((e = readdir(d))) {
+        size_t len = strlen(e->d_name);
+        for (int k = 0; k < 3; k++) {
+            size_t n = strlen(suffixes[k]);
+            if (len <= n || strcmp(e->d_name + len - n, suffixes[k]) != 0) continue;
+            report(I_LEFTOVER, k == 0 ? "%s/%s: interrupted transaction, start the server or a client to finish it"
+                                      : "%s/%s: temp file of an unfinished write",
+                   dir, e->d_name);
+        }
+    }
+    closedir(d);
+    return 0;
+}
+
+/**
+ * @brief A check run on its own thread; see run_parallel().
+ */
+typedef struct {
+    int (*fn)(Db *db, int arg);
+    Db *db;
+    int arg;
+    int status;
+} Task;
+
+static void *run_task(void *arg) {
+    Task *task = arg;
+    task->status = task->fn(task->db, task->arg);
+    return NULL;
+}
+
+/**
+ * @brief Runs independent tasks concurrently and waits for all of them.
+ * @return 0, or -1 if any task failed.
+ */
+static int run_parallel(Task *tasks, int n) {
+    pthread_t threads[T_COUNT];
+    int status = 0;
+    for (int i = 0; i < n; i++) pthread_create(&threads[i], NULL, run_task, &tasks[i]);
+    for (int i = 0; i < n; i++) {
+        pthread_join(threads[i], NULL);
+        if (tasks[i].status < 0) status = -1;
+    }
+    return status;
+}
+
+static int task_index_table(Db *db, int kind) {
+    IdIndex *by_id = kind == T_STUDENTS ? &db->student_by_id
+                   : kind == T_FACULTY ? &db->faculty_by_id
+                   : kind == T_COURSES ? &db->course_by_id : NULL;
+    return index_table(db, kind, by_id);
+}
+
+static int task_course_side(Db *db, int unused) {
+    (void)unused;
+    return load_course_side(db);
+}
+
+static int task_student_side(Db *db, int unused) {
+    (void)unused;
+    return load_student_side(db);
+}
+
+static int task_faculty(Db *db, int unused) {
+    (void)unused;
+    return check_faculty(db);
+}
+
+static int task_referring(Db *db, int kind) {
+    switch (kind) {
+        case T_SCHEDULE:  return check_schedule(db);
+        case T_PREREQS:   return check_prereqs(db);
+        default:          return check_completed(db);
+    }
+}
+
+/**
+ * @brief Runs every check.
+ *
+ * Independent stages run in parallel: the four per-table indexes first, then
+ * (after the course codes are indexed) both sides of the memberships, the
+ * faculty check and the checks of the schedule, prerequisite and completed
+ * tables. The two sides are then compared course by course with stamp
+ * arrays, and the waitlists checked against the course side, so the whole
+ * check is linear in rows and memberships.
+ */
+static int check_all(Db *db) {
+    int nc = db->t[T_COURSES].count, ns = db->t[T_STUDENTS].count;
+
+    Task indexes[T_CORE];
+    for (int k = 0; k < T_CORE; k++) indexes[k] = (Task){ task_index_table, db, k, 0 };
+    if (run_parallel(indexes, T_CORE) < 0 || index_courses(db) < 0) return -1;
+
+    Task sides[] = {
+        { task_course_side, db, 0, 0 },
+        { task_student_side, db, 0, 0 },
+        { task_faculty, db, 0, 0 },
+        { task_referring, db, T_SCHEDULE, 0 },
+        { task_referring, db, T_PREREQS, 0 },
+        { task_referring, db, T_COMPLETED, 0 },
+    };
+    if (run_parallel(sides, 6) < 0) return -1;
+
+    Csr by_course;
+    int *course_stamp = calloc(ns ? ns : 1, sizeof(int));
+    int *student_stamp = calloc(ns ? ns : 1, sizeof(int));
+    if (!course_stamp || !student_stamp || csr_transpose(&db->enrolled, ns, nc, &by_course) < 0) return -1;
+
+    for (int c = 0; c < nc; c++) {
+        const CourseRow *r = &db->courses[c];
+        for (int k = db->members.start[c]; k < db->members.start[c + 1]; k++) course_stamp[db->members.idx[k]] = c + 1;
+        for (int k = by_course.start[c]; k < by_course.start[c + 1]; k++) student_stamp[by_course.idx[k]] = c + 1;
+
+        for (int k = by_course.start[c]; k < by_course.start[c + 1]; k++) {
+            int s = by_course.idx[k];
+            if (course_stamp[s] != c + 1) {
+                report(I_MISSING_IN_COURSE, "students.csv:%d: student %d lists %.*s but the course does not list the student",
+                       db->students[s].line, db->students[s].id, r->code.len, r->code.p);
+            }
+        }
+        for (int k = db->members.start[c]; k < db->members.start[c + 1]; k++) {
+            int s = db->members.idx[k];
+            if (student_stamp[s] != c + 1) {
+                report(I_MISSING_IN_STUDENT, "students.csv:%d: student %d is listed by course %.*s but does not list it",
+                       db->students[s].line, db->students[s].id, r->code.len, r->code.p);
+            }
+        }
+    }
+
+    csr_free(&by_course);
+    free(course_stamp);
+    free(student_stamp);
+    return check_waitlists(db);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Repair                                                                    */
+/* ------------------------------------------------------------------------- */
+
+typedef struct {
+    const Db *db;
+    enum TableKind kind;
+    char path[PATH_LEN];
+    Csr courses;                           ///< Courses per student / faculty row
+    int status;
+} RepairJob;
+
+/**
+ * @brief Buffered writer owned by one thread (no stdio locking per call).
+ */
+typedef struct {
+    int fd;
+    char *buf;
+    size_t len;
+    int error;
+} Out;
+
+static void out_flush(Out *o) {
+    size_t done = 0;
+    while (done < o->len && !o->error) {
+        ssize_t n = write(o->fd, o->buf + done, o->len - done);
+        if (n < 0) o->error = errno;
+        else done += n;
+    }
+    o->len = 0;
+}
+
+static void out_mem(Out *o, const char *p, size_t len) {
+    if (o->len + len > OUTPUT_BUFFER) out_flush(o);
+    if (len > OUTPUT_BUFFER) {
+        write(o->fd, p, len);
+        return;
+    }
+    memcpy(o->buf + o->len, p, len);
+    o->len += len;
+}
+
+static void out_str(Out *o, Str s) {
+    out_mem(o, s.p, s.len);
+}
+
+static void out_char(Out *o, char c) {
+    if (o->len == OUTPUT_BUFFER) out_flush(o);
+    o->buf[o->len++] = c;
+}
+
+static void out_int(Out *o, int v) {
+    char buf[16];
+    int i = sizeof(buf);
+    unsigned u = v < 0 ? -(unsigned)v : (unsigned)v;
+    do {
+        buf[--i] = '0' + u % 10;
+        u /= 10;
+    } while (u);
+    if (v < 0) buf[--i] = '-';
+    out_mem(o, buf + i, sizeof(buf) - i);
+}
+
+/**
+ * @brief Thread entry point: writes one repaired table.
+ */
+static void *write_table(void *arg) {
+    RepairJob *job = arg;
+    const Db *db = job->db;
+    const Table *t = &db->t[job->kind];
+
+    Out out = { open(job->path, O_WRONLY | O_CREAT | O_TRUNC, 0644), malloc(OUTPUT_BUFFER), 0, 0 };
+    if (out.fd < 0 || !out.buf) {
+        job->status = out.fd < 0 ? errno : ENOMEM;
+        if (out.fd >= 0) close(out.fd);
+        free(out.buf);
+        return NULL;
+    }
+
+    static const char *headers[T_CORE] = {
+        "id,name,email,password",
+        "id,name,email,password,offered_courses",
+        "id,code,course_name,capacity,enrolled,credits,f_id,students",
+        "id,name,email,password,active,enrolled_courses"
+    };
+    if (t->header.len) out_str(&out, t->header);
+    else out_mem(&out, headers[job->kind], strlen(headers[job->kind]));
+    out_char(&out, '\n');
+
+    const Csr *members = &db->members;
+    for (int i = 0; i < t->count; i++) {
+        if (!db->keep[job->kind][i]) continue;
+
+        switch (job->kind) {
+            case T_ADMINS:
+                out_str(&out, db->admins[i].raw);
+                break;
+            case T_COURSES: {
+                // id,code,course_name,capacity,enrolled,credits,f_id,"students"
+                const CourseRow *r = &db->courses[i];
+                out_int(&out, r->id);
+                out_char(&out, ',');
+                out_str(&out, r->code);
+                out_char(&out, ',');
+                out_str(&out, r->name);
+                out_char(&out, ',');
+                out_int(&out, r->capacity);
+                out_char(&out, ',');
+                out_int(&out, members->start[i + 1] - members->start[i]);
+                out_char(&out, ',');
+                out_int(&out, r->credits);
+                out_char(&out, ',');
+                out_int(&out, r->fid);
+                out_mem(&out, ",\"", 2);
+                for (int k = members->start[i]; k < members->start[i + 1]; k++) {
+                    if (k > members->start[i]) out_char(&out, ',');
+                    out_int(&out, db->students[members->idx[k]].id);
+                }
+                out_char(&out, '"');
+                break;
+            }
+            case T_STUDENTS:
+            case T_FACULTY: {
+                // Both are "id,name,email,password,...,<list of course codes>"
+                Str head = job->kind == T_STUDENTS ? db->students[i].raw : db->faculty[i].raw;
+                Str list = job->kind == T_STUDENTS ? db->students[i].courses : db->faculty[i].offered;
+                out_mem(&out, head.p, list.p - head.p);
+                for (int k = job->courses.start[i]; k < job->courses.start[i + 1]; k++) {
+                    if (k > job->courses.start[i]) out_char(&out, ',');
+                    out_str(&out, db->courses[job->courses.idx[k]].code);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        out_char(&out, '\n');
+    }
+
+    out_flush(&out);
+    if (out.error) job->status = out.error;
+    if (close(out.fd) < 0 && !job->status) job->status = errno;
+    free(out.buf);
+    return NULL;
+}
+
+/**
+ * @brief Writes a repaired snapshot of the four core tables to a directory.
+ */
+static int repair(const Db *db, const char *dir) {
+    if (mkdir(dir, 0755) < 0 && errno != EEXIST) {
+        perror(dir);
+        return -1;
+    }
+
+    int nc = db->t[T_COURSES].count;
+    RepairJob jobs[T_CORE];
+    memset(jobs, 0, sizeof(jobs));
+    for (int k = 0; k < T_CORE; k++) {
+        jobs[k].db = db;
+        jobs[k].kind = k;
+        snprintf(jobs[k].path, sizeof(jobs[k].path), "%s/%s", dir, table_files[k]);
+    }
+
+    // Every course has at most one owning faculty row
+    Csr owner = { malloc((nc ? nc : 1) * sizeof(int)), malloc((nc + 1) * sizeof(int)) };
+    if (!owner.idx || !owner.start) return -1;
+    int n = 0;
+    for (int c = 0; c < nc; c++) {
+        owner.start[c] = n;
+        int f = db->keep[T_COURSES][c] ? id_index_get(&db->faculty_by_id, db->courses[c].fid) : -1;
+        if (f >= 0) owner.idx[n++] = f;
+    }
+    owner.start[nc] = n;
+
+    // Transposing keeps each row's courses in courses.csv order
+    if (csr_transpose(&db->members, nc, db->t[T_STUDENTS].count, &jobs[T_STUDENTS].courses) < 0 ||
+        csr_transpose(&owner, nc, db->t[T_FACULTY].count, &jobs[T_FACULTY].courses) < 0) {
+        fprintf(stderr, "dbcheck: out of memory\n");
+        return -1;
+    }
+    csr_free(&owner);
+
+    pthread_t threads[T_CORE];
+    for (int k = 0; k < T_CORE; k++) pthread_create(&threads[k], NULL, write_table, &jobs[k]);
+    int status = 0;
+    for (int k = 0; k < T_CORE; k++) {
+        pthread_join(threads[k], NULL);
+        if (jobs[k].status) {
+            fprintf(stderr, "dbcheck: %s: %s\n", jobs[k].path, strerror(jobs[k].status));
+            status = -1;
+        }
+        csr_free(&jobs[k].courses);
+    }
+    return status;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Main                                                                      */
+/* ------------------------------------------------------------------------- */
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-d database_dir] [-r repair_dir] [-v]\n"
+                    "Checks the core tables, waitlist.csv, schedule.csv, prereqs.csv and\n"
+                    "completed.csv, and leftover .journal/.txn/.tmp files; run it while no\n"
+                    "server or client is writing. -r repairs only the four core tables.\n", prog);
+}
+
+int main(int argc, char **argv) {
+    const char *db_dir = DEFAULT_DB_DIR;
+    const char *repair_dir = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:r:vh")) != -1) {
+        switch (opt) {
+            case 'd': db_dir = optarg; break;
+            case 'r': repair_dir = optarg; break;
+            case 'v': verbose = 1; break;
+            default:  usage(argv[0]); return 2;
+        }
+    }
+
+    // Load every table in parallel
+    Table tables[T_COUNT];
+    pthread_t threads[T_COUNT];
+    memset(tables, 0, sizeof(tables));
+    for (int k = 0; k < T_COUNT; k++) {
+        tables[k].kind = k;
+        snprintf(tables[k].path, sizeof(tables[k].path), "%s/%s", db_dir, table_files[k]);
+        pthread_create(&threads[k], NULL, load_table, &tables[k]);
+    }
+    for (int k = 0; k < T_COUNT; k++) pthread_join(threads[k], NULL);
+
+    for (int k = 0; k < T_COUNT; k++) {
+        // The server creates the referring tables on first use
+        if (k >= T_CORE && tables[k].error == ENOENT) tables[k].error = 0;
+        if (tables[k].error) {
+            fprintf(stderr, "dbcheck: %s: %s\n", tables[k].path, strerror(tables[k].error));
+            return 2;
+        }
+        issue_counts[I_MALFORMED] += tables[k].malformed;
+        if (tables[k].malformed) {
+            printf("%s: %d malformed rows skipped\n", table_files[k], tables[k].malformed);
+        }
+    }
+
+    Db db;
+    memset(&db, 0, sizeof(db));
+    db.t = tables;
+    db.students = tables[T_STUDENTS].rows;
+    db.courses = tables[T_COURSES].rows;
+    db.faculty = tables[T_FACULTY].rows;
+    db.admins = tables[T_ADMINS].rows;
+    db.waitlists = tables[T_WAITLIST].rows;
+    db.schedule = tables[T_SCHEDULE].rows;
+    db.prereqs = tables[T_PREREQS].rows;
+    db.completed = tables[T_COMPLETED].rows;
+
+    if (check_all(&db) < 0) {
+        fprintf(stderr, "dbcheck: out of memory\n");
+        return 2;
+    }
+    if (check_leftovers(db_dir) < 0) {
+        perror(db_dir);
+        return 2;
+    }
+
+    long total = 0;
+    printf("\n%d admins, %d faculty, %d courses, %d students, %d memberships\n",
+           tables[T_ADMINS].count, tables[T_FACULTY].count, tables[T_COURSES].count,
+           tables[T_STUDENTS].count, db.members.start[tables[T_COURSES].count]);
+    printf("%d waitlists, %d meetings, %d prerequisite edges, %d completion records\n",
+           tables[T_WAITLIST].count, tables[T_SCHEDULE].count, tables[T_PREREQS].count,
+           tables[T_COMPLETED].count);
+    for (int i = 0; i < I_COUNT; i++) {
+        if (!issue_counts[i]) continue;
+        printf("  %-40s %ld\n", issue_names[i], issue_counts[i]);
+        total += issue_counts[i];
+    }
+    printf(total ? "%ld problems found\n" : "database is consistent\n", total);
+
+    if (repair_dir) {
+        if (repair(&db, repair_dir) < 0) return 2;
+        printf("repaired snapshot written to %s\n", repair_dir);
+    }
+    return total ? 1 : 0;
+}